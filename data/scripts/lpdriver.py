@@ -38,27 +38,11 @@ def run_locuspocus(infile, outfile, delta, ilenfile=None, debug=False):
     return numloci
 
 
-def run_uloci(infile, outfile, counter, debug=False):
-    command = 'uloci.py --counter %d' % counter
-    command += ' --src AEGeAn::uloci.py'
-    command += ' %s' % infile
-    if debug:
-        print('command: %s' % command, file=sys.stderr)
-
-    cmd = command.split(' ')
-    with open('%s.ul' % outfile, 'w') as fp:
-        result = subprocess.call(cmd, stdout=fp)
-    if result:
-        print('command resulted in return status %d: %s' % (result, command),
-              file=sys.stderr)
-        exit(result)
-
-
 def combine_output(outfile, namefmt):
     locusids = {}
     with open(outfile, 'w') as fp:
         command = 'gt gff3 -retainids -sort -tidy '
-        command += '%s.lp %s.ul' % (outfile, outfile)
+        command += '%s.lp' % outfile
         cmd = command.split(' ')
         p = subprocess.Popen(cmd, stdout=subprocess.PIPE,
                              universal_newlines=True)
@@ -96,8 +80,6 @@ if __name__ == '__main__':
 
     numloci = run_locuspocus(args.infile, args.out, args.delta, args.ilenfile,
                              args.debug)
-    run_uloci(args.infile, args.out, numloci + 1, args.debug)
     combine_output(args.out, args.namefmt)
 
     os.unlink('%s.lp' % args.out)
-    os.unlink('%s.ul' % args.out)
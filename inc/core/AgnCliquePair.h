@@ -21,6 +21,22 @@ online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
  */
 typedef struct AgnCliquePair AgnCliquePair;
 
+/**
+ * @type Ranking of a clique pair in the order used to select which pairs are
+ * reported. ``tier`` is 4 for a perfect match; otherwise bit 1 is set for a CDS
+ * structure match and bit 0 for an exon structure match. Within a tier, pairs
+ * are ranked by coding and then UTR nucleotide correlation coefficients, each
+ * rounded down to a multiple of the locus tolerance used by
+ * :c:func:`agn_clique_pair_compare_direct` (undefined coefficients rank
+ * lowest). Perfect matches all rank equally.
+ */
+typedef struct
+{
+  int tier;
+  double cds_cc;
+  double utr_cc;
+} AgnCliquePairKey;
+
 /**
  * @function Based on the already-computed comparison statistics, classify this
  * clique pair as a perfect match, a CDS match, etc. See
@@ -73,12 +89,43 @@ AgnTranscriptClique *agn_clique_pair_get_refr_clique(AgnCliquePair *pair);
  */
 AgnComparison *agn_clique_pair_get_stats(AgnCliquePair *pair);
 
+/**
+ * @function Determine this pair's ranking from its comparison statistics.
+ */
+void agn_clique_pair_key(AgnCliquePair *pair, AgnCliquePairKey *key);
+
+/**
+ * @function Compute an upper bound on the ranking of the pair formed by two
+ * cliques, using only summaries of their models, without doing the full
+ * comparison. ``length`` is the length of the locus.
+ */
+void agn_clique_pair_key_bound(const AgnModelSummary *refr,
+                               const AgnModelSummary *pred, GtUword length,
+                               AgnCliquePairKey *key);
+
+/**
+ * @function Returns 1 if the first key ranks higher than the second, -1 if it
+ * ranks lower, and 0 if they are equal.
+ */
+int agn_clique_pair_key_compare(const AgnCliquePairKey *k1,
+                                const AgnCliquePairKey *k2);
+
 /**
  * @function Class constructor.
  */
 AgnCliquePair* agn_clique_pair_new(AgnTranscriptClique *refr,
                                    AgnTranscriptClique *pred);
 
+/**
+ * @function Class constructor for a pair whose comparison was done previously
+ * (for example, by an earlier run; see :c:type:`AgnLocusCache`). The
+ * comparison is skipped, and a copy of ``stats`` (which should already be
+ * resolved) is used instead.
+ */
+AgnCliquePair* agn_clique_pair_new_with_stats(AgnTranscriptClique *refr,
+                                              AgnTranscriptClique *pred,
+                                              AgnComparison *stats);
+
 /**
  * @function Run unit tests for this class. Returns true if all tests passed.
  */
@@ -42,4 +42,32 @@ GtNodeVisitor *agn_compare_report_text_new(FILE *outstream, bool gff3,
                                            GtLogger *logger);
 //                                           bool gff3);
 
+/**
+ * @function Add comparison data written by
+ * :c:func:`agn_compare_report_text_write_data` (possibly by another process)
+ * to this report. Data from any number of files can be combined, and the
+ * summary report will then be identical to that of a single report that
+ * processed all of the loci. Returns false and sets ``error`` if the data
+ * cannot be read.
+ */
+bool agn_compare_report_text_read_data(AgnCompareReportText *rpt,
+                                        FILE *instream, GtError *error);
+
+/**
+ * @function When processing loci built from a reference and several sets of
+ * predictions, report only the comparisons with prediction set ``set`` (see
+ * :c:func:`agn_locus_get_pred_set`). Loci with no annotations from the
+ * reference or that set are skipped.
+ */
+void agn_compare_report_text_set_pred_set(AgnCompareReportText *rpt,
+                                          GtUword set);
+
+/**
+ * @function After the node stream has been processed, call this function to
+ * write the data needed for the summary report (overall and for each sequence)
+ * to ``outstream`` in binary format.
+ */
+bool agn_compare_report_text_write_data(AgnCompareReportText *rpt,
+                                        FILE *outstream);
+
 #endif
@@ -0,0 +1,54 @@
+/**
+
+Copyright (c) 2010-2014, Daniel S. Standage and CONTRIBUTORS
+
+The AEGeAn Toolkit is distributed under the ISC License. See
+the 'LICENSE' file in the AEGeAn source code distribution or
+online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
+
+**/
+
+#ifndef AEGEAN_COMPARE_STREAM
+#define AEGEAN_COMPARE_STREAM
+
+#include "extended/node_stream_api.h"
+#include "core/logger_api.h"
+#include "AgnLocusCache.h"
+#include "AgnUnitTest.h"
+
+/**
+ * @class AgnCompareStream
+ *
+ * Implements the GenomeTools ``GtNodeStream`` interface. This is a node stream
+ * that runs the comparative analysis of each locus it receives (see
+ * :c:func:`agn_locus_comparative_analysis`) before passing it on, so that
+ * downstream report visitors only need to format the results. Loci are
+ * independent, so the analysis can be distributed across several threads.
+ * Nodes are always delivered in the order in which they were received.
+ */
+typedef struct AgnCompareStream AgnCompareStream;
+
+/**
+ * @function Class constructor. Loci are analyzed using ``numthreads`` threads
+ * (including the calling thread); if ``numthreads`` is 1, each locus is
+ * analyzed as it is pulled through the stream. At most ``numthreads`` times a
+ * fixed number of nodes are buffered at any time.
+ */
+GtNodeStream* agn_compare_stream_new(GtNodeStream *in_stream,
+                                     GtUword numthreads, GtLogger *logger);
+
+/**
+ * @function Look up each locus in ``cache`` before analyzing it, and add the
+ * results of each locus that had to be analyzed to ``cache``. The stream does
+ * not take ownership of the cache, which must remain valid as long as nodes
+ * are pulled through the stream.
+ */
+void agn_compare_stream_set_cache(AgnCompareStream *stream,
+                                  AgnLocusCache *cache);
+
+/**
+ * @function Run unit tests for this class. Returns true if all tests passed.
+ */
+bool agn_compare_stream_unit_test(AgnUnitTest *test);
+
+#endif
@@ -183,6 +183,21 @@ void agn_comparison_data_aggregate(AgnComparisonData *agg_data,
  */
 void agn_comparison_data_init(AgnComparisonData *data);
 
+/**
+ * @function Read counts written by :c:func:`agn_comparison_data_write` into
+ * ``data`` (replacing any previous values) and calculate the corresponding
+ * stats. Returns false if the input is truncated or cannot be read.
+ */
+bool agn_comparison_data_read(AgnComparisonData *data, FILE *instream);
+
+/**
+ * @function Write the counts in ``data`` to ``outstream`` in a compact,
+ * platform-independent binary format. Stats are not written, since they can
+ * be calculated from the counts; this way, data written by separate processes
+ * can be aggregated with no loss of precision. Returns false on a write error.
+ */
+bool agn_comparison_data_write(AgnComparisonData *data, FILE *outstream);
+
 /**
  * @function Initialize comparison stats to default values.
  */
@@ -193,6 +208,13 @@ void agn_comparison_init(AgnComparison *comparison);
  */
 void agn_comparison_print(AgnComparison *stats, FILE *outstream);
 
+/**
+ * @function Read counts written by :c:func:`agn_comparison_write` into
+ * ``comparison`` and calculate the corresponding stats. Returns false if the
+ * input is truncated or cannot be read.
+ */
+bool agn_comparison_read(AgnComparison *comparison, FILE *instream);
+
 /**
  * @function Calculate stats from the given counts.
  */
@@ -204,6 +226,13 @@ void agn_comparison_resolve(AgnComparison *comparison);
  */
 bool agn_comparison_test(AgnComparison *c1, AgnComparison *c2);
 
+/**
+ * @function Write the counts in ``comparison`` to ``outstream`` in the binary
+ * format used by :c:func:`agn_comparison_data_write`. Returns false on a write
+ * error.
+ */
+bool agn_comparison_write(AgnComparison *comparison, FILE *outstream);
+
 /**
  * @function Add values from ``desc`` to ``agg_desc``.
  */
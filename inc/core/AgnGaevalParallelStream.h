@@ -0,0 +1,48 @@
+/**
+
+Copyright (c) 2010-2016, Daniel S. Standage and CONTRIBUTORS
+
+The AEGeAn Toolkit is distributed under the ISC License. See
+the 'LICENSE' file in the AEGeAn source code distribution or
+online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
+
+**/
+
+#ifndef AEGEAN_GAEVAL_PARALLEL_STREAM
+#define AEGEAN_GAEVAL_PARALLEL_STREAM
+
+#include "extended/node_stream_api.h"
+#include "extended/node_visitor_api.h"
+#include "AgnUnitTest.h"
+
+/**
+ * @class AgnGaevalParallelStream
+ *
+ * Implements the GenomeTools ``GtNodeStream`` interface. This is a node stream
+ * that applies an :c:type:`AgnGaevalVisitor` to each node it receives, like a
+ * visitor stream, but scores the gene models of several features at once. The
+ * alignment data for each feature is gathered as the feature is received (see
+ * :c:func:`agn_gaeval_visitor_job_new`), the mRNAs are scored by any of the
+ * threads, and nodes are delivered and TSV rows are written in the order in
+ * which the nodes were received, so the output is identical to that of a
+ * visitor stream.
+ */
+typedef struct AgnGaevalParallelStream AgnGaevalParallelStream;
+
+/**
+ * @function Class constructor. The stream takes ownership of the GAEVAL
+ * visitor ``nv``. Gene models are scored using ``numthreads`` threads
+ * (including the calling thread); if ``numthreads`` is 1, each feature is
+ * scored as it is pulled through the stream. At most ``numthreads`` times a
+ * fixed number of nodes are buffered at any time.
+ */
+GtNodeStream *agn_gaeval_parallel_stream_new(GtNodeStream *in_stream,
+                                             GtNodeVisitor *nv,
+                                             GtUword numthreads);
+
+/**
+ * @function Run unit tests for this class. Returns true if all tests passed.
+ */
+bool agn_gaeval_parallel_stream_unit_test(AgnUnitTest *test);
+
+#endif
@@ -11,6 +11,7 @@ online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
 #ifndef AEGEAN_GAEVAL_VISITOR
 #define AEGEAN_GAEVAL_VISITOR
 
+#include "extended/feature_node_api.h"
 #include "extended/node_stream_api.h"
 #include "AgnUnitTest.h"
 
@@ -23,6 +24,18 @@ online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
  */
 typedef struct AgnGaevalVisitor AgnGaevalVisitor;
 
+/**
+ * @type The mRNAs of a single top-level feature, along with the alignment data
+ * needed to score them. Scoring a feature is split into three steps so that
+ * several features can be scored at once (see
+ * :c:type:`AgnGaevalParallelStream`): a job is created with
+ * :c:func:`agn_gaeval_visitor_job_new` and finished with
+ * :c:func:`agn_gaeval_visitor_job_finish` in input order by the thread pulling
+ * nodes, while :c:func:`agn_gaeval_visitor_job_run` may be called from any
+ * thread.
+ */
+typedef struct AgnGaevalJob AgnGaevalJob;
+
 /**
  * @type Parameters used in calculating GAEVAL integrity.
  * See http://www.plantgdb.org/GAEVAL/docs/integrity.html
@@ -45,12 +58,60 @@ typedef struct AgnGaevalParams AgnGaevalParams;
 GtNodeStream* agn_gaeval_stream_new(GtNodeStream *in, GtNodeStream *astream,
                                     AgnGaevalParams gparams);
 
+/**
+ * @function Time the coverage calculation for a synthetic 10-exon mRNA
+ * overlapped by thousands of short alignments, and check that every exon
+ * nucleotide is reported as covered. Returns true if it was at each size.
+ */
+bool agn_gaeval_visitor_benchmark(AgnUnitTest *test);
+
+/**
+ * @function Class destructor for a job, discarding its TSV rows.
+ */
+void agn_gaeval_visitor_job_delete(AgnGaevalJob *job);
+
+/**
+ * @function Write the TSV rows of a job that has been run (if TSV output is
+ * enabled) and free the job.
+ */
+void agn_gaeval_visitor_job_finish(AgnGaevalVisitor *v, AgnGaevalJob *job);
+
+/**
+ * @function Create a job for scoring the mRNAs of the top-level feature
+ * ``fn``, collecting the exons and introns of each mRNA and the segments and
+ * gaps of each overlapping alignment. The job holds copies of these intervals
+ * rather than references to the alignments, so it can be run without touching
+ * any node other than ``fn`` and its subfeatures. Returns NULL and sets
+ * ``error`` if the alignments could not be read.
+ */
+AgnGaevalJob *agn_gaeval_visitor_job_new(AgnGaevalVisitor *v, GtFeatureNode *fn,
+                                         GtError *error);
+
+/**
+ * @function Score each mRNA of a job, adding the ``gaeval_coverage`` and
+ * ``gaeval_integrity`` attributes and formatting its TSV row. Jobs of
+ * different features can be run concurrently.
+ */
+void agn_gaeval_visitor_job_run(AgnGaevalVisitor *v, AgnGaevalJob *job);
+
 /**
  * @function Class constructor for the node visitor.
  */
 GtNodeVisitor*
 agn_gaeval_visitor_new(GtNodeStream *astream, AgnGaevalParams gparams);
 
+/**
+ * @function Class constructor for the node visitor when both the alignments
+ * and the gene models are sorted by sequence ID and start position (as with
+ * ``gt gff3 -sort``). Rather than loading all alignments into memory, the
+ * visitor pulls them from ``astream`` as the gene models are visited and keeps
+ * only a window of alignments that may overlap the current or a later gene
+ * model, so memory use is proportional to the alignment depth rather than the
+ * size of the alignment file.
+ */
+GtNodeVisitor*
+agn_gaeval_visitor_new_sorted(GtNodeStream *astream, AgnGaevalParams gparams);
+
 /**
 * @function Indicate a file to be used for printing TSV output.
 */
@@ -0,0 +1,100 @@
+/**
+
+Copyright (c) 2010-2016, Daniel S. Standage and CONTRIBUTORS
+
+The AEGeAn Toolkit is distributed under the ISC License. See
+the 'LICENSE' file in the AEGeAn source code distribution or
+online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
+
+**/
+
+#ifndef AEGEAN_ILOCUS_CACHE
+#define AEGEAN_ILOCUS_CACHE
+
+#include "core/error_api.h"
+#include "extended/genome_node_api.h"
+#include "AgnOutputSink.h"
+#include "AgnUnitTest.h"
+
+/**
+ * @class AgnILocusCache
+ *
+ * Stores the iLoci computed for each sequence in a directory, so that when an
+ * annotation is processed again (typically after only a few sequences have
+ * been re-annotated) the iLoci of unchanged sequences can be reused. The nodes
+ * of a sequence (see :c:type:`AgnLocusParallelStream`) are keyed by a hash of
+ * the settings used to compute the iLoci and of the sequence ID, type,
+ * coordinates, strand, and ID of every feature and subfeature. Each entry is a
+ * separate file named after its key, holding the coordinates and attributes of
+ * each iLocus, the positions of its genes among the input nodes, and the iLocus
+ * lengths reported for the sequence. Entries are written to a temporary file
+ * and renamed, so any number of runs can share a directory; entries of
+ * sequences that have since changed are never read again and can be deleted
+ * at any time. A cache object can be shared by several threads.
+ */
+typedef struct AgnILocusCache AgnILocusCache;
+
+/**
+ * @function Class destructor.
+ */
+void agn_ilocus_cache_delete(AgnILocusCache *cache);
+
+/**
+ * @function If the iLoci of the sequence whose input nodes have the given
+ * ``key`` and description ``desc`` (see :c:func:`agn_ilocus_cache_key`) are
+ * in the cache, rebuild them from the input ``nodes``, add them (along with
+ * any other nodes that would have been delivered) to ``output``, write the
+ * cached iLocus lengths to ``ilens`` (if not NULL), and return true; the input
+ * nodes are then owned by the output or deleted. Otherwise return false and
+ * leave ``nodes`` as is.
+ */
+bool agn_ilocus_cache_get(AgnILocusCache *cache, GtUword key, GtStr *desc,
+                          GtArray *nodes, GtArray *output,
+                          AgnOutputSink *ilens);
+
+/**
+ * @function Write a description of a sequence, made up of the ``settings``
+ * used to compute its iLoci and its input ``nodes``, to ``desc``, and return
+ * its key, a hash of the description. Each node is labeled with its position
+ * so that :c:func:`agn_ilocus_cache_put` can identify it. Since different
+ * sequences may have the same key, the description is stored with each entry
+ * and compared on every lookup.
+ */
+GtUword agn_ilocus_cache_key(AgnILocusCache *cache, const char *settings,
+                             GtArray *nodes, GtStr *desc);
+
+/**
+ * @function Class constructor. Uses the directory ``dirname``, creating it if
+ * it does not exist. Returns NULL and sets ``error`` if the directory cannot be
+ * created.
+ */
+AgnILocusCache *agn_ilocus_cache_new(const char *dirname, GtError *error);
+
+/**
+ * @function Number of calls to :c:func:`agn_ilocus_cache_get` that found the
+ * sequence in the cache.
+ */
+GtUword agn_ilocus_cache_num_hits(AgnILocusCache *cache);
+
+/**
+ * @function Number of calls to :c:func:`agn_ilocus_cache_get` that did not find
+ * the sequence in the cache.
+ */
+GtUword agn_ilocus_cache_num_misses(AgnILocusCache *cache);
+
+/**
+ * @function Store the nodes computed for the sequence with the given ``key``
+ * and description ``desc`` (``output``, whose iLoci may contain only input
+ * nodes labeled by :c:func:`agn_ilocus_cache_key`) and the iLocus lengths
+ * written to the memory sink ``ilens`` (if not NULL), and remove the labels.
+ * Returns false if the entry could not be written.
+ */
+bool agn_ilocus_cache_put(AgnILocusCache *cache, GtUword key, GtStr *desc,
+                          GtArray *output, AgnOutputSink *ilens);
+
+/**
+ * @function Run unit tests for this class. Returns true if all tests passed.
+ */
+bool agn_ilocus_cache_unit_test(AgnUnitTest *test);
+
+#endif
@@ -101,6 +101,25 @@ void agn_locus_add(AgnLocus *locus, GtFeatureNode *feature,
 #define agn_locus_add_feature(LC, GN)\
         agn_locus_add(LC, GN, DEFAULTSOURCE)
 
+/**
+ * @function Associate a prediction annotation with this locus when comparing a
+ * single reference against several sets of predictions, recording that it
+ * belongs to the prediction set numbered ``set`` (see
+ * :c:func:`agn_locus_set_num_pred_sets`).
+ */
+void agn_locus_add_pred_set_feature(AgnLocus *locus, GtFeatureNode *feature,
+                                    GtUword set);
+
+/**
+ * @function Benchmark the two steps of locus comparison whose cost grows
+ * fastest with the number of isoforms. The pivoted Bron-Kerbosch search is
+ * timed against the unpivoted one on synthetic loci of 20 to 50 overlapping
+ * isoforms, and bounded clique pair selection against comparing every pair on
+ * loci with half as many isoforms in each annotation. Returns false if either
+ * version found different cliques or pairs.
+ */
+bool agn_locus_benchmark(AgnUnitTest *test);
+
 /**
  * @function Do a semi-shallow copy of this data structure--for members whose
  * data types support reference counting, the same pointer is used and the
@@ -195,6 +214,17 @@ bool agn_locus_filter_test(AgnLocus *locus, AgnLocusFilter *filter);
  */
 GtArray *agn_locus_get(AgnLocus *locus);
 
+/**
+ * @function For a locus built from a reference and several prediction sets,
+ * get the locus to be used for comparing the reference with prediction set
+ * ``set``: it has the same coordinates as ``locus`` and contains all of its
+ * reference genes, but only the prediction genes from the given set. Returns
+ * NULL if there are no such genes, or if the set has been removed with
+ * :c:func:`agn_locus_remove_pred_set`. These loci are created the first time
+ * this function is called and are owned by ``locus``.
+ */
+AgnLocus *agn_locus_get_pred_set(AgnLocus *locus, GtUword set);
+
 /**
  * @function Get a list of all the prediction transcript cliques that have no
  * corresponding reference transcript clique.
@@ -311,6 +341,12 @@ GtUword agn_locus_mrna_num(AgnLocus *locus, AgnComparisonSource src);
 #define agn_locus_num_mrnas(LC)\
         agn_locus_mrna_num(LC, DEFAULTSOURCE)
 
+/**
+ * @function Get the number of prediction sets this locus was built from, or 0
+ * if it is not a locus for comparing several sets of predictions.
+ */
+GtUword agn_locus_num_pred_sets(AgnLocus *locus);
+
 /**
  * @function Class constructor.
  */
@@ -342,6 +378,35 @@ void agn_locus_print_png(AgnLocus *locus, AgnLocusPngMetadata *metadata);
  */
 void agn_locus_print_transcript_mapping(AgnLocus *locus, FILE *outstream);
 
+/**
+ * @function Exclude prediction set ``set`` from this locus, so that
+ * :c:func:`agn_locus_get_pred_set` returns NULL for it (for example, because
+ * the corresponding locus did not pass a filter).
+ */
+void agn_locus_remove_pred_set(AgnLocus *locus, GtUword set);
+
+/**
+ * @function Store the results of a comparative analysis done previously (for
+ * example, loaded from an :c:type:`AgnLocusCache`) with this locus, so that
+ * :c:func:`agn_locus_comparative_analysis` has nothing left to do.
+ * ``pairs2report`` holds the selected clique pairs, and ``uniqrefr`` and
+ * ``uniqpred`` (either of which may be NULL) the cliques unique to each source.
+ * The locus takes ownership of the pairs and cliques, but the caller must still
+ * delete the arrays.
+ */
+void agn_locus_set_comparative_analysis(AgnLocus *locus,
+                                        GtArray *pairs2report,
+                                        GtArray *uniqrefr, GtArray *uniqpred);
+
+/**
+ * @function Mark this locus as one built from a reference and ``numsets`` sets
+ * of predictions. :c:func:`agn_locus_comparative_analysis` then enumerates the
+ * reference transcript cliques only once and compares them with each
+ * prediction set in turn, storing the results with the loci returned by
+ * :c:func:`agn_locus_get_pred_set`.
+ */
+void agn_locus_set_num_pred_sets(AgnLocus *locus, GtUword numsets);
+
 /**
  * @function Set the start and end coordinates for this locus.
  */
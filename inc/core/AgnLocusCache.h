@@ -0,0 +1,79 @@
+/**
+
+Copyright (c) 2010-2014, Daniel S. Standage and CONTRIBUTORS
+
+The AEGeAn Toolkit is distributed under the ISC License. See
+the 'LICENSE' file in the AEGeAn source code distribution or
+online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
+
+**/
+
+#ifndef AEGEAN_LOCUS_CACHE
+#define AEGEAN_LOCUS_CACHE
+
+#include "core/error_api.h"
+#include "AgnLocus.h"
+#include "AgnUnitTest.h"
+
+/**
+ * @class AgnLocusCache
+ *
+ * Stores the results of the comparative analysis of loci in a file, so that
+ * when the same annotations are compared again (typically after only a few
+ * genes have changed) the analysis of unchanged loci can be skipped. Each
+ * result is keyed by the structure of the locus: its coordinates and the ID,
+ * type, coordinates, and strand of each reference and prediction transcript
+ * and all of their subfeatures. The file is append-only: existing results are
+ * memory-mapped when the cache is opened, and new results are appended (with
+ * an exclusive lock) as loci are stored, so any number of runs can share a
+ * single cache file. Records left incomplete by an interrupted run are
+ * ignored. A cache object must not be used by more than one thread at a time.
+ */
+typedef struct AgnLocusCache AgnLocusCache;
+
+/**
+ * @function Class destructor.
+ */
+void agn_locus_cache_delete(AgnLocusCache *cache);
+
+/**
+ * @function If the results of the comparative analysis of a locus with the
+ * same structure as ``locus`` are in the cache, store them with ``locus`` (see
+ * :c:func:`agn_locus_set_comparative_analysis`) and return true. Otherwise
+ * return false.
+ */
+bool agn_locus_cache_get(AgnLocusCache *cache, AgnLocus *locus);
+
+/**
+ * @function Class constructor. Opens the cache file ``filename``, creating it
+ * if it does not exist. Returns NULL and sets ``error`` if the file cannot be
+ * opened or is not a cache file.
+ */
+AgnLocusCache *agn_locus_cache_new(const char *filename, GtError *error);
+
+/**
+ * @function Number of calls to :c:func:`agn_locus_cache_get` that found the
+ * locus in the cache.
+ */
+GtUword agn_locus_cache_num_hits(AgnLocusCache *cache);
+
+/**
+ * @function Number of calls to :c:func:`agn_locus_cache_get` that did not find
+ * the locus in the cache.
+ */
+GtUword agn_locus_cache_num_misses(AgnLocusCache *cache);
+
+/**
+ * @function Add the results of the comparative analysis of ``locus`` (see
+ * :c:func:`agn_locus_comparative_analysis`) to the cache. Loci that were not
+ * analyzed, or whose results are already in the cache, are ignored. Returns
+ * false if the results could not be written.
+ */
+bool agn_locus_cache_put(AgnLocusCache *cache, AgnLocus *locus);
+
+/**
+ * @function Run unit tests for this class. Returns true if all tests passed.
+ */
+bool agn_locus_cache_unit_test(AgnUnitTest *test);
+
+#endif
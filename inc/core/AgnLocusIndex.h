@@ -0,0 +1,101 @@
+/**
+
+Copyright (c) 2010-2016, Daniel S. Standage and CONTRIBUTORS
+
+The AEGeAn Toolkit is distributed under the ISC License. See
+the 'LICENSE' file in the AEGeAn source code distribution or
+online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
+
+**/
+
+#ifndef AEGEAN_LOCUS_INDEX
+#define AEGEAN_LOCUS_INDEX
+
+#include <stdio.h>
+#include "core/error_api.h"
+#include "extended/node_stream_api.h"
+#include "AgnUnitTest.h"
+
+/**
+ * @class AgnLocusIndex
+ *
+ * A compact binary index of the iLoci computed by LocusPocus, which can be
+ * queried by position or by gene/mRNA ID without parsing any GFF3. The index
+ * holds a table of sequence IDs, the iLoci of each sequence sorted by
+ * coordinates, the type (siLocus, ciLocus, iiLocus, fiLocus, etc.), label,
+ * and gene and mRNA counts of each iLocus, and the gene --> iLocus and mRNA
+ * --> iLocus relationships also reported by :c:type:`AgnLocusMapVisitor`
+ * sorted by ID. Index files are written by the node stream created with
+ * :c:func:`agn_locus_index_stream_new` and memory-mapped when opened, so
+ * position lookups and ID lookups both take logarithmic time.
+ */
+typedef struct AgnLocusIndex AgnLocusIndex;
+
+/**
+ * @type Description of an iLocus stored in an :c:type:`AgnLocusIndex`. The
+ * strings point into the index and are valid until the index is deleted.
+ */
+struct AgnLocusIndexEntry
+{
+  const char *seqid;
+  GtRange range;
+  const char *type;
+  const char *label;
+  GtUword numgenes;
+  GtUword nummrnas;
+};
+typedef struct AgnLocusIndexEntry AgnLocusIndexEntry;
+
+/**
+ * @function Class destructor.
+ */
+void agn_locus_index_delete(AgnLocusIndex *index);
+
+/**
+ * @function Store a description of iLocus number ``i`` (between 0 and
+ * :c:func:`agn_locus_index_num_loci` - 1) in ``entry``.
+ */
+void agn_locus_index_get(AgnLocusIndex *index, GtUword i,
+                         AgnLocusIndexEntry *entry);
+
+/**
+ * @function Add the number of each iLocus containing a gene or mRNA with the
+ * given ID (or label, see :c:func:`agn_feature_node_get_label`) to ``loci``.
+ */
+void agn_locus_index_lookup_id(AgnLocusIndex *index, const char *id,
+                               GtArray *loci);
+
+/**
+ * @function Add the number of each iLocus of sequence ``seqid`` overlapping
+ * ``range`` to ``loci``, in order of position. Returns false if the sequence
+ * is not in the index.
+ */
+bool agn_locus_index_lookup_range(AgnLocusIndex *index, const char *seqid,
+                                  GtRange *range, GtArray *loci);
+
+/**
+ * @function Class constructor. Memory-maps the index file ``filename``.
+ * Returns NULL and sets ``error`` if the file cannot be opened or is not an
+ * iLocus index.
+ */
+AgnLocusIndex *agn_locus_index_new(const char *filename, GtError *error);
+
+/**
+ * @function The number of iLoci in the index.
+ */
+GtUword agn_locus_index_num_loci(AgnLocusIndex *index);
+
+/**
+ * @function Constructor for a node stream that passes its input through
+ * unchanged and writes an index of all ``locus`` features (with their genes
+ * and mRNAs still attached) to ``outstream`` once the input is exhausted.
+ * iLoci are labeled as with :c:func:`agn_feature_node_get_label`.
+ */
+GtNodeStream *agn_locus_index_stream_new(GtNodeStream *in, FILE *outstream);
+
+/**
+ * @function Run unit tests for this class. Returns true if all tests passed.
+ */
+bool agn_locus_index_unit_test(AgnUnitTest *test);
+
+#endif
@@ -11,6 +11,7 @@ online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
 #define AEGEAN_LOCUS_MAP_VISITOR
 
 #include "extended/node_stream_api.h"
+#include "AgnOutputSink.h"
 #include "AgnUnitTest.h"
 
 /**
@@ -28,14 +29,16 @@ typedef struct AgnLocusMapVisitor AgnLocusMapVisitor;
  * arguments.
  */
 GtNodeStream*
-agn_locus_map_stream_new(GtNodeStream *in, FILE *genefh, FILE *mrnafh);
+agn_locus_map_stream_new(GtNodeStream *in, AgnOutputSink *genemap,
+                         AgnOutputSink *mrnamap);
 
 /**
  * @function Constructor for the node visitor. Gene-to-locus relationships are
- * printed to the ``genefh`` file handle, while mRNA-to-locus relationships are
- * printed to the ``mrnafh`` file handle. Setting either file handle to NULL
- * will disable printing the corresponding output.
+ * written to the ``genemap`` sink, while mRNA-to-locus relationships are
+ * written to the ``mrnamap`` sink. Setting either sink to NULL will disable
+ * the corresponding output.
  */
-GtNodeVisitor *agn_locus_map_visitor_new(FILE *genefh, FILE *mrnafh);
+GtNodeVisitor *agn_locus_map_visitor_new(AgnOutputSink *genemap,
+                                         AgnOutputSink *mrnamap);
 
 #endif
@@ -0,0 +1,93 @@
+/**
+
+Copyright (c) 2010-2016, Daniel S. Standage and CONTRIBUTORS
+
+The AEGeAn Toolkit is distributed under the ISC License. See
+the 'LICENSE' file in the AEGeAn source code distribution or
+online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
+
+**/
+
+#ifndef AEGEAN_LOCUS_PARALLEL_STREAM
+#define AEGEAN_LOCUS_PARALLEL_STREAM
+
+#include "extended/node_stream_api.h"
+#include "AgnILocusCache.h"
+#include "AgnOutputSink.h"
+#include "AgnUnitTest.h"
+
+/**
+ * @class AgnLocusParallelStream
+ *
+ * Implements the GenomeTools ``GtNodeStream`` interface. This stream computes
+ * the same iLoci as an :c:type:`AgnLocusStream` (optionally followed by an
+ * :c:type:`AgnLocusRefineStream`), but partitions its sorted input by sequence
+ * and parses the iLoci of each sequence in a separate pipeline, distributing
+ * the partitions across several threads. iLoci are delivered in the order of
+ * the input sequences and named with a single running count, so the output
+ * (including any iLocus lengths) is identical to that of the serial pipeline.
+ */
+typedef struct AgnLocusParallelStream AgnLocusParallelStream;
+
+/**
+ * @function Class constructor. Sequences are processed using ``numthreads``
+ * threads (including the calling thread); at most ``numthreads`` times a
+ * fixed number of sequences are buffered at any time. Input must be sorted.
+ */
+GtNodeStream *agn_locus_parallel_stream_new(GtNodeStream *in_stream,
+                                            GtUword delta,
+                                            GtUword numthreads);
+
+/**
+ * @function Refine the iLoci of each sequence as with an
+ * :c:type:`AgnLocusRefineStream` with the given settings.
+ */
+void agn_locus_parallel_stream_refine(AgnLocusParallelStream *stream,
+                                      GtUword minoverlap, bool by_cds);
+
+/**
+ * @function Reuse the iLoci of each sequence stored in ``cache`` by a previous
+ * run with the same settings if the sequence's features have not changed, and
+ * store the iLoci of each sequence that is processed.
+ */
+void agn_locus_parallel_stream_set_cache(AgnLocusParallelStream *stream,
+                                         AgnILocusCache *cache);
+
+/**
+ * @function See :c:func:`agn_locus_stream_set_endmode`.
+ */
+void agn_locus_parallel_stream_set_endmode(AgnLocusParallelStream *stream,
+                                           int endmode);
+
+/**
+ * @function Assign a `Name` attribute with a serial number to each iLocus
+ * using the specified printf-style format. Numbers run across all sequences.
+ */
+void agn_locus_parallel_stream_set_name_format(AgnLocusParallelStream *stream,
+                                               const char *format);
+
+/**
+ * @function Set the source value to be used for all iLoci created by this
+ * stream. Default value is 'AEGeAn::AgnLocusStream'.
+ */
+void agn_locus_parallel_stream_set_source(AgnLocusParallelStream *stream,
+                                          const char *source);
+
+/**
+ * @function See :c:func:`agn_locus_stream_skip_iiLoci`.
+ */
+void agn_locus_parallel_stream_skip_iiLoci(AgnLocusParallelStream *stream);
+
+/**
+ * @function Record the length of each intergenic iLocus. Lengths for each
+ * sequence are buffered until its iLoci are delivered.
+ */
+void agn_locus_parallel_stream_track_ilens(AgnLocusParallelStream *stream,
+                                           AgnOutputSink *ilens);
+
+/**
+ * @function Run unit tests for this class. Returns true if all tests passed.
+ */
+bool agn_locus_parallel_stream_unit_test(AgnUnitTest *test);
+
+#endif
@@ -12,6 +12,7 @@ online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
 #define AEGEAN_LOCUS_REFINE_STREAM
 
 #include "extended/node_stream_api.h"
+#include "AgnOutputSink.h"
 #include "AgnUnitTest.h"
 
 /**
@@ -27,6 +28,14 @@ online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
  */
 typedef struct AgnLocusRefineStream AgnLocusRefineStream;
 
+/**
+ * @function Bin the genes of synthetic iLoci holding 250 to 2000 genes, once
+ * with union-find and once by comparing each gene with the genes of the
+ * current bin, as was done before. Both times are printed. Returns false if
+ * the two disagree on any bin.
+ */
+bool agn_locus_refine_stream_benchmark(AgnUnitTest *test);
+
 /**
  * @function Class constructor.
  */
@@ -53,7 +62,7 @@ void agn_locus_refine_stream_set_source(AgnLocusRefineStream *stream,
  * parsed.
  */
 void agn_locus_refine_stream_track_ilens(AgnLocusRefineStream *stream,
-                                         FILE *ilenfile);
+                                         AgnOutputSink *ilens);
 
 /**
  * @function Run unit tests for this class. Returns true if all tests passed.
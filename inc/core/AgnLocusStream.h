@@ -13,6 +13,7 @@ online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
 
 #include "core/logger_api.h"
 #include "extended/node_stream_api.h"
+#include "AgnOutputSink.h"
 #include "AgnUnitTest.h"
 
 /**
@@ -26,6 +27,25 @@ online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
 typedef struct AgnLocusStream AgnLocusStream;
 
 
+/**
+ * @function Group synthetic chains of up to 100,000 genes, in which each gene
+ * overlaps only its neighbors, into loci. Checks that each chain yields the
+ * expected loci, and on chains small enough for the quadratic all-pairs check
+ * also reports its time and checks that it finds the same loci.
+ */
+bool agn_locus_stream_benchmark(AgnUnitTest *test);
+
+/**
+ * @function Like :c:func:`agn_locus_stream_label_pairwise`, but for comparing
+ * a single reference against ``numpredfiles`` sets of predictions. Loci are
+ * built over all of the inputs, and each prediction feature is also labeled
+ * with the index of its file in ``predfiles`` (see
+ * :c:func:`agn_locus_get_pred_set`).
+ */
+void agn_locus_stream_label_multi(AgnLocusStream *stream,
+                                  const char *refrfile, GtUword numpredfiles,
+                                  const char **predfiles);
+
 /**
  * @function Use the given filenames to label the direct children of each iLocus
  * as a 'reference' feature or a 'prediction' feature, to facilitate pairwise
@@ -39,7 +59,9 @@ void agn_locus_stream_label_pairwise(AgnLocusStream *stream,
  * @function Calculate iLoci from a node stream which may or may not include
  * data from multiple sources. Extend each iLocus boundary as far as possible
  * without overlapping a gene from another iLocus, or by `delta` nucleotides,
- * whichever is shorter.
+ * whichever is shorter. A sequence declared with a region node but containing
+ * no features is reported as a single terminal iLocus spanning the whole
+ * sequence, marked with ``unannot=true``.
  */
 GtNodeStream *agn_locus_stream_new(GtNodeStream *in_stream, GtUword delta);
 
@@ -74,7 +96,8 @@ void agn_locus_stream_set_source(AgnLocusStream *stream, const char *source);
  * @function Record the length of each intergenic iLocus as loci are being
  * parsed.
  */
-void agn_locus_stream_track_ilens(AgnLocusStream *stream, FILE *ilenfile);
+void agn_locus_stream_track_ilens(AgnLocusStream *stream,
+                                  AgnOutputSink *ilens);
 
 /**
  * @function Run unit tests for this class. Returns true if all tests passed.
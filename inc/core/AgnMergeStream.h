@@ -0,0 +1,51 @@
+/**
+
+Copyright (c) 2010-2014, Daniel S. Standage and CONTRIBUTORS
+
+The AEGeAn Toolkit is distributed under the ISC License. See
+the 'LICENSE' file in the AEGeAn source code distribution or
+online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
+
+**/
+
+#ifndef AEGEAN_MERGE_STREAM
+#define AEGEAN_MERGE_STREAM
+
+#include "extended/node_stream_api.h"
+#include "core/array_api.h"
+#include "AgnUnitTest.h"
+
+/**
+ * @class AgnMergeStream
+ *
+ * Implements the GenomeTools ``GtNodeStream`` interface. This is a node stream
+ * that merges several node streams, each already sorted by sequence ID and
+ * start position (as with ``gt gff3 -sort``), into a single sorted stream.
+ * Unlike ``GtSortStream``, it holds only one node per input stream at a time.
+ * The order of each input is verified as nodes are pulled through, and an
+ * error is raised as soon as a feature is found out of order. Nodes other than
+ * features (such as sequence regions) are passed through as soon as they are
+ * encountered.
+ */
+typedef struct AgnMergeStream AgnMergeStream;
+
+/**
+ * @function Class constructor. ``in_streams`` is an array of ``GtNodeStream``
+ * pointers; ties between input streams go to the stream that comes first in
+ * the array. A single input stream can be given to simply verify its order.
+ */
+GtNodeStream* agn_merge_stream_new(GtArray *in_streams);
+
+/**
+ * @function Class constructor that reads the given pre-sorted GFF3 files. ID
+ * attributes are checked and tidy mode is enabled, as is done elsewhere for
+ * ``GtGFF3InStream``. If ``numfiles`` is 0, data is read from standard input.
+ */
+GtNodeStream* agn_merge_stream_new_gff3(int numfiles, const char **filenames);
+
+/**
+ * @function Run unit tests for this class. Returns true if all tests passed.
+ */
+bool agn_merge_stream_unit_test(AgnUnitTest *test);
+
+#endif
@@ -0,0 +1,50 @@
+/**
+
+Copyright (c) 2010-2016, Daniel S. Standage and CONTRIBUTORS
+
+The AEGeAn Toolkit is distributed under the ISC License. See
+the 'LICENSE' file in the AEGeAn source code distribution or
+online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
+
+**/
+
+#ifndef AEGEAN_MILOCUS_STREAM
+#define AEGEAN_MILOCUS_STREAM
+
+#include "extended/node_stream_api.h"
+#include "AgnUnitTest.h"
+
+/**
+ * @class AgnMiLocusStream
+ *
+ * Implements the GenomeTools ``GtNodeStream`` interface. This stream takes
+ * refined iLoci (as produced by :c:type:`AgnLocusRefineStream`) and merges each
+ * run of adjacent or overlapping gene-containing iLoci (siLoci and niLoci,
+ * excluding genes nested in an intron) on the same sequence into a single
+ * merged iLocus (miLocus), as the ``miloci.py`` script does. A miLocus spans
+ * all of the iLoci it replaces and adopts all of their genes; its score is
+ * the number of iLoci merged and its attributes are ``iLocus_type=miLocus``
+ * followed by the sums of the numeric attributes of the merged iLoci (other
+ * than ``left_overlap`` and ``right_overlap``), sorted by key. All other
+ * iLoci are passed through unchanged.
+ */
+typedef struct AgnMiLocusStream AgnMiLocusStream;
+
+/**
+ * @function Class constructor.
+ */
+GtNodeStream *agn_milocus_stream_new(GtNodeStream *in_stream);
+
+/**
+ * @function Assign a `Name` attribute with a serial number to each iLocus
+ * (merged or not) using the specified printf-style format.
+ */
+void agn_milocus_stream_set_name_format(AgnMiLocusStream *stream,
+                                        const char *format);
+
+/**
+ * @function Run unit tests for this class. Returns true if all tests passed.
+ */
+bool agn_milocus_stream_unit_test(AgnUnitTest *test);
+
+#endif
@@ -0,0 +1,106 @@
+/**
+
+Copyright (c) 2010-2016, Daniel S. Standage and CONTRIBUTORS
+
+The AEGeAn Toolkit is distributed under the ISC License. See
+the 'LICENSE' file in the AEGeAn source code distribution or
+online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
+
+**/
+
+#ifndef AEGEAN_OUTPUT_SINK
+#define AEGEAN_OUTPUT_SINK
+
+#include "genometools.h"
+#include "AgnUnitTest.h"
+
+/**
+ * @class AgnOutputSink
+ *
+ * Buffered writer for tabular side outputs (such as iLocus lengths and
+ * gene-to-locus maps) that may run to millions of rows. Text is collected in a
+ * large buffer, with integers formatted directly into it rather than through
+ * ``printf``. A file sink hands each full buffer to a background thread that
+ * writes it (compressing it with gzip if the file name ends in ``.gz``), so
+ * the thread producing the rows is never blocked in I/O unless several
+ * buffers are waiting to be written. A memory sink keeps all of its text,
+ * which can be retrieved or appended to another sink. A sink must only be
+ * written to by one thread at a time.
+ */
+typedef struct AgnOutputSink AgnOutputSink;
+
+/**
+ * @function Write one and five million gene-to-locus map rows to temporary
+ * files, once with ``fprintf`` and once through a file sink, and print the
+ * throughput of each. Returns true if the sink wrote byte-for-byte the same
+ * file.
+ */
+bool agn_output_sink_benchmark(AgnUnitTest *test);
+
+/**
+ * @function Append the entire contents of the memory sink ``source`` to
+ * ``sink``.
+ */
+void agn_output_sink_append(AgnOutputSink *sink, AgnOutputSink *source);
+
+/**
+ * @function Write a single character.
+ */
+void agn_output_sink_char(AgnOutputSink *sink, char c);
+
+/**
+ * @function Write a null-terminated string.
+ */
+void agn_output_sink_cstr(AgnOutputSink *sink, const char *cstr);
+
+/**
+ * @function Class destructor. For a file sink, all remaining text is written
+ * and the file is closed.
+ */
+void agn_output_sink_delete(AgnOutputSink *sink);
+
+/**
+ * @function Return the text written to a memory sink so far. The text is not
+ * null-terminated; see :c:func:`agn_output_sink_length`.
+ */
+const char *agn_output_sink_get(AgnOutputSink *sink);
+
+/**
+ * @function Return the number of bytes written to a memory sink so far.
+ */
+GtUword agn_output_sink_length(AgnOutputSink *sink);
+
+/**
+ * @function Class constructor for a sink writing to the file ``filename``,
+ * gzip-compressed if the name ends in ``.gz``. Returns NULL and sets
+ * ``error`` if the file cannot be opened.
+ */
+AgnOutputSink *agn_output_sink_new(const char *filename, GtError *error);
+
+/**
+ * @function Class constructor for a sink that keeps its text in memory.
+ */
+AgnOutputSink *agn_output_sink_new_memory();
+
+/**
+ * @function Write the contents of ``str``.
+ */
+void agn_output_sink_str(AgnOutputSink *sink, GtStr *str);
+
+/**
+ * @function Run unit tests for this class. Returns true if all tests passed.
+ */
+bool agn_output_sink_unit_test(AgnUnitTest *test);
+
+/**
+ * @function Write a non-negative integer in decimal notation.
+ */
+void agn_output_sink_uword(AgnOutputSink *sink, GtUword value);
+
+/**
+ * @function Write ``length`` bytes of ``data``.
+ */
+void agn_output_sink_write(AgnOutputSink *sink, const void *data,
+                           GtUword length);
+
+#endif
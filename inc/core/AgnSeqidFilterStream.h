@@ -0,0 +1,57 @@
+/**
+
+Copyright (c) 2010-2014, Daniel S. Standage and CONTRIBUTORS
+
+The AEGeAn Toolkit is distributed under the ISC License. See
+the 'LICENSE' file in the AEGeAn source code distribution or
+online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
+
+**/
+
+#ifndef AEGEAN_SEQID_FILTER_STREAM
+#define AEGEAN_SEQID_FILTER_STREAM
+
+#include "extended/node_stream_api.h"
+#include "AgnUnitTest.h"
+
+/**
+ * @class AgnSeqidFilterStream
+ *
+ * Implements the GenomeTools ``GtNodeStream`` interface. This is a node stream
+ * used to select a subset of the sequences in a node stream, so that a large
+ * data set can be split across several processes. Sequences can be selected by
+ * name, by shard (see :c:func:`agn_seqid_filter_stream_set_shard`), or both
+ * (in which case a sequence must satisfy both criteria to be kept). Feature
+ * nodes and region nodes on any other sequence are discarded; all other nodes
+ * are passed through unchanged.
+ */
+typedef struct AgnSeqidFilterStream AgnSeqidFilterStream;
+
+/**
+ * @function Keep all features on the sequence ``seqid``. Can be called any
+ * number of times.
+ */
+void agn_seqid_filter_stream_keep(AgnSeqidFilterStream *stream,
+                                  const char *seqid);
+
+/**
+ * @function Class constructor. Until one of the selection functions is called,
+ * all nodes are passed through.
+ */
+GtNodeStream* agn_seqid_filter_stream_new(GtNodeStream *in_stream);
+
+/**
+ * @function Keep only the sequences belonging to shard ``shard`` of
+ * ``numshards`` (numbered from 1). Sequences are assigned to shards by a hash
+ * of the sequence ID, so each sequence belongs to exactly one shard and the
+ * assignment is the same for every input file and every run.
+ */
+void agn_seqid_filter_stream_set_shard(AgnSeqidFilterStream *stream,
+                                       GtUword shard, GtUword numshards);
+
+/**
+ * @function Run unit tests for this class. Returns true if all tests passed.
+ */
+bool agn_seqid_filter_stream_unit_test(AgnUnitTest *test);
+
+#endif
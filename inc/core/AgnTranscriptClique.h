@@ -27,6 +27,37 @@ online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
  */
 typedef GtGenomeNode AgnTranscriptClique;
 
+/**
+ * @type A maximal run of identically labeled nucleotides in a transcript
+ * clique's model. ``start`` and ``end`` are 0-based offsets (inclusive)
+ * relative to the start of the clique's locus, and ``type`` is one of ``C``
+ * (coding sequence), ``F`` (5' UTR), ``T`` (3' UTR), or ``I`` (intron).
+ * Nucleotides not covered by any segment are intergenic. Each clique stores its
+ * model as a sorted array of non-overlapping segments, so that the memory and
+ * time required for comparisons scale with the number of segments rather than
+ * the length of the locus.
+ */
+typedef struct
+{
+  GtUword start;
+  GtUword end;
+  char type;
+} AgnModelSegment;
+
+/**
+ * @type Coarse summary of a transcript clique's model, derived from its
+ * segments. ``cds_length`` and ``utr_length`` are the number of coding and UTR
+ * nucleotides, and ``num_cds`` and ``num_exons`` are the number of maximal runs
+ * of coding and exonic (coding or UTR) nucleotides, respectively.
+ */
+typedef struct
+{
+  GtUword cds_length;
+  GtUword utr_length;
+  GtUword num_cds;
+  GtUword num_exons;
+} AgnModelSummary;
+
 /**
  * @functype
  * The signature that functions must match to be applied to each transcript in
@@ -60,9 +91,26 @@ AgnTranscriptClique* agn_transcript_clique_copy(AgnTranscriptClique *clique);
  */
 void agn_transcript_clique_delete(AgnTranscriptClique *clique);
 
+/**
+ * @function Get the sorted array of :c:type:`AgnModelSegment` objects
+ * representing this clique's transcript structure. The array belongs to the
+ * clique and must not be modified or deleted by the caller.
+ */
+GtArray *agn_transcript_clique_get_model_segments(AgnTranscriptClique *clique);
+
+/**
+ * @function Summarize this clique's model segments (see
+ * :c:type:`AgnModelSummary`).
+ */
+void agn_transcript_clique_get_model_summary(AgnTranscriptClique *clique,
+                                             AgnModelSummary *summary);
+
 /**
  * @function Get a pointer to the string representing this clique's transcript
- * structure.
+ * structure, with one character per nucleotide of the locus (``G`` for
+ * intergenic, otherwise as described for :c:type:`AgnModelSegment`). The string
+ * is built on demand from the model segments and cached with the clique; it is
+ * intended for debugging and validation only.
  */
 const char *agn_transcript_clique_get_model_vector(AgnTranscriptClique *clique);
 
@@ -0,0 +1,60 @@
+/**
+
+Copyright (c) 2010-2016, Daniel S. Standage and CONTRIBUTORS
+
+The AEGeAn Toolkit is distributed under the ISC License. See
+the 'LICENSE' file in the AEGeAn source code distribution or
+online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
+
+**/
+
+#ifndef AEGEAN_TYPE_COUNTER
+#define AEGEAN_TYPE_COUNTER
+
+#include "genometools.h"
+#include "AgnUnitTest.h"
+
+/**
+ * @class AgnTypeCounter
+ *
+ * Tallies the feature types of the children and grandchildren of a feature and
+ * stores the tallies as ``child_<type>`` attributes, as is done for each
+ * (i)Locus. Feature types are interned by GenomeTools, so types are matched by
+ * pointer. The table of types and counters is kept and reused from one feature
+ * to the next, so once every type has been seen the only memory allocated is
+ * for the iterators over the children and for the attributes themselves.
+ */
+typedef struct AgnTypeCounter AgnTypeCounter;
+
+/**
+ * @function Time the tallying of child types on synthetic loci, and check the
+ * tallies and the number of calls per locus to functions that always allocate
+ * memory (one iterator for the locus and one for each gene, plus one key per
+ * type the first time it is seen). Returns true if all tests passed.
+ */
+bool agn_type_counter_benchmark(AgnUnitTest *test);
+
+/**
+ * @function Tally the types of the direct children and grandchildren of
+ * ``fn`` and set the corresponding ``child_<type>`` attributes of ``fn``, in
+ * the order in which the types were first encountered.
+ */
+void agn_type_counter_count_children(AgnTypeCounter *counter,
+                                     GtFeatureNode *fn);
+
+/**
+ * @function Class destructor.
+ */
+void agn_type_counter_delete(AgnTypeCounter *counter);
+
+/**
+ * @function Class constructor.
+ */
+AgnTypeCounter *agn_type_counter_new(void);
+
+/**
+ * @function Run unit tests for this class. Returns true if all tests passed.
+ */
+bool agn_type_counter_unit_test(AgnUnitTest *test);
+
+#endif
@@ -35,6 +35,21 @@ struct AgnSequenceRegion
 };
 typedef struct AgnSequenceRegion AgnSequenceRegion;
 
+/**
+ * @type Structural summary of a feature (such as a gene), computed with a
+ * single traversal of the feature and its subfeatures: the feature's range,
+ * the range occupied by coding sequence ({0,0} if there is none), whether it
+ * has any coding sequence, and the number of exons it contains.
+ */
+struct AgnFeatureSummary
+{
+  GtRange range;
+  GtRange cds;
+  bool has_cds;
+  GtUword num_exons;
+};
+typedef struct AgnFeatureSummary AgnFeatureSummary;
+
 #ifndef NDEBUG
 /* Stolen shamelessley from gt_assert() */
 #define agn_assert(expression)                                               \
@@ -109,6 +124,15 @@ GtArray *agn_feature_node_get_children(GtFeatureNode *fn);
  */
 const char *agn_feature_node_get_label(GtFeatureNode *fn);
 
+/**
+ * @function Store the structural summary of the given feature in ``summary``.
+ * If the summary was stored with the feature by
+ * :c:func:`agn_feature_node_summarize`, it is simply copied; otherwise the
+ * feature and its subfeatures are traversed.
+ */
+void agn_feature_node_get_summary(GtFeatureNode *fn,
+                                  AgnFeatureSummary *summary);
+
 /**
  * @function Remove feature ``fn`` and all its subfeatures from ``root``.
  * Analogous to ``gt_feature_node_remove_leaf`` with the difference that ``fn``
@@ -116,6 +140,14 @@ const char *agn_feature_node_get_label(GtFeatureNode *fn);
  */
 void agn_feature_node_remove_tree(GtFeatureNode *root, GtFeatureNode *fn);
 
+/**
+ * @function Compute the structural summary of the given feature and store it
+ * with the feature, so that :c:func:`agn_feature_node_get_summary` (and thus
+ * :c:func:`agn_overlap_ilocus`) no longer traverses its subfeatures. The
+ * summary is not updated if the subfeatures change afterwards.
+ */
+void agn_feature_node_summarize(GtFeatureNode *fn);
+
 /**
  * @function Returns true if any of the features in ``feats`` overlaps, false
  * otherwise.
@@ -154,7 +186,8 @@ GtRange agn_multi_child_range(GtFeatureNode *top, GtFeatureNode *rep);
  * @function Determine if two features overlap such that they should be
  * assigned to the same iLocus. Specify the minimum overlap (in bp) required
  * and whether the location of the feature's coding sequence (CDS) should be
- * used or not.
+ * used or not. Uses the structural summary of each feature (see
+ * :c:func:`agn_feature_node_summarize`) if available.
  */
 bool agn_overlap_ilocus(GtGenomeNode *f1, GtGenomeNode *f2,
                         GtUword minoverlap, bool by_cds);
@@ -183,4 +216,31 @@ int agn_string_compare(const void *p1, const void *p2);
  */
 GtStrArray* agn_str_array_union(GtStrArray *a1, GtStrArray *a2);
 
+/**
+ * @function Read a string written by :c:func:`agn_str_write` from
+ * ``instream``, replacing the contents of ``str``. Returns false if the string
+ * could not be read.
+ */
+bool agn_str_read(FILE *instream, GtStr *str);
+
+/**
+ * @function Write the string ``str`` to ``outstream`` in binary format: its
+ * length (see :c:func:`agn_uword_write`) followed by its characters. Returns
+ * false on a write error.
+ */
+bool agn_str_write(FILE *outstream, const char *str);
+
+/**
+ * @function Read an unsigned integer written by :c:func:`agn_uword_write` from
+ * ``instream``. Returns false if the value could not be read.
+ */
+bool agn_uword_read(FILE *instream, GtUword *value);
+
+/**
+ * @function Write an unsigned integer to ``outstream`` as 8 little-endian
+ * bytes, so that binary output can be read on any platform. Returns false on a
+ * write error.
+ */
+bool agn_uword_write(FILE *outstream, GtUword value);
+
 #endif
@@ -12,23 +12,33 @@ online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
 #include "AgnCliquePair.h"
 #include "AgnCompareReportHTML.h"
 #include "AgnCompareReportText.h"
+#include "AgnCompareStream.h"
 #include "AgnComparison.h"
 #include "AgnFilterStream.h"
 #include "AgnGeneStream.h"
 #include "AgnIdFilterStream.h"
+#include "AgnILocusCache.h"
 #include "AgnInferCDSVisitor.h"
 #include "AgnInferExonsVisitor.h"
 #include "AgnInferParentStream.h"
 #include "AgnLocus.h"
+#include "AgnLocusCache.h"
 #include "AgnLocusFilterStream.h"
+#include "AgnLocusIndex.h"
 #include "AgnLocusMapVisitor.h"
+#include "AgnLocusParallelStream.h"
 #include "AgnLocusRefineStream.h"
 #include "AgnLocusStream.h"
+#include "AgnMergeStream.h"
+#include "AgnMiLocusStream.h"
 #include "AgnMrnaRepVisitor.h"
+#include "AgnOutputSink.h"
 #include "AgnPseudogeneFixVisitor.h"
 #include "AgnRemoveChildrenVisitor.h"
+#include "AgnSeqidFilterStream.h"
 #include "AgnTranscriptClique.h"
 #include "AgnTypecheck.h"
+#include "AgnTypeCounter.h"
 #include "AgnUnitTest.h"
 #include "AgnUtils.h"
 #include "AgnVersion.h"
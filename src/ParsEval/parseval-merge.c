@@ -0,0 +1,172 @@
+/**
+
+Copyright (c) 2010-2014, Daniel S. Standage and CONTRIBUTORS
+
+The AEGeAn Toolkit is distributed under the ISC License. See
+the 'LICENSE' file in the AEGeAn source code distribution or
+online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
+
+**/
+#include "pe_options.h"
+#include "pe_utils.h"
+
+static void print_usage(FILE *outstream)
+{
+  fprintf(outstream,
+"\nparseval-merge: combine partial ParsEval results into a single summary\n"
+"Usage: parseval-merge [options] partial1.dat partial2.dat ...\n"
+"  Options:\n"
+"    -h|--help:                  Print help message and exit\n"
+"    -o|--outfile: FILENAME      File to which the summary will be written;\n"
+"                                default is the terminal (STDOUT)\n"
+"    -v|--version:               Print version number and exit\n"
+"    -w|--overwrite:             Force overwrite of an existing output file\n\n"
+"  Each input file is created with the '-P|--partial' option of ParsEval,\n"
+"  typically by running ParsEval once for each shard ('-n|--shard i/N') of\n"
+"  the sequences. The summary is identical to that of a single ParsEval run\n"
+"  over all of the sequences.\n\n");
+}
+
+int main(int argc, char **argv)
+{
+  GtError *error;
+  GtNodeVisitor *rpt;
+  GtStr *refrlabel, *predlabel, *label1, *label2;
+  ParsEvalOptions options;
+  FILE *outfile = stdout;
+  bool overwrite = false;
+  char *start_time;
+  int opt, i;
+
+  gt_lib_init();
+  start_time = pe_get_start_time();
+
+  const char *optstr = "ho:vw";
+  const struct option merge_options[] =
+  {
+    { "help",      no_argument,       NULL, 'h' },
+    { "outfile",   required_argument, NULL, 'o' },
+    { "version",   no_argument,       NULL, 'v' },
+    { "overwrite", no_argument,       NULL, 'w' },
+    { NULL,        no_argument,       NULL,  0  },
+  };
+  const char *outfilename = NULL;
+  const char *errfile = NULL;
+  for(opt  = getopt_long(argc, argv, optstr, merge_options, NULL);
+      opt != -1;
+      opt  = getopt_long(argc, argv, optstr, merge_options, NULL))
+  {
+    if(opt == 'h')
+    {
+      print_usage(stdout);
+      return 0;
+    }
+    else if(opt == 'o')
+      outfilename = optarg;
+    else if(opt == 'v')
+    {
+      agn_print_version("parseval-merge", stdout);
+      return 0;
+    }
+    else if(opt == 'w')
+      overwrite = true;
+    else
+    {
+      print_usage(stderr);
+      return 1;
+    }
+  }
+  if(argc - optind < 1)
+  {
+    print_usage(stderr);
+    fputs("error: must provide at least one partial results file\n", stderr);
+    return 1;
+  }
+  if(outfilename != NULL)
+  {
+    FILE *test = fopen(outfilename, "r");
+    if(test != NULL && !overwrite)
+    {
+      fclose(test);
+      fprintf(stderr, "error: outfile '%s' exists; use '-w' to force "
+              "overwrite\n", outfilename);
+      return 1;
+    }
+    if(test != NULL)
+      fclose(test);
+    outfile = fopen(outfilename, "w");
+    if(outfile == NULL)
+    {
+      fprintf(stderr, "error: cannot open output file '%s'\n", outfilename);
+      return 1;
+    }
+  }
+
+  error = gt_error_new();
+  rpt = agn_compare_report_text_new(NULL, false, NULL);
+  refrlabel = gt_str_new();
+  predlabel = gt_str_new();
+  label1 = gt_str_new();
+  label2 = gt_str_new();
+  for(i = optind; i < argc && !gt_error_is_set(error); i++)
+  {
+    FILE *instream = fopen(argv[i], "rb");
+    if(instream == NULL)
+    {
+      gt_error_set(error, "cannot open partial results file '%s'", argv[i]);
+      break;
+    }
+    if(pe_partial_read((AgnCompareReportText *)rpt, instream, label1, label2,
+                       error))
+    {
+      if(i == optind)
+      {
+        gt_str_append_str(refrlabel, label1);
+        gt_str_append_str(predlabel, label2);
+      }
+      else if(gt_str_cmp(refrlabel, label1) != 0 ||
+              gt_str_cmp(predlabel, label2) != 0)
+      {
+        gt_error_set(error, "partial results file '%s' compares '%s' vs '%s', "
+                     "expected '%s' vs '%s'", argv[i], gt_str_get(label1),
+                     gt_str_get(label2), gt_str_get(refrlabel),
+                     gt_str_get(predlabel));
+      }
+    }
+    else
+      errfile = argv[i];
+    fclose(instream);
+  }
+
+  int status = 0;
+  if(gt_error_is_set(error))
+  {
+    fprintf(stderr, "[parseval-merge] error: %s", gt_error_get(error));
+    if(errfile != NULL)
+      fprintf(stderr, " (file '%s')", errfile);
+    fputs("\n", stderr);
+    status = 1;
+  }
+  else
+  {
+    pe_set_option_defaults(&options);
+    options.refrlabel = gt_str_get(refrlabel);
+    options.predlabel = gt_str_get(predlabel);
+    pe_summary_header(&options, outfile, start_time, argc, argv);
+    agn_compare_report_text_create_summary((AgnCompareReportText *)rpt,
+                                           outfile);
+    gt_array_delete(options.filters);
+  }
+
+  if(outfile != stdout)
+    fclose(outfile);
+  gt_free(start_time);
+  gt_str_delete(refrlabel);
+  gt_str_delete(predlabel);
+  gt_str_delete(label1);
+  gt_str_delete(label2);
+  gt_node_visitor_delete(rpt);
+  gt_error_delete(error);
+  gt_lib_clean();
+  return status;
+}
@@ -16,9 +16,11 @@ int main(int argc, char **argv)
   GtLogger *logger;
   GtQueue *streams;
   GtNodeStream *current_stream, *last_stream;
-  GtNodeVisitor *rpt;
+  GtNodeVisitor *rpt = NULL;
+  GtArray *predrpts;
   PeHtmlOverviewData odata;
   char *start_time;
+  int status = 0;
 
   gt_lib_init();
   start_time = pe_get_start_time();
@@ -34,30 +36,62 @@ int main(int argc, char **argv)
     return 1;
   }
   int numfiles = argc - optind;
-  if(numfiles != 2)
+  if(numfiles < 2)
   {
-    fprintf(stderr, "[ParsEval] error: must provide two GFF3 files as input");
+    fprintf(stderr, "[ParsEval] error: must provide at least two GFF3 files "
+            "as input");
     pe_print_usage(stderr);
     return 1;
   }
 
   logger = gt_logger_new(true, "", stderr);
   streams = gt_queue_new();
+  predrpts = gt_array_new( sizeof(GtNodeVisitor *) );
 
 
   //----- Set up the node processing stream -----//
   //---------------------------------------------//
 
-  const char * infiles[] = { options.refrfile, options.predfile };
-  current_stream = gt_gff3_in_stream_new_unsorted(2, infiles);
-  gt_gff3_in_stream_check_id_attributes((GtGFF3InStream *)current_stream);
-  gt_gff3_in_stream_enable_tidy_mode((GtGFF3InStream *)current_stream);
-  gt_queue_add(streams, current_stream);
-  last_stream = current_stream;
+  const char **infiles = (const char **)argv + optind;
+  if(options.sorted)
+  {
+    current_stream = agn_merge_stream_new_gff3(numfiles, infiles);
+    gt_queue_add(streams, current_stream);
+    last_stream = current_stream;
+  }
+  else
+  {
+    current_stream = gt_gff3_in_stream_new_unsorted(numfiles, infiles);
+    gt_gff3_in_stream_check_id_attributes((GtGFF3InStream *)current_stream);
+    gt_gff3_in_stream_enable_tidy_mode((GtGFF3InStream *)current_stream);
+    gt_queue_add(streams, current_stream);
+    last_stream = current_stream;
+  }
 
-  current_stream = gt_sort_stream_new(last_stream);
-  gt_queue_add(streams, current_stream);
-  last_stream = current_stream;
+  // Sequences outside the selection are dropped as they are read, so that
+  // only the selected sequences are buffered for sorting
+  if(options.seqids != NULL || options.numshards > 0)
+  {
+    GtUword i;
+    current_stream = agn_seqid_filter_stream_new(last_stream);
+    AgnSeqidFilterStream *sfs = (AgnSeqidFilterStream *)current_stream;
+    for(i = 0; options.seqids && i < gt_str_array_size(options.seqids); i++)
+      agn_seqid_filter_stream_keep(sfs, gt_str_array_get(options.seqids, i));
+    if(options.numshards > 0)
+    {
+      agn_seqid_filter_stream_set_shard(sfs, options.shard,
+                                        options.numshards);
+    }
+    gt_queue_add(streams, current_stream);
+    last_stream = current_stream;
+  }
+
+  if(!options.sorted)
+  {
+    current_stream = gt_sort_stream_new(last_stream);
+    gt_queue_add(streams, current_stream);
+    last_stream = current_stream;
+  }
 
   current_stream = agn_gene_stream_new(last_stream, logger);
   gt_queue_add(streams, current_stream);
@@ -65,8 +99,17 @@ int main(int argc, char **argv)
 
   current_stream = agn_locus_stream_new(last_stream, options.delta);
   agn_locus_stream_skip_iiLoci((AgnLocusStream *)current_stream);
-  agn_locus_stream_label_pairwise((AgnLocusStream *)current_stream,
-                                  options.refrfile, options.predfile);
+  if(options.numpredfiles > 1)
+  {
+    agn_locus_stream_label_multi((AgnLocusStream *)current_stream,
+                                 options.refrfile, options.numpredfiles,
+                                 options.predfiles);
+  }
+  else
+  {
+    agn_locus_stream_label_pairwise((AgnLocusStream *)current_stream,
+                                    options.refrfile, options.predfile);
+  }
   gt_queue_add(streams, current_stream);
   last_stream = current_stream;
 
@@ -77,10 +120,45 @@ int main(int argc, char **argv)
     last_stream = current_stream;
   }
 
+  // With multiple prediction files, the compare stream makes sure each locus
+  // is analyzed for all prediction sets at once, sharing reference cliques
+  if(options.numthreads > 1 || options.cache != NULL ||
+     options.numpredfiles > 1)
+  {
+    current_stream = agn_compare_stream_new(last_stream, options.numthreads,
+                                            logger);
+    if(options.cache != NULL)
+    {
+      agn_compare_stream_set_cache((AgnCompareStream *)current_stream,
+                                   options.cache);
+    }
+    gt_queue_add(streams, current_stream);
+    last_stream = current_stream;
+  }
+
   switch(options.outfmt)
   {
     case TEXTMODE:
-      if(options.summary_only)
+      if(options.numpredfiles > 1)
+      {
+        GtUword i;
+        for(i = 0; i < options.numpredfiles; i++)
+        {
+          FILE *outstream = options.summary_only ? NULL
+                                                 : options.predoutfiles[i];
+          rpt = agn_compare_report_text_new(outstream, options.gff3, logger);
+          agn_compare_report_text_set_pred_set((AgnCompareReportText *)rpt, i);
+          gt_array_add(predrpts, rpt);
+          // The last report is added to the stream below like any other
+          if(i + 1 < options.numpredfiles)
+          {
+            current_stream = gt_visitor_stream_new(last_stream, rpt);
+            gt_queue_add(streams, current_stream);
+            last_stream = current_stream;
+          }
+        }
+      }
+      else if(options.summary_only)
         rpt = agn_compare_report_text_new(NULL, false, logger);
       else
         rpt = agn_compare_report_text_new(options.outfile,options.gff3,logger);
@@ -118,12 +196,41 @@ int main(int argc, char **argv)
   int result = gt_node_stream_pull(last_stream, error);
   if(result == -1)
     fprintf(stderr, "[ParsEval] error: %s", gt_error_get(error));
+  if(options.cache != NULL)
+  {
+    GtUword hits = agn_locus_cache_num_hits(options.cache);
+    GtUword misses = agn_locus_cache_num_misses(options.cache);
+    double reuse = hits + misses == 0 ? 0.0 : 100.0*hits / (hits + misses);
+    gt_logger_log(logger, "[ParsEval] locus cache: %lu hits, %lu misses "
+                  "(%.1f%% of loci reused)", hits, misses, reuse);
+  }
 
-  if(options.outfmt == TEXTMODE)
+  if(options.outfmt == TEXTMODE && options.numpredfiles > 1)
+  {
+    GtUword i;
+    for(i = 0; i < options.numpredfiles; i++)
+    {
+      GtNodeVisitor *predrpt = *(GtNodeVisitor **)gt_array_get(predrpts, i);
+      options.predlabel = options.predfiles[i];
+      if(options.predlabels != NULL)
+        options.predlabel = gt_str_array_get(options.predlabels, i);
+      pe_summary_header(&options, options.predoutfiles[i], start_time, argc,
+                        argv);
+      agn_compare_report_text_create_summary((AgnCompareReportText *)predrpt,
+                                             options.predoutfiles[i]);
+    }
+  }
+  else if(options.outfmt == TEXTMODE)
   {
     pe_summary_header(&options, options.outfile, start_time, argc, argv);
     agn_compare_report_text_create_summary((AgnCompareReportText *)rpt,
                                            options.outfile);
+    if(options.partialfile != NULL &&
+       !pe_partial_write(&options, (AgnCompareReportText *)rpt))
+    {
+      fprintf(stderr, "[ParsEval] error: could not write partial results\n");
+      status = 1;
+    }
   }
   else if(options.outfmt == HTMLMODE)
   {
@@ -152,8 +259,9 @@ int main(int argc, char **argv)
     gt_node_stream_delete(current_stream);
   }
   gt_queue_delete(streams);
+  gt_array_delete(predrpts);
   gt_logger_delete(logger);
   gt_error_delete(error);
   gt_lib_clean();
-  return 0;
+  return status;
 }
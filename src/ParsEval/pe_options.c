@@ -12,8 +12,22 @@ online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
 
 void pe_free_option_memory(ParsEvalOptions *options)
 {
+  GtUword i;
   fclose(options->outfile);
+  for(i = 0; options->predoutfiles && i < options->numpredfiles; i++)
+  {
+    if(options->predoutfiles[i] != stdout)
+      fclose(options->predoutfiles[i]);
+  }
+  gt_free(options->predoutfiles);
+  if(options->predlabels != NULL)
+    gt_str_array_delete(options->predlabels);
   gt_array_delete(options->filters);
+  if(options->seqids != NULL)
+    gt_str_array_delete(options->seqids);
+  if(options->partialfile != NULL)
+    fclose(options->partialfile);
+  agn_locus_cache_delete(options->cache);
 }
 
 int pe_parse_options(int argc, char **argv, ParsEvalOptions *options,
@@ -21,19 +35,25 @@ int pe_parse_options(int argc, char **argv, ParsEvalOptions *options,
 {
   int opt = 0;
   int optindex = 0;
-  const char *optstr = "a:df:ghkl:o:pr:st:Vvwx:y:";
+  const char *optstr = "a:c:df:ghi:j:kl:n:o:P:pr:Sst:Vvwx:y:";
   const struct option parseval_options[] =
   {
     { "datashare",  required_argument, NULL, 'a' },
+    { "cache",      required_argument, NULL, 'c' },
     { "debug",      no_argument,       NULL, 'd' },
     { "outformat",  required_argument, NULL, 'f' },
     { "printgff3",  no_argument,       NULL, 'g' },
     { "help",       no_argument,       NULL, 'h' },
+    { "seqids",     required_argument, NULL, 'i' },
+    { "threads",    required_argument, NULL, 'j' },
     { "makefilter", no_argument,       NULL, 'k' },
     { "delta",      required_argument, NULL, 'l' },
+    { "shard",      required_argument, NULL, 'n' },
     { "outfile",    required_argument, NULL, 'o' },
+    { "partial",    required_argument, NULL, 'P' },
     { "nopng",      no_argument,       NULL, 'p' },
     { "filterfile", required_argument, NULL, 'r' },
+    { "sorted",     no_argument,       NULL, 'S' },
     { "summary",    no_argument,       NULL, 's' },
     { "maxtrans",   required_argument, NULL, 't' },
     { "verbose",    no_argument,       NULL, 'V' },
@@ -52,6 +72,14 @@ int pe_parse_options(int argc, char **argv, ParsEvalOptions *options,
     {
       options->data_path = optarg;
     }
+    else if(opt == 'c')
+    {
+      if(options->cache != NULL)
+        agn_locus_cache_delete(options->cache);
+      options->cache = agn_locus_cache_new(optarg, error);
+      if(options->cache == NULL)
+        return -1;
+    }
     else if(opt == 'd')
     {
       options->debug = true;
@@ -78,6 +106,20 @@ int pe_parse_options(int argc, char **argv, ParsEvalOptions *options,
       pe_print_usage(stdout);
       exit(0);
     }
+    else if(opt == 'i')
+    {
+      const char *seqid = optarg;
+      if(options->seqids == NULL)
+        options->seqids = gt_str_array_new();
+      while(*seqid != '\0')
+      {
+        const char *comma = strchr(seqid, ',');
+        GtUword length = comma ? (GtUword)(comma - seqid) : strlen(seqid);
+        if(length > 0)
+          gt_str_array_add_cstr_nt(options->seqids, seqid, length);
+        seqid += comma ? length + 1 : length;
+      }
+    }
     else if(opt == 'k')
     {
       options->makefilter = true;
@@ -91,10 +133,40 @@ int pe_parse_options(int argc, char **argv, ParsEvalOptions *options,
         exit(1);
       }
     }
+    else if(opt == 'j')
+    {
+      if(sscanf(optarg, "%lu", &options->numthreads) != 1 ||
+         options->numthreads == 0)
+      {
+        fprintf(stderr, "error: could not convert threads '%s' to a positive "
+                "integer\n", optarg);
+        exit(1);
+      }
+    }
+    else if(opt == 'n')
+    {
+      if(sscanf(optarg, "%lu/%lu", &options->shard, &options->numshards) != 2 ||
+         options->shard == 0 || options->shard > options->numshards)
+      {
+        fprintf(stderr, "error: shard '%s' must be of the form 'i/N', where "
+                "1 <= i <= N\n", optarg);
+        exit(1);
+      }
+    }
     else if(opt == 'o')
     {
       options->outfilename = optarg;
     }
+    else if(opt == 'P')
+    {
+      options->partialfile = fopen(optarg, "wb");
+      if(options->partialfile == NULL)
+      {
+        gt_error_set(error, "unable to open partial results file '%s'",
+                     optarg);
+        return -1;
+      }
+    }
     else if(opt == 'p')
     {
       options->graphics = false;
@@ -110,6 +182,10 @@ int pe_parse_options(int argc, char **argv, ParsEvalOptions *options,
       agn_locus_filter_parse(filterfile, options->filters);
       fclose(filterfile);
     }
+    else if(opt == 'S')
+    {
+      options->sorted = true;
+    }
     else if(opt == 's')
     {
       options->summary_only = true;
@@ -180,11 +256,62 @@ int pe_parse_options(int argc, char **argv, ParsEvalOptions *options,
     gt_array_add(options->filters, filter);
   }
 
-  if(argc - optind != 2)
+  if(argc - optind < 2)
   {
     pe_print_usage(stderr);
-    fprintf(stderr, "error: must provide 2 (and only 2) input files, you "
-            "provided %d\n\n", argc - optind);
+    fprintf(stderr, "error: must provide a reference and at least one "
+            "prediction input file, you provided %d\n\n", argc - optind);
+    exit(1);
+  }
+  options->numpredfiles = argc - optind - 1;
+  options->predfiles = (const char **)argv + optind + 1;
+
+  if(options->numpredfiles > 1)
+  {
+    if(options->outfmt != TEXTMODE)
+    {
+      fprintf(stderr, "error: multiple prediction files can only be compared "
+              "in text output mode\n");
+      exit(1);
+    }
+    if(options->partialfile != NULL || options->cache != NULL)
+    {
+      fprintf(stderr, "error: partial results and the locus cache are not "
+              "supported when comparing multiple prediction files\n");
+      exit(1);
+    }
+    if(options->outfilename == NULL && !options->summary_only)
+    {
+      fprintf(stderr, "error: must provide an outfile when comparing "
+              "multiple prediction files, unless only printing summaries\n");
+      exit(1);
+    }
+    if(options->predlabel != NULL)
+    {
+      const char *label = options->predlabel;
+      options->predlabels = gt_str_array_new();
+      while(true)
+      {
+        const char *comma = strchr(label, ',');
+        GtUword length = comma ? (GtUword)(comma - label) : strlen(label);
+        gt_str_array_add_cstr_nt(options->predlabels, label, length);
+        if(comma == NULL)
+          break;
+        label = comma + 1;
+      }
+      if(gt_str_array_size(options->predlabels) != options->numpredfiles)
+      {
+        fprintf(stderr, "error: must provide one prediction label for each "
+                "of the %lu prediction files\n", options->numpredfiles);
+        exit(1);
+      }
+    }
+  }
+
+  if(options->outfmt != TEXTMODE && options->partialfile != NULL)
+  {
+    fprintf(stderr, "error: partial results can only be written in text "
+            "output mode\n");
     exit(1);
   }
 
@@ -222,6 +349,21 @@ int pe_parse_options(int argc, char **argv, ParsEvalOptions *options,
         }
       }
     }
+    else if(options->numpredfiles > 1)
+    {
+      GtUword i;
+      for(i = 0; i < options->numpredfiles; i++)
+      {
+        char filecmd[1024];
+        sprintf(filecmd, "test -f %s.%lu", options->outfilename, i + 1);
+        if(system(filecmd) == 0 && !options->overwrite)
+        {
+          fprintf(stderr, "error: outfile '%s.%lu' exists; use '-w' to force "
+                  "overwrite\n", options->outfilename, i + 1);
+          exit(1);
+        }
+      }
+    }
     else
     {
       char filecmd[1024];
@@ -278,6 +420,26 @@ int pe_parse_options(int argc, char **argv, ParsEvalOptions *options,
       options->graphics = false;
     }
   }
+  else if(options->numpredfiles > 1)
+  {
+    // Report on each prediction file separately: outfile.1, outfile.2, ...
+    GtUword i;
+    options->predoutfiles = gt_malloc(sizeof(FILE *) * options->numpredfiles);
+    for(i = 0; i < options->numpredfiles; i++)
+    {
+      char outname[1024];
+      options->predoutfiles[i] = stdout;
+      if(options->outfilename == NULL)
+        continue;
+      sprintf(outname, "%s.%lu", options->outfilename, i + 1);
+      options->predoutfiles[i] = fopen(outname, "w");
+      if(options->predoutfiles[i] == NULL)
+      {
+        fprintf(stderr, "error: cannot open output file '%s'\n", outname);
+        exit(1);
+      }
+    }
+  }
   else
   {
     if(options->outfilename)
@@ -293,7 +455,7 @@ int pe_parse_options(int argc, char **argv, ParsEvalOptions *options,
   }
 
   options->refrfile = argv[optind];
-  options->predfile = argv[optind + 1];
+  options->predfile = options->predfiles[0];
   if(options->outfmt != HTMLMODE && options->graphics)
     options->graphics = false;
 
@@ -315,11 +477,30 @@ void pe_print_usage(FILE *outstream)
   fprintf(outstream,
 "\nParsEval: comparative analysis of two alternative sources of annotation\n"
 "Usage: parseval [options] reference.gff3 prediction.gff3\n"
+"       parseval [options] reference.gff3 pred1.gff3 pred2.gff3 ...\n"
 "  Basic options:\n"
+"    -c|--cache: FILENAME        Reuse the results of previous runs stored in\n"
+"                                the given cache file (created if it does\n"
+"                                not exist) for loci whose annotations have\n"
+"                                not changed, and add new results to it; the\n"
+"                                file can be shared by any number of runs\n"
 "    -d|--debug:                 Print debugging messages\n"
 "    -h|--help:                  Print help message and exit\n"
+"    -i|--seqids: STRING         Only compare annotations on the given\n"
+"                                sequences (comma-separated list of IDs)\n"
+"    -j|--threads: INT           Number of threads to use for comparative\n"
+"                                analysis; default is 1\n"
 "    -l|--delta: INT             Extend gene loci by this many nucleotides;\n"
 "                                default is 0\n"
+"    -n|--shard: i/N             Split the sequences into N shards (of\n"
+"                                roughly equal number) and only compare\n"
+"                                annotations on the i-th shard; run once for\n"
+"                                each shard and combine the results with\n"
+"                                'parseval-merge'\n"
+"    -S|--sorted:                Input files are already sorted (as with\n"
+"                                'gt gff3 -sort'); merge them as they are\n"
+"                                read rather than loading them into memory,\n"
+"                                and fail on any feature out of order\n"
 "    -V|--verbose:               Print verbose warning messages\n"
 "    -v|--version:               Print version number and exit\n\n"
 "  Output options:\n"
@@ -334,14 +515,22 @@ void pe_print_usage(FILE *outstream)
 "    -g|--nogff3:                Do no print GFF3 output corresponding to each\n"
 "                                comparison\n"
 "    -o|--outfile: FILENAME      File/directory to which output will be\n"
-"                                written; default is the terminal (STDOUT)\n"
+"                                written; default is the terminal (STDOUT);\n"
+"                                with multiple prediction files, the report\n"
+"                                for the i-th file is written to FILENAME.i\n"
+"    -P|--partial: FILENAME      In text mode, also write the summary data in\n"
+"                                binary format to the given file, so that it\n"
+"                                can be combined with other runs (such as\n"
+"                                other shards) using 'parseval-merge'\n"
 "    -p|--nopng:                 In HTML output mode, skip generation of PNG\n"
 "                                graphics for each gene locus\n"
 "    -s|--summary:               Only print summary statistics, do not print\n"
 "                                individual comparisons\n"
 "    -w|--overwrite:             Force overwrite of any existing output files\n"
 "    -x|--refrlabel: STRING      Optional label for reference annotations\n"
-"    -y|--predlabel: STRING      Optional label for prediction annotations\n\n"
+"    -y|--predlabel: STRING      Optional label for prediction annotations;\n"
+"                                with multiple prediction files, a\n"
+"                                comma-separated list with one label per file\n\n"
 "  Filtering options:\n"
 "    -k|--makefilter             Create a default configuration file for\n"
 "                                filtering reported results and quit,\n"
@@ -367,6 +556,10 @@ void pe_set_option_defaults(ParsEvalOptions *options)
   options->predfile = NULL;
   options->refrlabel = NULL;
   options->predlabel = NULL;
+  options->numpredfiles = 0;
+  options->predfiles = NULL;
+  options->predlabels = NULL;
+  options->predoutfiles = NULL;
   options->outfmt = TEXTMODE;
   options->overwrite = false;
   options->data_path = AGN_DATA_PATH;
@@ -375,4 +568,11 @@ void pe_set_option_defaults(ParsEvalOptions *options)
   options->verbose = false;
   options->max_transcripts = 32;
   options->delta = 0;
+  options->numthreads = 1;
+  options->sorted = false;
+  options->seqids = NULL;
+  options->shard = 0;
+  options->numshards = 0;
+  options->partialfile = NULL;
+  options->cache = NULL;
 }
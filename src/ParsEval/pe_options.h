@@ -42,6 +42,10 @@ struct ParsEvalOptions
   const char *predfile;
   const char *refrlabel;
   const char *predlabel;
+  GtUword numpredfiles;
+  const char **predfiles;
+  GtStrArray *predlabels;
+  FILE **predoutfiles;
   PeOutFormat outfmt;
   bool overwrite;
   const char *data_path;
@@ -50,6 +54,13 @@ struct ParsEvalOptions
   bool verbose;
   int max_transcripts;
   GtUword delta;
+  GtUword numthreads;
+  bool sorted;
+  GtStrArray *seqids;
+  GtUword shard;
+  GtUword numshards;
+  FILE *partialfile;
+  AgnLocusCache *cache;
 };
 typedef struct ParsEvalOptions ParsEvalOptions;
 
@@ -13,6 +13,9 @@ online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
 #include "pe_options.h"
 #include "pe_utils.h"
 
+#define PE_PARTIAL_MAGIC   "AGNPEDAT"
+#define PE_PARTIAL_VERSION 1
+
 char *pe_get_start_time()
 {
   time_t start_time;
@@ -25,6 +28,46 @@ char *pe_get_start_time()
   return gt_cstr_dup(timestr);
 }
 
+bool pe_partial_read(AgnCompareReportText *rpt, FILE *instream,
+                     GtStr *refrlabel, GtStr *predlabel, GtError *error)
+{
+  char magic[8];
+  GtUword version;
+
+  gt_error_check(error);
+  if(fread(magic, 1, 8, instream) != 8 ||
+     strncmp(magic, PE_PARTIAL_MAGIC, 8) != 0)
+  {
+    gt_error_set(error, "not a ParsEval partial results file");
+    return false;
+  }
+  if(!agn_uword_read(instream, &version) || version != PE_PARTIAL_VERSION)
+  {
+    gt_error_set(error, "unsupported partial results version");
+    return false;
+  }
+  if(!agn_str_read(instream, refrlabel) || !agn_str_read(instream, predlabel))
+  {
+    gt_error_set(error, "truncated partial results file");
+    return false;
+  }
+  return agn_compare_report_text_read_data(rpt, instream, error);
+}
+
+bool pe_partial_write(ParsEvalOptions *options, AgnCompareReportText *rpt)
+{
+  const char *refrlabel = options->refrlabel ? options->refrlabel
+                                             : options->refrfile;
+  const char *predlabel = options->predlabel ? options->predlabel
+                                             : options->predfile;
+  FILE *outstream = options->partialfile;
+  return fwrite(PE_PARTIAL_MAGIC, 1, 8, outstream) == 8 &&
+         agn_uword_write(outstream, PE_PARTIAL_VERSION) &&
+         agn_str_write(outstream, refrlabel) &&
+         agn_str_write(outstream, predlabel) &&
+         agn_compare_report_text_write_data(rpt, outstream);
+}
+
 void pe_summary_html_overview(FILE *outstream, void *data)
 {
   int x;
@@ -24,6 +24,9 @@ struct PeHtmlOverviewData
 typedef struct PeHtmlOverviewData PeHtmlOverviewData;
 
 char *pe_get_start_time();
+bool pe_partial_read(AgnCompareReportText *rpt, FILE *instream,
+                     GtStr *refrlabel, GtStr *predlabel, GtError *error);
+bool pe_partial_write(ParsEvalOptions *options, AgnCompareReportText *rpt);
 void pe_summary_html_overview(FILE *outstream, void *data);
 void pe_summary_header(ParsEvalOptions *options, FILE *outstream,
                        char *start_time, int argc, char **argv);
@@ -17,6 +17,7 @@ typedef struct
   GtFile *outstream;
   GtStr *source;
   bool infer;
+  bool sorted;
 } CanonGFF3Options;
 
 static void print_usage(FILE *outstream)
@@ -29,6 +30,10 @@ static void print_usage(FILE *outstream)
 "                             feature on-they-fly\n"
 "     -o|--outfile: STRING    name of file to which GFF3 data will be\n"
 "                             written; default is terminal (stdout)\n"
+"     -S|--sorted             input files are already sorted (as with 'gt\n"
+"                             gff3 -sort'); merge them as they are read\n"
+"                             rather than loading them into memory, and fail\n"
+"                             on any feature out of order\n"
 "     -s|--source: STRING     reset the source of each feature to the given\n"
 "                             value\n"
 "     -v|--version            print version number and exit\n\n",
@@ -40,12 +45,13 @@ static void canon_gff3_parse_options(int argc, char * const *argv,
 {
   int opt = 0;
   int optindex = 0;
-  const char *optstr = "hio:s:v";
+  const char *optstr = "hio:Ss:v";
   const struct option init_options[] =
   {
     { "help",    no_argument,       NULL, 'h' },
     { "infer",   no_argument,       NULL, 'i' },
     { "outfile", required_argument, NULL, 'o' },
+    { "sorted",  no_argument,       NULL, 'S' },
     { "source",  required_argument, NULL, 's' },
     { "version", no_argument,       NULL, 'v' },
     { NULL,      no_argument,       NULL, 0 },
@@ -68,6 +74,8 @@ static void canon_gff3_parse_options(int argc, char * const *argv,
         gt_file_delete(options->outstream);
       options->outstream = gt_file_new(optarg, "w", error);
     }
+    else if(opt == 'S')
+      options->sorted = true;
     else if(opt == 's')
     {
       if(options->source != NULL)
@@ -89,7 +97,7 @@ int main(int argc, char * const *argv)
   GtLogger *logger;
   GtQueue *streams;
   GtNodeStream *stream, *last_stream;
-  CanonGFF3Options options = { NULL, NULL, false };
+  CanonGFF3Options options = { NULL, NULL, false, false };
 
   gt_lib_init();
   error = gt_error_new();
@@ -98,10 +106,18 @@ int main(int argc, char * const *argv)
   streams = gt_queue_new();
   logger = gt_logger_new(true, "", stderr);
 
-  stream = gt_gff3_in_stream_new_unsorted(argc - optind, (const char **)
-                                                          argv+optind);
-  gt_gff3_in_stream_check_id_attributes((GtGFF3InStream *)stream);
-  gt_gff3_in_stream_enable_tidy_mode((GtGFF3InStream *)stream);
+  if(options.sorted)
+  {
+    stream = agn_merge_stream_new_gff3(argc - optind, (const char **)
+                                                      argv+optind);
+  }
+  else
+  {
+    stream = gt_gff3_in_stream_new_unsorted(argc - optind, (const char **)
+                                                            argv+optind);
+    gt_gff3_in_stream_check_id_attributes((GtGFF3InStream *)stream);
+    gt_gff3_in_stream_enable_tidy_mode((GtGFF3InStream *)stream);
+  }
   gt_queue_add(streams, stream);
   last_stream = stream;
 
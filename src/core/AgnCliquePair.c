@@ -8,11 +8,17 @@ online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
 
 **/
 #include <math.h>
+#include <stdint.h>
 #include <string.h>
 #include "core/queue_api.h"
 #include "AgnCliquePair.h"
 #include "AgnUtils.h"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define AGN_SIMD_X86
+#include <immintrin.h>
+#endif
+
 #define char_is_exonic(C) (C == 'F' || C == 'T' || C == 'C')
 #define char_is_utric(C)  (C == 'F' || C == 'T')
 #define clique_pair_has_utrs(CP) \
@@ -33,30 +39,110 @@ struct AgnCliquePair
 
 typedef struct
 {
-  GtArray *refrstarts;
-  GtArray *refrends;
-  GtArray *predstarts;
-  GtArray *predends;
+  GtArray *refr;
+  GtArray *pred;
   AgnCompStatsBinary *stats;
 } StructuralData;
 
+typedef struct
+{
+  const AgnModelSegment *segs;
+  GtUword num_segs;
+  GtUword index;
+  const char *types;
+} SegmentRunIterator;
+
+/**
+ * Signature for routines that compare two model vectors nucleotide by
+ * nucleotide. Counts are added to ``stats`` and structure boundaries to
+ * ``structs``, which holds CDS, exon, and UTR data, in that order.
+ */
+typedef void (*ModelVectorKernel)(const char *refr_vector,
+                                  const char *pred_vector, GtUword length,
+                                  AgnComparison *stats,
+                                  StructuralData *structs);
+
 
 //------------------------------------------------------------------------------
 // Prototypes for private functions
 //------------------------------------------------------------------------------
 
 /**
- * @function Given a set of of start and end coordinates for reference and
- * prediction structures (exons, CDS segments, or UTR segments), determine the
- * number of congruent and incongruent structures.
+ * @function Allocate a pair for the given cliques, with empty comparison stats.
+ */
+static AgnCliquePair *clique_pair_alloc(AgnTranscriptClique *refr,
+                                        AgnTranscriptClique *pred);
+
+/**
+ * @function Given the coordinates of reference and prediction structures
+ * (exons, CDS segments, or UTR segments), each sorted by position, determine
+ * the number of congruent and incongruent structures with a single merge pass.
  */
 static void clique_pair_calc_struct_stats(StructuralData *dat);
 
+/**
+ * @function Upper bound on the correlation coefficient of two binary
+ * nucleotide labelings of a locus of the given ``length``, given only the
+ * number of positive nucleotides in each: the coefficient is greatest when the
+ * positives overlap as much as possible. Undefined coefficients are reported as
+ * negative infinity, consistent with :c:type:`AgnCliquePairKey`.
+ */
+static double clique_pair_cc_bound(GtUword refr_positives,
+                                   GtUword pred_positives, GtUword length);
+
+/**
+ * @function Round a correlation coefficient down to a multiple of
+ * ``tolerance``, so that coefficients differing by less than the tolerance
+ * (which ``agn_clique_pair_compare_direct`` treats as a tie) usually rank
+ * equally. Undefined coefficients are reported as negative infinity.
+ */
+static double clique_pair_cc_bucket(double cc, double tolerance);
+
 /**
  * @function Compare this pair of annotations at the nucleotide level and at the
- * structural level, recording relevant similarity statistics.
+ * structural level, recording relevant similarity statistics in ``stats``. The
+ * comparison walks the two cliques' model segments in tandem, so its cost is
+ * proportional to the number of segments rather than the length of the locus.
+ */
+static void clique_pair_comparative_analysis(AgnCliquePair *pair,
+                                             AgnComparison *stats);
+
+/**
+ * @function Same as ``clique_pair_comparative_analysis``, but comparing the two
+ * cliques' model vectors one nucleotide at a time using the given ``kernel``
+ * (or the fastest kernel supported by the CPU if ``kernel`` is NULL). Used only
+ * to validate the segment-based comparison.
+ */
+static void clique_pair_comparative_analysis_vector(AgnCliquePair *pair,
+                                                    AgnComparison *stats,
+                                                    ModelVectorKernel kernel);
+
+/**
+ * @function Determine whether two sets of comparison statistics have identical
+ * counts.
  */
-static void clique_pair_comparative_analysis(AgnCliquePair *pair);
+static bool clique_pair_stats_identical(AgnComparison *s1, AgnComparison *s2);
+
+/**
+ * @function Determine whether comparing the pair's model vectors with the given
+ * kernel yields exactly the same statistics as the segment-based comparison.
+ */
+static bool clique_pair_test_kernel(AgnCliquePair *pair,
+                                    ModelVectorKernel kernel);
+
+/**
+ * @function Determine whether ranking pairs derived from ``pair`` by their
+ * keys yields the same order as sorting them with
+ * ``agn_clique_pair_compare_reverse``, for coding correlation coefficients
+ * that differ by less than the tolerance.
+ */
+static bool clique_pair_test_key(AgnCliquePair *pair);
+
+/**
+ * @function Run ``clique_pair_test_kernel`` for each SIMD kernel supported by
+ * the CPU. Returns true trivially if none are.
+ */
+static bool clique_pair_test_simd(AgnCliquePair *pair);
 
 /**
  * @function Initialize the data structure used to store start and end
@@ -66,6 +152,41 @@ static void clique_pair_comparative_analysis(AgnCliquePair *pair);
 static void clique_pair_init_struct_dat(StructuralData *dat,
                                         AgnCompStatsBinary *stats);
 
+/**
+ * @function Determine the number of congruent and incongruent structures, where
+ * a structure is a maximal run of model segments whose type is one of the
+ * characters in ``types``. Runs are generated on the fly from both segment
+ * arrays and matched with a single merge pass, without any allocation.
+ */
+static void clique_pair_match_segment_runs(GtArray *refr_segments,
+                                           GtArray *pred_segments,
+                                           const char *types,
+                                           AgnCompStatsBinary *stats);
+
+/**
+ * @function Append a new structure starting at ``pos``.
+ */
+static void clique_pair_run_begin(GtArray *runs, GtUword pos);
+
+/**
+ * @function Mark the end of the most recently started structure.
+ */
+static void clique_pair_run_end(GtArray *runs, GtUword pos);
+
+/**
+ * @function Initialize an iterator over runs of segments whose type is one of
+ * the characters in ``types``.
+ */
+static void clique_pair_run_iterator_init(SegmentRunIterator *iter,
+                                          GtArray *segments, const char *types);
+
+/**
+ * @function Store the next maximal run of segments (of the types specified when
+ * the iterator was initialized) in ``run``. Returns false when no runs remain.
+ */
+static bool clique_pair_run_iterator_next(SegmentRunIterator *iter,
+                                          GtRange *run);
+
 /**
  * @function Free the memory previously occupied by the data structure.
  */
@@ -76,6 +197,66 @@ static void clique_pair_term_struct_dat(StructuralData *dat);
  */
 static void clique_pair_test_data(GtQueue *queue);
 
+/**
+ * @function Tolerance used in comparing the correlation coefficients of pairs
+ * in a locus of the given ``length``: the largest power of 10 no greater than
+ * the inverse of the length.
+ */
+static double clique_pair_tolerance(GtUword length);
+
+#ifdef AGN_SIMD_X86
+/**
+ * @function Add counts and structure boundaries for a block of up to 32
+ * nucleotides, given one bitmask per predicate (refr CDS, pred CDS, refr exon,
+ * pred exon, refr UTR, pred UTR) and a bitmask of identical nucleotides.
+ * ``carry`` holds each predicate's value at the last position of the previous
+ * block.
+ */
+static void clique_pair_vector_block(const uint32_t *masks, uint32_t eqmask,
+                                     GtUword offset, unsigned width,
+                                     AgnComparison *stats,
+                                     StructuralData *structs, uint32_t *carry);
+
+/**
+ * @function Close any structures still open at the end of the model vectors.
+ */
+static void clique_pair_vector_finish(GtUword length, StructuralData *structs,
+                                      uint32_t carry);
+
+/**
+ * @function Model vector comparison kernel, 32 nucleotides per instruction.
+ */
+static void clique_pair_vector_kernel_avx2(const char *refr_vector,
+                                           const char *pred_vector,
+                                           GtUword length,
+                                           AgnComparison *stats,
+                                           StructuralData *structs);
+
+/**
+ * @function Model vector comparison kernel, 16 nucleotides per instruction.
+ */
+static void clique_pair_vector_kernel_sse2(const char *refr_vector,
+                                           const char *pred_vector,
+                                           GtUword length,
+                                           AgnComparison *stats,
+                                           StructuralData *structs);
+#endif
+
+/**
+ * @function Portable model vector comparison kernel, one nucleotide at a time.
+ */
+static void clique_pair_vector_kernel_scalar(const char *refr_vector,
+                                             const char *pred_vector,
+                                             GtUword length,
+                                             AgnComparison *stats,
+                                             StructuralData *structs);
+
+/**
+ * @function Select the fastest model vector comparison kernel supported by the
+ * CPU at runtime.
+ */
+static ModelVectorKernel clique_pair_vector_kernel_select(void);
+
 
 //------------------------------------------------------------------------------
 // Method implementations
@@ -228,26 +409,83 @@ AgnComparison *agn_clique_pair_get_stats(AgnCliquePair *pair)
   return &pair->stats;
 }
 
-AgnCliquePair* agn_clique_pair_new(AgnTranscriptClique *refr,
-                                   AgnTranscriptClique *pred)
+void agn_clique_pair_key(AgnCliquePair *pair, AgnCliquePairKey *key)
 {
-  GtStr *seqidrefr = gt_genome_node_get_seqid(refr);
-  GtStr *seqidpred = gt_genome_node_get_seqid(pred);
-  agn_assert(gt_genome_node_get_start(refr) == gt_genome_node_get_start(pred) &&
-            gt_genome_node_get_end(refr) == gt_genome_node_get_end(pred) &&
-            gt_str_cmp(seqidrefr, seqidpred) == 0);
+  AgnComparison *stats = &pair->stats;
+  key->cds_cc = 0.0;
+  key->utr_cc = 0.0;
+  if(stats->overall_matches == stats->overall_length)
+  {
+    key->tier = 4;
+    return;
+  }
 
-  AgnCliquePair *pair = (AgnCliquePair *)gt_malloc( sizeof(AgnCliquePair) );
-  pair->refr_clique = gt_genome_node_ref(refr);
-  pair->pred_clique = gt_genome_node_ref(pred);
+  key->tier = 0;
+  if(stats->cds_struc_stats.missing == 0 && stats->cds_struc_stats.wrong == 0)
+    key->tier |= 2;
+  if(stats->exon_struc_stats.missing == 0 && stats->exon_struc_stats.wrong == 0)
+    key->tier |= 1;
+  key->cds_cc = clique_pair_cc_bucket(stats->cds_nuc_stats.cc,
+                                      pair->tolerance);
+  key->utr_cc = clique_pair_cc_bucket(stats->utr_nuc_stats.cc,
+                                      pair->tolerance);
+}
 
-  agn_comparison_init(&pair->stats);
-  double perc = 1.0 / (double)gt_genome_node_get_length(refr);
-  pair->tolerance = 1.0;
-  while(pair->tolerance > perc)
-    pair->tolerance /= 10;
+void agn_clique_pair_key_bound(const AgnModelSummary *refr,
+                               const AgnModelSummary *pred, GtUword length,
+                               AgnCliquePairKey *key)
+{
+  // A structure match requires the same number of structures covering the same
+  // number of nucleotides; a perfect match requires both
+  bool cds = refr->num_cds == pred->num_cds &&
+             refr->cds_length == pred->cds_length;
+  bool exon = refr->num_exons == pred->num_exons &&
+              refr->cds_length + refr->utr_length ==
+              pred->cds_length + pred->utr_length;
+  key->cds_cc = 0.0;
+  key->utr_cc = 0.0;
+  if(cds && exon && refr->utr_length == pred->utr_length)
+  {
+    key->tier = 4;
+    return;
+  }
+
+  key->tier = (cds ? 2 : 0) | (exon ? 1 : 0);
+  double tolerance = clique_pair_tolerance(length);
+  double cds_cc = clique_pair_cc_bound(refr->cds_length, pred->cds_length,
+                                       length);
+  double utr_cc = clique_pair_cc_bound(refr->utr_length, pred->utr_length,
+                                       length);
+  key->cds_cc = clique_pair_cc_bucket(cds_cc, tolerance);
+  key->utr_cc = clique_pair_cc_bucket(utr_cc, tolerance);
+}
 
-  clique_pair_comparative_analysis(pair);
+int agn_clique_pair_key_compare(const AgnCliquePairKey *k1,
+                                const AgnCliquePairKey *k2)
+{
+  if(k1->tier != k2->tier)
+    return k1->tier > k2->tier ? 1 : -1;
+  if(k1->cds_cc != k2->cds_cc)
+    return k1->cds_cc > k2->cds_cc ? 1 : -1;
+  if(k1->utr_cc != k2->utr_cc)
+    return k1->utr_cc > k2->utr_cc ? 1 : -1;
+  return 0;
+}
+
+AgnCliquePair* agn_clique_pair_new(AgnTranscriptClique *refr,
+                                   AgnTranscriptClique *pred)
+{
+  AgnCliquePair *pair = clique_pair_alloc(refr, pred);
+  clique_pair_comparative_analysis(pair, &pair->stats);
+  return pair;
+}
+
+AgnCliquePair* agn_clique_pair_new_with_stats(AgnTranscriptClique *refr,
+                                              AgnTranscriptClique *pred,
+                                              AgnComparison *stats)
+{
+  AgnCliquePair *pair = clique_pair_alloc(refr, pred);
+  pair->stats = *stats;
   return pair;
 }
 
@@ -257,203 +495,374 @@ bool agn_clique_pair_unit_test(AgnUnitTest *test)
   clique_pair_test_data(pairs);
   agn_assert(gt_queue_size(pairs) == 3);
 
+  bool vectorcheck = true;
+  bool simdcheck = true;
+
   AgnCliquePair *pair = gt_queue_get(pairs);
   AgnCompClassification result = agn_clique_pair_classify(pair);
   bool simplecheck = (result == AGN_COMP_CLASS_PERFECT_MATCH);
   agn_unit_test_result(test, "perfect match vs. self", simplecheck);
+  vectorcheck = vectorcheck &&
+                clique_pair_test_kernel(pair, clique_pair_vector_kernel_scalar);
+  simdcheck = simdcheck && clique_pair_test_simd(pair);
   agn_clique_pair_delete(pair);
 
   pair = gt_queue_get(pairs);
   result = agn_clique_pair_classify(pair);
   bool cdscheck = result == (AGN_COMP_CLASS_CDS_MATCH);
   agn_unit_test_result(test, "CDS match", cdscheck);
+  vectorcheck = vectorcheck &&
+                clique_pair_test_kernel(pair, clique_pair_vector_kernel_scalar);
+  simdcheck = simdcheck && clique_pair_test_simd(pair);
   agn_clique_pair_delete(pair);
 
   pair = gt_queue_get(pairs);
   result = agn_clique_pair_classify(pair);
   bool nomatchcheck = result == (AGN_COMP_CLASS_NON_MATCH);
   agn_unit_test_result(test, "non-match", nomatchcheck);
+  vectorcheck = vectorcheck &&
+                clique_pair_test_kernel(pair, clique_pair_vector_kernel_scalar);
+  simdcheck = simdcheck && clique_pair_test_simd(pair);
+  bool keycheck = clique_pair_test_key(pair);
+  agn_unit_test_result(test, "ranking vs. pairwise comparison", keycheck);
   agn_clique_pair_delete(pair);
 
+  agn_unit_test_result(test, "segments vs. model vectors", vectorcheck);
+  agn_unit_test_result(test, "SIMD vs. scalar model vectors", simdcheck);
+
   gt_queue_delete(pairs);
   return agn_unit_test_success(test);
 }
 
+static AgnCliquePair *clique_pair_alloc(AgnTranscriptClique *refr,
+                                        AgnTranscriptClique *pred)
+{
+  GtStr *seqidrefr = gt_genome_node_get_seqid(refr);
+  GtStr *seqidpred = gt_genome_node_get_seqid(pred);
+  agn_assert(gt_genome_node_get_start(refr) == gt_genome_node_get_start(pred) &&
+            gt_genome_node_get_end(refr) == gt_genome_node_get_end(pred) &&
+            gt_str_cmp(seqidrefr, seqidpred) == 0);
+
+  AgnCliquePair *pair = (AgnCliquePair *)gt_malloc( sizeof(AgnCliquePair) );
+  pair->refr_clique = gt_genome_node_ref(refr);
+  pair->pred_clique = gt_genome_node_ref(pred);
+
+  agn_comparison_init(&pair->stats);
+  pair->tolerance = clique_pair_tolerance(gt_genome_node_get_length(refr));
+
+  return pair;
+}
+
 static void clique_pair_calc_struct_stats(StructuralData *dat)
 {
-  GtUword num_refr = gt_array_size(dat->refrstarts);
-  GtUword num_pred = gt_array_size(dat->predstarts);
-  agn_assert(num_refr == gt_array_size(dat->refrends));
-  agn_assert(num_pred == gt_array_size(dat->predends));
-  GtUword i, j;
-  for(i = 0; i < num_refr; i++)
+  GtUword num_refr = gt_array_size(dat->refr);
+  GtUword num_pred = gt_array_size(dat->pred);
+  GtRange *refr = gt_array_get_space(dat->refr);
+  GtRange *pred = gt_array_get_space(dat->pred);
+  GtUword i = 0, j = 0;
+  while(i < num_refr && j < num_pred)
   {
-    bool found_match = 0;
-    GtUword *refrstart = gt_array_get(dat->refrstarts, i);
-    GtUword *refrend   = gt_array_get(dat->refrends,   i);
-    for(j = 0; j < num_pred; j++)
+    int result = gt_range_compare(refr + i, pred + j);
+    if(result == 0)
     {
-      GtUword *predstart = gt_array_get(dat->predstarts, j);
-      GtUword *predend   = gt_array_get(dat->predends,   j);
-      if(*refrstart == *predstart && *refrend == *predend)
-      {
-        dat->stats->correct++;
-        found_match = 1;
-        break;
-      }
+      dat->stats->correct++;
+      i++;
+      j++;
     }
-    if(!found_match)
+    else if(result < 0)
+    {
       dat->stats->missing++;
+      i++;
+    }
+    else
+    {
+      dat->stats->wrong++;
+      j++;
+    }
   }
-  for(i = 0; i < num_pred; i++)
+  dat->stats->missing += num_refr - i;
+  dat->stats->wrong   += num_pred - j;
+  agn_comp_stats_binary_resolve(dat->stats);
+  clique_pair_term_struct_dat(dat);
+}
+
+static double clique_pair_cc_bound(GtUword refr_positives,
+                                   GtUword pred_positives, GtUword length)
+{
+  if(refr_positives == 0 || pred_positives == 0 ||
+     refr_positives >= length || pred_positives >= length)
+    return -INFINITY;
+
+  double a = (double)refr_positives;
+  double b = (double)pred_positives;
+  double n = (double)length;
+  double tp = a < b ? a : b;
+  double cc = (n*tp - a*b) / pow(a*(n - a)*b*(n - b), 0.5);
+
+  // Pad the bound so that rounding can never put it below the coefficient
+  // computed from the actual counts
+  return cc + 1e-9;
+}
+
+static double clique_pair_cc_bucket(double cc, double tolerance)
+{
+  if(isnan(cc) || isinf(cc))
+    return -INFINITY;
+  return floor(cc / tolerance) * tolerance;
+}
+
+static void clique_pair_comparative_analysis(AgnCliquePair *pair,
+                                             AgnComparison *stats)
+{
+  GtUword locus_length = gt_genome_node_get_length(pair->refr_clique);
+  GtArray *refr_segments =
+      agn_transcript_clique_get_model_segments(pair->refr_clique);
+  GtArray *pred_segments =
+      agn_transcript_clique_get_model_segments(pair->pred_clique);
+  GtUword num_refr = gt_array_size(refr_segments);
+  GtUword num_pred = gt_array_size(pred_segments);
+  AgnModelSegment *refr_segs = gt_array_get_space(refr_segments);
+  AgnModelSegment *pred_segs = gt_array_get_space(pred_segments);
+  agn_assert(num_refr == 0 || refr_segs[num_refr - 1].end < locus_length);
+  agn_assert(num_pred == 0 || pred_segs[num_pred - 1].end < locus_length);
+  stats->overall_length = locus_length;
+
+  // Nucleotide counts: walk both segment lists in tandem, advancing to the
+  // next position at which either model changes
+  GtUword pos = 0, ri = 0, pi = 0;
+  while(pos < locus_length)
   {
-    bool found_match = 0;
-    GtUword *predstart = gt_array_get(dat->predstarts, i);
-    GtUword *predend   = gt_array_get(dat->predends,   i);
-    for(j = 0; j < num_refr; j++)
+    char refr_c = 'G', pred_c = 'G';
+    GtUword next = locus_length;
+
+    if(ri < num_refr && refr_segs[ri].end < pos)
+      ri++;
+    if(ri < num_refr)
     {
-      GtUword *refrstart = gt_array_get(dat->refrstarts, j);
-      GtUword *refrend   = gt_array_get(dat->refrends,   j);
-      if(*refrstart == *predstart && *refrend == *predend)
+      if(refr_segs[ri].start <= pos)
       {
-        found_match = 1;
-        break;
+        refr_c = refr_segs[ri].type;
+        next = refr_segs[ri].end + 1;
       }
+      else
+        next = refr_segs[ri].start;
     }
-    if(!found_match)
-      dat->stats->wrong++;
+
+    if(pi < num_pred && pred_segs[pi].end < pos)
+      pi++;
+    if(pi < num_pred)
+    {
+      if(pred_segs[pi].start <= pos)
+      {
+        pred_c = pred_segs[pi].type;
+        if(pred_segs[pi].end + 1 < next)
+          next = pred_segs[pi].end + 1;
+      }
+      else if(pred_segs[pi].start < next)
+        next = pred_segs[pi].start;
+    }
+
+    GtUword length = next - pos;
+
+    // Coding nucleotide counts
+    if(refr_c == 'C' && pred_c == 'C')
+      stats->cds_nuc_stats.tp += length;
+    else if(refr_c == 'C' && pred_c != 'C')
+      stats->cds_nuc_stats.fn += length;
+    else if(refr_c != 'C' && pred_c == 'C')
+      stats->cds_nuc_stats.fp += length;
+    else
+      stats->cds_nuc_stats.tn += length;
+
+    // UTR nucleotide counts
+    bool refr_utr = char_is_utric(refr_c);
+    bool pred_utr = char_is_utric(pred_c);
+    if(refr_utr && pred_utr)        stats->utr_nuc_stats.tp += length;
+    else if(refr_utr && !pred_utr)  stats->utr_nuc_stats.fn += length;
+    else if(!refr_utr && pred_utr)  stats->utr_nuc_stats.fp += length;
+    else                            stats->utr_nuc_stats.tn += length;
+
+    // Overall matches
+    if(refr_c == pred_c)
+      stats->overall_matches += length;
+
+    pos = next;
   }
-  agn_comp_stats_binary_resolve(dat->stats);
-  clique_pair_term_struct_dat(dat);
+
+  // Calculate nucleotide-level statistics from counts
+  agn_comp_stats_scaled_resolve(&stats->cds_nuc_stats);
+  agn_comp_stats_scaled_resolve(&stats->utr_nuc_stats);
+
+  // Calculate statistics for structure directly from the segments
+  clique_pair_match_segment_runs(refr_segments, pred_segments, "C",
+                                 &stats->cds_struc_stats);
+  clique_pair_match_segment_runs(refr_segments, pred_segments, "CFT",
+                                 &stats->exon_struc_stats);
+  clique_pair_match_segment_runs(refr_segments, pred_segments, "FT",
+                                 &stats->utr_struc_stats);
 }
 
-static void clique_pair_comparative_analysis(AgnCliquePair *pair)
+static void clique_pair_comparative_analysis_vector(AgnCliquePair *pair,
+                                                    AgnComparison *stats,
+                                                    ModelVectorKernel kernel)
 {
   GtUword locus_length = gt_genome_node_get_length(pair->refr_clique);
-  char *refr_vector = gt_genome_node_get_user_data(pair->refr_clique,
-                                                   "modelvector");
-  char *pred_vector = gt_genome_node_get_user_data(pair->pred_clique,
-                                                   "modelvector");
+  const char *refr_vector =
+      agn_transcript_clique_get_model_vector(pair->refr_clique);
+  const char *pred_vector =
+      agn_transcript_clique_get_model_vector(pair->pred_clique);
   agn_assert(
       strlen(refr_vector) == gt_genome_node_get_length(pair->refr_clique) &&
       strlen(pred_vector) == gt_genome_node_get_length(pair->refr_clique)
   );
-  pair->stats.overall_length = locus_length;
+  stats->overall_length = locus_length;
 
-  StructuralData cdsstruct;
-  clique_pair_init_struct_dat(&cdsstruct, &pair->stats.cds_struc_stats);
-  StructuralData exonstruct;
-  clique_pair_init_struct_dat(&exonstruct, &pair->stats.exon_struc_stats);
-  StructuralData utrstruct;
-  clique_pair_init_struct_dat(&utrstruct, &pair->stats.utr_struc_stats);
+  StructuralData structs[3];
+  clique_pair_init_struct_dat(&structs[0], &stats->cds_struc_stats);
+  clique_pair_init_struct_dat(&structs[1], &stats->exon_struc_stats);
+  clique_pair_init_struct_dat(&structs[2], &stats->utr_struc_stats);
 
-  // Collect counts
-  GtUword i;
-  for(i = 0; i < locus_length; i++)
-  {
-    // Coding nucleotide counts
-    if(refr_vector[i] == 'C' && pred_vector[i] == 'C')
-      pair->stats.cds_nuc_stats.tp++;
-    else if(refr_vector[i] == 'C' && pred_vector[i] != 'C')
-      pair->stats.cds_nuc_stats.fn++;
-    else if(refr_vector[i] != 'C' && pred_vector[i] == 'C')
-      pair->stats.cds_nuc_stats.fp++;
-    else if(refr_vector[i] != 'C' && pred_vector[i] != 'C')
-      pair->stats.cds_nuc_stats.tn++;
+  if(kernel == NULL)
+    kernel = clique_pair_vector_kernel_select();
+  kernel(refr_vector, pred_vector, locus_length, stats, structs);
 
-    // UTR nucleotide counts
-    bool refr_utr = char_is_utric(refr_vector[i]);
-    bool pred_utr = char_is_utric(pred_vector[i]);
-    if(refr_utr && pred_utr)        pair->stats.utr_nuc_stats.tp++;
-    else if(refr_utr && !pred_utr)  pair->stats.utr_nuc_stats.fn++;
-    else if(!refr_utr && pred_utr)  pair->stats.utr_nuc_stats.fp++;
-    else if(!refr_utr && !pred_utr) pair->stats.utr_nuc_stats.tn++;
+  // Calculate nucleotide-level statistics from counts
+  agn_comp_stats_scaled_resolve(&stats->cds_nuc_stats);
+  agn_comp_stats_scaled_resolve(&stats->utr_nuc_stats);
 
-    // Overall matches
-    if(refr_vector[i] == pred_vector[i])
-      pair->stats.overall_matches++;
+  // Calculate statistics for structure from counts
+  clique_pair_calc_struct_stats(&structs[0]);
+  clique_pair_calc_struct_stats(&structs[1]);
+  clique_pair_calc_struct_stats(&structs[2]);
+}
 
-    // CDS structure counts
-    if(refr_vector[i] == 'C')
-    {
-      if(i == 0 || refr_vector[i-1] != 'C')
-        gt_array_add(cdsstruct.refrstarts, i);
+static void clique_pair_init_struct_dat(StructuralData *dat,
+                                        AgnCompStatsBinary *stats)
+{
+  dat->refr  = gt_array_new( sizeof(GtRange) );
+  dat->pred  = gt_array_new( sizeof(GtRange) );
+  dat->stats = stats;
+}
 
-      if(i == locus_length - 1 || refr_vector[i+1] != 'C')
-        gt_array_add(cdsstruct.refrends, i);
-    }
-    if(pred_vector[i] == 'C')
+static void clique_pair_match_segment_runs(GtArray *refr_segments,
+                                           GtArray *pred_segments,
+                                           const char *types,
+                                           AgnCompStatsBinary *stats)
+{
+  SegmentRunIterator refr_iter, pred_iter;
+  clique_pair_run_iterator_init(&refr_iter, refr_segments, types);
+  clique_pair_run_iterator_init(&pred_iter, pred_segments, types);
+
+  GtRange refr, pred;
+  bool refr_valid = clique_pair_run_iterator_next(&refr_iter, &refr);
+  bool pred_valid = clique_pair_run_iterator_next(&pred_iter, &pred);
+  while(refr_valid && pred_valid)
+  {
+    int result = gt_range_compare(&refr, &pred);
+    if(result == 0)
     {
-      if(i == 0 || pred_vector[i-1] != 'C')
-        gt_array_add(cdsstruct.predstarts, i);
-
-      if(i == locus_length - 1 || pred_vector[i+1] != 'C')
-        gt_array_add(cdsstruct.predends, i);
+      stats->correct++;
+      refr_valid = clique_pair_run_iterator_next(&refr_iter, &refr);
+      pred_valid = clique_pair_run_iterator_next(&pred_iter, &pred);
     }
-
-    // Exon structure counts
-    if(char_is_exonic(refr_vector[i]))
+    else if(result < 0)
     {
-      if(i == 0 || !char_is_exonic(refr_vector[i-1]))
-        gt_array_add(exonstruct.refrstarts, i);
-
-      if(i == locus_length - 1 || !char_is_exonic(refr_vector[i+1]))
-        gt_array_add(exonstruct.refrends, i);
+      stats->missing++;
+      refr_valid = clique_pair_run_iterator_next(&refr_iter, &refr);
     }
-    if(char_is_exonic(pred_vector[i]))
+    else
     {
-      if(i == 0 || !char_is_exonic(pred_vector[i-1]))
-        gt_array_add(exonstruct.predstarts, i);
-
-      if(i == locus_length - 1 || !char_is_exonic(pred_vector[i+1]))
-        gt_array_add(exonstruct.predends, i);
+      stats->wrong++;
+      pred_valid = clique_pair_run_iterator_next(&pred_iter, &pred);
     }
+  }
+  while(refr_valid)
+  {
+    stats->missing++;
+    refr_valid = clique_pair_run_iterator_next(&refr_iter, &refr);
+  }
+  while(pred_valid)
+  {
+    stats->wrong++;
+    pred_valid = clique_pair_run_iterator_next(&pred_iter, &pred);
+  }
+  agn_comp_stats_binary_resolve(stats);
+}
 
-    // UTR structure counts
-    if(char_is_utric(refr_vector[i]))
-    {
-      if(i == 0 || !char_is_utric(refr_vector[i-1]))
-        gt_array_add(utrstruct.refrstarts, i);
+static void clique_pair_run_begin(GtArray *runs, GtUword pos)
+{
+  GtRange run = { pos, pos };
+  gt_array_add(runs, run);
+}
 
-      if(i == locus_length - 1 || !char_is_utric(refr_vector[i+1]))
-        gt_array_add(utrstruct.refrends, i);
-    }
-    if(char_is_utric(pred_vector[i]))
-    {
-      if(i == 0 || !char_is_utric(pred_vector[i-1]))
-        gt_array_add(utrstruct.predstarts, i);
+static void clique_pair_run_end(GtArray *runs, GtUword pos)
+{
+  GtRange *run = gt_array_get_last(runs);
+  agn_assert(run->start <= pos);
+  run->end = pos;
+}
 
-      if(i == locus_length - 1 || !char_is_utric(pred_vector[i+1]))
-        gt_array_add(utrstruct.predends, i);
-    }
-  }
+static void clique_pair_run_iterator_init(SegmentRunIterator *iter,
+                                          GtArray *segments, const char *types)
+{
+  iter->segs = gt_array_get_space(segments);
+  iter->num_segs = gt_array_size(segments);
+  iter->index = 0;
+  iter->types = types;
+}
 
-  // Calculate nucleotide-level statistics from counts
-  agn_comp_stats_scaled_resolve(&pair->stats.cds_nuc_stats);
-  agn_comp_stats_scaled_resolve(&pair->stats.utr_nuc_stats);
+static bool clique_pair_run_iterator_next(SegmentRunIterator *iter,
+                                          GtRange *run)
+{
+  while(iter->index < iter->num_segs &&
+        strchr(iter->types, iter->segs[iter->index].type) == NULL)
+  {
+    iter->index++;
+  }
+  if(iter->index >= iter->num_segs)
+    return false;
 
-  // Calculate statistics for structure from counts
-  clique_pair_calc_struct_stats(&cdsstruct);
-  clique_pair_calc_struct_stats(&exonstruct);
-  clique_pair_calc_struct_stats(&utrstruct);
+  run->start = iter->segs[iter->index].start;
+  run->end   = iter->segs[iter->index].end;
+  for(iter->index++; iter->index < iter->num_segs; iter->index++)
+  {
+    const AgnModelSegment *seg = iter->segs + iter->index;
+    if(seg->start != run->end + 1 || strchr(iter->types, seg->type) == NULL)
+      break;
+    run->end = seg->end;
+  }
+  return true;
 }
 
-static void clique_pair_init_struct_dat(StructuralData *dat,
-                                        AgnCompStatsBinary *stats)
+static bool clique_pair_stats_identical(AgnComparison *s1, AgnComparison *s2)
 {
-  dat->refrstarts = gt_array_new( sizeof(GtUword) );
-  dat->refrends   = gt_array_new( sizeof(GtUword) );
-  dat->predstarts = gt_array_new( sizeof(GtUword) );
-  dat->predends   = gt_array_new( sizeof(GtUword) );
-  dat->stats      = stats;
+  AgnCompStatsScaled *n1[] = { &s1->cds_nuc_stats, &s1->utr_nuc_stats };
+  AgnCompStatsScaled *n2[] = { &s2->cds_nuc_stats, &s2->utr_nuc_stats };
+  AgnCompStatsBinary *b1[] = { &s1->cds_struc_stats, &s1->exon_struc_stats,
+                               &s1->utr_struc_stats };
+  AgnCompStatsBinary *b2[] = { &s2->cds_struc_stats, &s2->exon_struc_stats,
+                               &s2->utr_struc_stats };
+  int i;
+  for(i = 0; i < 2; i++)
+  {
+    if(n1[i]->tp != n2[i]->tp || n1[i]->fn != n2[i]->fn ||
+       n1[i]->fp != n2[i]->fp || n1[i]->tn != n2[i]->tn)
+      return false;
+  }
+  for(i = 0; i < 3; i++)
+  {
+    if(b1[i]->correct != b2[i]->correct || b1[i]->missing != b2[i]->missing ||
+       b1[i]->wrong != b2[i]->wrong)
+      return false;
+  }
+  return s1->overall_matches == s2->overall_matches &&
+         s1->overall_length  == s2->overall_length;
 }
 
 static void clique_pair_term_struct_dat(StructuralData *dat)
 {
-  gt_array_delete(dat->refrstarts);
-  gt_array_delete(dat->refrends);
-  gt_array_delete(dat->predstarts);
-  gt_array_delete(dat->predends);
+  gt_array_delete(dat->refr);
+  gt_array_delete(dat->pred);
 }
 
 static void clique_pair_test_data(GtQueue *queue)
@@ -548,3 +957,334 @@ static void clique_pair_test_data(GtQueue *queue)
   gt_array_delete(predfeats);
   gt_error_delete(error);
 }
+
+static bool clique_pair_test_kernel(AgnCliquePair *pair,
+                                    ModelVectorKernel kernel)
+{
+  AgnComparison vectorstats;
+  agn_comparison_init(&vectorstats);
+  clique_pair_comparative_analysis_vector(pair, &vectorstats, kernel);
+  return clique_pair_stats_identical(&pair->stats, &vectorstats);
+}
+
+static bool clique_pair_test_key(AgnCliquePair *pair)
+{
+  // Three imperfect pairs with neither structure match; the first two have
+  // coding coefficients within the tolerance, so their UTR coefficients decide
+  double t = pair->tolerance;
+  double base = floor(0.95 / t) * t;
+  double cds_cc[] = { base + 0.6*t, base + 0.3*t, base - 3.0*t };
+  double utr_cc[] = { 0.5, 0.9, 1.0 };
+  GtArray *pairs = gt_array_new( sizeof(AgnCliquePair *) );
+  GtUword i;
+  for(i = 0; i < 3; i++)
+  {
+    AgnComparison stats = pair->stats;
+    stats.overall_matches = stats.overall_length - 1;
+    stats.cds_struc_stats.missing = 1;
+    stats.exon_struc_stats.missing = 1;
+    stats.cds_nuc_stats.cc = cds_cc[i];
+    stats.utr_nuc_stats.cc = utr_cc[i];
+    AgnCliquePair *testpair = agn_clique_pair_new_with_stats(pair->refr_clique,
+                                                             pair->pred_clique,
+                                                             &stats);
+    gt_array_add(pairs, testpair);
+  }
+
+  gt_array_sort(pairs, (GtCompare)agn_clique_pair_compare_reverse);
+  AgnCliquePair **sorted = gt_array_get_space(pairs);
+  bool success = sorted[0]->stats.utr_nuc_stats.cc == 0.9 &&
+                 sorted[1]->stats.utr_nuc_stats.cc == 0.5;
+  for(i = 0; i + 1 < gt_array_size(pairs); i++)
+  {
+    AgnCliquePairKey k1, k2;
+    agn_clique_pair_key(sorted[i], &k1);
+    agn_clique_pair_key(sorted[i+1], &k2);
+    success = success && agn_clique_pair_key_compare(&k1, &k2) > 0;
+  }
+
+  for(i = 0; i < gt_array_size(pairs); i++)
+    agn_clique_pair_delete(sorted[i]);
+  gt_array_delete(pairs);
+  return success;
+}
+
+static bool clique_pair_test_simd(AgnCliquePair *pair)
+{
+  bool success = true;
+#ifdef AGN_SIMD_X86
+  if(__builtin_cpu_supports("sse2"))
+    success = success &&
+              clique_pair_test_kernel(pair, clique_pair_vector_kernel_sse2);
+  if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+    success = success &&
+              clique_pair_test_kernel(pair, clique_pair_vector_kernel_avx2);
+#endif
+  return success;
+}
+
+static double clique_pair_tolerance(GtUword length)
+{
+  double perc = 1.0 / (double)length;
+  double tolerance = 1.0;
+  while(tolerance > perc)
+    tolerance /= 10;
+  return tolerance;
+}
+
+#ifdef AGN_SIMD_X86
+static void clique_pair_vector_block(const uint32_t *masks, uint32_t eqmask,
+                                     GtUword offset, unsigned width,
+                                     AgnComparison *stats,
+                                     StructuralData *structs, uint32_t *carry)
+{
+  uint32_t valid = width == 32 ? 0xffffffff : ((uint32_t)1 << width) - 1;
+
+  // Nucleotide counts: masks 0/1 are refr/pred CDS, masks 4/5 are refr/pred UTR
+  uint32_t rc = masks[0] & valid, pc = masks[1] & valid;
+  stats->cds_nuc_stats.tp += __builtin_popcount(rc & pc);
+  stats->cds_nuc_stats.fn += __builtin_popcount(rc & ~pc);
+  stats->cds_nuc_stats.fp += __builtin_popcount(~rc & pc);
+  stats->cds_nuc_stats.tn += width - __builtin_popcount(rc | pc);
+  uint32_t ru = masks[4] & valid, pu = masks[5] & valid;
+  stats->utr_nuc_stats.tp += __builtin_popcount(ru & pu);
+  stats->utr_nuc_stats.fn += __builtin_popcount(ru & ~pu);
+  stats->utr_nuc_stats.fp += __builtin_popcount(~ru & pu);
+  stats->utr_nuc_stats.tn += width - __builtin_popcount(ru | pu);
+  stats->overall_matches += __builtin_popcount(eqmask & valid);
+
+  // Structure boundaries: each bit that differs from the previous position's
+  // bit is either the start of a run or the position just after its end
+  unsigned k;
+  for(k = 0; k < 6; k++)
+  {
+    StructuralData *dat = structs + (k / 2);
+    GtArray *runs = k % 2 == 0 ? dat->refr : dat->pred;
+    uint32_t m = masks[k] & valid;
+    uint32_t transitions = (m ^ ((m << 1) | ((*carry >> k) & 1))) & valid;
+    while(transitions)
+    {
+      unsigned bit = __builtin_ctz(transitions);
+      GtUword pos = offset + bit;
+      if((m >> bit) & 1)
+        clique_pair_run_begin(runs, pos);
+      else
+        clique_pair_run_end(runs, pos - 1);
+      transitions &= transitions - 1;
+    }
+    *carry = (*carry & ~((uint32_t)1 << k)) | (((m >> (width - 1)) & 1) << k);
+  }
+}
+
+static void clique_pair_vector_finish(GtUword length, StructuralData *structs,
+                                      uint32_t carry)
+{
+  unsigned k;
+  for(k = 0; k < 6; k++)
+  {
+    if((carry >> k) & 1)
+    {
+      StructuralData *dat = structs + (k / 2);
+      clique_pair_run_end(k % 2 == 0 ? dat->refr : dat->pred, length - 1);
+    }
+  }
+}
+
+__attribute__((target("avx2,popcnt")))
+static void clique_pair_vector_kernel_avx2(const char *refr_vector,
+                                           const char *pred_vector,
+                                           GtUword length,
+                                           AgnComparison *stats,
+                                           StructuralData *structs)
+{
+  const __m256i cds = _mm256_set1_epi8('C');
+  const __m256i utr5p = _mm256_set1_epi8('F');
+  const __m256i utr3p = _mm256_set1_epi8('T');
+  uint32_t carry = 0;
+  GtUword i;
+  for(i = 0; i < length; i += 32)
+  {
+    unsigned width = length - i < 32 ? length - i : 32;
+    __m256i r, p;
+    if(width == 32)
+    {
+      r = _mm256_loadu_si256((const __m256i *)(refr_vector + i));
+      p = _mm256_loadu_si256((const __m256i *)(pred_vector + i));
+    }
+    else
+    {
+      char rbuf[32], pbuf[32];
+      memset(rbuf, 'G', 32);
+      memset(pbuf, 'G', 32);
+      memcpy(rbuf, refr_vector + i, width);
+      memcpy(pbuf, pred_vector + i, width);
+      r = _mm256_loadu_si256((const __m256i *)rbuf);
+      p = _mm256_loadu_si256((const __m256i *)pbuf);
+    }
+    __m256i rc = _mm256_cmpeq_epi8(r, cds);
+    __m256i pc = _mm256_cmpeq_epi8(p, cds);
+    __m256i ru = _mm256_or_si256(_mm256_cmpeq_epi8(r, utr5p),
+                                 _mm256_cmpeq_epi8(r, utr3p));
+    __m256i pu = _mm256_or_si256(_mm256_cmpeq_epi8(p, utr5p),
+                                 _mm256_cmpeq_epi8(p, utr3p));
+    uint32_t masks[6];
+    masks[0] = (uint32_t)_mm256_movemask_epi8(rc);
+    masks[1] = (uint32_t)_mm256_movemask_epi8(pc);
+    masks[2] = (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(rc, ru));
+    masks[3] = (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(pc, pu));
+    masks[4] = (uint32_t)_mm256_movemask_epi8(ru);
+    masks[5] = (uint32_t)_mm256_movemask_epi8(pu);
+    uint32_t eqmask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(r, p));
+    clique_pair_vector_block(masks, eqmask, i, width, stats, structs, &carry);
+  }
+  clique_pair_vector_finish(length, structs, carry);
+}
+
+__attribute__((target("sse2")))
+static void clique_pair_vector_kernel_sse2(const char *refr_vector,
+                                           const char *pred_vector,
+                                           GtUword length,
+                                           AgnComparison *stats,
+                                           StructuralData *structs)
+{
+  const __m128i cds = _mm_set1_epi8('C');
+  const __m128i utr5p = _mm_set1_epi8('F');
+  const __m128i utr3p = _mm_set1_epi8('T');
+  uint32_t carry = 0;
+  GtUword i;
+  for(i = 0; i < length; i += 16)
+  {
+    unsigned width = length - i < 16 ? length - i : 16;
+    __m128i r, p;
+    if(width == 16)
+    {
+      r = _mm_loadu_si128((const __m128i *)(refr_vector + i));
+      p = _mm_loadu_si128((const __m128i *)(pred_vector + i));
+    }
+    else
+    {
+      char rbuf[16], pbuf[16];
+      memset(rbuf, 'G', 16);
+      memset(pbuf, 'G', 16);
+      memcpy(rbuf, refr_vector + i, width);
+      memcpy(pbuf, pred_vector + i, width);
+      r = _mm_loadu_si128((const __m128i *)rbuf);
+      p = _mm_loadu_si128((const __m128i *)pbuf);
+    }
+    __m128i rc = _mm_cmpeq_epi8(r, cds);
+    __m128i pc = _mm_cmpeq_epi8(p, cds);
+    __m128i ru = _mm_or_si128(_mm_cmpeq_epi8(r, utr5p),
+                              _mm_cmpeq_epi8(r, utr3p));
+    __m128i pu = _mm_or_si128(_mm_cmpeq_epi8(p, utr5p),
+                              _mm_cmpeq_epi8(p, utr3p));
+    uint32_t masks[6];
+    masks[0] = (uint32_t)_mm_movemask_epi8(rc);
+    masks[1] = (uint32_t)_mm_movemask_epi8(pc);
+    masks[2] = (uint32_t)_mm_movemask_epi8(_mm_or_si128(rc, ru));
+    masks[3] = (uint32_t)_mm_movemask_epi8(_mm_or_si128(pc, pu));
+    masks[4] = (uint32_t)_mm_movemask_epi8(ru);
+    masks[5] = (uint32_t)_mm_movemask_epi8(pu);
+    uint32_t eqmask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(r, p));
+    clique_pair_vector_block(masks, eqmask, i, width, stats, structs, &carry);
+  }
+  clique_pair_vector_finish(length, structs, carry);
+}
+#endif
+
+static void clique_pair_vector_kernel_scalar(const char *refr_vector,
+                                             const char *pred_vector,
+                                             GtUword length,
+                                             AgnComparison *stats,
+                                             StructuralData *structs)
+{
+  GtUword i;
+  for(i = 0; i < length; i++)
+  {
+    // Coding nucleotide counts
+    if(refr_vector[i] == 'C' && pred_vector[i] == 'C')
+      stats->cds_nuc_stats.tp++;
+    else if(refr_vector[i] == 'C' && pred_vector[i] != 'C')
+      stats->cds_nuc_stats.fn++;
+    else if(refr_vector[i] != 'C' && pred_vector[i] == 'C')
+      stats->cds_nuc_stats.fp++;
+    else if(refr_vector[i] != 'C' && pred_vector[i] != 'C')
+      stats->cds_nuc_stats.tn++;
+
+    // UTR nucleotide counts
+    bool refr_utr = char_is_utric(refr_vector[i]);
+    bool pred_utr = char_is_utric(pred_vector[i]);
+    if(refr_utr && pred_utr)        stats->utr_nuc_stats.tp++;
+    else if(refr_utr && !pred_utr)  stats->utr_nuc_stats.fn++;
+    else if(!refr_utr && pred_utr)  stats->utr_nuc_stats.fp++;
+    else if(!refr_utr && !pred_utr) stats->utr_nuc_stats.tn++;
+
+    // Overall matches
+    if(refr_vector[i] == pred_vector[i])
+      stats->overall_matches++;
+
+    // CDS structure counts
+    if(refr_vector[i] == 'C')
+    {
+      if(i == 0 || refr_vector[i-1] != 'C')
+        clique_pair_run_begin(structs[0].refr, i);
+
+      if(i == length - 1 || refr_vector[i+1] != 'C')
+        clique_pair_run_end(structs[0].refr, i);
+    }
+    if(pred_vector[i] == 'C')
+    {
+      if(i == 0 || pred_vector[i-1] != 'C')
+        clique_pair_run_begin(structs[0].pred, i);
+
+      if(i == length - 1 || pred_vector[i+1] != 'C')
+        clique_pair_run_end(structs[0].pred, i);
+    }
+
+    // Exon structure counts
+    if(char_is_exonic(refr_vector[i]))
+    {
+      if(i == 0 || !char_is_exonic(refr_vector[i-1]))
+        clique_pair_run_begin(structs[1].refr, i);
+
+      if(i == length - 1 || !char_is_exonic(refr_vector[i+1]))
+        clique_pair_run_end(structs[1].refr, i);
+    }
+    if(char_is_exonic(pred_vector[i]))
+    {
+      if(i == 0 || !char_is_exonic(pred_vector[i-1]))
+        clique_pair_run_begin(structs[1].pred, i);
+
+      if(i == length - 1 || !char_is_exonic(pred_vector[i+1]))
+        clique_pair_run_end(structs[1].pred, i);
+    }
+
+    // UTR structure counts
+    if(char_is_utric(refr_vector[i]))
+    {
+      if(i == 0 || !char_is_utric(refr_vector[i-1]))
+        clique_pair_run_begin(structs[2].refr, i);
+
+      if(i == length - 1 || !char_is_utric(refr_vector[i+1]))
+        clique_pair_run_end(structs[2].refr, i);
+    }
+    if(char_is_utric(pred_vector[i]))
+    {
+      if(i == 0 || !char_is_utric(pred_vector[i-1]))
+        clique_pair_run_begin(structs[2].pred, i);
+
+      if(i == length - 1 || !char_is_utric(pred_vector[i+1]))
+        clique_pair_run_end(structs[2].pred, i);
+    }
+  }
+}
+
+static ModelVectorKernel clique_pair_vector_kernel_select(void)
+{
+#ifdef AGN_SIMD_X86
+  if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+    return clique_pair_vector_kernel_avx2;
+  if(__builtin_cpu_supports("sse2"))
+    return clique_pair_vector_kernel_sse2;
+#endif
+  return clique_pair_vector_kernel_scalar;
+}
@@ -12,6 +12,7 @@ online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
 #include "AgnComparison.h"
 #include "AgnCompareReportText.h"
 #include "AgnLocus.h"
+#include "AgnUtils.h"
 
 #define compare_report_text_cast(GV)\
         gt_node_visitor_cast(compare_report_text_class(), GV)
@@ -25,9 +26,11 @@ struct AgnCompareReportText
   const GtNodeVisitor parent_instance;
   AgnComparisonData data;
   GtStrArray *seqids;
+  GtHashmap *seqdata;
   FILE *outstream;
   GtLogger *logger;
   GtUword locuscount;
+  GtWord predset;
   bool gff3;
 };
 
@@ -61,6 +64,14 @@ static void compare_report_text_comp_class_summary(AgnCompClassDesc *summ,
  */
 static void compare_report_text_free(GtNodeVisitor *nv);
 
+/**
+ * @function Get the data aggregated for the given sequence, creating it if
+ * necessary.
+ */
+static AgnComparisonData *compare_report_text_get_seqdata(
+                                                      AgnCompareReportText *rpt,
+                                                      const char *seqid);
+
 /**
  * @function Create a report for each locus.
  */
@@ -198,6 +209,92 @@ void agn_compare_report_text_create_summary(AgnCompareReportText *rpt,
           data->stats.utr_nuc_stats.eds, "--");
 }
 
+bool agn_compare_report_text_read_data(AgnCompareReportText *rpt,
+                                        FILE *instream, GtError *error)
+{
+  AgnComparisonData data, *seqdat;
+  GtUword locuscount, numseqs, i;
+  GtStr *seqid;
+  GtStrArray *seqids, *allseqids;
+  bool success = true;
+
+  agn_assert(rpt && instream);
+  gt_error_check(error);
+  if(!agn_uword_read(instream, &locuscount) ||
+     !agn_uword_read(instream, &numseqs))
+  {
+    gt_error_set(error, "truncated comparison data");
+    return false;
+  }
+
+  seqid = gt_str_new();
+  seqids = gt_str_array_new();
+  for(i = 0; i < numseqs; i++)
+  {
+    if(!agn_str_read(instream, seqid) ||
+       !agn_comparison_data_read(&data, instream))
+    {
+      gt_error_set(error, "truncated comparison data for sequence %lu", i + 1);
+      success = false;
+      break;
+    }
+    gt_str_array_add(seqids, seqid);
+    seqdat = compare_report_text_get_seqdata(rpt, gt_str_get(seqid));
+    agn_comparison_data_aggregate(seqdat, &data);
+    agn_comparison_resolve(&seqdat->stats);
+  }
+  if(success && !agn_comparison_data_read(&data, instream))
+  {
+    gt_error_set(error, "truncated comparison data");
+    success = false;
+  }
+
+  if(success)
+  {
+    rpt->locuscount += locuscount;
+    agn_comparison_data_aggregate(&rpt->data, &data);
+    agn_comparison_resolve(&rpt->data.stats);
+    allseqids = agn_str_array_union(rpt->seqids, seqids);
+    gt_str_array_delete(rpt->seqids);
+    rpt->seqids = allseqids;
+  }
+  gt_str_array_delete(seqids);
+  gt_str_delete(seqid);
+  return success;
+}
+
+void agn_compare_report_text_set_pred_set(AgnCompareReportText *rpt,
+                                          GtUword set)
+{
+  agn_assert(rpt);
+  rpt->predset = set;
+}
+
+bool agn_compare_report_text_write_data(AgnCompareReportText *rpt,
+                                        FILE *outstream)
+{
+  AgnComparisonData empty;
+  GtUword i, numseqs;
+
+  agn_assert(rpt && outstream);
+  agn_comparison_data_init(&empty);
+  numseqs = gt_str_array_size(rpt->seqids);
+  if(!agn_uword_write(outstream, rpt->locuscount) ||
+     !agn_uword_write(outstream, numseqs))
+    return false;
+  for(i = 0; i < numseqs; i++)
+  {
+    const char *seqid = gt_str_array_get(rpt->seqids, i);
+    AgnComparisonData *seqdat = gt_hashmap_get(rpt->seqdata, seqid);
+    if(seqdat == NULL)
+      seqdat = &empty;
+    if(!agn_str_write(outstream, seqid) ||
+       !agn_comparison_data_write(seqdat, outstream))
+      return false;
+  }
+  return agn_comparison_data_write(&rpt->data, outstream);
+}
+
 GtNodeVisitor *agn_compare_report_text_new(FILE *outstream, bool gff3,
                                            GtLogger *logger)
 {
@@ -205,10 +302,12 @@ GtNodeVisitor *agn_compare_report_text_new(FILE *outstream, bool gff3,
   AgnCompareReportText *rpt = compare_report_text_cast(nv);
   agn_comparison_data_init(&rpt->data);
   rpt->seqids = gt_str_array_new();
+  rpt->seqdata = gt_hashmap_new(GT_HASH_STRING, gt_free_func, gt_free_func);
   rpt->outstream = outstream;
   rpt->logger = logger;
   rpt->gff3 = gff3;
   rpt->locuscount = 0;
+  rpt->predset = -1;
 
   return nv;
 }
@@ -305,6 +404,21 @@ static void compare_report_text_free(GtNodeVisitor *nv)
 
   rpt = compare_report_text_cast(nv);
   gt_str_array_delete(rpt->seqids);
+  gt_hashmap_delete(rpt->seqdata);
+}
+
+static AgnComparisonData *compare_report_text_get_seqdata(
+                                                      AgnCompareReportText *rpt,
+                                                      const char *seqid)
+{
+  AgnComparisonData *seqdat = gt_hashmap_get(rpt->seqdata, seqid);
+  if(seqdat == NULL)
+  {
+    seqdat = gt_malloc( sizeof(AgnComparisonData) );
+    agn_comparison_data_init(seqdat);
+    gt_hashmap_add(rpt->seqdata, gt_cstr_dup(seqid), seqdat);
+  }
+  return seqdat;
 }
 
 static void compare_report_text_locus_gene_ids(AgnLocus *locus, FILE *outstream)
@@ -623,10 +737,18 @@ static int compare_report_text_visit_feature_node(GtNodeVisitor *nv,
   agn_assert(nv && fn && gt_feature_node_has_type(fn, "locus"));
 
   rpt = compare_report_text_cast(nv);
-  rpt->locuscount += 1;
   locus = (AgnLocus *)fn;
+  if(rpt->predset >= 0)
+  {
+    locus = agn_locus_get_pred_set(locus, rpt->predset);
+    if(locus == NULL)
+      return 0;
+  }
+  rpt->locuscount += 1;
   agn_locus_comparative_analysis(locus, rpt->logger);
   agn_locus_data_aggregate(locus, &rpt->data);
+  agn_locus_data_aggregate(locus, compare_report_text_get_seqdata(rpt,
+                           gt_str_get(gt_genome_node_get_seqid(locus))));
   compare_report_text_locus_handler(rpt, locus);
 
   return 0;
@@ -0,0 +1,512 @@
+/**
+
+Copyright (c) 2010-2014, Daniel S. Standage and CONTRIBUTORS
+
+The AEGeAn Toolkit is distributed under the ISC License. See
+the 'LICENSE' file in the AEGeAn source code distribution or
+online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
+
+**/
+#include <pthread.h>
+#include "core/queue_api.h"
+#include "extended/sort_stream_api.h"
+#include "AgnCompareStream.h"
+#include "AgnGeneStream.h"
+#include "AgnLocus.h"
+#include "AgnLocusStream.h"
+
+#define COMPARE_STREAM_BUFFER_PER_THREAD 16
+
+//------------------------------------------------------------------------------
+// Data structure definitions
+//------------------------------------------------------------------------------
+
+/**
+ * A node waiting in the stream's buffer. ``analyze`` is true for loci, which
+ * must be analyzed before they are delivered (unless their results were found
+ * in the cache); ``done`` is set once they have.
+ */
+typedef struct
+{
+  GtGenomeNode *node;
+  bool analyze;
+  bool done;
+} CompareJob;
+
+struct AgnCompareStream
+{
+  const GtNodeStream parent_instance;
+  GtNodeStream *in_stream;
+  GtLogger *logger;
+  AgnLocusCache *cache;
+  GtUword numthreads;
+  GtUword numworkers;
+  pthread_t *workers;
+  pthread_mutex_t mutex;
+  pthread_cond_t job_added;
+  pthread_cond_t job_done;
+  CompareJob *jobs;
+  GtUword capacity;
+  GtUword received;
+  GtUword claimed;
+  GtUword delivered;
+  bool input_done;
+  bool shutdown;
+};
+
+
+//------------------------------------------------------------------------------
+// Prototypes for private functions
+//------------------------------------------------------------------------------
+
+#define compare_stream_cast(GS)\
+        gt_node_stream_cast(compare_stream_class(), GS)
+
+/**
+ * @function Add a node pulled from the input stream to the buffer, making it
+ * available to the workers if it is a locus.
+ */
+static void compare_stream_add_job(AgnCompareStream *stream,
+                                   GtGenomeNode *node);
+
+/**
+ * @function Claim the oldest locus in the buffer that no thread has started
+ * analyzing yet, or return NULL if there is none. Must be called with the
+ * stream's mutex locked.
+ */
+static CompareJob *compare_stream_claim(AgnCompareStream *stream);
+
+/**
+ * @function Implements the GtNodeStream interface for this class.
+ */
+static const GtNodeStreamClass* compare_stream_class(void);
+
+/**
+ * @function Class destructor.
+ */
+static void compare_stream_free(GtNodeStream *ns);
+
+/**
+ * @function Returns true if the given node is a locus.
+ */
+static bool compare_stream_is_locus(GtGenomeNode *gn);
+
+/**
+ * @function Pulls nodes from the input stream, makes sure the comparative
+ * analysis of each locus is complete, and delivers nodes in the order they
+ * were received.
+ */
+static int compare_stream_next(GtNodeStream *ns, GtGenomeNode **gn,
+                               GtError *error);
+
+/**
+ * @function Pull the given data files through a compare stream using the given
+ * number of threads, and return the resulting nodes in an array. If
+ * ``predsets`` is true, the loci are labeled as for comparison with multiple
+ * prediction sets (here, a single set).
+ */
+static GtArray *compare_stream_test_data(const char **filenames,
+                                         GtUword numthreads, bool predsets);
+
+/**
+ * @function Worker thread main loop: analyze loci from the buffer until the
+ * stream is shut down.
+ */
+static void *compare_stream_worker(void *data);
+
+
+//------------------------------------------------------------------------------
+// Method implementations
+//------------------------------------------------------------------------------
+
+GtNodeStream* agn_compare_stream_new(GtNodeStream *in_stream,
+                                     GtUword numthreads, GtLogger *logger)
+{
+  GtNodeStream *ns;
+  AgnCompareStream *stream;
+  agn_assert(in_stream && numthreads > 0);
+  ns = gt_node_stream_create(compare_stream_class(), false);
+  stream = compare_stream_cast(ns);
+  stream->in_stream = gt_node_stream_ref(in_stream);
+  stream->logger = logger;
+  stream->cache = NULL;
+  stream->numthreads = numthreads;
+  stream->numworkers = 0;
+  stream->workers = NULL;
+  stream->jobs = NULL;
+  stream->capacity = numthreads * COMPARE_STREAM_BUFFER_PER_THREAD;
+  stream->received = 0;
+  stream->claimed = 0;
+  stream->delivered = 0;
+  stream->input_done = false;
+  stream->shutdown = false;
+  if(numthreads == 1)
+    return ns;
+
+  stream->jobs = gt_calloc(stream->capacity, sizeof(CompareJob));
+  pthread_mutex_init(&stream->mutex, NULL);
+  pthread_cond_init(&stream->job_added, NULL);
+  pthread_cond_init(&stream->job_done, NULL);
+
+  // The calling thread analyzes loci too while it waits for results, so if
+  // fewer workers can be started the stream is slower but still correct
+  stream->workers = gt_malloc( sizeof(pthread_t) * (numthreads - 1) );
+  GtUword i;
+  for(i = 0; i < numthreads - 1; i++)
+  {
+    if(pthread_create(stream->workers + i, NULL, compare_stream_worker,
+                      stream) != 0)
+      break;
+    stream->numworkers++;
+  }
+
+  return ns;
+}
+
+void agn_compare_stream_set_cache(AgnCompareStream *stream,
+                                  AgnLocusCache *cache)
+{
+  agn_assert(stream && cache);
+  stream->cache = cache;
+}
+
+bool agn_compare_stream_unit_test(AgnUnitTest *test)
+{
+  const char *filenames[] = { "data/gff3/pd0159-refr.gff3",
+                              "data/gff3/pd0159-pred.gff3" };
+  GtArray *serial = compare_stream_test_data(filenames, 1, false);
+  GtArray *parallel = compare_stream_test_data(filenames, 4, false);
+  GtArray *predsets = compare_stream_test_data(filenames, 4, true);
+
+  bool ordertest = gt_array_size(serial) > 0 &&
+                   gt_array_size(parallel) == gt_array_size(serial);
+  bool statstest = ordertest;
+  GtUword i;
+  for(i = 0; ordertest && i < gt_array_size(serial); i++)
+  {
+    AgnLocus *l1 = *(AgnLocus **)gt_array_get(serial, i);
+    AgnLocus *l2 = *(AgnLocus **)gt_array_get(parallel, i);
+    GtRange r1 = gt_genome_node_get_range(l1);
+    GtRange r2 = gt_genome_node_get_range(l2);
+    ordertest = gt_range_compare(&r1, &r2) == 0;
+
+    GtArray *pairs1 = agn_locus_pairs_to_report(l1);
+    GtArray *pairs2 = agn_locus_pairs_to_report(l2);
+    AgnComparison c1, c2;
+    agn_comparison_init(&c1);
+    agn_comparison_init(&c2);
+    agn_locus_comparison_aggregate(l1, &c1);
+    agn_locus_comparison_aggregate(l2, &c2);
+    agn_comparison_resolve(&c1);
+    agn_comparison_resolve(&c2);
+    statstest = statstest && (pairs1 == NULL) == (pairs2 == NULL) &&
+                (pairs1 == NULL || gt_array_size(pairs1)==gt_array_size(pairs2))
+                && agn_comparison_test(&c1, &c2) &&
+                c1.overall_matches == c2.overall_matches &&
+                c1.overall_length == c2.overall_length;
+  }
+  agn_unit_test_result(test, "locus order", ordertest);
+  agn_unit_test_result(test, "comparison stats", statstest);
+
+  bool setstest = gt_array_size(predsets) == gt_array_size(serial);
+  for(i = 0; setstest && i < gt_array_size(serial); i++)
+  {
+    AgnLocus *l1 = *(AgnLocus **)gt_array_get(serial, i);
+    AgnLocus *l2 = *(AgnLocus **)gt_array_get(predsets, i);
+    AgnLocus *setlocus = agn_locus_get_pred_set(l2, 0);
+    GtArray *pairs1 = agn_locus_pairs_to_report(l1);
+    GtArray *pairs2 = agn_locus_pairs_to_report(setlocus);
+    AgnComparison c1, c2;
+    agn_comparison_init(&c1);
+    agn_comparison_init(&c2);
+    agn_locus_comparison_aggregate(l1, &c1);
+    agn_locus_comparison_aggregate(setlocus, &c2);
+    agn_comparison_resolve(&c1);
+    agn_comparison_resolve(&c2);
+    setstest = agn_locus_num_pred_sets(l2) == 1 &&
+               agn_locus_num_refr_mrnas(l1)==agn_locus_num_refr_mrnas(setlocus)
+               && agn_locus_num_pred_mrnas(l1) ==
+                  agn_locus_num_pred_mrnas(setlocus) &&
+               (pairs1 == NULL) == (pairs2 == NULL) &&
+               (pairs1 == NULL || gt_array_size(pairs1)==gt_array_size(pairs2))
+               && agn_comparison_test(&c1, &c2) &&
+               c1.overall_matches == c2.overall_matches &&
+               c1.overall_length == c2.overall_length;
+  }
+  agn_unit_test_result(test, "prediction sets", setstest);
+
+  while(gt_array_size(serial) > 0)
+  {
+    AgnLocus **locus = gt_array_pop(serial);
+    agn_locus_delete(*locus);
+  }
+  while(gt_array_size(parallel) > 0)
+  {
+    AgnLocus **locus = gt_array_pop(parallel);
+    agn_locus_delete(*locus);
+  }
+  while(gt_array_size(predsets) > 0)
+  {
+    AgnLocus **locus = gt_array_pop(predsets);
+    agn_locus_delete(*locus);
+  }
+  gt_array_delete(serial);
+  gt_array_delete(parallel);
+  gt_array_delete(predsets);
+  return agn_unit_test_success(test);
+}
+
+static void compare_stream_add_job(AgnCompareStream *stream,
+                                   GtGenomeNode *node)
+{
+  // The cache is only used by the thread pulling nodes through the stream
+  bool analyze = compare_stream_is_locus(node);
+  if(analyze && stream->cache != NULL)
+    analyze = !agn_locus_cache_get(stream->cache, node);
+  if(analyze)
+  {
+    // Loci on the same sequence share a sequence ID string, whose reference
+    // count is not thread safe; give each locus its own copy
+    GtStr *seqid = gt_str_clone(gt_genome_node_get_seqid(node));
+    gt_genome_node_change_seqid(node, seqid);
+    gt_str_delete(seqid);
+  }
+
+  pthread_mutex_lock(&stream->mutex);
+  CompareJob *job = stream->jobs + stream->received % stream->capacity;
+  job->node = node;
+  job->analyze = analyze;
+  job->done = !analyze;
+  stream->received++;
+  if(analyze)
+    pthread_cond_signal(&stream->job_added);
+  pthread_mutex_unlock(&stream->mutex);
+}
+
+static CompareJob *compare_stream_claim(AgnCompareStream *stream)
+{
+  // Nodes that need no analysis may be delivered before any thread looks at
+  // them; never revisit a buffer slot that has been recycled
+  if(stream->claimed < stream->delivered)
+    stream->claimed = stream->delivered;
+
+  while(stream->claimed < stream->received)
+  {
+    CompareJob *job = stream->jobs + stream->claimed % stream->capacity;
+    stream->claimed++;
+    if(job->analyze)
+      return job;
+  }
+  return NULL;
+}
+
+static const GtNodeStreamClass *compare_stream_class(void)
+{
+  static const GtNodeStreamClass *nsc = NULL;
+  if(!nsc)
+  {
+    nsc = gt_node_stream_class_new(sizeof (AgnCompareStream),
+                                   compare_stream_free,
+                                   compare_stream_next);
+  }
+  return nsc;
+}
+
+static void compare_stream_free(GtNodeStream *ns)
+{
+  AgnCompareStream *stream = compare_stream_cast(ns);
+  gt_node_stream_delete(stream->in_stream);
+  if(stream->numthreads == 1)
+    return;
+
+  pthread_mutex_lock(&stream->mutex);
+  stream->shutdown = true;
+  pthread_cond_broadcast(&stream->job_added);
+  pthread_mutex_unlock(&stream->mutex);
+  GtUword i;
+  for(i = 0; i < stream->numworkers; i++)
+    pthread_join(stream->workers[i], NULL);
+
+  // Nodes left over if the caller stopped pulling early (e.g. after an error)
+  for(i = stream->delivered; i < stream->received; i++)
+    gt_genome_node_delete(stream->jobs[i % stream->capacity].node);
+
+  pthread_cond_destroy(&stream->job_added);
+  pthread_cond_destroy(&stream->job_done);
+  pthread_mutex_destroy(&stream->mutex);
+  gt_free(stream->workers);
+  gt_free(stream->jobs);
+}
+
+static bool compare_stream_is_locus(GtGenomeNode *gn)
+{
+  GtFeatureNode *fn = gt_feature_node_try_cast(gn);
+  return fn != NULL && gt_feature_node_has_type(fn, "locus");
+}
+
+static int compare_stream_next(GtNodeStream *ns, GtGenomeNode **gn,
+                               GtError *error)
+{
+  AgnCompareStream *stream;
+  gt_error_check(error);
+  stream = compare_stream_cast(ns);
+
+  if(stream->numthreads == 1)
+  {
+    int had_err = gt_node_stream_next(stream->in_stream, gn, error);
+    if(had_err || !*gn)
+      return had_err;
+    if(!compare_stream_is_locus(*gn))
+      return 0;
+    if(stream->cache != NULL && agn_locus_cache_get(stream->cache, *gn))
+      return 0;
+    agn_locus_comparative_analysis(*gn, stream->logger);
+    if(stream->cache != NULL && !agn_locus_cache_put(stream->cache, *gn))
+    {
+      gt_error_set(error, "could not add locus to cache");
+      return -1;
+    }
+    return 0;
+  }
+
+  // Keep the buffer full so that the workers always have loci to analyze
+  while(!stream->input_done &&
+        stream->received - stream->delivered < stream->capacity)
+  {
+    GtGenomeNode *node;
+    int had_err = gt_node_stream_next(stream->in_stream, &node, error);
+    if(had_err)
+      return had_err;
+    if(node == NULL)
+      stream->input_done = true;
+    else
+      compare_stream_add_job(stream, node);
+  }
+
+  if(stream->delivered == stream->received)
+  {
+    *gn = NULL;
+    return 0;
+  }
+
+  // Wait for the oldest node; rather than sitting idle while a large locus is
+  // analyzed, take on loci that no other thread has started yet
+  pthread_mutex_lock(&stream->mutex);
+  CompareJob *job = stream->jobs + stream->delivered % stream->capacity;
+  while(!job->done)
+  {
+    CompareJob *pending = compare_stream_claim(stream);
+    if(pending == NULL)
+    {
+      pthread_cond_wait(&stream->job_done, &stream->mutex);
+      continue;
+    }
+    pthread_mutex_unlock(&stream->mutex);
+    agn_locus_comparative_analysis(pending->node, stream->logger);
+    pthread_mutex_lock(&stream->mutex);
+    pending->done = true;
+  }
+  *gn = job->node;
+  bool analyzed = job->analyze;
+  job->node = NULL;
+  stream->delivered++;
+  pthread_mutex_unlock(&stream->mutex);
+
+  if(analyzed && stream->cache != NULL &&
+     !agn_locus_cache_put(stream->cache, *gn))
+  {
+    gt_error_set(error, "could not add locus to cache");
+    gt_genome_node_delete(*gn);
+    *gn = NULL;
+    return -1;
+  }
+  return 0;
+}
+
+static GtArray *compare_stream_test_data(const char **filenames,
+                                         GtUword numthreads, bool predsets)
+{
+  GtNodeStream *current_stream, *last_stream;
+  GtQueue *streams = gt_queue_new();
+  GtLogger *logger = gt_logger_new(true, "", stderr);
+  GtError *error = gt_error_new();
+
+  current_stream = gt_gff3_in_stream_new_unsorted(2, filenames);
+  gt_gff3_in_stream_check_id_attributes((GtGFF3InStream *)current_stream);
+  gt_gff3_in_stream_enable_tidy_mode((GtGFF3InStream *)current_stream);
+  gt_queue_add(streams, current_stream);
+  last_stream = current_stream;
+
+  current_stream = gt_sort_stream_new(last_stream);
+  gt_queue_add(streams, current_stream);
+  last_stream = current_stream;
+
+  current_stream = agn_gene_stream_new(last_stream, logger);
+  gt_queue_add(streams, current_stream);
+  last_stream = current_stream;
+
+  current_stream = agn_locus_stream_new(last_stream, 0);
+  agn_locus_stream_skip_iiLoci((AgnLocusStream *)current_stream);
+  if(predsets)
+  {
+    agn_locus_stream_label_multi((AgnLocusStream *)current_stream,
+                                 filenames[0], 1, filenames + 1);
+  }
+  else
+  {
+    agn_locus_stream_label_pairwise((AgnLocusStream *)current_stream,
+                                    filenames[0], filenames[1]);
+  }
+  gt_queue_add(streams, current_stream);
+  last_stream = current_stream;
+
+  current_stream = agn_compare_stream_new(last_stream, numthreads, logger);
+  gt_queue_add(streams, current_stream);
+  last_stream = current_stream;
+
+  GtArray *loci = gt_array_new( sizeof(AgnLocus *) );
+  current_stream = gt_array_out_stream_new(last_stream, loci, error);
+  gt_queue_add(streams, current_stream);
+  last_stream = current_stream;
+
+  int result = gt_node_stream_pull(last_stream, error);
+  if(result == -1)
+  {
+    fprintf(stderr, "error loading unit test data: %s\n", gt_error_get(error));
+    exit(1);
+  }
+
+  while(gt_queue_size(streams) > 0)
+  {
+    GtNodeStream *ns = gt_queue_get(streams);
+    gt_node_stream_delete(ns);
+  }
+  gt_queue_delete(streams);
+  gt_logger_delete(logger);
+  gt_error_delete(error);
+  return loci;
+}
+
+static void *compare_stream_worker(void *data)
+{
+  AgnCompareStream *stream = data;
+  pthread_mutex_lock(&stream->mutex);
+  while(true)
+  {
+    CompareJob *job = compare_stream_claim(stream);
+    if(job == NULL)
+    {
+      if(stream->shutdown)
+        break;
+      pthread_cond_wait(&stream->job_added, &stream->mutex);
+      continue;
+    }
+    pthread_mutex_unlock(&stream->mutex);
+    agn_locus_comparative_analysis(job->node, stream->logger);
+    pthread_mutex_lock(&stream->mutex);
+    job->done = true;
+    pthread_cond_signal(&stream->job_done);
+  }
+  pthread_mutex_unlock(&stream->mutex);
+  return NULL;
+}
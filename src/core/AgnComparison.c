@@ -10,6 +10,76 @@ online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
 #include <math.h>
 #include <stdio.h>
 #include "AgnComparison.h"
+#include "AgnUtils.h"
+
+#define COMPARISON_NUM_COUNTS      19
+#define COMPARISON_DATA_NUM_COUNTS 63
+
+/**
+ * @function Collect pointers to each of the counts in ``comparison`` (in a
+ * fixed order) so that they can be serialized; the stats are all derived from
+ * these.
+ */
+static void comparison_counts(AgnComparison *comparison, GtUword **counts)
+{
+  AgnCompStatsScaled *scaled[] = { &comparison->cds_nuc_stats,
+                                   &comparison->utr_nuc_stats };
+  AgnCompStatsBinary *binary[] = { &comparison->cds_struc_stats,
+                                   &comparison->exon_struc_stats,
+                                   &comparison->utr_struc_stats };
+  GtUword i, n = 0;
+
+  for(i = 0; i < 2; i++)
+  {
+    counts[n++] = &scaled[i]->tp;
+    counts[n++] = &scaled[i]->fn;
+    counts[n++] = &scaled[i]->fp;
+    counts[n++] = &scaled[i]->tn;
+  }
+  for(i = 0; i < 3; i++)
+  {
+    counts[n++] = &binary[i]->correct;
+    counts[n++] = &binary[i]->missing;
+    counts[n++] = &binary[i]->wrong;
+  }
+  counts[n++] = &comparison->overall_matches;
+  counts[n++] = &comparison->overall_length;
+  agn_assert(n == COMPARISON_NUM_COUNTS);
+}
+
+/**
+ * @function Same as ``comparison_counts``, for all of the counts in ``data``.
+ */
+static void comparison_data_counts(AgnComparisonData *data, GtUword **counts)
+{
+  AgnCompClassDesc *descs[] = { &data->summary.perfect_matches,
+                                &data->summary.perfect_mislabeled,
+                                &data->summary.cds_matches,
+                                &data->summary.exon_matches,
+                                &data->summary.utr_matches,
+                                &data->summary.non_matches };
+  GtUword i, n = 0;
+
+  for(i = 0; i < 6; i++)
+  {
+    counts[n++] = &descs[i]->comparison_count;
+    counts[n++] = &descs[i]->total_length;
+    counts[n++] = &descs[i]->refr_cds_length;
+    counts[n++] = &descs[i]->pred_cds_length;
+    counts[n++] = &descs[i]->refr_exon_count;
+    counts[n++] = &descs[i]->pred_exon_count;
+  }
+  counts[n++] = &data->info.num_loci;
+  counts[n++] = &data->info.unique_refr_loci;
+  counts[n++] = &data->info.unique_pred_loci;
+  counts[n++] = &data->info.refr_genes;
+  counts[n++] = &data->info.pred_genes;
+  counts[n++] = &data->info.refr_transcripts;
+  counts[n++] = &data->info.pred_transcripts;
+  counts[n++] = &data->info.num_comparisons;
+  comparison_counts(&data->stats, counts + n);
+  agn_assert(n + COMPARISON_NUM_COUNTS == COMPARISON_DATA_NUM_COUNTS);
+}
 
 void agn_comparison_aggregate(AgnComparison *a, AgnComparison *b)
 {
@@ -30,6 +100,22 @@ void agn_comparison_data_aggregate(AgnComparisonData *agg_data,
   agn_comparison_aggregate(&agg_data->stats, &data->stats);
 }
 
+bool agn_comparison_data_read(AgnComparisonData *data, FILE *instream)
+{
+  GtUword *counts[COMPARISON_DATA_NUM_COUNTS];
+  GtUword i;
+
+  agn_comparison_data_init(data);
+  comparison_data_counts(data, counts);
+  for(i = 0; i < COMPARISON_DATA_NUM_COUNTS; i++)
+  {
+    if(!agn_uword_read(instream, counts[i]))
+      return false;
+  }
+  agn_comparison_resolve(&data->stats);
+  return true;
+}
+
 void agn_comparison_data_init(AgnComparisonData *data)
 {
   agn_comp_class_summary_init(&data->summary);
@@ -37,6 +123,20 @@ void agn_comparison_data_init(AgnComparisonData *data)
   agn_comparison_init(&data->stats);
 }
 
+bool agn_comparison_data_write(AgnComparisonData *data, FILE *outstream)
+{
+  GtUword *counts[COMPARISON_DATA_NUM_COUNTS];
+  GtUword i;
+
+  comparison_data_counts(data, counts);
+  for(i = 0; i < COMPARISON_DATA_NUM_COUNTS; i++)
+  {
+    if(!agn_uword_write(outstream, *counts[i]))
+      return false;
+  }
+  return true;
+}
+
 void agn_comparison_init(AgnComparison *comparison)
 {
   agn_comp_stats_scaled_init(&comparison->cds_nuc_stats);
@@ -65,6 +165,22 @@ void agn_comparison_print(AgnComparison *stats, FILE *outstream)
           stats->overall_matches, stats->overall_length);
 }
 
+bool agn_comparison_read(AgnComparison *comparison, FILE *instream)
+{
+  GtUword *counts[COMPARISON_NUM_COUNTS];
+  GtUword i;
+
+  agn_comparison_init(comparison);
+  comparison_counts(comparison, counts);
+  for(i = 0; i < COMPARISON_NUM_COUNTS; i++)
+  {
+    if(!agn_uword_read(instream, counts[i]))
+      return false;
+  }
+  agn_comparison_resolve(comparison);
+  return true;
+}
+
 void agn_comparison_resolve(AgnComparison *comparison)
 {
   agn_comp_stats_scaled_resolve(&comparison->cds_nuc_stats);
@@ -83,15 +199,29 @@ bool agn_comparison_test(AgnComparison *c1, AgnComparison *c2)
      agn_comp_stats_binary_test(&c1->utr_struc_stats, &c2->utr_struc_stats);
 }
 
+bool agn_comparison_write(AgnComparison *comparison, FILE *outstream)
+{
+  GtUword *counts[COMPARISON_NUM_COUNTS];
+  GtUword i;
+
+  comparison_counts(comparison, counts);
+  for(i = 0; i < COMPARISON_NUM_COUNTS; i++)
+  {
+    if(!agn_uword_write(outstream, *counts[i]))
+      return false;
+  }
+  return true;
+}
+
 void agn_comp_class_desc_aggregate(AgnCompClassDesc *agg_desc,
                                    AgnCompClassDesc *desc)
 {
-  agg_desc->comparison_count = desc->comparison_count;
-  agg_desc->total_length = desc->total_length;
-  agg_desc->refr_cds_length = desc->refr_cds_length;
-  agg_desc->pred_cds_length = desc->pred_cds_length;
-  agg_desc->refr_exon_count = desc->refr_exon_count;
-  agg_desc->pred_exon_count = desc->pred_exon_count;
+  agg_desc->comparison_count += desc->comparison_count;
+  agg_desc->total_length += desc->total_length;
+  agg_desc->refr_cds_length += desc->refr_cds_length;
+  agg_desc->pred_cds_length += desc->pred_cds_length;
+  agg_desc->refr_exon_count += desc->refr_exon_count;
+  agg_desc->pred_exon_count += desc->pred_exon_count;
 }
 
 void agn_comp_class_desc_init(AgnCompClassDesc *desc)
@@ -129,14 +259,14 @@ void agn_comp_class_summary_init(AgnCompClassSummary *summ)
 
 void agn_comp_info_aggregate(AgnCompInfo *agg_info, AgnCompInfo *info)
 {
-  agg_info->num_loci = info->num_loci;
-  agg_info->unique_refr_loci = info->unique_refr_loci;
-  agg_info->unique_pred_loci = info->unique_pred_loci;
-  agg_info->refr_genes = info->refr_genes;
-  agg_info->pred_genes = info->pred_genes;
-  agg_info->refr_transcripts = info->refr_transcripts;
-  agg_info->pred_transcripts = info->pred_transcripts;
-  agg_info->num_comparisons = info->num_comparisons;
+  agg_info->num_loci += info->num_loci;
+  agg_info->unique_refr_loci += info->unique_refr_loci;
+  agg_info->unique_pred_loci += info->unique_pred_loci;
+  agg_info->refr_genes += info->refr_genes;
+  agg_info->pred_genes += info->pred_genes;
+  agg_info->refr_transcripts += info->refr_transcripts;
+  agg_info->pred_transcripts += info->pred_transcripts;
+  agg_info->num_comparisons += info->num_comparisons;
 }
 
 void agn_comp_info_init(AgnCompInfo *info)
@@ -0,0 +1,598 @@
+/**
+
+Copyright (c) 2010-2016, Daniel S. Standage and CONTRIBUTORS
+
+The AEGeAn Toolkit is distributed under the ISC License. See
+the 'LICENSE' file in the AEGeAn source code distribution or
+online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
+
+**/
+#include <pthread.h>
+#include <unistd.h>
+#include "core/queue_api.h"
+#include "AgnGaevalParallelStream.h"
+#include "AgnGaevalVisitor.h"
+#include "AgnInferCDSVisitor.h"
+#include "AgnInferExonsVisitor.h"
+#include "AgnMergeStream.h"
+#include "AgnTypecheck.h"
+#include "AgnUtils.h"
+
+#define GAEVAL_PARALLEL_STREAM_BUFFER_PER_THREAD 16
+
+//------------------------------------------------------------------------------
+// Data structure definitions
+//------------------------------------------------------------------------------
+
+/**
+ * A node waiting in the stream's buffer. Feature nodes have a ``job``, which
+ * must be run before they are delivered; ``done`` is set once it has.
+ */
+typedef struct
+{
+  GtGenomeNode *node;
+  AgnGaevalJob *job;
+  bool done;
+} GaevalSlot;
+
+struct AgnGaevalParallelStream
+{
+  const GtNodeStream parent_instance;
+  GtNodeStream *in_stream;
+  GtNodeVisitor *visitor;
+  GtUword numthreads;
+  GtUword numworkers;
+  pthread_t *workers;
+  pthread_mutex_t mutex;
+  pthread_cond_t job_added;
+  pthread_cond_t job_done;
+  GaevalSlot *slots;
+  GtUword capacity;
+  GtUword received;
+  GtUword claimed;
+  GtUword delivered;
+  bool input_done;
+  bool shutdown;
+};
+
+
+//------------------------------------------------------------------------------
+// Prototypes for private functions
+//------------------------------------------------------------------------------
+
+#define gaeval_parallel_stream_cast(GS)\
+        gt_node_stream_cast(gaeval_parallel_stream_class(), GS)
+
+/**
+ * @function Add a node pulled from the input stream to the buffer, creating a
+ * job for it and making the job available to the workers if it is a feature.
+ * Returns -1 (deleting the node) if the job could not be created.
+ */
+static int gaeval_parallel_stream_add_job(AgnGaevalParallelStream *stream,
+                                          GtGenomeNode *node, GtError *error);
+
+/**
+ * @function Claim the oldest job in the buffer that no thread has started
+ * running yet, or return NULL if there is none. Must be called with the
+ * stream's mutex locked.
+ */
+static GaevalSlot *
+gaeval_parallel_stream_claim(AgnGaevalParallelStream *stream);
+
+/**
+ * @function Implements the GtNodeStream interface for this class.
+ */
+static const GtNodeStreamClass* gaeval_parallel_stream_class(void);
+
+/**
+ * @function Class destructor.
+ */
+static void gaeval_parallel_stream_free(GtNodeStream *ns);
+
+/**
+ * @function Pulls nodes from the input stream, makes sure the job of each
+ * feature has been run, and delivers nodes (writing their TSV rows) in the
+ * order they were received.
+ */
+static int gaeval_parallel_stream_next(GtNodeStream *ns, GtGenomeNode **gn,
+                                       GtError *error);
+
+/**
+ * @function Write ``numgenes`` synthetic gene models and the transcript
+ * alignments overlapping them, sorted by sequence ID and position, to the
+ * given file for unit testing. Gene models have one or two mRNAs of three or
+ * four exons and up to five alignments, some on the opposite strand and some
+ * skipping the first exon, so that scores vary from gene to gene.
+ */
+static void gaeval_parallel_stream_test_data(const char *filename,
+                                             GtUword numgenes);
+
+/**
+ * @function Score the gene models in the given file against the alignments in
+ * the same file, and return a description of the output: the type and
+ * position of each node with the scores of each mRNA, followed by the
+ * contents of the TSV output. If ``numthreads`` is 1 a visitor stream is used,
+ * otherwise a parallel stream with the given number of threads.
+ */
+static GtStr *gaeval_parallel_stream_test_run(const char *filename,
+                                              bool sorted, GtUword numthreads);
+
+/**
+ * @function Worker thread main loop: run jobs from the buffer until the stream
+ * is shut down.
+ */
+static void *gaeval_parallel_stream_worker(void *data);
+
+
+//------------------------------------------------------------------------------
+// Method implementations
+//------------------------------------------------------------------------------
+
+GtNodeStream *agn_gaeval_parallel_stream_new(GtNodeStream *in_stream,
+                                             GtNodeVisitor *nv,
+                                             GtUword numthreads)
+{
+  GtNodeStream *ns;
+  AgnGaevalParallelStream *stream;
+  agn_assert(in_stream && nv && numthreads > 0);
+  ns = gt_node_stream_create(gaeval_parallel_stream_class(), false);
+  stream = gaeval_parallel_stream_cast(ns);
+  stream->in_stream = gt_node_stream_ref(in_stream);
+  stream->visitor = nv;
+  stream->numthreads = numthreads;
+  stream->numworkers = 0;
+  stream->workers = NULL;
+  stream->slots = NULL;
+  stream->capacity = numthreads * GAEVAL_PARALLEL_STREAM_BUFFER_PER_THREAD;
+  stream->received = 0;
+  stream->claimed = 0;
+  stream->delivered = 0;
+  stream->input_done = false;
+  stream->shutdown = false;
+  if(numthreads == 1)
+    return ns;
+
+  stream->slots = gt_calloc(stream->capacity, sizeof(GaevalSlot));
+  pthread_mutex_init(&stream->mutex, NULL);
+  pthread_cond_init(&stream->job_added, NULL);
+  pthread_cond_init(&stream->job_done, NULL);
+
+  // The calling thread runs jobs too while it waits for results, so if fewer
+  // workers can be started the stream is slower but still correct
+  stream->workers = gt_malloc( sizeof(pthread_t) * (numthreads - 1) );
+  GtUword i;
+  for(i = 0; i < numthreads - 1; i++)
+  {
+    if(pthread_create(stream->workers + i, NULL, gaeval_parallel_stream_worker,
+                      stream) != 0)
+      break;
+    stream->numworkers++;
+  }
+
+  return ns;
+}
+
+bool agn_gaeval_parallel_stream_unit_test(AgnUnitTest *test)
+{
+  char filename[] = "/tmp/agn-gaeval-parallel-stream-XXXXXX";
+  int fd = mkstemp(filename);
+  agn_assert(fd != -1);
+  close(fd);
+  gaeval_parallel_stream_test_data(filename, 300);
+
+  // Run each configuration several times, since a race between threads
+  // scoring gene models would only show up now and then
+  GtUword numthreads[] = { 2, 4, 8 };
+  const char *labels[] = { "alignment index", "sorted input" };
+  int mode;
+  for(mode = 0; mode < 2; mode++)
+  {
+    GtStr *serial = gaeval_parallel_stream_test_run(filename, mode == 1, 1);
+    bool scoretest = gt_str_length(serial) > 0;
+    GtUword i, j;
+    for(i = 0; i < sizeof(numthreads) / sizeof(numthreads[0]); i++)
+    {
+      for(j = 0; j < 5; j++)
+      {
+        GtStr *parallel = gaeval_parallel_stream_test_run(filename, mode == 1,
+                                                          numthreads[i]);
+        scoretest = scoretest && gt_str_cmp(serial, parallel) == 0;
+        gt_str_delete(parallel);
+      }
+    }
+    agn_unit_test_result(test, labels[mode], scoretest);
+    gt_str_delete(serial);
+  }
+
+  unlink(filename);
+  return agn_unit_test_success(test);
+}
+
+static int gaeval_parallel_stream_add_job(AgnGaevalParallelStream *stream,
+                                          GtGenomeNode *node, GtError *error)
+{
+  // Jobs are created in input order by the thread pulling nodes, and hold
+  // copies of the alignment data; workers only touch the nodes of their own
+  // feature
+  AgnGaevalJob *job = NULL;
+  GtFeatureNode *fn = gt_feature_node_try_cast(node);
+  if(fn != NULL)
+  {
+    AgnGaevalVisitor *v = (AgnGaevalVisitor *)stream->visitor;
+    job = agn_gaeval_visitor_job_new(v, fn, error);
+    if(job == NULL)
+    {
+      gt_genome_node_delete(node);
+      return -1;
+    }
+  }
+
+  pthread_mutex_lock(&stream->mutex);
+  GaevalSlot *slot = stream->slots + stream->received % stream->capacity;
+  slot->node = node;
+  slot->job = job;
+  slot->done = job == NULL;
+  stream->received++;
+  if(job != NULL)
+    pthread_cond_signal(&stream->job_added);
+  pthread_mutex_unlock(&stream->mutex);
+  return 0;
+}
+
+static GaevalSlot *
+gaeval_parallel_stream_claim(AgnGaevalParallelStream *stream)
+{
+  // Nodes without a job may be delivered before any thread looks at them;
+  // never revisit a buffer slot that has been recycled
+  if(stream->claimed < stream->delivered)
+    stream->claimed = stream->delivered;
+
+  while(stream->claimed < stream->received)
+  {
+    GaevalSlot *slot = stream->slots + stream->claimed % stream->capacity;
+    stream->claimed++;
+    if(slot->job != NULL)
+      return slot;
+  }
+  return NULL;
+}
+
+static const GtNodeStreamClass *gaeval_parallel_stream_class(void)
+{
+  static const GtNodeStreamClass *nsc = NULL;
+  if(!nsc)
+  {
+    nsc = gt_node_stream_class_new(sizeof (AgnGaevalParallelStream),
+                                   gaeval_parallel_stream_free,
+                                   gaeval_parallel_stream_next);
+  }
+  return nsc;
+}
+
+static void gaeval_parallel_stream_free(GtNodeStream *ns)
+{
+  AgnGaevalParallelStream *stream = gaeval_parallel_stream_cast(ns);
+  gt_node_stream_delete(stream->in_stream);
+  if(stream->numthreads == 1)
+  {
+    gt_node_visitor_delete(stream->visitor);
+    return;
+  }
+
+  pthread_mutex_lock(&stream->mutex);
+  stream->shutdown = true;
+  pthread_cond_broadcast(&stream->job_added);
+  pthread_mutex_unlock(&stream->mutex);
+  GtUword i;
+  for(i = 0; i < stream->numworkers; i++)
+    pthread_join(stream->workers[i], NULL);
+
+  // Nodes left over if the caller stopped pulling early (e.g. after an error)
+  for(i = stream->delivered; i < stream->received; i++)
+  {
+    GaevalSlot *slot = stream->slots + i % stream->capacity;
+    if(slot->job != NULL)
+      agn_gaeval_visitor_job_delete(slot->job);
+    gt_genome_node_delete(slot->node);
+  }
+
+  pthread_cond_destroy(&stream->job_added);
+  pthread_cond_destroy(&stream->job_done);
+  pthread_mutex_destroy(&stream->mutex);
+  gt_free(stream->workers);
+  gt_free(stream->slots);
+  gt_node_visitor_delete(stream->visitor);
+}
+
+static int gaeval_parallel_stream_next(GtNodeStream *ns, GtGenomeNode **gn,
+                                       GtError *error)
+{
+  AgnGaevalParallelStream *stream;
+  gt_error_check(error);
+  stream = gaeval_parallel_stream_cast(ns);
+  AgnGaevalVisitor *v = (AgnGaevalVisitor *)stream->visitor;
+
+  if(stream->numthreads == 1)
+  {
+    int had_err = gt_node_stream_next(stream->in_stream, gn, error);
+    if(had_err || !*gn)
+      return had_err;
+    GtFeatureNode *fn = gt_feature_node_try_cast(*gn);
+    if(fn == NULL)
+      return 0;
+    AgnGaevalJob *job = agn_gaeval_visitor_job_new(v, fn, error);
+    if(job == NULL)
+    {
+      gt_genome_node_delete(*gn);
+      *gn = NULL;
+      return -1;
+    }
+    agn_gaeval_visitor_job_run(v, job);
+    agn_gaeval_visitor_job_finish(v, job);
+    return 0;
+  }
+
+  // Keep the buffer full so that the workers always have jobs to run
+  while(!stream->input_done &&
+        stream->received - stream->delivered < stream->capacity)
+  {
+    GtGenomeNode *node;
+    int had_err = gt_node_stream_next(stream->in_stream, &node, error);
+    if(had_err)
+      return had_err;
+    if(node == NULL)
+      stream->input_done = true;
+    else if(gaeval_parallel_stream_add_job(stream, node, error) != 0)
+      return -1;
+  }
+
+  if(stream->delivered == stream->received)
+  {
+    *gn = NULL;
+    return 0;
+  }
+
+  // Wait for the oldest node; rather than sitting idle while a large gene is
+  // scored, take on jobs that no other thread has started yet
+  pthread_mutex_lock(&stream->mutex);
+  GaevalSlot *slot = stream->slots + stream->delivered % stream->capacity;
+  while(!slot->done)
+  {
+    GaevalSlot *pending = gaeval_parallel_stream_claim(stream);
+    if(pending == NULL)
+    {
+      pthread_cond_wait(&stream->job_done, &stream->mutex);
+      continue;
+    }
+    pthread_mutex_unlock(&stream->mutex);
+    agn_gaeval_visitor_job_run(v, pending->job);
+    pthread_mutex_lock(&stream->mutex);
+    pending->done = true;
+  }
+  *gn = slot->node;
+  AgnGaevalJob *job = slot->job;
+  slot->node = NULL;
+  slot->job = NULL;
+  stream->delivered++;
+  pthread_mutex_unlock(&stream->mutex);
+
+  if(job != NULL)
+    agn_gaeval_visitor_job_finish(v, job);
+  return 0;
+}
+
+static void gaeval_parallel_stream_test_data(const char *filename,
+                                             GtUword numgenes)
+{
+  FILE *outstream = fopen(filename, "w");
+  agn_assert(outstream != NULL);
+  fputs("##gff-version 3\n", outstream);
+  GtUword g;
+  for(g = 0; g < numgenes; g++)
+  {
+    GtUword seqnum = g / 100;
+    GtUword start = 1000 + (g % 100) * 4000;
+    GtUword end = start + 3 * 600 + 299;
+    char strand = g % 3 == 0 ? '-' : '+';
+    fprintf(outstream, "chr%lu\tAEGeAn\tgene\t%lu\t%lu\t.\t%c\t.\tID=gene%lu\n",
+            seqnum, start, end, strand, g);
+    GtUword numrnas = g % 5 == 0 ? 2 : 1;
+    GtUword r, k;
+    for(r = 0; r < numrnas; r++)
+    {
+      fprintf(outstream, "chr%lu\tAEGeAn\tmRNA\t%lu\t%lu\t.\t%c\t.\t"
+              "ID=mRNA%lu.%lu;Parent=gene%lu\n", seqnum, start, end, strand, g,
+              r, g);
+      for(k = 0; k < 4; k++)
+      {
+        // The second mRNA skips the third exon
+        if(r == 1 && k == 2)
+          continue;
+        GtUword exonstart = start + k * 600;
+        fprintf(outstream, "chr%lu\tAEGeAn\texon\t%lu\t%lu\t.\t%c\t.\t"
+                "Parent=mRNA%lu.%lu\n", seqnum, exonstart, exonstart + 299,
+                strand, g, r);
+      }
+    }
+    fputs("###\n", outstream);
+
+    // Alignments starting at the first exon (even) precede those starting at
+    // the second exon (odd), so that they are sorted by start position
+    GtUword numalignments = g % 6;
+    GtUword a, pass;
+    for(pass = 0; pass < 2; pass++)
+    {
+      for(a = pass; a < numalignments; a += 2)
+      {
+        char alnstrand = strand;
+        if(a == 4)
+          alnstrand = strand == '+' ? '-' : '+';
+        for(k = a % 2; k < 4; k++)
+        {
+          GtUword segstart = start + k * 600;
+          GtUword segend = segstart + 299;
+          if(k == a % 2)
+            segstart += a * 7;
+          if(k == 3)
+            segend -= a * 5;
+          fprintf(outstream, "chr%lu\tAEGeAn\tEST_match\t%lu\t%lu\t.\t%c\t.\t"
+                  "ID=match%lu.%lu\n", seqnum, segstart, segend, alnstrand, g,
+                  a);
+        }
+      }
+    }
+    if(numalignments > 0)
+      fputs("###\n", outstream);
+  }
+  fclose(outstream);
+}
+
+static GtStr *gaeval_parallel_stream_test_run(const char *filename,
+                                              bool sorted, GtUword numthreads)
+{
+  char tsvfile[] = "/tmp/agn-gaeval-parallel-stream-tsv-XXXXXX";
+  int fd = mkstemp(tsvfile);
+  agn_assert(fd != -1);
+  close(fd);
+
+  AgnGaevalParams params = { 0.6, 0.3, 0.05, 0.05, 400, 200, 100 };
+  GtLogger *logger = gt_logger_new(true, "", stderr);
+  GtError *error = gt_error_new();
+  GtQueue *streams = gt_queue_new();
+  GtNodeStream *current_stream, *last_stream, *align_stream;
+
+  if(sorted)
+    current_stream = agn_merge_stream_new_gff3(1, &filename);
+  else
+  {
+    current_stream = gt_gff3_in_stream_new_unsorted(1, &filename);
+    gt_gff3_in_stream_enable_tidy_mode((GtGFF3InStream *)current_stream);
+  }
+  gt_queue_add(streams, current_stream);
+  align_stream = current_stream;
+
+  if(sorted)
+    current_stream = agn_merge_stream_new_gff3(1, &filename);
+  else
+  {
+    current_stream = gt_gff3_in_stream_new_unsorted(1, &filename);
+    gt_gff3_in_stream_enable_tidy_mode((GtGFF3InStream *)current_stream);
+  }
+  gt_queue_add(streams, current_stream);
+  last_stream = current_stream;
+
+  current_stream = agn_infer_cds_stream_new(last_stream, NULL, logger);
+  gt_queue_add(streams, current_stream);
+  last_stream = current_stream;
+
+  current_stream = agn_infer_exons_stream_new(last_stream, NULL, logger);
+  gt_queue_add(streams, current_stream);
+  last_stream = current_stream;
+
+  GtNodeVisitor *nv;
+  if(sorted)
+    nv = agn_gaeval_visitor_new_sorted(align_stream, params);
+  else
+    nv = agn_gaeval_visitor_new(align_stream, params);
+  GtStr *tsvname = gt_str_new_cstr(tsvfile);
+  agn_gaeval_visitor_tsv_out((AgnGaevalVisitor *)nv, tsvname);
+  gt_str_delete(tsvname);
+  if(numthreads == 1)
+    current_stream = gt_visitor_stream_new(last_stream, nv);
+  else
+    current_stream = agn_gaeval_parallel_stream_new(last_stream, nv,
+                                                     numthreads);
+  gt_queue_add(streams, current_stream);
+  last_stream = current_stream;
+
+  GtArray *feats = gt_array_new( sizeof(GtGenomeNode *) );
+  current_stream = gt_array_out_stream_new(last_stream, feats, error);
+  gt_queue_add(streams, current_stream);
+  last_stream = current_stream;
+
+  int result = gt_node_stream_pull(last_stream, error);
+  if(result == -1)
+  {
+    fprintf(stderr, "[AgnGaevalParallelStream::gaeval_parallel_stream_test_run]"
+            " error processing GFF3: %s\n", gt_error_get(error));
+  }
+
+  // Deleting the streams deletes the visitor, which closes the TSV file
+  while(gt_queue_size(streams) > 0)
+  {
+    GtNodeStream *ns = gt_queue_get(streams);
+    gt_node_stream_delete(ns);
+  }
+  gt_queue_delete(streams);
+
+  GtStr *output = gt_str_new();
+  GtUword i;
+  for(i = 0; i < gt_array_size(feats); i++)
+  {
+    GtFeatureNode *fn = *(GtFeatureNode **)gt_array_get(feats, i);
+    GtRange range = gt_genome_node_get_range((GtGenomeNode *)fn);
+    gt_str_append_cstr(output, gt_feature_node_get_type(fn));
+    gt_str_append_char(output, ' ');
+    gt_str_append_uword(output, range.start);
+    GtFeatureNodeIterator *iter = gt_feature_node_iterator_new(fn);
+    GtFeatureNode *feat;
+    for(feat  = gt_feature_node_iterator_next(iter);
+        feat != NULL;
+        feat  = gt_feature_node_iterator_next(iter))
+    {
+      if(!agn_typecheck_mrna(feat))
+        continue;
+      const char *cov, *itg;
+      cov = gt_feature_node_get_attribute(feat, "gaeval_coverage");
+      itg = gt_feature_node_get_attribute(feat, "gaeval_integrity");
+      gt_str_append_char(output, ' ');
+      gt_str_append_cstr(output, cov ? cov : "NA");
+      gt_str_append_char(output, ' ');
+      gt_str_append_cstr(output, itg ? itg : "NA");
+    }
+    gt_feature_node_iterator_delete(iter);
+    gt_str_append_char(output, '\n');
+    gt_genome_node_delete((GtGenomeNode *)fn);
+  }
+  gt_array_delete(feats);
+
+  FILE *instream = fopen(tsvfile, "r");
+  agn_assert(instream != NULL);
+  char buffer[4096];
+  size_t n;
+  while((n = fread(buffer, 1, sizeof(buffer), instream)) > 0)
+    gt_str_append_cstr_nt(output, buffer, n);
+  fclose(instream);
+  unlink(tsvfile);
+
+  gt_error_delete(error);
+  gt_logger_delete(logger);
+  if(result == -1)
+    gt_str_reset(output);
+  return output;
+}
+
+static void *gaeval_parallel_stream_worker(void *data)
+{
+  AgnGaevalParallelStream *stream = data;
+  AgnGaevalVisitor *v = (AgnGaevalVisitor *)stream->visitor;
+  pthread_mutex_lock(&stream->mutex);
+  while(true)
+  {
+    GaevalSlot *slot = gaeval_parallel_stream_claim(stream);
+    if(slot == NULL)
+    {
+      if(stream->shutdown)
+        break;
+      pthread_cond_wait(&stream->job_added, &stream->mutex);
+      continue;
+    }
+    pthread_mutex_unlock(&stream->mutex);
+    agn_gaeval_visitor_job_run(v, slot->job);
+    pthread_mutex_lock(&stream->mutex);
+    slot->done = true;
+    pthread_cond_signal(&stream->job_done);
+  }
+  pthread_mutex_unlock(&stream->mutex);
+  return NULL;
+}
@@ -10,6 +10,7 @@ online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
 
 #include <math.h>
 #include <string.h>
+#include <time.h>
 #include "core/array_api.h"
 #include "core/queue_api.h"
 #include "extended/feature_index_memory_api.h"
@@ -17,6 +18,7 @@ online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
 #include "AgnGaevalVisitor.h"
 #include "AgnInferCDSVisitor.h"
 #include "AgnInferExonsVisitor.h"
+#include "AgnMergeStream.h"
 #include "AgnTypecheck.h"
 #include "AgnUtils.h"
 
@@ -31,40 +33,120 @@ struct AgnGaevalVisitor
 {
   const GtNodeVisitor parent_instance;
   GtFeatureIndex *alignments;
+  GtQueue *astreams;
+  GtNodeStream *astream;
+  GtArray *window;
+  GtGenomeNode *pending;
   FILE *tsvout;
   AgnGaevalParams params;
 };
 
+struct AgnGaevalJob
+{
+  GtArray *contexts;
+  GtStr *rows;
+};
+
+/**
+ * @type The aligned segments of one alignment overlapping an mRNA, stored as a
+ * slice of the ``segments`` array of a ``GaevalContext``.
+ */
+typedef struct
+{
+  GtUword first_segment;
+  GtUword num_segments;
+  bool same_strand;
+} GaevalAlignment;
+
+/**
+ * @type Everything needed to score one mRNA, gathered in a single pass over the
+ * mRNA and over each overlapping alignment. Exon, intron, segment, and gap
+ * intervals are stored as flat arrays of ``GtRange`` objects.
+ */
+typedef struct
+{
+  GtFeatureNode *mrna;
+  GtStrand strand;
+  GtArray *exons;
+  GtArray *introns;
+  GtArray *intron_support;
+  GtArray *alignments;
+  GtArray *segments;
+  GtArray *gaps;
+  GtUword exon_length;
+  GtUword cds_length;
+  GtUword utr5p_length;
+  GtUword utr3p_length;
+} GaevalContext;
+
 
 //----------------------------------------------------------------------------//
 // Prototypes of private functions
 //----------------------------------------------------------------------------//
 
 /**
- * @function Calculate coverage for the given gene model.
+ * @function Set up the node streams that select alignments from ``astream``
+ * and add ``match_gap`` features to them, adding each stream to ``streams``.
+ * If the visitor has a feature index, alignments are stored in it as they are
+ * pulled through. Returns the last stream.
  */
-static double gaeval_visitor_calculate_coverage(AgnGaevalVisitor *v,
-                                                GtFeatureNode *genemodel,
-                                                GtError *error);
+static GtNodeStream *gaeval_visitor_alignment_stream(AgnGaevalVisitor *v,
+                                                     GtNodeStream *astream,
+                                                     GtQueue *streams);
 
 /**
- * @function Calculate integrity for the given gene model.
+ * @function Calculate coverage for the mRNA of the given context.
+ */
+static double gaeval_visitor_calculate_coverage(GaevalContext *ctx);
+
+/**
+ * @function Calculate integrity for the mRNA of the given context.
  */
 static double gaeval_visitor_calculate_integrity(AgnGaevalVisitor *v,
-                                                 GtFeatureNode *genemodel,
+                                                 GaevalContext *ctx,
                                                  double coverage,
-                                                 double *components,
-                                                 GtError *error);
+                                                 double *components);
 
 /**
  * @function Cast a node visitor object as a AgnGaevalVisitor.
  */
 static const GtNodeVisitorClass* gaeval_visitor_class();
 
+/**
+ * @function Add the aligned segments and gaps of ``alignment`` to the context.
+ */
+static void gaeval_visitor_context_add_alignment(GaevalContext *ctx,
+                                                 GtFeatureNode *alignment);
+
+/**
+ * @function Free the memory held by the context.
+ */
+static void gaeval_visitor_context_free(GaevalContext *ctx);
+
+/**
+ * @function Gather the exons, introns, and feature lengths of ``mrna`` and (if
+ * ``v`` is not NULL) the alignments overlapping it, querying the alignments
+ * only once.
+ */
+static void gaeval_visitor_context_init(AgnGaevalVisitor *v,
+                                        GaevalContext *ctx, GtFeatureNode *mrna,
+                                        GtError *error);
+
+/**
+ * @function Create an mRNA with ``numexons`` exons and ``numalignments``
+ * single-segment alignments scattered across its exons and introns, and load
+ * them into the given context. The mRNA and alignments are stored in ``nodes``
+ * for later deletion.
+ */
+static void gaeval_visitor_context_synthetic(GaevalContext *ctx,
+                                             GtUword numexons,
+                                             GtUword numalignments,
+                                             GtArray *nodes);
+
 /**
  * @function Add up exon and match lengths to calculate coverage.
  */
-static double gaeval_visitor_coverage_resolve(GtFeatureNode *genemodel,
+static double gaeval_visitor_coverage_resolve(GaevalContext *ctx,
                                               GtArray *exon_coverage);
 
 /**
@@ -73,17 +155,36 @@ static double gaeval_visitor_coverage_resolve(GtFeatureNode *genemodel,
 static void gaeval_visitor_free(GtNodeVisitor *nv);
 
 /**
- * @function Determine the ranges of overlap, if any, between the gene model and
- * the alignment. Returns NULL if there is no overlap.
+ * @function Add the ranges of overlap, if any, between the exons of the
+ * context's mRNA and its ``i``th alignment to ``covered_parts``. Returns false
+ * if the alignment is on the other strand.
  */
-static GtArray*
-gaeval_visitor_intersect(GtGenomeNode *genemodel, GtGenomeNode *alignment);
+static bool gaeval_visitor_intersect(GaevalContext *ctx, GtUword i,
+                                     GtArray *covered_parts);
 
 /**
  * @function Calculate the proportion of introns confirmed by gaps in
- * overlapping alignments.
+ * overlapping alignments. Both arrays hold ``GtRange`` objects. The number of
+ * gaps matching each intron exactly is stored in ``support``, which must have
+ * room for one value per intron. Introns are indexed by their coordinates in
+ * an open-addressing hash table, so each gap is matched in constant time.
+ */
+static double gaeval_visitor_introns_confirmed(GtArray *introns, GtArray *gaps,
+                                               GtUword *support);
+
+/**
+ * @function Store the alignments overlapping the given gene model in
+ * ``overlapping``, taking them from the feature index or (for sorted input)
+ * from the window of alignments.
  */
-static double gaeval_visitor_introns_confirmed(GtArray *introns, GtArray *gaps);
+static void gaeval_visitor_overlapping(AgnGaevalVisitor *v,
+                                       GtFeatureNode *genemodel,
+                                       GtArray *overlapping, GtError *error);
+
+/**
+ * @function Hash function for exact intron and gap coordinates.
+ */
+static GtUword gaeval_visitor_range_hash(GtRange *range);
 
 /**
  * @function Determine the overlap, if any, between the two ranges. Returns the
@@ -91,16 +192,24 @@ static double gaeval_visitor_introns_confirmed(GtArray *introns, GtArray *gaps);
  */
 static GtRange gaeval_visitor_range_intersect(GtRange *r1, GtRange *r2);
 
+/**
+ * @function Calculate the coverage and integrity of an mRNA, add them to the
+ * mRNA as attributes, and append its TSV row to ``rows`` (if not NULL).
+ */
+static void gaeval_visitor_score(AgnGaevalVisitor *v, GaevalContext *ctx,
+                                 GtStr *rows);
+
 /**
  * @function Typecheck select function for grabbing `match_gap` features.
  */
 static bool gaeval_visitor_typecheck_gap(GtFeatureNode *fn);
 
 /**
- * @function Used to bombine the coverage from individual alignments into a
- * single aggregate coverage.
+ * @function Used to combine the coverage from individual alignments into a
+ * single aggregate coverage. The ranges are sorted once and overlapping ranges
+ * are merged in place in a single pass.
  */
-static GtArray *gaeval_visitor_union(GtArray *cov1, GtArray *cov2);
+static void gaeval_visitor_union(GtArray *coverage);
 
 /**
  * @function Procedure for processing feature nodes (the only node of interest
@@ -110,6 +219,15 @@ static int
 gaeval_visitor_visit_feature_node(GtNodeVisitor *nv, GtFeatureNode *fn,
                                   GtError *error);
 
+/**
+ * @function For sorted input, bring the window of alignments up to date with
+ * the given top-level feature: pull every alignment that starts before the end
+ * of the feature from the alignment stream, and discard alignments that end
+ * before its start (no later feature can overlap them).
+ */
+static int gaeval_visitor_window_advance(AgnGaevalVisitor *v,
+                                         GtFeatureNode *fn, GtError *error);
+
 /**
  * @function Unit test for coverage calculations.
  */
@@ -140,6 +258,11 @@ static void gv_test_introns_confirmed(AgnUnitTest *test);
  */
 static void gv_test_range_intersect(AgnUnitTest *test);
 
+/**
+ * @function Unit test for scoring sorted input with a window of alignments.
+ */
+static void gv_test_sorted(AgnUnitTest *test);
+
 /**
  * @function Unit test for `gaeval_visitor_union` function.
  */
@@ -158,6 +281,101 @@ GtNodeStream *agn_gaeval_stream_new(GtNodeStream *in, GtNodeStream *astream,
   return ns;
 }
 
+bool agn_gaeval_visitor_benchmark(AgnUnitTest *test)
+{
+  // The alignments cover every exon nucleotide at each of these sizes
+  GtUword sizes[] = { 1000, 2000, 4000, 8000 };
+  GtUword i;
+  for(i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+  {
+    char label[64];
+    GaevalContext ctx;
+    GtArray *nodes = gt_array_new( sizeof(GtGenomeNode *) );
+    gaeval_visitor_context_synthetic(&ctx, 10, sizes[i], nodes);
+
+    clock_t start = clock();
+    double coverage = gaeval_visitor_calculate_coverage(&ctx);
+    clock_t end = clock();
+    double elapsed = (double)(end - start) / CLOCKS_PER_SEC;
+
+    printf("        [coverage] %5lu alignments: %.3fs\n", sizes[i], elapsed);
+    sprintf(label, "full coverage, %lu alignments", sizes[i]);
+    agn_unit_test_result(test, label, coverage == 1.0);
+
+    gaeval_visitor_context_free(&ctx);
+    while(gt_array_size(nodes) > 0)
+    {
+      GtGenomeNode **gn = gt_array_pop(nodes);
+      gt_genome_node_delete(*gn);
+    }
+    gt_array_delete(nodes);
+  }
+  return agn_unit_test_success(test);
+}
+
+void agn_gaeval_visitor_job_delete(AgnGaevalJob *job)
+{
+  agn_assert(job);
+  while(gt_array_size(job->contexts) > 0)
+  {
+    GaevalContext *ctx = gt_array_pop(job->contexts);
+    gaeval_visitor_context_free(ctx);
+  }
+  gt_array_delete(job->contexts);
+  if(job->rows != NULL)
+    gt_str_delete(job->rows);
+  gt_free(job);
+}
+
+void agn_gaeval_visitor_job_finish(AgnGaevalVisitor *v, AgnGaevalJob *job)
+{
+  agn_assert(v && job);
+  if(job->rows != NULL)
+    fputs(gt_str_get(job->rows), v->tsvout);
+  agn_gaeval_visitor_job_delete(job);
+}
+
+AgnGaevalJob *agn_gaeval_visitor_job_new(AgnGaevalVisitor *v, GtFeatureNode *fn,
+                                         GtError *error)
+{
+  agn_assert(v && fn);
+  if(v->alignments == NULL &&
+     gaeval_visitor_window_advance(v, fn, error) != 0)
+    return NULL;
+
+  AgnGaevalJob *job = gt_malloc( sizeof(AgnGaevalJob) );
+  job->contexts = gt_array_new( sizeof(GaevalContext) );
+  job->rows = v->tsvout != NULL ? gt_str_new() : NULL;
+
+  GtFeatureNodeIterator *feats = gt_feature_node_iterator_new(fn);
+  GtFeatureNode *tempfeat;
+  for(tempfeat  = gt_feature_node_iterator_next(feats);
+      tempfeat != NULL;
+      tempfeat  = gt_feature_node_iterator_next(feats))
+  {
+    if(agn_typecheck_mrna(tempfeat) == false)
+      continue;
+
+    GaevalContext ctx;
+    gaeval_visitor_context_init(v, &ctx, tempfeat, error);
+    gt_array_add(job->contexts, ctx);
+  }
+  gt_feature_node_iterator_delete(feats);
+
+  return job;
+}
+
+void agn_gaeval_visitor_job_run(AgnGaevalVisitor *v, AgnGaevalJob *job)
+{
+  agn_assert(v && job);
+  GtUword i;
+  for(i = 0; i < gt_array_size(job->contexts); i++)
+  {
+    GaevalContext *ctx = gt_array_get(job->contexts, i);
+    gaeval_visitor_score(v, ctx, job->rows);
+  }
+}
+
 GtNodeVisitor*
 agn_gaeval_visitor_new(GtNodeStream *astream, AgnGaevalParams gparams)
 {
@@ -167,6 +385,10 @@ agn_gaeval_visitor_new(GtNodeStream *astream, AgnGaevalParams gparams)
   GtNodeVisitor *nv = gt_node_visitor_create(gaeval_visitor_class());
   AgnGaevalVisitor *v = gaeval_visitor_cast(nv);
   v->alignments = gt_feature_index_memory_new();
+  v->astreams = NULL;
+  v->astream = NULL;
+  v->window = NULL;
+  v->pending = NULL;
   v->tsvout = NULL;
   v->params = gparams;
 
@@ -184,30 +406,7 @@ agn_gaeval_visitor_new(GtNodeStream *astream, AgnGaevalParams gparams)
   // Set up node stream to load alignment features into memory
   GtQueue *streams = gt_queue_new();
   GtNodeStream *stream, *last_stream;
-  GtHashmap *typestokeep = gt_hashmap_new(GT_HASH_STRING, NULL, NULL);
-  gt_hashmap_add(typestokeep, "cDNA_match", "cDNA_match");
-  gt_hashmap_add(typestokeep, "EST_match", "EST_match");
-  gt_hashmap_add(typestokeep, "nucleotide_match", "nucleotide_match");
-  stream = agn_filter_stream_new(astream, typestokeep);
-  gt_queue_add(streams, stream);
-  last_stream = stream;
-
-  stream = gt_feature_out_stream_new(last_stream, v->alignments);
-  gt_queue_add(streams, stream);
-  last_stream = stream;
-
-  stream = gt_inter_feature_stream_new(last_stream, "cDNA_match", "match_gap");
-  gt_queue_add(streams, stream);
-  last_stream = stream;
-
-  stream = gt_inter_feature_stream_new(last_stream, "EST_match", "match_gap");
-  gt_queue_add(streams, stream);
-  last_stream = stream;
-
-  stream = gt_inter_feature_stream_new(last_stream, "nucleotide_match",
-                                       "match_gap");
-  gt_queue_add(streams, stream);
-  last_stream = stream;
+  last_stream = gaeval_visitor_alignment_stream(v, astream, streams);
 
   // Process the node stream
   GtError *error = gt_error_new();
@@ -220,7 +419,6 @@ agn_gaeval_visitor_new(GtNodeStream *astream, AgnGaevalParams gparams)
     return NULL;
   }
   gt_error_delete(error);
-  gt_hashmap_delete(typestokeep);
   while(gt_queue_size(streams) > 0)
   {
     stream = gt_queue_get(streams);
@@ -231,6 +429,33 @@ agn_gaeval_visitor_new(GtNodeStream *astream, AgnGaevalParams gparams)
   return nv;
 }
 
+GtNodeVisitor*
+agn_gaeval_visitor_new_sorted(GtNodeStream *astream, AgnGaevalParams gparams)
+{
+  agn_assert(astream);
+
+  GtNodeVisitor *nv = gt_node_visitor_create(gaeval_visitor_class());
+  AgnGaevalVisitor *v = gaeval_visitor_cast(nv);
+  v->alignments = NULL;
+  v->astreams = gt_queue_new();
+  v->astream = gaeval_visitor_alignment_stream(v, astream, v->astreams);
+  v->window = gt_array_new( sizeof(GtGenomeNode *) );
+  v->pending = NULL;
+  v->tsvout = NULL;
+  v->params = gparams;
+
+  double weights_total = gparams.alpha + gparams.beta +
+                         gparams.gamma + gparams.epsilon;
+  if(fabs(weights_total - 1.0) > 0.0001)
+  {
+    fprintf(stderr, "[AgnGaevalVisitor::agn_gaeval_visitor_new_sorted] "
+            "warning: sum of weights is not 1.0 %.3lf; integrity calculations "
+            "will be incorrect\n", weights_total);
+  }
+
+  return nv;
+}
+
 void agn_gaeval_visitor_tsv_out(AgnGaevalVisitor *v, GtStr *tsvfilename)
 {
   v->tsvout = fopen(gt_str_get(tsvfilename), "w");
@@ -240,7 +465,8 @@ void agn_gaeval_visitor_tsv_out(AgnGaevalVisitor *v, GtStr *tsvfilename)
             gt_str_get(tsvfilename));
     exit(1);
   }
-  fprintf(v->tsvout, "ID\tLabel\tIntegrity\tCoverage\tNumIntrons\tA\tB\tΓ\tE\n");
+  fprintf(v->tsvout, "ID\tLabel\tIntegrity\tCoverage\tNumIntrons\tA\tB\tΓ\tE\t"
+          "IntronSupport\n");
 }
 
 bool agn_gaeval_visitor_unit_test(AgnUnitTest *test)
@@ -252,6 +478,7 @@ bool agn_gaeval_visitor_unit_test(AgnUnitTest *test)
   gv_test_introns_confirmed(test);
   gv_test_calc_integrity(test);
   gv_test_calc_integrity_simple(test);
+  gv_test_sorted(test);
   return agn_unit_test_success(test);
 }
 
@@ -268,109 +495,97 @@ static const GtNodeVisitorClass* gaeval_visitor_class()
   return nvc;
 }
 
-static double gaeval_visitor_calculate_coverage(AgnGaevalVisitor *v,
-                                                GtFeatureNode *genemodel,
-                                                GtError *error)
+static GtNodeStream *gaeval_visitor_alignment_stream(AgnGaevalVisitor *v,
+                                                     GtNodeStream *astream,
+                                                     GtQueue *streams)
 {
-  agn_assert(v && genemodel);
+  GtNodeStream *stream, *last_stream;
+  GtHashmap *typestokeep = gt_hashmap_new(GT_HASH_STRING, NULL, NULL);
+  gt_hashmap_add(typestokeep, "cDNA_match", "cDNA_match");
+  gt_hashmap_add(typestokeep, "EST_match", "EST_match");
+  gt_hashmap_add(typestokeep, "nucleotide_match", "nucleotide_match");
+  stream = agn_filter_stream_new(astream, typestokeep);
+  gt_queue_add(streams, stream);
+  last_stream = stream;
+  gt_hashmap_delete(typestokeep);
 
-  GtStr *seqid = gt_genome_node_get_seqid((GtGenomeNode *)genemodel);
-  GtRange mrna_range = gt_genome_node_get_range((GtGenomeNode *)genemodel);
-  GtArray *overlapping = gt_array_new( sizeof(GtFeatureNode *) );
-  bool hasseqid;
-  gt_feature_index_has_seqid(v->alignments, &hasseqid, gt_str_get(seqid),error);
-  if(hasseqid)
+  if(v->alignments != NULL)
   {
-    gt_feature_index_get_features_for_range(v->alignments, overlapping,
-                                            gt_str_get(seqid), &mrna_range,
-                                            error);
+    stream = gt_feature_out_stream_new(last_stream, v->alignments);
+    gt_queue_add(streams, stream);
+    last_stream = stream;
   }
 
+  stream = gt_inter_feature_stream_new(last_stream, "cDNA_match", "match_gap");
+  gt_queue_add(streams, stream);
+  last_stream = stream;
+
+  stream = gt_inter_feature_stream_new(last_stream, "EST_match", "match_gap");
+  gt_queue_add(streams, stream);
+  last_stream = stream;
+
+  stream = gt_inter_feature_stream_new(last_stream, "nucleotide_match",
+                                       "match_gap");
+  gt_queue_add(streams, stream);
+  last_stream = stream;
+
+  return last_stream;
+}
+
+static double gaeval_visitor_calculate_coverage(GaevalContext *ctx)
+{
+  agn_assert(ctx);
+
+  // Gather the covered parts of all alignments, then merge them all at once
   GtArray *exon_coverage = gt_array_new( sizeof(GtRange) );
   GtUword i;
-  for(i = 0; i < gt_array_size(overlapping); i++)
-  {
-    GtFeatureNode *alignment = *(GtFeatureNode **)gt_array_get(overlapping, i);
-    GtArray *covered_parts = gaeval_visitor_intersect((GtGenomeNode*)genemodel,
-                                                      (GtGenomeNode*)alignment);
-    if(covered_parts != NULL)
-    {
-      GtArray *temp = gaeval_visitor_union(exon_coverage, covered_parts);
-      gt_array_delete(covered_parts);
-      gt_array_delete(exon_coverage);
-      exon_coverage = temp;
-    }
-  }
-  double coverage = gaeval_visitor_coverage_resolve(genemodel, exon_coverage);
+  for(i = 0; i < gt_array_size(ctx->alignments); i++)
+    gaeval_visitor_intersect(ctx, i, exon_coverage);
+  gaeval_visitor_union(exon_coverage);
+  double coverage = gaeval_visitor_coverage_resolve(ctx, exon_coverage);
   gt_array_delete(exon_coverage);
-  gt_array_delete(overlapping);
 
   return coverage;
 }
 
 static double gaeval_visitor_calculate_integrity(AgnGaevalVisitor *v,
-                                                 GtFeatureNode *genemodel,
+                                                 GaevalContext *ctx,
                                                  double coverage,
-                                                 double *components,
-                                                 GtError *error)
+                                                 double *components)
 {
-  agn_assert(v && genemodel);
-
-  GtStr *seqid = gt_genome_node_get_seqid((GtGenomeNode *)genemodel);
-  GtRange mrna_range = gt_genome_node_get_range((GtGenomeNode *)genemodel);
-  GtArray *overlapping = gt_array_new( sizeof(GtFeatureNode *) );
-  bool hasseqid;
-  gt_feature_index_has_seqid(v->alignments, &hasseqid, gt_str_get(seqid),error);
-  if(hasseqid)
-  {
-    gt_feature_index_get_features_for_range(v->alignments, overlapping,
-                                            gt_str_get(seqid), &mrna_range,
-                                            error);
-  }
-
-  GtArray *gaps = gt_array_new( sizeof(GtFeatureNode *) );
-  while(gt_array_size(overlapping) > 0)
-  {
-    GtFeatureNode *alignment = *(GtFeatureNode **)gt_array_pop(overlapping);
-    GtArray *agaps = agn_typecheck_select(alignment,
-                                          gaeval_visitor_typecheck_gap);
-    gt_array_add_array(gaps, agaps);
-    gt_array_delete(agaps);
-  }
-  gt_array_delete(overlapping);
+  agn_assert(v && ctx);
 
-  GtUword utr5p_len = agn_mrna_5putr_length(genemodel);
   double utr5p_score = 0.0;
-  if(utr5p_len >= v->params.exp_5putr_len)
+  if(ctx->utr5p_length >= v->params.exp_5putr_len)
     utr5p_score = 1.0;
   else
-    utr5p_score = (double)utr5p_len / (double)v->params.exp_5putr_len;
+    utr5p_score = (double)ctx->utr5p_length / (double)v->params.exp_5putr_len;
 
-  GtUword utr3p_len = agn_mrna_3putr_length(genemodel);
   double utr3p_score = 0.0;
-  if(utr3p_len >= v->params.exp_3putr_len)
+  if(ctx->utr3p_length >= v->params.exp_3putr_len)
     utr3p_score = 1.0;
   else
-    utr3p_score = (double)utr3p_len / (double)v->params.exp_3putr_len;
+    utr3p_score = (double)ctx->utr3p_length / (double)v->params.exp_3putr_len;
 
-  GtArray *introns = agn_typecheck_select(genemodel, agn_typecheck_intron);
-  GtUword exoncount = agn_typecheck_count(genemodel, agn_typecheck_exon);
-  agn_assert(gt_array_size(introns) == exoncount - 1);
+  agn_assert(gt_array_size(ctx->introns) == gt_array_size(ctx->exons) - 1);
   double structure_score = 0.0;
-  if(gt_array_size(introns) == 0)
+  if(gt_array_size(ctx->introns) == 0)
   {
-    GtUword cdslen = agn_mrna_cds_length(genemodel);
-    if(cdslen >= v->params.exp_cds_len)
+    if(ctx->cds_length >= v->params.exp_cds_len)
       structure_score = 1.0;
     else
-      structure_score = (double)cdslen / (double)v->params.exp_cds_len;
+      structure_score = (double)ctx->cds_length / (double)v->params.exp_cds_len;
   }
   else
   {
-    structure_score = gaeval_visitor_introns_confirmed(introns, gaps);
+    GtUword i, zero = 0;
+    gt_array_reset(ctx->intron_support);
+    for(i = 0; i < gt_array_size(ctx->introns); i++)
+      gt_array_add(ctx->intron_support, zero);
+    GtUword *support = gt_array_get_space(ctx->intron_support);
+    structure_score = gaeval_visitor_introns_confirmed(ctx->introns, ctx->gaps,
+                                                       support);
   }
-  gt_array_delete(gaps);
-  gt_array_delete(introns);
 
   double integrity = (v->params.alpha   * structure_score) +
                      (v->params.beta    * coverage)        +
@@ -387,14 +602,147 @@ static double gaeval_visitor_calculate_integrity(AgnGaevalVisitor *v,
   return integrity;
 }
 
-static double gaeval_visitor_coverage_resolve(GtFeatureNode *genemodel,
-                                              GtArray *exon_coverage)
+static void gaeval_visitor_context_add_alignment(GaevalContext *ctx,
+                                                 GtFeatureNode *alignment)
 {
-  agn_assert(genemodel && exon_coverage);
-  agn_assert(gt_feature_node_has_type(genemodel, "mRNA"));
+  agn_assert(ctx && alignment);
+  GaevalAlignment aln;
+  aln.first_segment = gt_array_size(ctx->segments);
+  aln.num_segments = 0;
+  aln.same_strand = gt_feature_node_get_strand(alignment) == ctx->strand;
+
+  GtFeatureNodeIterator *iter = gt_feature_node_iterator_new(alignment);
+  GtFeatureNode *part;
+  for(part  = gt_feature_node_iterator_next(iter);
+      part != NULL;
+      part  = gt_feature_node_iterator_next(iter))
+  {
+    GtRange range = gt_genome_node_get_range((GtGenomeNode *)part);
+    if(gaeval_visitor_typecheck_gap(part))
+      gt_array_add(ctx->gaps, range);
+    else
+    {
+      gt_array_add(ctx->segments, range);
+      aln.num_segments++;
+    }
+  }
+  gt_feature_node_iterator_delete(iter);
+  gt_array_add(ctx->alignments, aln);
+}
 
-  GtUword cum_exon_length =
-      agn_typecheck_feature_combined_length(genemodel, agn_typecheck_exon);
+static void gaeval_visitor_context_free(GaevalContext *ctx)
+{
+  gt_array_delete(ctx->exons);
+  gt_array_delete(ctx->introns);
+  gt_array_delete(ctx->intron_support);
+  gt_array_delete(ctx->alignments);
+  gt_array_delete(ctx->segments);
+  gt_array_delete(ctx->gaps);
+}
+
+static void gaeval_visitor_context_init(AgnGaevalVisitor *v,
+                                        GaevalContext *ctx, GtFeatureNode *mrna,
+                                        GtError *error)
+{
+  agn_assert(ctx && mrna);
+  agn_assert(gt_feature_node_has_type(mrna, "mRNA"));
+  ctx->mrna = mrna;
+  ctx->strand = gt_feature_node_get_strand(mrna);
+  ctx->exons = gt_array_new( sizeof(GtRange) );
+  ctx->introns = gt_array_new( sizeof(GtRange) );
+  ctx->intron_support = gt_array_new( sizeof(GtUword) );
+  ctx->alignments = gt_array_new( sizeof(GaevalAlignment) );
+  ctx->segments = gt_array_new( sizeof(GtRange) );
+  ctx->gaps = gt_array_new( sizeof(GtRange) );
+  ctx->exon_length = 0;
+  ctx->cds_length = 0;
+  ctx->utr5p_length = 0;
+  ctx->utr3p_length = 0;
+
+  GtFeatureNodeIterator *iter = gt_feature_node_iterator_new(mrna);
+  GtFeatureNode *child;
+  for(child  = gt_feature_node_iterator_next(iter);
+      child != NULL;
+      child  = gt_feature_node_iterator_next(iter))
+  {
+    GtRange range = gt_genome_node_get_range((GtGenomeNode *)child);
+    if(agn_typecheck_exon(child))
+    {
+      gt_array_add(ctx->exons, range);
+      ctx->exon_length += gt_range_length(&range);
+    }
+    else if(agn_typecheck_intron(child))
+      gt_array_add(ctx->introns, range);
+    else if(agn_typecheck_cds(child))
+      ctx->cds_length += gt_range_length(&range);
+    else if(agn_typecheck_utr5p(child))
+      ctx->utr5p_length += gt_range_length(&range);
+    else if(agn_typecheck_utr3p(child))
+      ctx->utr3p_length += gt_range_length(&range);
+  }
+  gt_feature_node_iterator_delete(iter);
+  gt_array_sort(ctx->exons, (GtCompare)gt_range_compare);
+  gt_array_sort(ctx->introns, (GtCompare)gt_range_compare);
+
+  if(v == NULL)
+    return;
+
+  GtArray *overlapping = gt_array_new( sizeof(GtFeatureNode *) );
+  gaeval_visitor_overlapping(v, mrna, overlapping, error);
+  GtUword i;
+  for(i = 0; i < gt_array_size(overlapping); i++)
+  {
+    GtFeatureNode *alignment = *(GtFeatureNode **)gt_array_get(overlapping, i);
+    gaeval_visitor_context_add_alignment(ctx, alignment);
+  }
+  gt_array_delete(overlapping);
+}
+
+static void gaeval_visitor_context_synthetic(GaevalContext *ctx,
+                                             GtUword numexons,
+                                             GtUword numalignments,
+                                             GtArray *nodes)
+{
+  GtStr *seqid = gt_str_new_cstr("chr");
+  GtUword end = 1000 + (numexons * 500) - 300;
+  GtGenomeNode *mrna = gt_feature_node_new(seqid, "mRNA", 1001, end,
+                                           GT_STRAND_FORWARD);
+  gt_array_add(nodes, mrna);
+  GtUword i;
+  for(i = 0; i < numexons; i++)
+  {
+    GtUword start = 1001 + (i * 500);
+    GtGenomeNode *exon = gt_feature_node_new(seqid, "exon", start, start + 199,
+                                             GT_STRAND_FORWARD);
+    gt_feature_node_add_child((GtFeatureNode *)mrna, (GtFeatureNode *)exon);
+    if(i > 0)
+    {
+      GtGenomeNode *intron = gt_feature_node_new(seqid, "intron", start - 300,
+                                                 start - 1, GT_STRAND_FORWARD);
+      gt_feature_node_add_child((GtFeatureNode *)mrna,
+                                (GtFeatureNode *)intron);
+    }
+  }
+  gaeval_visitor_context_init(NULL, ctx, gt_feature_node_cast(mrna), NULL);
+
+  GtUword span = end - 1000;
+  for(i = 0; i < numalignments; i++)
+  {
+    GtUword start = 1001 + ((i * 7919) % span);
+    GtUword length = 20 + ((i * 104729) % 150);
+    GtGenomeNode *aln = gt_feature_node_new(seqid, "EST_match", start,
+                                            start + length - 1,
+                                            GT_STRAND_FORWARD);
+    gt_array_add(nodes, aln);
+    gaeval_visitor_context_add_alignment(ctx, gt_feature_node_cast(aln));
+  }
+  gt_str_delete(seqid);
+}
+
+static double gaeval_visitor_coverage_resolve(GaevalContext *ctx,
+                                              GtArray *exon_coverage)
+{
+  agn_assert(ctx && exon_coverage);
 
   GtUword i, covered = 0;
   for(i = 0; i < gt_array_size(exon_coverage); i++)
@@ -402,100 +750,163 @@ static double gaeval_visitor_coverage_resolve(GtFeatureNode *genemodel,
     GtRange *range = gt_array_get(exon_coverage, i);
     covered += gt_range_length(range);
   }
-  agn_assert(covered <= cum_exon_length);
-  return (double)covered / (double)cum_exon_length;
+  agn_assert(covered <= ctx->exon_length);
+  return (double)covered / (double)ctx->exon_length;
 }
 
 static void gaeval_visitor_free(GtNodeVisitor *nv)
 {
   AgnGaevalVisitor *v = gaeval_visitor_cast(nv);
-  gt_feature_index_delete(v->alignments);
+  if(v->alignments != NULL)
+    gt_feature_index_delete(v->alignments);
+  if(v->window != NULL)
+  {
+    while(gt_array_size(v->window) > 0)
+    {
+      GtGenomeNode *alignment = *(GtGenomeNode **)gt_array_pop(v->window);
+      gt_genome_node_delete(alignment);
+    }
+    gt_array_delete(v->window);
+  }
+  if(v->pending != NULL)
+    gt_genome_node_delete(v->pending);
+  if(v->tsvout != NULL)
+    fclose(v->tsvout);
+  if(v->astreams != NULL)
+  {
+    while(gt_queue_size(v->astreams) > 0)
+    {
+      GtNodeStream *stream = gt_queue_get(v->astreams);
+      gt_node_stream_delete(stream);
+    }
+    gt_queue_delete(v->astreams);
+  }
 }
 
-static GtArray*
-gaeval_visitor_intersect(GtGenomeNode *genemodel, GtGenomeNode *alignment)
+static bool gaeval_visitor_intersect(GaevalContext *ctx, GtUword i,
+                                     GtArray *covered_parts)
 {
-  agn_assert(genemodel && alignment);
+  agn_assert(ctx && i < gt_array_size(ctx->alignments) && covered_parts);
 
-  GtFeatureNode *genefn = gt_feature_node_cast(genemodel);
-  GtFeatureNode *algnfn = gt_feature_node_cast(alignment);
-  agn_assert(gt_feature_node_has_type(genefn, "mRNA"));
-  GtStrand genestrand = gt_feature_node_get_strand(genefn);
-  GtStrand algnstrand = gt_feature_node_get_strand(algnfn);
-  if(genestrand != algnstrand)
-    return NULL;
+  GaevalAlignment *aln = gt_array_get(ctx->alignments, i);
+  if(!aln->same_strand)
+    return false;
 
-  GtArray *covered_parts = gt_array_new( sizeof(GtRange) );
-  GtArray *exons = agn_typecheck_select(genefn, agn_typecheck_exon);
-  GtWord i;
-  for(i = 0; i < gt_array_size(exons); i++)
+  GtUword first = gt_array_size(covered_parts);
+  GtRange nullrange = {0, 0};
+  GtUword j, k;
+  for(j = 0; j < gt_array_size(ctx->exons); j++)
   {
-    GtGenomeNode *exon = *(GtGenomeNode **)gt_array_get(exons, i);
-    GtRange exonrange = gt_genome_node_get_range(exon);
-
-    GtFeatureNodeIterator *aniter = gt_feature_node_iterator_new(algnfn);
-    GtFeatureNode *tempaln;
-    GtRange nullrange = {0, 0};
-    for(tempaln  = gt_feature_node_iterator_next(aniter);
-        tempaln != NULL;
-        tempaln  = gt_feature_node_iterator_next(aniter))
+    GtRange *exonrange = gt_array_get(ctx->exons, j);
+    for(k = 0; k < aln->num_segments; k++)
     {
-      if(gt_feature_node_has_type(tempaln, "match_gap"))
-        continue;
-
-      GtRange alnrange = gt_genome_node_get_range((GtGenomeNode *) tempaln);
-      GtRange intr = gaeval_visitor_range_intersect(&exonrange, &alnrange);
+      GtRange *alnrange = gt_array_get(ctx->segments, aln->first_segment + k);
+      GtRange intr = gaeval_visitor_range_intersect(exonrange, alnrange);
       if(gt_range_compare(&intr, &nullrange) != 0)
         gt_array_add(covered_parts, intr);
     }
-    gt_feature_node_iterator_delete(aniter);
   }
-  gt_array_delete(exons);
 
-  for(i = 0; i < gt_array_size(covered_parts); i++)
+  for(j = first; j < gt_array_size(covered_parts); j++)
   {
-    GtRange *r1 = gt_array_get(covered_parts, i);
-    GtUword j;
-    for(j = i+1; j < gt_array_size(covered_parts); j++)
+    GtRange *r1 = gt_array_get(covered_parts, j);
+    for(k = j+1; k < gt_array_size(covered_parts); k++)
     {
-      GtRange *r2 = gt_array_get(covered_parts, j);
+      GtRange *r2 = gt_array_get(covered_parts, k);
       agn_assert(gt_range_overlap(r1, r2) == false);
     }
   }
 
-  return covered_parts;
+  return true;
 }
 
-static double gaeval_visitor_introns_confirmed(GtArray *introns, GtArray *gaps)
+static double gaeval_visitor_introns_confirmed(GtArray *introns, GtArray *gaps,
+                                               GtUword *support)
 {
-  agn_assert(introns && gaps);
+  agn_assert(introns && gaps && support);
   GtUword intron_count = gt_array_size(introns);
   GtUword gap_count = gt_array_size(gaps);
   agn_assert(intron_count > 0);
 
+  memset(support, 0, intron_count * sizeof (GtUword));
   if(gap_count == 0)
     return 0.0;
 
-  GtUword i, j, num_confirmed = 0;
+  // Slots hold intron index + 1, with 0 marking an empty slot
+  GtUword capacity = 8;
+  while(capacity < intron_count * 2)
+    capacity *= 2;
+  GtUword mask = capacity - 1;
+  GtUword *table = gt_calloc(capacity, sizeof (GtUword));
+  GtRange *intron_ranges = gt_array_get_space(introns);
+  GtUword i, slot;
   for(i = 0; i < intron_count; i++)
   {
-    GtGenomeNode *intron = *(GtGenomeNode **)gt_array_get(introns, i);
-    GtRange intron_range = gt_genome_node_get_range(intron);
-    for(j = 0; j < gap_count; j++)
+    slot = gaeval_visitor_range_hash(intron_ranges + i) & mask;
+    while(table[slot] != 0)
+      slot = (slot + 1) & mask;
+    table[slot] = i + 1;
+  }
+
+  GtRange *gap_ranges = gt_array_get_space(gaps);
+  for(i = 0; i < gap_count; i++)
+  {
+    slot = gaeval_visitor_range_hash(gap_ranges + i) & mask;
+    for(; table[slot] != 0; slot = (slot + 1) & mask)
     {
-      GtGenomeNode *gap = *(GtGenomeNode **)gt_array_get(gaps, j);
-      GtRange gap_range = gt_genome_node_get_range(gap);
-      if(gt_range_compare(&intron_range, &gap_range) == 0)
-      {
-        num_confirmed++;
-        break;
-      }
+      GtUword index = table[slot] - 1;
+      if(gt_range_compare(intron_ranges + index, gap_ranges + i) == 0)
+        support[index]++;
     }
   }
+  gt_free(table);
 
+  GtUword num_confirmed = 0;
+  for(i = 0; i < intron_count; i++)
+  {
+    if(support[i] > 0)
+      num_confirmed++;
+  }
   return (double)num_confirmed / (double)intron_count;
 }
 
+static void gaeval_visitor_overlapping(AgnGaevalVisitor *v,
+                                       GtFeatureNode *genemodel,
+                                       GtArray *overlapping, GtError *error)
+{
+  GtStr *seqid = gt_genome_node_get_seqid((GtGenomeNode *)genemodel);
+  GtRange mrna_range = gt_genome_node_get_range((GtGenomeNode *)genemodel);
+  if(v->alignments == NULL)
+  {
+    GtUword i;
+    for(i = 0; i < gt_array_size(v->window); i++)
+    {
+      GtGenomeNode *alignment = *(GtGenomeNode **)gt_array_get(v->window, i);
+      GtRange range = gt_genome_node_get_range(alignment);
+      if(gt_str_cmp(seqid, gt_genome_node_get_seqid(alignment)) == 0 &&
+         gt_range_overlap(&mrna_range, &range))
+        gt_array_add(overlapping, alignment);
+    }
+    return;
+  }
+
+  bool hasseqid;
+  gt_feature_index_has_seqid(v->alignments, &hasseqid, gt_str_get(seqid),error);
+  if(hasseqid)
+  {
+    gt_feature_index_get_features_for_range(v->alignments, overlapping,
+                                            gt_str_get(seqid), &mrna_range,
+                                            error);
+  }
+}
+
+static GtUword gaeval_visitor_range_hash(GtRange *range)
+{
+  GtUword hash = range->start * 2654435761UL;
+  hash ^= range->end + 0x9e3779b9UL + (hash << 6) + (hash >> 2);
+  return hash;
+}
+
 static GtRange gaeval_visitor_range_intersect(GtRange *r1, GtRange *r2)
 {
   agn_assert(r1 && r2);
@@ -510,41 +921,77 @@ static GtRange gaeval_visitor_range_intersect(GtRange *r1, GtRange *r2)
   return nullrange;
 }
 
+static void gaeval_visitor_score(AgnGaevalVisitor *v, GaevalContext *ctx,
+                                 GtStr *rows)
+{
+  double coverage = gaeval_visitor_calculate_coverage(ctx);
+  char covstr[16];
+  sprintf(covstr, "%.3lf", coverage);
+  gt_feature_node_add_attribute(ctx->mrna, "gaeval_coverage", covstr);
+
+  double integrity_components[5];
+  double integrity = gaeval_visitor_calculate_integrity(
+      v, ctx, coverage, integrity_components
+  );
+  char intstr[16];
+  sprintf(intstr, "%.3lf", integrity);
+  gt_feature_node_add_attribute(ctx->mrna, "gaeval_integrity", intstr);
+
+  if(rows == NULL)
+    return;
+
+  const char *mrnaid = gt_feature_node_get_attribute(ctx->mrna, "ID");
+  const char *mrnalabel = agn_feature_node_get_label(ctx->mrna);
+  char components[128];
+  sprintf(components, "%lu\t%.3lf\t%.3lf\t%.3lf\t%.3lf\t",
+          gt_array_size(ctx->introns), integrity_components[0],
+          integrity_components[1], integrity_components[2],
+          integrity_components[3]);
+  gt_str_append_cstr(rows, mrnaid != NULL ? mrnaid : ".");
+  gt_str_append_char(rows, '\t');
+  gt_str_append_cstr(rows, mrnalabel);
+  gt_str_append_char(rows, '\t');
+  gt_str_append_cstr(rows, intstr);
+  gt_str_append_char(rows, '\t');
+  gt_str_append_cstr(rows, covstr);
+  gt_str_append_char(rows, '\t');
+  gt_str_append_cstr(rows, components);
+  GtUword i;
+  for(i = 0; i < gt_array_size(ctx->intron_support); i++)
+  {
+    GtUword *count = gt_array_get(ctx->intron_support, i);
+    if(i > 0)
+      gt_str_append_char(rows, ',');
+    gt_str_append_uword(rows, *count);
+  }
+  if(gt_array_size(ctx->intron_support) == 0)
+    gt_str_append_char(rows, '.');
+  gt_str_append_char(rows, '\n');
+}
+
 static bool gaeval_visitor_typecheck_gap(GtFeatureNode *fn)
 {
   return gt_feature_node_has_type(fn, "match_gap");
 }
 
-static GtArray *gaeval_visitor_union(GtArray *cov1, GtArray *cov2)
+static void gaeval_visitor_union(GtArray *coverage)
 {
-  agn_assert(cov1 && cov2);
-  gt_array_add_array(cov1, cov2);
-  if(gt_array_size(cov1) > 1)
-    gt_array_sort(cov1, (GtCompare)gt_range_compare);
-
-  GtArray *runion = gt_array_new(sizeof(GtRange));
-  if(gt_array_size(cov1) == 0)
-    return runion;
-  GtRange *rng = gt_array_get(cov1, 0);
-  gt_array_add(runion, *rng);
-  GtRange *prev = gt_array_get(runion, 0);
-  if(gt_array_size(cov1) == 1)
-    return runion;
+  agn_assert(coverage);
+  GtUword n = gt_array_size(coverage);
+  if(n < 2)
+    return;
 
-  GtUword i;
-  for(i = 1; i < gt_array_size(cov1); i++)
+  gt_array_sort(coverage, (GtCompare)gt_range_compare);
+  GtRange *ranges = gt_array_get_space(coverage);
+  GtUword i, last = 0;
+  for(i = 1; i < n; i++)
   {
-    rng = gt_array_get(cov1, i);
-    if(gt_range_overlap(rng, prev))
-      *prev = gt_range_join(rng, prev);
+    if(gt_range_overlap(ranges + i, ranges + last))
+      ranges[last] = gt_range_join(ranges + i, ranges + last);
     else
-    {
-      gt_array_add(runion, *rng);
-      prev = gt_array_get(runion, gt_array_size(runion) - 1);
-    }
+      ranges[++last] = ranges[i];
   }
-
-  return runion;
+  gt_array_set_size(coverage, last + 1);
 }
 
 static int
@@ -554,40 +1001,64 @@ gaeval_visitor_visit_feature_node(GtNodeVisitor *nv, GtFeatureNode *fn,
   AgnGaevalVisitor *v = gaeval_visitor_cast(nv);
   gt_error_check(error);
 
-  GtFeatureNodeIterator *feats = gt_feature_node_iterator_new(fn);
-  GtFeatureNode *tempfeat;
-  for(tempfeat  = gt_feature_node_iterator_next(feats);
-      tempfeat != NULL;
-      tempfeat  = gt_feature_node_iterator_next(feats))
-  {
-    if(agn_typecheck_mrna(tempfeat) == false)
-      continue;
+  AgnGaevalJob *job = agn_gaeval_visitor_job_new(v, fn, error);
+  if(job == NULL)
+    return -1;
+  agn_gaeval_visitor_job_run(v, job);
+  agn_gaeval_visitor_job_finish(v, job);
+  return 0;
+}
 
-    double coverage = gaeval_visitor_calculate_coverage(v, tempfeat, error);
-    char covstr[16];
-    sprintf(covstr, "%.3lf", coverage);
-    gt_feature_node_add_attribute(tempfeat, "gaeval_coverage", covstr);
+static int gaeval_visitor_window_advance(AgnGaevalVisitor *v,
+                                         GtFeatureNode *fn, GtError *error)
+{
+  agn_assert(v && v->astream && v->window && fn);
+  GtStr *seqid = gt_genome_node_get_seqid((GtGenomeNode *)fn);
+  GtRange range = gt_genome_node_get_range((GtGenomeNode *)fn);
 
-    double integrity_components[5];
-    double integrity = gaeval_visitor_calculate_integrity(
-        v, tempfeat, coverage, integrity_components, error
-    );
-    char intstr[16];
-    sprintf(intstr, "%.3lf", integrity);
-    gt_feature_node_add_attribute(tempfeat, "gaeval_integrity", intstr);
+  // Drop alignments from previous sequences or ending before this feature
+  GtUword i, kept = 0;
+  for(i = 0; i < gt_array_size(v->window); i++)
+  {
+    GtGenomeNode **alignment = gt_array_get(v->window, i);
+    if(gt_str_cmp(seqid, gt_genome_node_get_seqid(*alignment)) != 0 ||
+       gt_genome_node_get_end(*alignment) < range.start)
+    {
+      gt_genome_node_delete(*alignment);
+      continue;
+    }
+    *(GtGenomeNode **)gt_array_get(v->window, kept++) = *alignment;
+  }
+  gt_array_set_size(v->window, kept);
 
-    if(v->tsvout)
+  // Pull alignments until one starts after the end of this feature
+  while(true)
+  {
+    if(v->pending == NULL)
     {
-      const char *mrnaid = gt_feature_node_get_attribute(tempfeat, "ID");
-      const char *mrnalabel = agn_feature_node_get_label(tempfeat);
-      GtUword num_introns = agn_typecheck_count(tempfeat, agn_typecheck_intron);
-      fprintf(v->tsvout, "%s\t%s\t%s\t%s\t%lu\t%.3lf\t%.3lf\t%.3lf\t%.3lf\n",
-              mrnaid, mrnalabel, intstr, covstr, num_introns,
-              integrity_components[0], integrity_components[1],
-              integrity_components[2], integrity_components[3]);
+      int had_err = gt_node_stream_next(v->astream, &v->pending, error);
+      if(had_err)
+        return had_err;
+      if(v->pending == NULL)
+        break;
+      if(gt_feature_node_try_cast(v->pending) == NULL)
+      {
+        gt_genome_node_delete(v->pending);
+        v->pending = NULL;
+        continue;
+      }
     }
+
+    int seqcmp = gt_str_cmp(gt_genome_node_get_seqid(v->pending), seqid);
+    if(seqcmp > 0 ||
+       (seqcmp == 0 && gt_genome_node_get_start(v->pending) > range.end))
+      break;
+    if(seqcmp < 0 || gt_genome_node_get_end(v->pending) < range.start)
+      gt_genome_node_delete(v->pending);
+    else
+      gt_array_add(v->window, v->pending);
+    v->pending = NULL;
   }
-  gt_feature_node_iterator_delete(feats);
 
   return 0;
 }
@@ -626,15 +1097,45 @@ static void gv_test_calc_coverage(AgnUnitTest *test)
   GtFeatureNode *g2 = *(GtFeatureNode **)gt_array_get(feats, 1);
   GtFeatureNode *g3 = *(GtFeatureNode **)gt_array_get(feats, 2);
 
-  double cov1 = gaeval_visitor_calculate_coverage(gv, g1, error);
-  double cov2 = gaeval_visitor_calculate_coverage(gv, g2, error);
-  double cov3 = gaeval_visitor_calculate_coverage(gv, g3, error);
+  GaevalContext ctx1, ctx2, ctx3;
+  gaeval_visitor_context_init(gv, &ctx1, g1, error);
+  gaeval_visitor_context_init(gv, &ctx2, g2, error);
+  gaeval_visitor_context_init(gv, &ctx3, g3, error);
+  double cov1 = gaeval_visitor_calculate_coverage(&ctx1);
+  double cov2 = gaeval_visitor_calculate_coverage(&ctx2);
+  double cov3 = gaeval_visitor_calculate_coverage(&ctx3);
+  gaeval_visitor_context_free(&ctx1);
+  gaeval_visitor_context_free(&ctx2);
+  gaeval_visitor_context_free(&ctx3);
   bool test1 = fabs(cov1 - 0.252) < 0.001 &&
                fabs(cov2 - 0.473) < 0.001 &&
                fabs(cov3 - 1.000) < 0.001;
 
   agn_unit_test_result(test, "calculate coverage", test1);
 
+  // Many overlapping, unsorted alignments on a 10-exon synthetic mRNA, whose
+  // exons total 2000 nucleotides
+  GtUword numalignments[] = { 20, 50, 100 };
+  GtUword covered[] = { 903, 1630, 1890 };
+  bool test2 = true;
+  GtUword i;
+  for(i = 0; i < sizeof(numalignments) / sizeof(numalignments[0]); i++)
+  {
+    GaevalContext ctx;
+    GtArray *nodes = gt_array_new( sizeof(GtGenomeNode *) );
+    gaeval_visitor_context_synthetic(&ctx, 10, numalignments[i], nodes);
+    double coverage = gaeval_visitor_calculate_coverage(&ctx);
+    test2 = test2 && coverage == (double)covered[i] / 2000.0;
+    gaeval_visitor_context_free(&ctx);
+    while(gt_array_size(nodes) > 0)
+    {
+      GtGenomeNode **gn = gt_array_pop(nodes);
+      gt_genome_node_delete(*gn);
+    }
+    gt_array_delete(nodes);
+  }
+  agn_unit_test_result(test, "calculate coverage (synthetic)", test2);
+
   gt_error_delete(error);
   gt_array_delete(feats);
   gt_genome_node_delete((GtGenomeNode *)g1);
@@ -682,10 +1183,14 @@ static void gv_test_calc_integrity(AgnUnitTest *test)
   GtFeatureNode *g1 = *(GtFeatureNode **)gt_array_get(feats, 0);
   GtFeatureNode *g2 = *(GtFeatureNode **)gt_array_get(feats, 1);
 
-  double cov1 = gaeval_visitor_calculate_coverage(gv,  g1, error);
-  double cov2 = gaeval_visitor_calculate_coverage(gv,  g2, error);
-  double int1 = gaeval_visitor_calculate_integrity(gv, g1, cov1, NULL, error);
-  double int2 = gaeval_visitor_calculate_integrity(gv, g2, cov2, NULL, error);
+  GaevalContext ctx1, ctx2;
+  gaeval_visitor_context_init(gv, &ctx1, g1, error);
+  gaeval_visitor_context_init(gv, &ctx2, g2, error);
+  double cov1 = gaeval_visitor_calculate_coverage(&ctx1);
+  double cov2 = gaeval_visitor_calculate_coverage(&ctx2);
+  double comp1[4], comp2[4];
+  double int1 = gaeval_visitor_calculate_integrity(gv, &ctx1, cov1, comp1);
+  double int2 = gaeval_visitor_calculate_integrity(gv, &ctx2, cov2, comp2);
 
   bool test1 = fabs(cov1 - 1.000) < 0.001 &&
                fabs(cov2 - 0.997) < 0.001 &&
@@ -693,6 +1198,21 @@ static void gv_test_calc_integrity(AgnUnitTest *test)
                fabs(int2 - 0.863) < 0.001;
   agn_unit_test_result(test, "calculate integrity", test1);
 
+  // Each intron's support is the number of alignment gaps matching it exactly
+  GtUword exp1[] = { 2, 2, 2, 2, 1, 0 };
+  GtUword exp2[] = { 0, 2, 2, 2, 2, 1, 4 };
+  bool test2 = gt_array_size(ctx1.intron_support) == 6 &&
+               gt_array_size(ctx2.intron_support) == 7 &&
+               memcmp(gt_array_get_space(ctx1.intron_support), exp1,
+                      sizeof (exp1)) == 0 &&
+               memcmp(gt_array_get_space(ctx2.intron_support), exp2,
+                      sizeof (exp2)) == 0 &&
+               fabs(comp1[0] - 0.833) < 0.001 &&
+               fabs(comp2[0] - 0.857) < 0.001;
+  agn_unit_test_result(test, "intron support", test2);
+  gaeval_visitor_context_free(&ctx1);
+  gaeval_visitor_context_free(&ctx2);
+
   gt_error_delete(error);
   gt_array_delete(feats);
   gt_genome_node_delete((GtGenomeNode *)g1);
@@ -738,8 +1258,11 @@ static void gv_test_calc_integrity_simple(AgnUnitTest *test)
   agn_assert(gt_array_size(feats) == 1);
   GtFeatureNode *g1 = *(GtFeatureNode **)gt_array_get(feats, 0);
 
-  double cov1 = gaeval_visitor_calculate_coverage(gv,  g1, error);
-  double int1 = gaeval_visitor_calculate_integrity(gv, g1, cov1, NULL, error);
+  GaevalContext ctx1;
+  gaeval_visitor_context_init(gv, &ctx1, g1, error);
+  double cov1 = gaeval_visitor_calculate_coverage(&ctx1);
+  double int1 = gaeval_visitor_calculate_integrity(gv, &ctx1, cov1, NULL);
+  gaeval_visitor_context_free(&ctx1);
 
   bool test1 = fabs(cov1 - 0.882) < 0.001 &&
                fabs(int1 - 0.680) < 0.001;
@@ -781,10 +1304,21 @@ static void gv_test_intersect(AgnUnitTest *test)
   GtGenomeNode *est5 = *(GtGenomeNode **)gt_array_get(feats, 6);
   GtGenomeNode *est6 = *(GtGenomeNode **)gt_array_get(feats, 8);
 
-  GtArray *cov = gaeval_visitor_intersect(g1, est1);
-  bool test1 = cov == NULL;
-  cov = gaeval_visitor_intersect(g1, est2);
-  test1 = gt_array_size(cov) == 1;
+  GaevalContext ctx1, ctx2, ctx3;
+  gaeval_visitor_context_init(NULL, &ctx1, gt_feature_node_cast(g1), NULL);
+  gaeval_visitor_context_init(NULL, &ctx2, gt_feature_node_cast(g2), NULL);
+  gaeval_visitor_context_init(NULL, &ctx3, gt_feature_node_cast(g3), NULL);
+  gaeval_visitor_context_add_alignment(&ctx1, gt_feature_node_cast(est1));
+  gaeval_visitor_context_add_alignment(&ctx1, gt_feature_node_cast(est2));
+  gaeval_visitor_context_add_alignment(&ctx2, gt_feature_node_cast(est3));
+  gaeval_visitor_context_add_alignment(&ctx2, gt_feature_node_cast(est4));
+  gaeval_visitor_context_add_alignment(&ctx3, gt_feature_node_cast(est5));
+  gaeval_visitor_context_add_alignment(&ctx3, gt_feature_node_cast(est6));
+
+  GtArray *cov = gt_array_new( sizeof(GtRange) );
+  bool test1 = !gaeval_visitor_intersect(&ctx1, 0, cov) &&
+               gaeval_visitor_intersect(&ctx1, 1, cov) &&
+               gt_array_size(cov) == 1;
   if(test1)
   {
     GtRange *range01 = gt_array_pop(cov);
@@ -792,10 +1326,10 @@ static void gv_test_intersect(AgnUnitTest *test)
     test1 = gt_range_compare(range01, &testrange) == 0;
   }
   agn_unit_test_result(test, "intersect (1)", test1);
-  gt_array_delete(cov);
+  gt_array_reset(cov);
 
-  cov = gaeval_visitor_intersect(g2, est3);
-  bool test2 = gt_array_size(cov) == 2;
+  bool test2 = gaeval_visitor_intersect(&ctx2, 0, cov) &&
+               gt_array_size(cov) == 2;
   if(test2)
   {
     GtRange *range01 = gt_array_get(cov, 0);
@@ -806,10 +1340,10 @@ static void gv_test_intersect(AgnUnitTest *test)
             gt_range_compare(range02, &testrange2) == 0;
   }
   agn_unit_test_result(test, "intersect (2)", test2);
-  gt_array_delete(cov);
+  gt_array_reset(cov);
 
-  cov = gaeval_visitor_intersect(g2, est4);
-  bool test3 = gt_array_size(cov) == 2;
+  bool test3 = gaeval_visitor_intersect(&ctx2, 1, cov) &&
+               gt_array_size(cov) == 2;
   if(test3)
   {
     GtRange *range01 = gt_array_get(cov, 0);
@@ -820,10 +1354,10 @@ static void gv_test_intersect(AgnUnitTest *test)
             gt_range_compare(range02, &testrange2) == 0;
   }
   agn_unit_test_result(test, "intersect (3)", test3);
-  gt_array_delete(cov);
+  gt_array_reset(cov);
 
-  cov = gaeval_visitor_intersect(g3, est5);
-  bool test4 = gt_array_size(cov) == 2;
+  bool test4 = gaeval_visitor_intersect(&ctx3, 0, cov) &&
+               gt_array_size(cov) == 2;
   if(test4)
   {
     GtRange *range01 = gt_array_get(cov, 0);
@@ -834,10 +1368,10 @@ static void gv_test_intersect(AgnUnitTest *test)
             gt_range_compare(range02, &testrange2) == 0;
   }
   agn_unit_test_result(test, "intersect (4)", test4);
-  gt_array_delete(cov);
+  gt_array_reset(cov);
 
-  cov = gaeval_visitor_intersect(g3, est6);
-  bool test5 = gt_array_size(cov) == 2;
+  bool test5 = gaeval_visitor_intersect(&ctx3, 1, cov) &&
+               gt_array_size(cov) == 2;
   if(test5)
   {
     GtRange *range01 = gt_array_get(cov, 0);
@@ -850,6 +1384,10 @@ static void gv_test_intersect(AgnUnitTest *test)
   agn_unit_test_result(test, "intersect (5)", test5);
   gt_array_delete(cov);
 
+  gaeval_visitor_context_free(&ctx1);
+  gaeval_visitor_context_free(&ctx2);
+  gaeval_visitor_context_free(&ctx3);
+
   gt_array_delete(feats);
   gt_genome_node_delete(g1);
   gt_genome_node_delete(g2);
@@ -864,55 +1402,44 @@ static void gv_test_intersect(AgnUnitTest *test)
 
 static void gv_test_introns_confirmed(AgnUnitTest *test)
 {
-  GtGenomeNode *intron, *gap;
-  GtStr *seqid = gt_str_new_cstr("chr");
-  GtArray *introns = gt_array_new( sizeof(GtGenomeNode *) );
-  intron = gt_feature_node_new(seqid, "intron", 1000, 1170, GT_STRAND_REVERSE);
-  gt_array_add(introns, intron);
-  intron = gt_feature_node_new(seqid, "intron", 1225, 1305, GT_STRAND_REVERSE);
-  gt_array_add(introns, intron);
-  intron = gt_feature_node_new(seqid, "intron", 1950, 2110, GT_STRAND_REVERSE);
-  gt_array_add(introns, intron);
-  intron = gt_feature_node_new(seqid, "intron", 2545, 2655, GT_STRAND_REVERSE);
-  gt_array_add(introns, intron);
-  intron = gt_feature_node_new(seqid, "intron", 2800, 2950, GT_STRAND_REVERSE);
-  gt_array_add(introns, intron);
-
-  GtArray *gaps = gt_array_new( sizeof(GtGenomeNode *) );
-
-  double intcon = gaeval_visitor_introns_confirmed(introns, gaps);
-  bool test1 = fabs(intcon - 0.0) < 0.0001;
+  GtArray *introns = gt_array_new( sizeof(GtRange) );
+  GtRange introns_data[] = {
+    { 1000, 1170 }, { 1225, 1305 }, { 1950, 2110 }, { 2545, 2655 },
+    { 2800, 2950 },
+  };
+  GtUword i;
+  for(i = 0; i < 5; i++)
+    gt_array_add(introns, introns_data[i]);
+
+  GtArray *gaps = gt_array_new( sizeof(GtRange) );
+
+  GtUword support[5];
+  double intcon = gaeval_visitor_introns_confirmed(introns, gaps, support);
+  bool test1 = fabs(intcon - 0.0) < 0.0001 && support[0] == 0;
   agn_unit_test_result(test, "introns confirmed (no gaps)", test1);
 
-  gap = gt_feature_node_new(seqid, "match_gap", 1000, 1170, GT_STRAND_REVERSE);
-  gt_array_add(gaps, gap);
-  gap = gt_feature_node_new(seqid, "match_gap", 1225, 1302, GT_STRAND_REVERSE);
-  gt_array_add(gaps, gap);
-  gap = gt_feature_node_new(seqid, "match_gap", 1950, 2110, GT_STRAND_REVERSE);
-  gt_array_add(gaps, gap);
-  gap = gt_feature_node_new(seqid, "match_gap", 2575, 2655, GT_STRAND_REVERSE);
-  gt_array_add(gaps, gap);
-  gap = gt_feature_node_new(seqid, "match_gap", 2800, 2950, GT_STRAND_REVERSE);
-  gt_array_add(gaps, gap);
-
-  intcon = gaeval_visitor_introns_confirmed(introns, gaps);
+  GtRange gaps_data[] = {
+    { 1000, 1170 }, { 1225, 1302 }, { 1950, 2110 }, { 2575, 2655 },
+    { 2800, 2950 },
+  };
+  for(i = 0; i < 5; i++)
+    gt_array_add(gaps, gaps_data[i]);
+
+  intcon = gaeval_visitor_introns_confirmed(introns, gaps, support);
   bool test2 = fabs(intcon - 0.6) < 0.0001;
   agn_unit_test_result(test, "introns confirmed (gaps)", test2);
 
-  while(gt_array_size(introns) > 0)
-  {
-    intron = *(GtGenomeNode **)gt_array_pop(introns);
-    gt_genome_node_delete(intron);
-  }
-  gt_array_delete(introns);
+  GtRange moregaps_data[] = { { 1000, 1170 }, { 2800, 2950 }, { 1000, 1170 } };
+  for(i = 0; i < 3; i++)
+    gt_array_add(gaps, moregaps_data[i]);
+  intcon = gaeval_visitor_introns_confirmed(introns, gaps, support);
+  bool test3 = fabs(intcon - 0.6) < 0.0001 &&
+               support[0] == 3 && support[1] == 0 && support[2] == 1 &&
+               support[3] == 0 && support[4] == 2;
+  agn_unit_test_result(test, "introns confirmed (support)", test3);
 
-  while(gt_array_size(gaps) > 0)
-  {
-    gap = *(GtGenomeNode **)gt_array_pop(gaps);
-    gt_genome_node_delete(gap);
-  }
+  gt_array_delete(introns);
   gt_array_delete(gaps);
-  gt_str_delete(seqid);
 }
 
 static void gv_test_range_intersect(AgnUnitTest *test)
@@ -940,6 +1467,81 @@ static void gv_test_range_intersect(AgnUnitTest *test)
                        gt_range_compare(&nullrange, &testrange3) == 0);
 }
 
+static void gv_test_sorted(AgnUnitTest *test)
+{
+  const char *filenames[] = {
+    "data/gff3/gaeval-stream-unit-test-1.gff3",
+    "data/gff3/gaeval-stream-unit-test-2.gff3",
+  };
+  const char *expected[] = {
+    "0.252 0.076 0.473 0.742 1.000 0.300 ",
+    "1.000 0.850 0.997 0.863 ",
+  };
+  AgnGaevalParams params = { 0.6, 0.3, 0.05, 0.05, 400, 200, 100 };
+  GtLogger *logger = gt_logger_new(true, "", stderr);
+  GtError *error = gt_error_new();
+  GtStr *scores = gt_str_new();
+  bool scorestest = true;
+  int i;
+  for(i = 0; i < 2; i++)
+  {
+    GtNodeStream *align_in = agn_merge_stream_new_gff3(1, filenames + i);
+    GtNodeVisitor *nv = agn_gaeval_visitor_new_sorted(align_in, params);
+    GtNodeStream *gff3in = agn_merge_stream_new_gff3(1, filenames + i);
+    GtNodeStream *ics = agn_infer_cds_stream_new(gff3in, NULL, logger);
+    GtNodeStream *ies = agn_infer_exons_stream_new(ics, NULL, logger);
+    GtNodeStream *gvs = gt_visitor_stream_new(ies, nv);
+    GtArray *feats = gt_array_new( sizeof(GtFeatureNode *) );
+    GtNodeStream *featstream = gt_array_out_stream_new(gvs, feats, error);
+    int result = gt_node_stream_pull(featstream, error);
+    if(result == -1)
+    {
+      fprintf(stderr, "[AgnGaevalVisitor::gv_test_sorted] error processing "
+              "GFF3: %s\n", gt_error_get(error));
+      scorestest = false;
+    }
+
+    gt_str_reset(scores);
+    while(gt_array_size(feats) > 0)
+    {
+      GtFeatureNode *fn = *(GtFeatureNode **)gt_array_get(feats, 0);
+      gt_array_rem(feats, 0);
+      GtFeatureNodeIterator *iter = gt_feature_node_iterator_new(fn);
+      GtFeatureNode *feat;
+      for(feat  = gt_feature_node_iterator_next(iter);
+          feat != NULL;
+          feat  = gt_feature_node_iterator_next(iter))
+      {
+        if(!agn_typecheck_mrna(feat))
+          continue;
+        const char *cov, *itg;
+        cov = gt_feature_node_get_attribute(feat, "gaeval_coverage");
+        itg = gt_feature_node_get_attribute(feat, "gaeval_integrity");
+        gt_str_append_cstr(scores, cov ? cov : "NA");
+        gt_str_append_char(scores, ' ');
+        gt_str_append_cstr(scores, itg ? itg : "NA");
+        gt_str_append_char(scores, ' ');
+      }
+      gt_feature_node_iterator_delete(iter);
+      gt_genome_node_delete((GtGenomeNode *)fn);
+    }
+    scorestest = scorestest && strcmp(gt_str_get(scores), expected[i]) == 0;
+
+    gt_array_delete(feats);
+    gt_node_stream_delete(featstream);
+    gt_node_stream_delete(gvs);
+    gt_node_stream_delete(ies);
+    gt_node_stream_delete(ics);
+    gt_node_stream_delete(gff3in);
+    gt_node_stream_delete(align_in);
+  }
+  agn_unit_test_result(test, "sorted input", scorestest);
+
+  gt_str_delete(scores);
+  gt_error_delete(error);
+  gt_logger_delete(logger);
+}
+
 static void gv_test_union(AgnUnitTest *test)
 {
   GtArray *r1 = gt_array_new( sizeof(GtRange) );
@@ -948,19 +1550,19 @@ static void gv_test_union(AgnUnitTest *test)
   GtRange rng02 = {11525, 14070};
   gt_array_add(r2, rng01);
   gt_array_add(r2, rng02);
-  GtArray *ru = gaeval_visitor_union(r1, r2);
-  bool test1 = gt_array_size(ru) == 2;
+  gt_array_add_array(r1, r2);
+  gaeval_visitor_union(r1);
+  bool test1 = gt_array_size(r1) == 2;
   if(test1)
   {
-    GtRange *temp1 = gt_array_get(ru, 0);
-    GtRange *temp2 = gt_array_get(ru, 1);
+    GtRange *temp1 = gt_array_get(r1, 0);
+    GtRange *temp2 = gt_array_get(r1, 1);
     test1 = gt_range_compare(temp1, &rng01) == 0 &&
             gt_range_compare(temp2, &rng02) == 0;
   }
   agn_unit_test_result(test, "union (1)", test1);
   gt_array_delete(r1);
   gt_array_delete(r2);
-  gt_array_delete(ru);
 
   r1 = gt_array_new( sizeof(GtRange) );
   r2 = gt_array_new( sizeof(GtRange) );
@@ -972,12 +1574,13 @@ static void gv_test_union(AgnUnitTest *test)
   gt_array_add(r1, rng04);
   gt_array_add(r2, rng05);
   gt_array_add(r2, rng06);
-  ru = gaeval_visitor_union(r1, r2);
-  bool test2 = gt_array_size(ru) == 2;
+  gt_array_add_array(r1, r2);
+  gaeval_visitor_union(r1);
+  bool test2 = gt_array_size(r1) == 2;
   if(test2)
   {
-    GtRange *temp1 = gt_array_get(ru, 0);
-    GtRange *temp2 = gt_array_get(ru, 1);
+    GtRange *temp1 = gt_array_get(r1, 0);
+    GtRange *temp2 = gt_array_get(r1, 1);
     GtRange testr1 = { 200, 500 };
     GtRange testr2 = { 700, 900 };
     test2 = gt_range_compare(temp1, &testr1) == 0 &&
@@ -986,7 +1589,6 @@ static void gv_test_union(AgnUnitTest *test)
   agn_unit_test_result(test, "union (2)", test2);
   gt_array_delete(r1);
   gt_array_delete(r2);
-  gt_array_delete(ru);
 
   r1 = gt_array_new( sizeof(GtRange) );
   r2 = gt_array_new( sizeof(GtRange) );
@@ -1000,14 +1602,15 @@ static void gv_test_union(AgnUnitTest *test)
   gt_array_add(r2, rng09);
   gt_array_add(r2, rng10);
   gt_array_add(r2, rng11);
-  ru = gaeval_visitor_union(r1, r2);
-  bool test3 = gt_array_size(ru) == 3;
+  gt_array_add_array(r1, r2);
+  gaeval_visitor_union(r1);
+  bool test3 = gt_array_size(r1) == 3;
 
   if(test3)
   {
-    GtRange *temp1 = gt_array_get(ru, 0);
-    GtRange *temp2 = gt_array_get(ru, 1);
-    GtRange *temp3 = gt_array_get(ru, 2);
+    GtRange *temp1 = gt_array_get(r1, 0);
+    GtRange *temp2 = gt_array_get(r1, 1);
+    GtRange *temp3 = gt_array_get(r1, 2);
     GtRange testr1 = { 100, 150 };
     GtRange testr2 = { 200, 500 };
     GtRange testr3 = { 700, 900 };
@@ -1018,5 +1621,18 @@ static void gv_test_union(AgnUnitTest *test)
   agn_unit_test_result(test, "union (3)", test3);
   gt_array_delete(r1);
   gt_array_delete(r2);
-  gt_array_delete(ru);
+
+  // Unsorted ranges, one containing another and a chain merged in one sweep
+  r1 = gt_array_new( sizeof(GtRange) );
+  GtRange rng12[] = { {500, 600}, {950, 1000}, {100, 900}, {990, 1100},
+                      {50, 60}, {1100, 1200} };
+  GtUword i;
+  for(i = 0; i < sizeof(rng12) / sizeof(rng12[0]); i++)
+    gt_array_add(r1, rng12[i]);
+  gaeval_visitor_union(r1);
+  GtRange testr4[] = { {50, 60}, {100, 900}, {950, 1200} };
+  bool test4 = gt_array_size(r1) == 3 &&
+               memcmp(gt_array_get_space(r1), testr4, sizeof (testr4)) == 0;
+  agn_unit_test_result(test, "union (4)", test4);
+  gt_array_delete(r1);
 }
@@ -0,0 +1,770 @@
+/**
+
+Copyright (c) 2010-2016, Daniel S. Standage and CONTRIBUTORS
+
+The AEGeAn Toolkit is distributed under the ISC License. See
+the 'LICENSE' file in the AEGeAn source code distribution or
+online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
+
+**/
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "extended/array_in_stream_api.h"
+#include "extended/array_out_stream_api.h"
+#include "extended/feature_node_iterator_api.h"
+#include "AgnILocusCache.h"
+#include "AgnLocus.h"
+#include "AgnLocusStream.h"
+#include "AgnUtils.h"
+
+#define ILOCUS_CACHE_MAGIC "AGNILOCC"
+#define ILOCUS_CACHE_VERSION 2
+#define ILOCUS_CACHE_LABEL "ilocus_cache_index"
+
+//------------------------------------------------------------------------------
+// Data structure definitions
+//------------------------------------------------------------------------------
+
+/**
+ * Each cache entry begins with an 8-byte magic string, a format version, the
+ * key of the sequence, and the full description from which the key was
+ * computed (compared on every lookup, so that two sequences whose keys collide
+ * never share an entry), followed by the iLocus lengths reported for the
+ * sequence and the number of nodes delivered. Each node is either an input node
+ * delivered as is (0, followed by its position among the input nodes) or an
+ * iLocus (1, followed by its sequence ID, source, start and end coordinates,
+ * iLocus type, attributes as key/value pairs, and the positions of its genes
+ * among the input nodes). All integers are written with
+ * :c:func:`agn_uword_write` and all strings with :c:func:`agn_str_write`.
+ */
+struct AgnILocusCache
+{
+  char *dirname;
+  GtUword hits;
+  GtUword misses;
+  pthread_mutex_t mutex;
+};
+
+/**
+ * A node read from a cache entry: an iLocus (with the positions of its genes
+ * and its coordinates, set once the genes are added) or, if ``locus`` is NULL,
+ * the input node at position ``index``.
+ */
+typedef struct
+{
+  AgnLocus *locus;
+  GtArray *children;
+  GtRange range;
+  GtUword index;
+} ILocusCacheItem;
+
+
+//------------------------------------------------------------------------------
+// Prototypes for private functions
+//------------------------------------------------------------------------------
+
+/**
+ * @function Append a line describing ``gn`` (and, for a feature, each of its
+ * subfeatures) to ``desc`` for computing the key of a sequence.
+ */
+static void ilocus_cache_describe(GtGenomeNode *gn, GtStr *desc);
+
+/**
+ * @function Store the name of the file holding the cache entry with the given
+ * key in ``filename``.
+ */
+static void ilocus_cache_filename(AgnILocusCache *cache, GtUword key,
+                                  GtStr *filename);
+
+/**
+ * @function Update the FNV-1a ``hash`` with ``length`` bytes of ``data``.
+ */
+static GtUword ilocus_cache_hash(GtUword hash, const void *data,
+                                 GtUword length);
+
+/**
+ * @function Read one node of a cache entry into ``item``, checking each
+ * position against the input ``nodes`` and marking it as ``used``. Returns
+ * false if the node could not be read or refers to an invalid or already used
+ * position.
+ */
+static bool ilocus_cache_read_item(FILE *instream, GtArray *nodes, bool *used,
+                                   ILocusCacheItem *item);
+
+/**
+ * @function Return the position of ``gn`` among the input nodes of its sequence
+ * as labeled by :c:func:`agn_ilocus_cache_key`, or NULL if it is not labeled.
+ */
+static GtUword *ilocus_cache_label(GtGenomeNode *gn);
+
+/**
+ * @function Create the input nodes of a synthetic sequence for unit testing: a
+ * sequence region and three genes, the second starting at ``start``.
+ */
+static GtArray *ilocus_cache_test_data(GtUword start);
+
+/**
+ * @function Compute the iLoci of the given input ``nodes`` for unit testing,
+ * taking ownership of the nodes.
+ */
+static void ilocus_cache_test_run(GtArray *nodes, GtArray *output,
+                                  AgnOutputSink *ilens);
+
+/**
+ * @function Remove the label added by :c:func:`agn_ilocus_cache_key`, if any.
+ */
+static void ilocus_cache_unlabel(GtGenomeNode *gn);
+
+/**
+ * @function Write an iLocus to a cache entry. Sets ``cacheable`` to false if
+ * any of its genes is not a labeled input node.
+ */
+static bool ilocus_cache_write_locus(FILE *outstream, GtFeatureNode *locus,
+                                     bool *cacheable);
+
+
+//------------------------------------------------------------------------------
+// Method definitions
+//------------------------------------------------------------------------------
+
+void agn_ilocus_cache_delete(AgnILocusCache *cache)
+{
+  if(cache == NULL)
+    return;
+  pthread_mutex_destroy(&cache->mutex);
+  gt_free(cache->dirname);
+  gt_free(cache);
+}
+
+bool agn_ilocus_cache_get(AgnILocusCache *cache, GtUword key, GtStr *desc,
+                          GtArray *nodes, GtArray *output, AgnOutputSink *ilens)
+{
+  agn_assert(cache && desc && nodes && output);
+  GtStr *filename = gt_str_new();
+  ilocus_cache_filename(cache, key, filename);
+  FILE *instream = fopen(gt_str_get(filename), "rb");
+  gt_str_delete(filename);
+
+  GtUword numnodes = gt_array_size(nodes);
+  bool *used = gt_calloc(numnodes + 1, sizeof(bool));
+  GtArray *items = gt_array_new( sizeof(ILocusCacheItem) );
+  GtStr *entrydesc = gt_str_new();
+  GtStr *ilentext = gt_str_new();
+  GtUword i, j, version, entrykey, numitems;
+  char magic[8];
+  bool success = instream != NULL &&
+                 fread(magic, 1, 8, instream) == 8 &&
+                 memcmp(magic, ILOCUS_CACHE_MAGIC, 8) == 0 &&
+                 agn_uword_read(instream, &version) &&
+                 version == ILOCUS_CACHE_VERSION &&
+                 agn_uword_read(instream, &entrykey) && entrykey == key &&
+                 agn_str_read(instream, entrydesc) &&
+                 gt_str_cmp(entrydesc, desc) == 0 &&
+                 agn_str_read(instream, ilentext) &&
+                 agn_uword_read(instream, &numitems);
+  for(i = 0; success && i < numitems; i++)
+  {
+    ILocusCacheItem item;
+    success = ilocus_cache_read_item(instream, nodes, used, &item);
+    if(success)
+      gt_array_add(items, item);
+  }
+  if(instream != NULL)
+    fclose(instream);
+
+  // Nothing is done to the input nodes until the entire entry has been read
+  for(i = 0; i < gt_array_size(items); i++)
+  {
+    ILocusCacheItem *item = gt_array_get(items, i);
+    if(item->locus == NULL)
+    {
+      if(success)
+      {
+        GtGenomeNode **gn = gt_array_get(nodes, item->index);
+        ilocus_cache_unlabel(*gn);
+        gt_array_add(output, *gn);
+      }
+      continue;
+    }
+
+    for(j = 0; success && j < gt_array_size(item->children); j++)
+    {
+      GtUword *index = gt_array_get(item->children, j);
+      GtGenomeNode **gn = gt_array_get(nodes, *index);
+      ilocus_cache_unlabel(*gn);
+      agn_locus_add_feature(item->locus, (GtFeatureNode *)*gn);
+    }
+    if(success)
+    {
+      agn_locus_set_range(item->locus, item->range.start, item->range.end);
+      gt_array_add(output, item->locus);
+    }
+    else
+      agn_locus_delete(item->locus);
+    gt_array_delete(item->children);
+  }
+  if(success)
+  {
+    for(i = 0; i < numnodes; i++)
+    {
+      GtGenomeNode **gn = gt_array_get(nodes, i);
+      if(!used[i])
+        gt_genome_node_delete(*gn);
+    }
+    if(ilens != NULL)
+      agn_output_sink_str(ilens, ilentext);
+  }
+
+  pthread_mutex_lock(&cache->mutex);
+  if(success)
+    cache->hits++;
+  else
+    cache->misses++;
+  pthread_mutex_unlock(&cache->mutex);
+
+  gt_free(used);
+  gt_array_delete(items);
+  gt_str_delete(entrydesc);
+  gt_str_delete(ilentext);
+  return success;
+}
+
+GtUword agn_ilocus_cache_key(AgnILocusCache *cache, const char *settings,
+                             GtArray *nodes, GtStr *desc)
+{
+  agn_assert(cache && settings && nodes && desc);
+  gt_str_reset(desc);
+  gt_str_append_cstr(desc, settings);
+  gt_str_append_char(desc, '\n');
+
+  GtUword i;
+  for(i = 0; i < gt_array_size(nodes); i++)
+  {
+    GtGenomeNode **gn = gt_array_get(nodes, i);
+    GtUword *index = gt_malloc( sizeof(GtUword) );
+    *index = i;
+    ilocus_cache_unlabel(*gn);
+    gt_genome_node_add_user_data(*gn, ILOCUS_CACHE_LABEL, index, gt_free_func);
+    ilocus_cache_describe(*gn, desc);
+  }
+  return ilocus_cache_hash(14695981039346656037ULL, gt_str_get(desc),
+                           gt_str_length(desc));
+}
+
+AgnILocusCache *agn_ilocus_cache_new(const char *dirname, GtError *error)
+{
+  agn_assert(dirname);
+  struct stat dirstat;
+  if(mkdir(dirname, 0755) != 0 && errno != EEXIST)
+  {
+    gt_error_set(error, "cannot create cache directory '%s'", dirname);
+    return NULL;
+  }
+  if(stat(dirname, &dirstat) != 0 || !S_ISDIR(dirstat.st_mode))
+  {
+    gt_error_set(error, "cache directory '%s' is not a directory", dirname);
+    return NULL;
+  }
+
+  AgnILocusCache *cache = gt_malloc( sizeof(AgnILocusCache) );
+  cache->dirname = gt_cstr_dup(dirname);
+  cache->hits = 0;
+  cache->misses = 0;
+  pthread_mutex_init(&cache->mutex, NULL);
+  return cache;
+}
+
+GtUword agn_ilocus_cache_num_hits(AgnILocusCache *cache)
+{
+  return cache->hits;
+}
+
+GtUword agn_ilocus_cache_num_misses(AgnILocusCache *cache)
+{
+  return cache->misses;
+}
+
+bool agn_ilocus_cache_put(AgnILocusCache *cache, GtUword key, GtStr *desc,
+                          GtArray *output, AgnOutputSink *ilens)
+{
+  agn_assert(cache && desc && output);
+  GtStr *ilentext = gt_str_new();
+  if(ilens != NULL)
+  {
+    gt_str_append_cstr_nt(ilentext, agn_output_sink_get(ilens),
+                          agn_output_sink_length(ilens));
+  }
+
+  char *body = NULL;
+  size_t bodysize = 0;
+  bool cacheable = true;
+  FILE *outstream = open_memstream(&body, &bodysize);
+  bool success = outstream != NULL &&
+                 fwrite(ILOCUS_CACHE_MAGIC, 1, 8, outstream) == 8 &&
+                 agn_uword_write(outstream, ILOCUS_CACHE_VERSION) &&
+                 agn_uword_write(outstream, key) &&
+                 agn_str_write(outstream, gt_str_get(desc)) &&
+                 agn_str_write(outstream, gt_str_get(ilentext)) &&
+                 agn_uword_write(outstream, gt_array_size(output));
+  GtUword i;
+  for(i = 0; success && cacheable && i < gt_array_size(output); i++)
+  {
+    GtGenomeNode **gn = gt_array_get(output, i);
+    GtFeatureNode *fn = gt_feature_node_try_cast(*gn);
+    if(fn != NULL)
+    {
+      success = ilocus_cache_write_locus(outstream, fn, &cacheable);
+      continue;
+    }
+    GtUword *index = ilocus_cache_label(*gn);
+    if(index == NULL)
+      cacheable = false;
+    else
+    {
+      success = agn_uword_write(outstream, 0) &&
+                agn_uword_write(outstream, *index);
+    }
+  }
+  if(outstream != NULL)
+    success = fclose(outstream) == 0 && success;
+
+  // Write to a temporary file first so that other runs never read a partial
+  // entry
+  if(success && cacheable)
+  {
+    GtStr *filename = gt_str_new();
+    ilocus_cache_filename(cache, key, filename);
+    GtStr *tempname = gt_str_new_cstr(cache->dirname);
+    gt_str_append_cstr(tempname, "/.tmp-XXXXXX");
+    int fd = mkstemp(gt_str_get(tempname));
+    FILE *entrystream = fd == -1 ? NULL : fdopen(fd, "wb");
+    success = entrystream != NULL &&
+              fwrite(body, 1, bodysize, entrystream) == bodysize;
+    if(entrystream != NULL)
+      success = fclose(entrystream) == 0 && success;
+    else if(fd != -1)
+      close(fd);
+    success = success &&
+              rename(gt_str_get(tempname), gt_str_get(filename)) == 0;
+    if(!success && fd != -1)
+      unlink(gt_str_get(tempname));
+    gt_str_delete(filename);
+    gt_str_delete(tempname);
+  }
+
+  for(i = 0; i < gt_array_size(output); i++)
+  {
+    GtGenomeNode **gn = gt_array_get(output, i);
+    GtFeatureNode *fn = gt_feature_node_try_cast(*gn);
+    if(fn == NULL)
+    {
+      ilocus_cache_unlabel(*gn);
+      continue;
+    }
+    GtFeatureNodeIterator *iter = gt_feature_node_iterator_new_direct(fn);
+    GtFeatureNode *child;
+    for(child = gt_feature_node_iterator_next(iter);
+        child != NULL;
+        child = gt_feature_node_iterator_next(iter))
+    {
+      ilocus_cache_unlabel((GtGenomeNode *)child);
+    }
+    gt_feature_node_iterator_delete(iter);
+  }
+
+  free(body);
+  gt_str_delete(ilentext);
+  return success;
+}
+
+bool agn_ilocus_cache_unit_test(AgnUnitTest *test)
+{
+  char dirname[] = "/tmp/agn-ilocus-cache-XXXXXX";
+  if(mkdtemp(dirname) == NULL)
+  {
+    fprintf(stderr, "error creating unit test cache directory\n");
+    exit(1);
+  }
+
+  GtError *error = gt_error_new();
+  AgnILocusCache *cache = agn_ilocus_cache_new(dirname, error);
+  agn_assert(cache != NULL);
+  const char *settings = "delta=200";
+
+  // First run: nothing is cached, so compute and store the iLoci
+  GtArray *nodes1 = ilocus_cache_test_data(5001);
+  GtArray *output1 = gt_array_new( sizeof(GtGenomeNode *) );
+  AgnOutputSink *ilens1 = agn_output_sink_new_memory();
+  GtStr *desc1 = gt_str_new();
+  GtUword key1 = agn_ilocus_cache_key(cache, settings, nodes1, desc1);
+  bool misstest = !agn_ilocus_cache_get(cache, key1, desc1, nodes1, output1,
+                                        ilens1);
+  misstest = misstest && agn_ilocus_cache_num_hits(cache) == 0 &&
+             agn_ilocus_cache_num_misses(cache) == 1;
+  agn_unit_test_result(test, "empty cache", misstest);
+  ilocus_cache_test_run(nodes1, output1, ilens1);
+  bool puttest = gt_array_size(output1) == 7 &&
+                 agn_ilocus_cache_put(cache, key1, desc1, output1, ilens1);
+  agn_unit_test_result(test, "store iLoci", puttest);
+
+  // Second run: the same input is rebuilt from the cache
+  GtArray *nodes2 = ilocus_cache_test_data(5001);
+  GtArray *output2 = gt_array_new( sizeof(GtGenomeNode *) );
+  AgnOutputSink *ilens2 = agn_output_sink_new_memory();
+  GtStr *desc2 = gt_str_new();
+  GtUword key2 = agn_ilocus_cache_key(cache, settings, nodes2, desc2);
+  bool hittest = key1 == key2 &&
+                 agn_ilocus_cache_get(cache, key2, desc2, nodes2, output2,
+                                      ilens2) &&
+                 agn_ilocus_cache_num_hits(cache) == 1;
+  agn_unit_test_result(test, "cache hit", hittest);
+  gt_array_delete(nodes2);
+
+  bool loctest = hittest && gt_array_size(output1) == gt_array_size(output2);
+  GtUword i, j;
+  for(i = 0; loctest && i < gt_array_size(output1); i++)
+  {
+    GtFeatureNode *l1 = *(GtFeatureNode **)gt_array_get(output1, i);
+    GtFeatureNode *l2 = *(GtFeatureNode **)gt_array_get(output2, i);
+    GtRange r1 = gt_genome_node_get_range((GtGenomeNode *)l1);
+    GtRange r2 = gt_genome_node_get_range((GtGenomeNode *)l2);
+    GtStrArray *attrs1 = gt_feature_node_get_attribute_list(l1);
+    GtStrArray *attrs2 = gt_feature_node_get_attribute_list(l2);
+    loctest = gt_range_compare(&r1, &r2) == 0 &&
+              gt_feature_node_number_of_children(l1) ==
+              gt_feature_node_number_of_children(l2) &&
+              strcmp(gt_feature_node_get_source(l1),
+                     gt_feature_node_get_source(l2)) == 0 &&
+              gt_str_array_size(attrs1) == gt_str_array_size(attrs2);
+    for(j = 0; loctest && j < gt_str_array_size(attrs1); j++)
+    {
+      const char *key = gt_str_array_get(attrs1, j);
+      loctest = strcmp(key, gt_str_array_get(attrs2, j)) == 0 &&
+                strcmp(gt_feature_node_get_attribute(l1, key),
+                       gt_feature_node_get_attribute(l2, key)) == 0;
+    }
+    gt_str_array_delete(attrs1);
+    gt_str_array_delete(attrs2);
+  }
+  agn_unit_test_result(test, "cached iLoci", loctest);
+
+  GtUword length = agn_output_sink_length(ilens1);
+  bool ilenstest = length > 0 && length == agn_output_sink_length(ilens2) &&
+                   memcmp(agn_output_sink_get(ilens1),
+                          agn_output_sink_get(ilens2), length) == 0;
+  agn_unit_test_result(test, "cached iLocus lengths", ilenstest);
+
+  // A change to the annotation or to the settings changes the key
+  GtArray *nodes3 = ilocus_cache_test_data(5101);
+  GtArray *nodes4 = ilocus_cache_test_data(5001);
+  GtStr *desc3 = gt_str_new();
+  GtStr *desc4 = gt_str_new();
+  GtUword key3 = agn_ilocus_cache_key(cache, settings, nodes3, desc3);
+  GtUword key4 = agn_ilocus_cache_key(cache, "delta=300", nodes4, desc4);
+  GtArray *output3 = gt_array_new( sizeof(GtGenomeNode *) );
+  bool changetest = key3 != key1 && key4 != key1 &&
+                    !agn_ilocus_cache_get(cache, key3, desc3, nodes3, output3,
+                                          NULL) &&
+                    gt_array_size(output3) == 0;
+  agn_unit_test_result(test, "changed sequence", changetest);
+
+  // A sequence whose key collides with that of a cached sequence (simulated
+  // here by looking up a different sequence under the cached key) is a miss
+  bool collisiontest = !agn_ilocus_cache_get(cache, key1, desc4, nodes4,
+                                             output3, NULL) &&
+                       gt_array_size(output3) == 0 &&
+                       gt_array_size(nodes4) > 0;
+  agn_unit_test_result(test, "key collision", collisiontest);
+
+  GtArray *arrays[] = { output1, output2, nodes3, nodes4, output3 };
+  for(i = 0; i < sizeof(arrays) / sizeof(arrays[0]); i++)
+  {
+    while(gt_array_size(arrays[i]) > 0)
+    {
+      GtGenomeNode **gn = gt_array_pop(arrays[i]);
+      gt_genome_node_delete(*gn);
+    }
+    gt_array_delete(arrays[i]);
+  }
+  agn_output_sink_delete(ilens1);
+  agn_output_sink_delete(ilens2);
+  gt_str_delete(desc1);
+  gt_str_delete(desc2);
+  gt_str_delete(desc3);
+  gt_str_delete(desc4);
+  GtStr *filename = gt_str_new();
+  ilocus_cache_filename(cache, key1, filename);
+  unlink(gt_str_get(filename));
+  gt_str_delete(filename);
+  rmdir(dirname);
+  agn_ilocus_cache_delete(cache);
+  gt_error_delete(error);
+  return agn_unit_test_success(test);
+}
+
+static void ilocus_cache_describe(GtGenomeNode *gn, GtStr *desc)
+{
+  GtFeatureNode *fn = gt_feature_node_try_cast(gn);
+  if(fn == NULL)
+  {
+    // Sequence regions determine the coordinates of iLoci at sequence ends
+    if(gt_region_node_try_cast(gn) == NULL)
+    {
+      gt_str_append_cstr(desc, "node\n");
+      return;
+    }
+    gt_str_append_cstr(desc, "region\t");
+    gt_str_append_str(desc, gt_genome_node_get_seqid(gn));
+    gt_str_append_char(desc, '\t');
+    gt_str_append_uword(desc, gt_genome_node_get_start(gn));
+    gt_str_append_char(desc, '\t');
+    gt_str_append_uword(desc, gt_genome_node_get_end(gn));
+    gt_str_append_char(desc, '\n');
+    return;
+  }
+
+  GtFeatureNodeIterator *iter = gt_feature_node_iterator_new(fn);
+  GtFeatureNode *subfeature;
+  for(subfeature = gt_feature_node_iterator_next(iter);
+      subfeature != NULL;
+      subfeature = gt_feature_node_iterator_next(iter))
+  {
+    GtGenomeNode *sgn = (GtGenomeNode *)subfeature;
+    const char *id = gt_feature_node_get_attribute(subfeature, "ID");
+    gt_str_append_str(desc, gt_genome_node_get_seqid(sgn));
+    gt_str_append_char(desc, '\t');
+    gt_str_append_cstr(desc, gt_feature_node_get_type(subfeature));
+    gt_str_append_char(desc, '\t');
+    gt_str_append_uword(desc, gt_genome_node_get_start(sgn));
+    gt_str_append_char(desc, '\t');
+    gt_str_append_uword(desc, gt_genome_node_get_end(sgn));
+    gt_str_append_char(desc, '\t');
+    gt_str_append_char(desc,
+                       GT_STRAND_CHARS[gt_feature_node_get_strand(subfeature)]);
+    gt_str_append_char(desc, '\t');
+    gt_str_append_uword(desc, gt_feature_node_number_of_children(subfeature));
+    gt_str_append_char(desc, '\t');
+    gt_str_append_cstr(desc, id != NULL ? id : "");
+    gt_str_append_char(desc, '\n');
+  }
+  gt_feature_node_iterator_delete(iter);
+}
+
+static void ilocus_cache_filename(AgnILocusCache *cache, GtUword key,
+                                  GtStr *filename)
+{
+  char keystr[32];
+  sprintf(keystr, "/%016lx.ilc", key);
+  gt_str_reset(filename);
+  gt_str_append_cstr(filename, cache->dirname);
+  gt_str_append_cstr(filename, keystr);
+}
+
+static GtUword ilocus_cache_hash(GtUword hash, const void *data,
+                                 GtUword length)
+{
+  const unsigned char *bytes = data;
+  uint64_t value = hash;
+  GtUword i;
+  for(i = 0; i < length; i++)
+  {
+    value ^= bytes[i];
+    value *= 1099511628211ULL;
+  }
+  return (GtUword)value;
+}
+
+static GtUword *ilocus_cache_label(GtGenomeNode *gn)
+{
+  return gt_genome_node_get_user_data(gn, ILOCUS_CACHE_LABEL);
+}
+
+static bool ilocus_cache_read_item(FILE *instream, GtArray *nodes, bool *used,
+                                   ILocusCacheItem *item)
+{
+  GtUword kind, i, index, numattrs, numchildren;
+  GtUword numnodes = gt_array_size(nodes);
+  item->locus = NULL;
+  item->children = NULL;
+  item->index = 0;
+  if(!agn_uword_read(instream, &kind))
+    return false;
+  if(kind == 0)
+  {
+    if(!agn_uword_read(instream, &item->index) || item->index >= numnodes ||
+       used[item->index])
+      return false;
+    used[item->index] = true;
+    return true;
+  }
+
+  GtStr *seqid = gt_str_new();
+  GtStr *source = gt_str_new();
+  GtStr *type = gt_str_new();
+  GtStr *key = gt_str_new();
+  GtStr *value = gt_str_new();
+  bool success = kind == 1 &&
+                 agn_str_read(instream, seqid) &&
+                 agn_str_read(instream, source) &&
+                 agn_uword_read(instream, &item->range.start) &&
+                 agn_uword_read(instream, &item->range.end) &&
+                 item->range.start <= item->range.end &&
+                 agn_str_read(instream, type) &&
+                 agn_uword_read(instream, &numattrs);
+  if(success)
+  {
+    item->locus = agn_locus_new(seqid);
+    gt_feature_node_set_source((GtFeatureNode *)item->locus, source);
+    if(gt_str_length(type) > 0)
+    {
+      gt_genome_node_add_user_data(item->locus, "iLocus_type",
+                                   gt_cstr_dup(gt_str_get(type)),
+                                   gt_free_func);
+    }
+    item->children = gt_array_new( sizeof(GtUword) );
+  }
+  for(i = 0; success && i < numattrs; i++)
+  {
+    success = agn_str_read(instream, key) && agn_str_read(instream, value) &&
+              gt_feature_node_get_attribute((GtFeatureNode *)item->locus,
+                                            gt_str_get(key)) == NULL;
+    if(success)
+    {
+      gt_feature_node_add_attribute((GtFeatureNode *)item->locus,
+                                    gt_str_get(key), gt_str_get(value));
+    }
+  }
+  success = success && agn_uword_read(instream, &numchildren);
+  for(i = 0; success && i < numchildren; i++)
+  {
+    success = agn_uword_read(instream, &index) && index < numnodes &&
+              !used[index] &&
+              gt_feature_node_try_cast(*(GtGenomeNode **)
+                                       gt_array_get(nodes, index)) != NULL;
+    if(success)
+    {
+      used[index] = true;
+      gt_array_add(item->children, index);
+    }
+  }
+
+  if(!success && item->locus != NULL)
+  {
+    agn_locus_delete(item->locus);
+    gt_array_delete(item->children);
+    item->locus = NULL;
+    item->children = NULL;
+  }
+  gt_str_delete(seqid);
+  gt_str_delete(source);
+  gt_str_delete(type);
+  gt_str_delete(key);
+  gt_str_delete(value);
+  return success;
+}
+
+static GtArray *ilocus_cache_test_data(GtUword start)
+{
+  GtArray *nodes = gt_array_new( sizeof(GtGenomeNode *) );
+  GtStr *seqid = gt_str_new_cstr("chr");
+  GtGenomeNode *gn = gt_region_node_new(seqid, 1, 20000);
+  gt_array_add(nodes, gn);
+
+  GtUword starts[] = { 1001, start, 12001 };
+  GtStrand strands[] = { GT_STRAND_FORWARD, GT_STRAND_REVERSE,
+                         GT_STRAND_FORWARD };
+  GtUword i;
+  for(i = 0; i < 3; i++)
+  {
+    char id[16];
+    GtGenomeNode *gene = gt_feature_node_new(seqid, "gene", starts[i],
+                                             starts[i] + 999, strands[i]);
+    GtGenomeNode *mrna = gt_feature_node_new(seqid, "mRNA", starts[i],
+                                             starts[i] + 999, strands[i]);
+    sprintf(id, "gene%lu", i + 1);
+    gt_feature_node_add_attribute((GtFeatureNode *)gene, "ID", id);
+    gt_feature_node_add_child((GtFeatureNode *)gene, (GtFeatureNode *)mrna);
+    gt_array_add(nodes, gene);
+  }
+  gt_str_delete(seqid);
+  return nodes;
+}
+
+static void ilocus_cache_test_run(GtArray *nodes, GtArray *output,
+                                  AgnOutputSink *ilens)
+{
+  GtUword progress;
+  GtError *error = gt_error_new();
+  GtNodeStream *ais = gt_array_in_stream_new(nodes, &progress, error);
+  GtNodeStream *ls = agn_locus_stream_new(ais, 200);
+  agn_locus_stream_set_name_format((AgnLocusStream *)ls, "iLocus%lu");
+  agn_locus_stream_track_ilens((AgnLocusStream *)ls, ilens);
+  GtNodeStream *aos = gt_array_out_stream_new(ls, output, error);
+  int result = gt_node_stream_pull(aos, error);
+  if(result)
+  {
+    fprintf(stderr, "[AgnILocusCache::ilocus_cache_test_run] error computing "
+            "iLoci: %s\n", gt_error_get(error));
+  }
+  gt_node_stream_delete(aos);
+  gt_node_stream_delete(ls);
+  gt_node_stream_delete(ais);
+  gt_array_delete(nodes);
+  gt_error_delete(error);
+}
+
+static void ilocus_cache_unlabel(GtGenomeNode *gn)
+{
+  if(ilocus_cache_label(gn) != NULL)
+    gt_genome_node_release_user_data(gn, ILOCUS_CACHE_LABEL);
+}
+
+static bool ilocus_cache_write_locus(FILE *outstream, GtFeatureNode *locus,
+                                     bool *cacheable)
+{
+  GtGenomeNode *gn = (GtGenomeNode *)locus;
+  const char *type = gt_genome_node_get_user_data(gn, "iLocus_type");
+  bool success = agn_uword_write(outstream, 1) &&
+                 agn_str_write(outstream,
+                               gt_str_get(gt_genome_node_get_seqid(gn))) &&
+                 agn_str_write(outstream, gt_feature_node_get_source(locus)) &&
+                 agn_uword_write(outstream, gt_genome_node_get_start(gn)) &&
+                 agn_uword_write(outstream, gt_genome_node_get_end(gn)) &&
+                 agn_str_write(outstream, type != NULL ? type : "");
+
+  GtStrArray *attrs = gt_feature_node_get_attribute_list(locus);
+  GtUword i;
+  success = success && agn_uword_write(outstream, gt_str_array_size(attrs));
+  for(i = 0; success && i < gt_str_array_size(attrs); i++)
+  {
+    const char *key = gt_str_array_get(attrs, i);
+    success = agn_str_write(outstream, key) &&
+              agn_str_write(outstream,
+                            gt_feature_node_get_attribute(locus, key));
+  }
+  gt_str_array_delete(attrs);
+
+  success = success &&
+            agn_uword_write(outstream,
+                            gt_feature_node_number_of_children(locus));
+  GtFeatureNodeIterator *iter = gt_feature_node_iterator_new_direct(locus);
+  GtFeatureNode *child;
+  for(child = gt_feature_node_iterator_next(iter);
+      success && *cacheable && child != NULL;
+      child = gt_feature_node_iterator_next(iter))
+  {
+    GtUword *index = ilocus_cache_label((GtGenomeNode *)child);
+    if(index == NULL)
+      *cacheable = false;
+    else
+      success = agn_uword_write(outstream, *index);
+  }
+  gt_feature_node_iterator_delete(iter);
+  return success;
+}
@@ -8,13 +8,56 @@ online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
 
 **/
 #include <math.h>
+#include <stdint.h>
 #include <string.h>
+#include <time.h>
 #include "core/array_api.h"
 #include "extended/feature_node_iterator_api.h"
 #include "AgnLocus.h"
 #include "AgnTypecheck.h"
 #include "AgnUtils.h"
 
+#define locus_bitset_has(BS, I) (((BS)[(I) / 64] >> ((I) % 64)) & 1)
+#define locus_bitset_add(BS, I) ((BS)[(I) / 64] |= (uint64_t)1 << ((I) % 64))
+#define locus_bitset_rem(BS, I) ((BS)[(I) / 64] &= ~((uint64_t)1 << ((I) % 64)))
+
+//------------------------------------------------------------------------------
+// Data structure definitions
+//------------------------------------------------------------------------------
+
+/**
+ * State for enumerating maximal cliques of a set of transcripts, indexed
+ * 0..n-1. ``adjacency`` holds one bitset of ``numwords`` 64-bit words per
+ * transcript, with bit j of transcript i's bitset set if transcripts i and j do
+ * not overlap. ``workspace`` holds the R, P, X, and candidate bitsets for each
+ * level of recursion, and each maximal clique found is stored in ``cliques`` as
+ * a sorted array of transcript indices.
+ */
+typedef struct
+{
+  GtUword numtrans;
+  GtUword numwords;
+  uint64_t *adjacency;
+  uint64_t *workspace;
+  GtArray *cliques;
+} CliqueSearch;
+
+/**
+ * A candidate pairing of the reference clique and prediction clique at the
+ * given indices. Until the pair is evaluated, ``pair`` is NULL and ``key`` is
+ * only an upper bound on the pair's ranking. ``order`` is the position of the
+ * pair in refr-major enumeration order, used to break ties.
+ */
+typedef struct
+{
+  GtUword refr_index;
+  GtUword pred_index;
+  GtUword order;
+  AgnCliquePairKey key;
+  AgnCliquePair *pair;
+} PairCandidate;
+
+
 //------------------------------------------------------------------------------
 // Prototypes for private functions
 //------------------------------------------------------------------------------
@@ -23,13 +66,68 @@ online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
  * @function The Bron-Kerbosch algorithm is an algorithm for enumerating all
  * maximal cliques in an undirected graph. See the `algorithm's Wikipedia entry
  * <http://en.wikipedia.org/wiki/Bron%E2%80%93Kerbosch_algorithm>`_
- * for a description of ``R``, ``P``, and ``X``. All maximal cliques will be
- * stored in ``cliques``. If ``skipsimplecliques`` is true, cliques containing a
- * single item will not be stored.
+ * for a description of ``R``, ``P``, and ``X``. This implementation uses
+ * Tomita-style pivoting (only vertices not adjacent to a pivot chosen to
+ * maximize ``|P \intersect N(u)|`` are expanded) and represents ``R``, ``P``,
+ * and ``X`` as bitsets stored at level ``depth`` of the search workspace.
+ * Cliques containing a single item are not stored.
+ */
+static void locus_bron_kerbosch(CliqueSearch *search, GtUword depth);
+
+/**
+ * @function Textbook implementation of the Bron-Kerbosch algorithm, without
+ * pivoting. All maximal cliques will be stored in ``cliques``. If
+ * ``skipsimplecliques`` is true, cliques containing a single item will not be
+ * stored. Used only as a reference for testing and benchmarking.
+ */
+static void locus_bron_kerbosch_unpivoted(GtArray *R, GtArray *P, GtArray *X,
+                                          GtArray *cliques,
+                                          AgnSequenceRegion *region,
+                                          bool skipsimplecliques);
+
+/**
+ * @function Comparison function for sorting candidates in the order they should
+ * be considered (see ``locus_candidate_precedes``).
+ */
+static int locus_candidate_compare(const PairCandidate *c1,
+                                   const PairCandidate *c2);
+
+/**
+ * @function Remove the highest-priority candidate from the binary heap
+ * ``queue`` and store it in ``candidate``.
+ */
+static void locus_candidate_pop(GtArray *queue, PairCandidate *candidate);
+
+/**
+ * @function Returns true if candidate ``c1`` should be considered before
+ * ``c2``: the one with the higher ranking comes first; for equal rankings, an
+ * upper bound comes before an evaluated pair, and otherwise enumeration order
+ * decides.
  */
-static void locus_bron_kerbosch(GtArray *R, GtArray *P, GtArray *X,
-                                GtArray *cliques, AgnSequenceRegion *region,
-                                bool skipsimplecliques);
+static bool locus_candidate_precedes(const PairCandidate *c1,
+                                     const PairCandidate *c2);
+
+/**
+ * @function Add a candidate to the binary heap ``queue``.
+ */
+static void locus_candidate_push(GtArray *queue, PairCandidate *candidate);
+
+/**
+ * @function Run both clique enumeration implementations on synthetic loci with
+ * ``numtrans`` overlapping transcripts. Returns true if both yield the same
+ * cliques in the same order. If ``elapsed`` is not NULL, the CPU time (in
+ * seconds) taken by the unpivoted and pivoted implementations is stored in
+ * ``elapsed[0]`` and ``elapsed[1]``, respectively.
+ */
+static bool locus_clique_enumeration_check(GtUword numtrans, GtUword numloci,
+                                           double *elapsed);
+
+/**
+ * @function Compare two maximal cliques, each stored as a sorted array of
+ * transcript indices, lexicographically. This is the order in which the
+ * unpivoted Bron-Kerbosch algorithm discovers cliques.
+ */
+static int locus_clique_index_compare(const void *c1, const void *c2);
 
 /**
  * @function ``GtFree`` function: treats each entry in the array as an
@@ -45,6 +143,15 @@ static void locus_clique_array_delete(GtArray *array);
  */
 static void locus_clique_pair_array_delete(GtArray *array);
 
+/**
+ * @function Comparative analysis for a locus built from a reference and
+ * ``numsets`` prediction sets: the reference transcript cliques are enumerated
+ * once and shared by the comparisons with each prediction set, whose results
+ * are stored with the corresponding prediction set locus.
+ */
+static void locus_comparative_analysis_pred_sets(AgnLocus *locus,
+                                                 GtUword numsets);
+
 /**
  * @function If reference transcripts belonging to the same locus overlap, they
  * must be separated before comparison with prediction transcript models (and
@@ -53,6 +160,14 @@ static void locus_clique_pair_array_delete(GtArray *array);
  */
 static GtArray *locus_enumerate_cliques(AgnLocus *locus, GtArray *trans);
 
+/**
+ * @function Same as ``locus_enumerate_cliques``, but using the unpivoted
+ * Bron-Kerbosch implementation. Used only as a reference for testing and
+ * benchmarking.
+ */
+static GtArray *locus_enumerate_cliques_unpivoted(AgnLocus *locus,
+                                                  GtArray *trans);
+
 /**
  * @function Once all reference transcript cliques and prediction transcript
  * cliques have been enumerated, this function enumerates every possible
@@ -68,10 +183,63 @@ static GtUword locus_length(AgnLocus *locus,
                             GT_UNUSED AgnComparisonSource source);
 
 /**
- * @function Determine which clique pairs will actually be reported.
+ * @function ``GtFree`` function: treats each entry in the array as an
+ * ``AgnLocus **``, dereferences & deletes each non-NULL entry, and deletes the
+ * array.
+ */
+static void locus_pred_set_array_delete(GtArray *array);
+
+/**
+ * @function Create a locus for each prediction set, containing all of the
+ * reference genes and the prediction genes from that set, and store them with
+ * ``locus``. The entry for a set with no genes at all is NULL.
+ */
+static GtArray *locus_pred_sets_split(AgnLocus *locus, GtUword numsets);
+
+/**
+ * @function Store the selected clique pairs (and any cliques not included in
+ * them) with the locus for reporting, and aggregate their comparison stats.
  */
-static void locus_select_pairs(AgnLocus *locus, GtArray *refrcliques,
-                               GtArray *predcliques, GtArray *clique_pairs);
+static void locus_report_pairs(AgnLocus *locus, GtArray *refrcliques,
+                               GtArray *predcliques, GtArray *pairs2report);
+
+/**
+ * @function Determine which clique pairs will actually be reported: in order of
+ * decreasing ranking, each pair is selected unless it shares a transcript with
+ * a previously selected pair. Pairs are drawn from a priority queue seeded with
+ * cheap upper bounds on each pair's ranking, and a pair is only evaluated in
+ * full when its bound reaches the front of the queue and neither of its cliques
+ * has been claimed. Unselected pairs are deleted.
+ */
+static GtArray *locus_select_pairs(GtArray *refrcliques, GtArray *predcliques);
+
+/**
+ * @function Same as ``locus_select_pairs``, but evaluating and sorting every
+ * possible pair up front, as was done before bounds were introduced. Used only
+ * as a reference for testing.
+ */
+static GtArray *locus_select_pairs_exhaustive(AgnLocus *locus,
+                                              GtArray *refrcliques,
+                                              GtArray *predcliques);
+
+/**
+ * @function Run both clique pair selection implementations on a synthetic locus
+ * with ``numtrans`` reference and ``numtrans`` prediction transcripts. Returns
+ * true if both select the same pairs in the same order. If ``elapsed`` is not
+ * NULL, the CPU time (in seconds) taken by the exhaustive and bounded
+ * implementations is added to ``elapsed[0]`` and ``elapsed[1]``, respectively.
+ */
+static bool locus_select_pairs_check(GtUword numtrans, uint64_t *seed,
+                                     double *elapsed);
+
+/**
+ * @function Generate a locus spanning ``length`` bp with ``numtrans`` randomly
+ * placed, heavily overlapping single-exon transcripts for testing and
+ * benchmarking. Transcripts are stored in ``trans``; the caller is responsible
+ * for deleting them and the locus.
+ */
+static AgnLocus *locus_synthetic_isoforms(GtUword numtrans, GtUword length,
+                                          uint64_t *seed, GtArray *trans);
 
 /**
  * @function Generate data for unit testing.
@@ -145,6 +313,53 @@ void agn_locus_add(AgnLocus *locus, GtFeatureNode *feature,
     gt_hashmap_add(feats, feature, feature);
 }
 
+void agn_locus_add_pred_set_feature(AgnLocus *locus, GtFeatureNode *feature,
+                                    GtUword set)
+{
+  GtUword *setnum = gt_malloc( sizeof(GtUword) );
+  *setnum = set;
+  gt_genome_node_add_user_data((GtGenomeNode *)feature, "predset", setnum,
+                               (GtFree)gt_free_func);
+  agn_locus_add(locus, feature, PREDICTIONSOURCE);
+}
+
+bool agn_locus_benchmark(AgnUnitTest *test)
+{
+  GtUword sizes[] = { 20, 30, 40, 50 };
+  GtUword i;
+  for(i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+  {
+    double elapsed[2];
+    char label[64];
+    bool identical = locus_clique_enumeration_check(sizes[i], 10, elapsed);
+    printf("        [clique enumeration] %2lu isoforms x 10 loci: unpivoted "
+           "%.3fs, pivoted %.3fs (%.1fx)\n", sizes[i], elapsed[0], elapsed[1],
+           elapsed[1] > 0.0 ? elapsed[0] / elapsed[1] : 0.0);
+    sprintf(label, "identical cliques, %lu isoforms", sizes[i]);
+    agn_unit_test_result(test, label, identical);
+  }
+
+  uint64_t seed = 42;
+  for(i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+  {
+    double elapsed[2] = { 0.0, 0.0 };
+    char label[64];
+    bool identical = true;
+    GtUword j;
+    for(j = 0; j < 10; j++)
+      identical = locus_select_pairs_check(sizes[i] / 2, &seed, elapsed) &&
+                  identical;
+    printf("        [pair selection] %2lu+%2lu isoforms x 10 loci: exhaustive "
+           "%.3fs, bounded %.3fs (%.1fx)\n", sizes[i] / 2, sizes[i] / 2,
+           elapsed[0], elapsed[1],
+           elapsed[1] > 0.0 ? elapsed[0] / elapsed[1] : 0.0);
+    sprintf(label, "identical clique pairs, %lu+%lu isoforms", sizes[i] / 2,
+            sizes[i] / 2);
+    agn_unit_test_result(test, label, identical);
+  }
+  return agn_unit_test_success(test);
+}
+
 AgnLocus *agn_locus_clone(AgnLocus *locus)
 {
   GtStr *seqid = gt_genome_node_get_seqid(locus);
@@ -232,6 +447,13 @@ void agn_locus_comparative_analysis(AgnLocus *locus, GtLogger *logger)
   if(pairs2report != NULL)
     return;
 
+  GtUword numsets = agn_locus_num_pred_sets(locus);
+  if(numsets > 0)
+  {
+    locus_comparative_analysis_pred_sets(locus, numsets);
+    return;
+  }
+
   GtArray *refr_trans = agn_locus_refr_mrnas(locus);
   GtArray *refrcliques = locus_enumerate_cliques(locus, refr_trans);
   gt_array_delete(refr_trans);
@@ -262,13 +484,12 @@ void agn_locus_comparative_analysis(AgnLocus *locus, GtLogger *logger)
     return;
   }
 
-  GtArray *clique_pairs = locus_enumerate_pairs(locus,refrcliques,predcliques);
-  gt_array_sort(clique_pairs, (GtCompare)agn_clique_pair_compare_reverse);
-  locus_select_pairs(locus, refrcliques, predcliques, clique_pairs);
+  pairs2report = locus_select_pairs(refrcliques, predcliques);
+  locus_report_pairs(locus, refrcliques, predcliques, pairs2report);
 
   gt_array_delete(refrcliques);
   gt_array_delete(predcliques);
-  gt_array_delete(clique_pairs);
+  gt_array_delete(pairs2report);
 }
 
 int agn_locus_array_compare(const void *p1, const void *p2)
@@ -539,6 +760,16 @@ GtArray *agn_locus_get(AgnLocus *locus)
   return children;
 }
 
+AgnLocus *agn_locus_get_pred_set(AgnLocus *locus, GtUword set)
+{
+  GtUword numsets = agn_locus_num_pred_sets(locus);
+  agn_assert(set < numsets);
+  GtArray *setloci = gt_genome_node_get_user_data(locus, "predsetloci");
+  if(setloci == NULL)
+    setloci = locus_pred_sets_split(locus, numsets);
+  return *(AgnLocus **)gt_array_get(setloci, set);
+}
+
 GtArray *agn_locus_get_unique_pred_cliques(AgnLocus *locus)
 {
   return gt_genome_node_get_user_data(locus, "uniqpred");
@@ -742,6 +973,14 @@ GtUword agn_locus_mrna_num(AgnLocus *locus, AgnComparisonSource src)
   return count;
 }
 
+GtUword agn_locus_num_pred_sets(AgnLocus *locus)
+{
+  GtUword *numsets = gt_genome_node_get_user_data(locus, "numpredsets");
+  if(numsets == NULL)
+    return 0;
+  return *numsets;
+}
+
 AgnLocus *agn_locus_new(GtStr *seqid)
 {
   AgnLocus *locus = gt_feature_node_new(seqid, "locus", 0, 0, GT_STRAND_BOTH);
@@ -921,6 +1160,58 @@ void agn_locus_print_transcript_mapping(AgnLocus *locus, FILE *outstream)
   gt_array_delete(transids);
 }
 
+void agn_locus_remove_pred_set(AgnLocus *locus, GtUword set)
+{
+  AgnLocus *setlocus = agn_locus_get_pred_set(locus, set);
+  if(setlocus == NULL)
+    return;
+
+  GtArray *setloci = gt_genome_node_get_user_data(locus, "predsetloci");
+  AgnLocus **entry = gt_array_get(setloci, set);
+  agn_locus_delete(setlocus);
+  *entry = NULL;
+}
+
+void agn_locus_set_comparative_analysis(AgnLocus *locus,
+                                        GtArray *pairs2report,
+                                        GtArray *uniqrefr, GtArray *uniqpred)
+{
+  AgnComparison *stats = gt_genome_node_get_user_data(locus, "compstats");
+  GtUword i;
+  agn_assert(stats != NULL && pairs2report != NULL);
+  agn_assert(gt_genome_node_get_user_data(locus, "pairs2report") == NULL);
+
+  for(i = 0; i < gt_array_size(pairs2report); i++)
+  {
+    AgnCliquePair *pair = *(AgnCliquePair **)gt_array_get(pairs2report, i);
+    agn_clique_pair_comparison_aggregate(pair, stats);
+  }
+  gt_genome_node_add_user_data(locus,"pairs2report",gt_array_ref(pairs2report),
+                               (GtFree)locus_clique_pair_array_delete);
+  agn_comparison_resolve(stats);
+
+  if(uniqrefr != NULL && gt_array_size(uniqrefr) > 0)
+  {
+    gt_genome_node_add_user_data(locus, "uniqrefr", gt_array_ref(uniqrefr),
+                                 (GtFree)locus_clique_array_delete);
+  }
+  if(uniqpred != NULL && gt_array_size(uniqpred) > 0)
+  {
+    gt_genome_node_add_user_data(locus, "uniqpred", gt_array_ref(uniqpred),
+                                 (GtFree)locus_clique_array_delete);
+  }
+}
+
+void agn_locus_set_num_pred_sets(AgnLocus *locus, GtUword numsets)
+{
+  agn_assert(numsets > 0);
+  agn_assert(gt_genome_node_get_user_data(locus, "predsetloci") == NULL);
+  GtUword *setcount = gt_malloc( sizeof(GtUword) );
+  *setcount = numsets;
+  gt_genome_node_add_user_data(locus, "numpredsets", setcount,
+                               (GtFree)gt_free_func);
+}
+
 void agn_locus_set_range(AgnLocus *locus, GtUword start, GtUword end)
 {
   if(start > end)
@@ -1088,14 +1379,112 @@ bool agn_locus_unit_test(AgnUnitTest *test)
   agn_locus_delete(locus1);
   agn_locus_delete(locus2);
 
+  bool cliquetest = locus_clique_enumeration_check(16, 5, NULL);
+  agn_unit_test_result(test, "pivoted Bron-Kerbosch", cliquetest);
+
+  GtUword i;
+  uint64_t seed = 1234;
+  bool selecttest = true;
+  for(i = 0; i < 10; i++)
+    selecttest = selecttest && locus_select_pairs_check(8, &seed, NULL);
+  agn_unit_test_result(test, "bounded clique pair selection", selecttest);
+
   gt_logger_delete(logger);
   gt_queue_delete(queue);
   return agn_unit_test_success(test);
 }
 
-static void locus_bron_kerbosch(GtArray *R, GtArray *P, GtArray *X,
-                                GtArray *cliques, AgnSequenceRegion *region,
-                                bool skipsimplecliques)
+static void locus_bron_kerbosch(CliqueSearch *search, GtUword depth)
+{
+  GtUword w, numwords = search->numwords;
+  uint64_t *R = search->workspace + depth * 4 * numwords;
+  uint64_t *P = R + numwords;
+  uint64_t *X = P + numwords;
+  uint64_t *candidates = X + numwords;
+
+  bool P_empty = true, X_empty = true;
+  for(w = 0; w < numwords; w++)
+  {
+    P_empty = P_empty && P[w] == 0;
+    X_empty = X_empty && X[w] == 0;
+  }
+  if(P_empty)
+  {
+    if(X_empty)
+    {
+      GtArray *clique = gt_array_new( sizeof(GtUword) );
+      for(w = 0; w < numwords; w++)
+      {
+        uint64_t bits = R[w];
+        while(bits)
+        {
+          GtUword index = w * 64 + __builtin_ctzll(bits);
+          gt_array_add(clique, index);
+          bits &= bits - 1;
+        }
+      }
+      if(gt_array_size(clique) > 1)
+        gt_array_add(search->cliques, clique);
+      else
+        gt_array_delete(clique);
+    }
+    return;
+  }
+
+  // Choose the pivot u from P \union X with the most neighbors in P
+  GtUword i, pivot = 0;
+  int maxneighbors = -1;
+  for(i = 0; i < search->numtrans; i++)
+  {
+    if(!locus_bitset_has(P, i) && !locus_bitset_has(X, i))
+      continue;
+    const uint64_t *N = search->adjacency + i * numwords;
+    int numneighbors = 0;
+    for(w = 0; w < numwords; w++)
+      numneighbors += __builtin_popcountll(P[w] & N[w]);
+    if(numneighbors > maxneighbors)
+    {
+      maxneighbors = numneighbors;
+      pivot = i;
+    }
+  }
+
+  // Only expand vertices in P \ N(u)
+  const uint64_t *pivotN = search->adjacency + pivot * numwords;
+  for(w = 0; w < numwords; w++)
+    candidates[w] = P[w] & ~pivotN[w];
+
+  uint64_t *newR = candidates + numwords;
+  uint64_t *newP = newR + numwords;
+  uint64_t *newX = newP + numwords;
+  for(w = 0; w < numwords; w++)
+  {
+    uint64_t bits = candidates[w];
+    while(bits)
+    {
+      GtUword v = w * 64 + __builtin_ctzll(bits);
+      const uint64_t *N = search->adjacency + v * numwords;
+      GtUword k;
+      for(k = 0; k < numwords; k++)
+      {
+        newR[k] = R[k];
+        newP[k] = P[k] & N[k];
+        newX[k] = X[k] & N[k];
+      }
+      locus_bitset_add(newR, v);
+      locus_bron_kerbosch(search, depth + 1);
+
+      locus_bitset_rem(P, v);
+      locus_bitset_add(X, v);
+      bits &= bits - 1;
+    }
+  }
+}
+
+static void locus_bron_kerbosch_unpivoted(GtArray *R, GtArray *P, GtArray *X,
+                                          GtArray *cliques,
+                                          AgnSequenceRegion *region,
+                                          bool skipsimplecliques)
 {
   agn_assert(R != NULL && P != NULL && X != NULL && cliques != NULL);
 
@@ -1128,7 +1517,8 @@ static void locus_bron_kerbosch(GtArray *R, GtArray *P, GtArray *X,
 
     // Recursive call
     // locus_bron_kerbosch(R \union {v}, P \intersect N(v), X \intersect N(X))
-    locus_bron_kerbosch(newR, newP, newX, cliques, region, skipsimplecliques);
+    locus_bron_kerbosch_unpivoted(newR, newP, newX, cliques, region,
+                                  skipsimplecliques);
 
     // Delete temporary arrays just created
     gt_array_delete(newR);
@@ -1143,6 +1533,63 @@ static void locus_bron_kerbosch(GtArray *R, GtArray *P, GtArray *X,
   }
 }
 
+static int locus_candidate_compare(const PairCandidate *c1,
+                                   const PairCandidate *c2)
+{
+  if(locus_candidate_precedes(c1, c2))
+    return -1;
+  if(locus_candidate_precedes(c2, c1))
+    return 1;
+  return 0;
+}
+
+static void locus_candidate_pop(GtArray *queue, PairCandidate *candidate)
+{
+  PairCandidate *heap = gt_array_get_space(queue);
+  GtUword size = gt_array_size(queue) - 1;
+  *candidate = heap[0];
+  PairCandidate last = heap[size];
+  gt_array_set_size(queue, size);
+
+  GtUword i = 0;
+  while(2*i + 1 < size)
+  {
+    GtUword child = 2*i + 1;
+    if(child + 1 < size && locus_candidate_precedes(heap+child+1, heap+child))
+      child++;
+    if(!locus_candidate_precedes(heap + child, &last))
+      break;
+    heap[i] = heap[child];
+    i = child;
+  }
+  if(size > 0)
+    heap[i] = last;
+}
+
+static bool locus_candidate_precedes(const PairCandidate *c1,
+                                     const PairCandidate *c2)
+{
+  int result = agn_clique_pair_key_compare(&c1->key, &c2->key);
+  if(result != 0)
+    return result > 0;
+  if((c1->pair == NULL) != (c2->pair == NULL))
+    return c1->pair == NULL;
+  return c1->order < c2->order;
+}
+
+static void locus_candidate_push(GtArray *queue, PairCandidate *candidate)
+{
+  gt_array_add(queue, *candidate);
+  PairCandidate *heap = gt_array_get_space(queue);
+  GtUword i = gt_array_size(queue) - 1;
+  while(i > 0 && locus_candidate_precedes(candidate, heap + (i - 1) / 2))
+  {
+    heap[i] = heap[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+  heap[i] = *candidate;
+}
+
 static void locus_clique_array_delete(GtArray *array)
 {
   agn_assert(array != NULL);
@@ -1154,6 +1601,79 @@ static void locus_clique_array_delete(GtArray *array)
   gt_array_delete(array);
 }
 
+static bool locus_clique_enumeration_check(GtUword numtrans, GtUword numloci,
+                                           double *elapsed)
+{
+  bool identical = true;
+  uint64_t seed = 42;
+  GtUword i, j;
+  if(elapsed != NULL)
+    elapsed[0] = elapsed[1] = 0.0;
+
+  for(i = 0; i < numloci; i++)
+  {
+    GtArray *trans = gt_array_new( sizeof(GtFeatureNode *) );
+    AgnLocus *locus = locus_synthetic_isoforms(numtrans, 10000, &seed, trans);
+
+    clock_t start = clock();
+    GtArray *refcliques = locus_enumerate_cliques_unpivoted(locus, trans);
+    clock_t middle = clock();
+    GtArray *cliques = locus_enumerate_cliques(locus, trans);
+    clock_t end = clock();
+    if(elapsed != NULL)
+    {
+      elapsed[0] += (double)(middle - start) / CLOCKS_PER_SEC;
+      elapsed[1] += (double)(end - middle) / CLOCKS_PER_SEC;
+    }
+
+    identical = identical && gt_array_size(cliques) > numtrans &&
+                gt_array_size(cliques) == gt_array_size(refcliques);
+    for(j = 0; identical && j < gt_array_size(cliques); j++)
+    {
+      AgnTranscriptClique *c1 = *(AgnTranscriptClique **)
+                                gt_array_get(cliques, j);
+      AgnTranscriptClique *c2 = *(AgnTranscriptClique **)
+                                gt_array_get(refcliques, j);
+      char *id1 = agn_transcript_clique_id(c1);
+      char *id2 = agn_transcript_clique_id(c2);
+      identical = strcmp(id1, id2) == 0;
+      gt_free(id1);
+      gt_free(id2);
+    }
+
+    locus_clique_array_delete(refcliques);
+    locus_clique_array_delete(cliques);
+    while(gt_array_size(trans) > 0)
+    {
+      GtGenomeNode **transcript = gt_array_pop(trans);
+      gt_genome_node_delete(*transcript);
+    }
+    gt_array_delete(trans);
+    agn_locus_delete(locus);
+  }
+
+  return identical;
+}
+
+static int locus_clique_index_compare(const void *c1, const void *c2)
+{
+  GtArray *clique1 = *(GtArray **)c1;
+  GtArray *clique2 = *(GtArray **)c2;
+  GtUword size1 = gt_array_size(clique1);
+  GtUword size2 = gt_array_size(clique2);
+  GtUword i;
+  for(i = 0; i < size1 && i < size2; i++)
+  {
+    GtUword index1 = *(GtUword *)gt_array_get(clique1, i);
+    GtUword index2 = *(GtUword *)gt_array_get(clique2, i);
+    if(index1 != index2)
+      return index1 < index2 ? -1 : 1;
+  }
+  if(size1 == size2)
+    return 0;
+  return size1 < size2 ? -1 : 1;
+}
+
 static void locus_clique_pair_array_delete(GtArray *array)
 {
   agn_assert(array != NULL);
@@ -1165,6 +1685,49 @@ static void locus_clique_pair_array_delete(GtArray *array)
   gt_array_delete(array);
 }
 
+static void locus_comparative_analysis_pred_sets(AgnLocus *locus,
+                                                 GtUword numsets)
+{
+  // Cliques are enumerated on the combined locus, which has the same seqid and
+  // range as each prediction set locus
+  GtArray *refr_trans = agn_locus_refr_mrnas(locus);
+  GtArray *refrcliques = locus_enumerate_cliques(locus, refr_trans);
+  gt_array_delete(refr_trans);
+
+  GtUword i, j;
+  for(i = 0; i < numsets; i++)
+  {
+    AgnLocus *setlocus = agn_locus_get_pred_set(locus, i);
+    if(setlocus == NULL ||
+       gt_genome_node_get_user_data(setlocus, "pairs2report") != NULL)
+      continue;
+
+    GtArray *pred_trans = agn_locus_pred_mrnas(setlocus);
+    GtArray *predcliques = locus_enumerate_cliques(locus, pred_trans);
+    gt_array_delete(pred_trans);
+    if(refrcliques == NULL || predcliques == NULL)
+    {
+      if(predcliques != NULL)
+        locus_clique_array_delete(predcliques);
+      continue;
+    }
+
+    // locus_report_pairs releases a reference to each clique it is given
+    GtArray *setrefr = agn_array_copy(refrcliques,
+                                      sizeof(AgnTranscriptClique *));
+    for(j = 0; j < gt_array_size(setrefr); j++)
+      gt_genome_node_ref(*(GtGenomeNode **)gt_array_get(setrefr, j));
+    GtArray *pairs2report = locus_select_pairs(setrefr, predcliques);
+    locus_report_pairs(setlocus, setrefr, predcliques, pairs2report);
+    gt_array_delete(setrefr);
+    gt_array_delete(predcliques);
+    gt_array_delete(pairs2report);
+  }
+
+  if(refrcliques != NULL)
+    locus_clique_array_delete(refrcliques);
+}
+
 static GtArray *locus_enumerate_cliques(AgnLocus *locus, GtArray *trans)
 {
   if(gt_array_size(trans) == 0)
@@ -1176,6 +1739,93 @@ static GtArray *locus_enumerate_cliques(AgnLocus *locus, GtArray *trans)
   GtRange range = gt_genome_node_get_range(locus);
   AgnSequenceRegion region = { seqid, range };
 
+  if(numtrans == 1)
+  {
+    GtFeatureNode *fn = *(GtFeatureNode **)gt_array_get(trans, 0);
+    AgnTranscriptClique *clique = agn_transcript_clique_new(&region);
+    agn_transcript_clique_add(clique, fn);
+    gt_array_add(cliques, clique);
+  }
+  else
+  {
+    // First add each transcript as a clique, even if it is not a maximal clique
+    GtUword i;
+    for(i = 0; i < numtrans; i++)
+    {
+      GtFeatureNode *fn = *(GtFeatureNode **)gt_array_get(trans, i);
+      AgnTranscriptClique *clique = agn_transcript_clique_new(&region);
+      agn_transcript_clique_add(clique, fn);
+      gt_array_add(cliques, clique);
+    }
+
+    // Two transcripts are adjacent in the graph if they do not overlap
+    CliqueSearch search;
+    search.numtrans = numtrans;
+    search.numwords = (numtrans + 63) / 64;
+    search.adjacency = gt_calloc(numtrans * search.numwords, sizeof(uint64_t));
+    GtUword j;
+    for(i = 0; i < numtrans; i++)
+    {
+      GtGenomeNode *gn_i = *(GtGenomeNode **)gt_array_get(trans, i);
+      GtRange range_i = gt_genome_node_get_range(gn_i);
+      for(j = i + 1; j < numtrans; j++)
+      {
+        GtGenomeNode *gn_j = *(GtGenomeNode **)gt_array_get(trans, j);
+        GtRange range_j = gt_genome_node_get_range(gn_j);
+        if(gt_range_overlap(&range_i, &range_j) == false)
+        {
+          locus_bitset_add(search.adjacency + i * search.numwords, j);
+          locus_bitset_add(search.adjacency + j * search.numwords, i);
+        }
+      }
+    }
+
+    // Then use the Bron-Kerbosch algorithm to find all maximal cliques
+    // containing >1 transcript; each level of recursion needs R, P, X, and
+    // candidate bitsets, and recursion is at most numtrans + 1 levels deep
+    search.workspace = gt_calloc((numtrans + 2) * 4 * search.numwords,
+                                 sizeof(uint64_t));
+    search.cliques = gt_array_new( sizeof(GtArray *) );
+    uint64_t *P = search.workspace + search.numwords;
+    for(i = 0; i < numtrans; i++)
+      locus_bitset_add(P, i);
+    locus_bron_kerbosch(&search, 0);
+
+    // Report cliques in the same order as the unpivoted algorithm would
+    gt_array_sort(search.cliques, locus_clique_index_compare);
+    for(i = 0; i < gt_array_size(search.cliques); i++)
+    {
+      GtArray *indices = *(GtArray **)gt_array_get(search.cliques, i);
+      AgnTranscriptClique *clique = agn_transcript_clique_new(&region);
+      for(j = 0; j < gt_array_size(indices); j++)
+      {
+        GtUword index = *(GtUword *)gt_array_get(indices, j);
+        GtFeatureNode *fn = *(GtFeatureNode **)gt_array_get(trans, index);
+        agn_transcript_clique_add(clique, fn);
+      }
+      gt_array_add(cliques, clique);
+      gt_array_delete(indices);
+    }
+    gt_array_delete(search.cliques);
+    gt_free(search.workspace);
+    gt_free(search.adjacency);
+  }
+
+  return cliques;
+}
+
+static GtArray *locus_enumerate_cliques_unpivoted(AgnLocus *locus,
+                                                  GtArray *trans)
+{
+  if(gt_array_size(trans) == 0)
+    return NULL;
+
+  GtArray *cliques = gt_array_new( sizeof(AgnTranscriptClique *) );
+  GtUword numtrans = gt_array_size(trans);
+  GtStr *seqid = gt_genome_node_get_seqid(locus);
+  GtRange range = gt_genome_node_get_range(locus);
+  AgnSequenceRegion region = { seqid, range };
+
   if(numtrans == 1)
   {
     GtFeatureNode *fn = *(GtFeatureNode **)gt_array_get(trans, 0);
@@ -1202,7 +1852,7 @@ static GtArray *locus_enumerate_cliques(AgnLocus *locus, GtArray *trans)
     GtArray *X = gt_array_new( sizeof(GtGenomeNode *) );
 
     // Initial call: locus_bron_kerbosch(\emptyset, vertex_set, \emptyset )
-    locus_bron_kerbosch(R, P, X, cliques, &region, true);
+    locus_bron_kerbosch_unpivoted(R, P, X, cliques, &region, true);
 
     gt_array_delete(R);
     gt_array_delete(P);
@@ -1240,38 +1890,87 @@ static GtUword locus_length(AgnLocus *locus,
   return gt_genome_node_get_length(locus);
 }
 
-static void locus_select_pairs(AgnLocus *locus, GtArray *refrcliques,
-                               GtArray *predcliques, GtArray *clique_pairs)
+static void locus_pred_set_array_delete(GtArray *array)
 {
-  GtHashmap *refrcliques_acctd = gt_hashmap_new(GT_HASH_STRING, NULL, NULL);
-  GtHashmap *predcliques_acctd = gt_hashmap_new(GT_HASH_STRING, NULL, NULL);
+  agn_assert(array != NULL);
+  while(gt_array_size(array) > 0)
+  {
+    AgnLocus **setlocus = gt_array_pop(array);
+    if(*setlocus != NULL)
+      agn_locus_delete(*setlocus);
+  }
+  gt_array_delete(array);
+}
 
-  AgnComparison *stats = gt_genome_node_get_user_data(locus, "compstats");
-  agn_assert(stats != NULL);
-  GtArray *pairs2report = gt_array_new( sizeof(AgnCliquePair *) );
+static GtArray *locus_pred_sets_split(AgnLocus *locus, GtUword numsets)
+{
+  GtArray *setloci = gt_array_new( sizeof(AgnLocus *) );
+  AgnLocus *setlocus = NULL;
   GtUword i;
-  for(i = 0; i < gt_array_size(clique_pairs); i++)
+  for(i = 0; i < numsets; i++)
+    gt_array_add(setloci, setlocus);
+  AgnLocus **loci = gt_array_get_space(setloci);
+
+  // Each prediction set locus gets its own copy of the seqid, so that it does
+  // not share a reference count with loci analyzed on other threads
+  GtStr *seqid = gt_str_clone(gt_genome_node_get_seqid(locus));
+  GtRange range = gt_genome_node_get_range(locus);
+  GtArray *features = agn_locus_get(locus);
+  for(i = 0; i < gt_array_size(features); i++)
   {
-    AgnCliquePair **pair = gt_array_get(clique_pairs, i);
-    AgnTranscriptClique *rclique = agn_clique_pair_get_refr_clique(*pair);
-    AgnTranscriptClique *pclique = agn_clique_pair_get_pred_clique(*pair);
-    if(agn_transcript_clique_has_id_in_hash(rclique, refrcliques_acctd) ||
-       agn_transcript_clique_has_id_in_hash(pclique, predcliques_acctd))
+    GtFeatureNode *fn = *(GtFeatureNode **)gt_array_get(features, i);
+    GtUword *setnum = gt_genome_node_get_user_data((GtGenomeNode *)fn,
+                                                   "predset");
+    GtUword first = 0, last = numsets - 1;
+    bool isrefr = locus_gene_source_test(locus, fn, REFERENCESOURCE);
+    if(!isrefr)
     {
-      agn_clique_pair_delete(*pair);
+      if(setnum == NULL)
+        continue;
+      agn_assert(*setnum < numsets);
+      first = last = *setnum;
     }
-    else
+
+    GtUword set;
+    for(set = first; set <= last; set++)
     {
-      gt_array_add(pairs2report, *pair);
-      agn_clique_pair_comparison_aggregate(*pair, stats);
-      agn_transcript_clique_put_ids_in_hash(rclique, refrcliques_acctd);
-      agn_transcript_clique_put_ids_in_hash(pclique, predcliques_acctd);
+      if(loci[set] == NULL)
+        loci[set] = agn_locus_new(seqid);
+      gt_genome_node_ref((GtGenomeNode *)fn);
+      if(isrefr)
+        agn_locus_add_refr_feature(loci[set], fn);
+      else
+        agn_locus_add_pred_feature(loci[set], fn);
     }
   }
-  gt_genome_node_add_user_data(locus,"pairs2report",gt_array_ref(pairs2report),
-                               (GtFree)locus_clique_pair_array_delete);
-  gt_array_delete(pairs2report);
-  agn_comparison_resolve(stats);
+  gt_array_delete(features);
+  gt_str_delete(seqid);
+
+  for(i = 0; i < numsets; i++)
+  {
+    if(loci[i] != NULL)
+      agn_locus_set_range(loci[i], range.start, range.end);
+  }
+  gt_genome_node_add_user_data(locus, "predsetloci", setloci,
+                               (GtFree)locus_pred_set_array_delete);
+  return setloci;
+}
+
+static void locus_report_pairs(AgnLocus *locus, GtArray *refrcliques,
+                               GtArray *predcliques, GtArray *pairs2report)
+{
+  GtHashmap *refrcliques_acctd = gt_hashmap_new(GT_HASH_STRING, NULL, NULL);
+  GtHashmap *predcliques_acctd = gt_hashmap_new(GT_HASH_STRING, NULL, NULL);
+
+  GtUword i;
+  for(i = 0; i < gt_array_size(pairs2report); i++)
+  {
+    AgnCliquePair *pair = *(AgnCliquePair **)gt_array_get(pairs2report, i);
+    AgnTranscriptClique *rclique = agn_clique_pair_get_refr_clique(pair);
+    AgnTranscriptClique *pclique = agn_clique_pair_get_pred_clique(pair);
+    agn_transcript_clique_put_ids_in_hash(rclique, refrcliques_acctd);
+    agn_transcript_clique_put_ids_in_hash(pclique, predcliques_acctd);
+  }
 
   GtArray *uniqrefr = gt_array_new( sizeof(AgnTranscriptClique *) );
   for(i = 0; i < gt_array_size(refrcliques); i++)
@@ -1286,12 +1985,6 @@ static void locus_select_pairs(AgnLocus *locus, GtArray *refrcliques,
     }
     agn_transcript_clique_delete(refr_clique);
   }
-  if(gt_array_size(uniqrefr) > 0)
-  {
-    gt_genome_node_add_user_data(locus, "uniqrefr", gt_array_ref(uniqrefr),
-                                 (GtFree)locus_clique_array_delete);
-  }
-  gt_array_delete(uniqrefr);
 
   GtArray *uniqpred = gt_array_new( sizeof(AgnTranscriptClique *) );
   for(i = 0; i < gt_array_size(predcliques); i++)
@@ -1306,15 +1999,219 @@ static void locus_select_pairs(AgnLocus *locus, GtArray *refrcliques,
     }
     agn_transcript_clique_delete(pred_clique);
   }
-  if(gt_array_size(uniqpred) > 0)
+
+  agn_locus_set_comparative_analysis(locus, pairs2report, uniqrefr, uniqpred);
+  gt_array_delete(uniqrefr);
+  gt_array_delete(uniqpred);
+
+  gt_hashmap_delete(refrcliques_acctd);
+  gt_hashmap_delete(predcliques_acctd);
+}
+
+static GtArray *locus_select_pairs(GtArray *refrcliques, GtArray *predcliques)
+{
+  GtUword numrefr = gt_array_size(refrcliques);
+  GtUword numpred = gt_array_size(predcliques);
+  GtArray *pairs2report = gt_array_new( sizeof(AgnCliquePair *) );
+  if(numrefr == 0 || numpred == 0)
+    return pairs2report;
+
+  // Summarize each clique's model once, for computing cheap upper bounds
+  AgnTranscriptClique **refr = gt_array_get_space(refrcliques);
+  AgnTranscriptClique **pred = gt_array_get_space(predcliques);
+  AgnModelSummary *refrsums = gt_malloc( sizeof(AgnModelSummary) * numrefr );
+  AgnModelSummary *predsums = gt_malloc( sizeof(AgnModelSummary) * numpred );
+  GtUword i, j;
+  for(i = 0; i < numrefr; i++)
+    agn_transcript_clique_get_model_summary(refr[i], refrsums + i);
+  for(j = 0; j < numpred; j++)
+    agn_transcript_clique_get_model_summary(pred[j], predsums + j);
+  GtUword length = gt_genome_node_get_length(refr[0]);
+
+  GtArray *queue = gt_array_new( sizeof(PairCandidate) );
+  for(i = 0; i < numrefr; i++)
   {
-    gt_genome_node_add_user_data(locus, "uniqpred", gt_array_ref(uniqpred),
-                                 (GtFree)locus_clique_array_delete);
+    for(j = 0; j < numpred; j++)
+    {
+      PairCandidate candidate = { i, j, i * numpred + j, { 0, 0.0, 0.0 }, NULL };
+      agn_clique_pair_key_bound(refrsums + i, predsums + j, length,
+                                &candidate.key);
+      locus_candidate_push(queue, &candidate);
+    }
+  }
+  gt_free(refrsums);
+  gt_free(predsums);
+
+  GtHashmap *refrcliques_acctd = gt_hashmap_new(GT_HASH_STRING, NULL, NULL);
+  GtHashmap *predcliques_acctd = gt_hashmap_new(GT_HASH_STRING, NULL, NULL);
+  while(gt_array_size(queue) > 0)
+  {
+    PairCandidate candidate;
+    locus_candidate_pop(queue, &candidate);
+    AgnTranscriptClique *rclique = refr[candidate.refr_index];
+    AgnTranscriptClique *pclique = pred[candidate.pred_index];
+    if(agn_transcript_clique_has_id_in_hash(rclique, refrcliques_acctd) ||
+       agn_transcript_clique_has_id_in_hash(pclique, predcliques_acctd))
+    {
+      if(candidate.pair != NULL)
+        agn_clique_pair_delete(candidate.pair);
+      continue;
+    }
+
+    // A bound that reaches the front of the queue must be evaluated in full;
+    // an evaluated pair that reaches the front outranks everything remaining
+    if(candidate.pair == NULL)
+    {
+      candidate.pair = agn_clique_pair_new(rclique, pclique);
+      agn_clique_pair_key(candidate.pair, &candidate.key);
+      locus_candidate_push(queue, &candidate);
+      continue;
+    }
+    gt_array_add(pairs2report, candidate.pair);
+    agn_transcript_clique_put_ids_in_hash(rclique, refrcliques_acctd);
+    agn_transcript_clique_put_ids_in_hash(pclique, predcliques_acctd);
+  }
+
+  gt_array_delete(queue);
+  gt_hashmap_delete(refrcliques_acctd);
+  gt_hashmap_delete(predcliques_acctd);
+  return pairs2report;
+}
+
+static GtArray *locus_select_pairs_exhaustive(AgnLocus *locus,
+                                              GtArray *refrcliques,
+                                              GtArray *predcliques)
+{
+  GtArray *clique_pairs = locus_enumerate_pairs(locus,refrcliques,predcliques);
+  GtArray *candidates = gt_array_new( sizeof(PairCandidate) );
+  GtUword i;
+  for(i = 0; i < gt_array_size(clique_pairs); i++)
+  {
+    PairCandidate candidate = { 0, 0, i, { 0, 0.0, 0.0 }, NULL };
+    candidate.pair = *(AgnCliquePair **)gt_array_get(clique_pairs, i);
+    agn_clique_pair_key(candidate.pair, &candidate.key);
+    gt_array_add(candidates, candidate);
+  }
+  gt_array_sort(candidates, (GtCompare)locus_candidate_compare);
+
+  GtHashmap *refrcliques_acctd = gt_hashmap_new(GT_HASH_STRING, NULL, NULL);
+  GtHashmap *predcliques_acctd = gt_hashmap_new(GT_HASH_STRING, NULL, NULL);
+  GtArray *pairs2report = gt_array_new( sizeof(AgnCliquePair *) );
+  for(i = 0; i < gt_array_size(candidates); i++)
+  {
+    PairCandidate *candidate = gt_array_get(candidates, i);
+    AgnTranscriptClique *rclique, *pclique;
+    rclique = agn_clique_pair_get_refr_clique(candidate->pair);
+    pclique = agn_clique_pair_get_pred_clique(candidate->pair);
+    if(agn_transcript_clique_has_id_in_hash(rclique, refrcliques_acctd) ||
+       agn_transcript_clique_has_id_in_hash(pclique, predcliques_acctd))
+    {
+      agn_clique_pair_delete(candidate->pair);
+    }
+    else
+    {
+      gt_array_add(pairs2report, candidate->pair);
+      agn_transcript_clique_put_ids_in_hash(rclique, refrcliques_acctd);
+      agn_transcript_clique_put_ids_in_hash(pclique, predcliques_acctd);
+    }
   }
-  gt_array_delete(uniqpred);
 
+  gt_array_delete(clique_pairs);
+  gt_array_delete(candidates);
   gt_hashmap_delete(refrcliques_acctd);
   gt_hashmap_delete(predcliques_acctd);
+  return pairs2report;
+}
+
+static bool locus_select_pairs_check(GtUword numtrans, uint64_t *seed,
+                                     double *elapsed)
+{
+  GtArray *refr_trans = gt_array_new( sizeof(GtFeatureNode *) );
+  GtArray *pred_trans = gt_array_new( sizeof(GtFeatureNode *) );
+  AgnLocus *locus = locus_synthetic_isoforms(numtrans,10000,seed,refr_trans);
+  agn_locus_delete(locus);
+  locus = locus_synthetic_isoforms(numtrans, 10000, seed, pred_trans);
+  GtArray *refrcliques = locus_enumerate_cliques(locus, refr_trans);
+  GtArray *predcliques = locus_enumerate_cliques(locus, pred_trans);
+
+  clock_t start = clock();
+  GtArray *refpairs = locus_select_pairs_exhaustive(locus, refrcliques,
+                                                    predcliques);
+  clock_t middle = clock();
+  GtArray *pairs = locus_select_pairs(refrcliques, predcliques);
+  clock_t end = clock();
+  if(elapsed != NULL)
+  {
+    elapsed[0] += (double)(middle - start) / CLOCKS_PER_SEC;
+    elapsed[1] += (double)(end - middle) / CLOCKS_PER_SEC;
+  }
+  bool identical = gt_array_size(pairs) > 0 &&
+                   gt_array_size(pairs) == gt_array_size(refpairs);
+  GtUword i;
+  for(i = 0; identical && i < gt_array_size(pairs); i++)
+  {
+    AgnCliquePair *p1 = *(AgnCliquePair **)gt_array_get(pairs, i);
+    AgnCliquePair *p2 = *(AgnCliquePair **)gt_array_get(refpairs, i);
+    identical = agn_clique_pair_get_refr_clique(p1) ==
+                agn_clique_pair_get_refr_clique(p2) &&
+                agn_clique_pair_get_pred_clique(p1) ==
+                agn_clique_pair_get_pred_clique(p2);
+  }
+
+  locus_clique_pair_array_delete(pairs);
+  locus_clique_pair_array_delete(refpairs);
+  locus_clique_array_delete(refrcliques);
+  locus_clique_array_delete(predcliques);
+  while(gt_array_size(refr_trans) > 0)
+  {
+    GtGenomeNode **transcript = gt_array_pop(refr_trans);
+    gt_genome_node_delete(*transcript);
+  }
+  while(gt_array_size(pred_trans) > 0)
+  {
+    GtGenomeNode **transcript = gt_array_pop(pred_trans);
+    gt_genome_node_delete(*transcript);
+  }
+  gt_array_delete(refr_trans);
+  gt_array_delete(pred_trans);
+  agn_locus_delete(locus);
+  return identical;
+}
+
+static AgnLocus *locus_synthetic_isoforms(GtUword numtrans, GtUword length,
+                                          uint64_t *seed, GtArray *trans)
+{
+  GtStr *seqid = gt_str_new_cstr("synthetic");
+  AgnLocus *locus = agn_locus_new(seqid);
+  agn_locus_set_range(locus, 1, length);
+
+  GtUword i;
+  for(i = 0; i < numtrans; i++)
+  {
+    // Linear congruential generator, for reproducibility across platforms
+    *seed = *seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    GtUword translength = length / 20 + (*seed >> 33) % (length / 5);
+    *seed = *seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    GtUword start = 1 + (*seed >> 33) % (length - translength);
+    GtUword end = start + translength - 1;
+
+    char id[32];
+    sprintf(id, "mRNA%lu", i + 1);
+    GtGenomeNode *mrna = gt_feature_node_new(seqid, "mRNA", start, end,
+                                             GT_STRAND_FORWARD);
+    GtFeatureNode *mrnafn = gt_feature_node_cast(mrna);
+    gt_feature_node_set_attribute(mrnafn, "ID", id);
+    GtGenomeNode *exon = gt_feature_node_new(seqid, "exon", start, end,
+                                             GT_STRAND_FORWARD);
+    gt_feature_node_add_child(mrnafn, gt_feature_node_cast(exon));
+    GtGenomeNode *cds = gt_feature_node_new(seqid, "CDS", start, end,
+                                            GT_STRAND_FORWARD);
+    gt_feature_node_add_child(mrnafn, gt_feature_node_cast(cds));
+    gt_array_add(trans, mrnafn);
+  }
+
+  gt_str_delete(seqid);
+  return locus;
 }
 
 static void locus_test_data(GtQueue *queue)
@@ -0,0 +1,807 @@
+/**
+
+Copyright (c) 2010-2014, Daniel S. Standage and CONTRIBUTORS
+
+The AEGeAn Toolkit is distributed under the ISC License. See
+the 'LICENSE' file in the AEGeAn source code distribution or
+online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
+
+**/
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "core/hashmap_api.h"
+#include "core/queue_api.h"
+#include "extended/feature_node_iterator_api.h"
+#include "extended/sort_stream_api.h"
+#include "AgnCliquePair.h"
+#include "AgnGeneStream.h"
+#include "AgnLocusCache.h"
+#include "AgnLocusStream.h"
+#include "AgnTranscriptClique.h"
+#include "AgnUtils.h"
+
+#define LOCUS_CACHE_MAGIC "AGNLCACH"
+#define LOCUS_CACHE_VERSION 1
+#define LOCUS_CACHE_HEADER_SIZE 16
+#define LOCUS_CACHE_RECORD_HEADER_SIZE 24
+
+//------------------------------------------------------------------------------
+// Data structure definition
+//------------------------------------------------------------------------------
+
+/**
+ * The cache file begins with an 8-byte magic string and a format version,
+ * followed by any number of records. Each record consists of the length of its
+ * body, the key of the locus (a hash of the locus description, see
+ * ``locus_cache_describe``), and a checksum of the body, followed by the body
+ * itself: the full locus description, the selected clique pairs (the members
+ * of each clique as indices into the locus' reference or prediction mRNAs,
+ * followed by the comparison stats), and the unique reference and prediction
+ * cliques. All integers are written with :c:func:`agn_uword_write`.
+ *
+ * ``index`` maps keys to the offsets of records in ``map``; ``appended`` holds
+ * the keys of records written by this object, which are not mapped.
+ */
+struct AgnLocusCache
+{
+  int fd;
+  unsigned char *map;
+  GtUword mapsize;
+  GtHashmap *index;
+  GtHashmap *appended;
+  GtUword hits;
+  GtUword misses;
+};
+
+
+//------------------------------------------------------------------------------
+// Prototypes for private functions
+//------------------------------------------------------------------------------
+
+/**
+ * @function Decode an unsigned integer written by :c:func:`agn_uword_write`.
+ */
+static GtUword locus_cache_decode(const unsigned char *bytes);
+
+/**
+ * @function Describe the structure of ``locus`` in ``desc``: the locus
+ * coordinates, followed by the type, coordinates, strand, and ID of each mRNA
+ * in ``refrmrnas`` and ``predmrnas`` and each of their subfeatures. Two loci
+ * with the same description yield the same comparative analysis.
+ */
+static void locus_cache_describe(AgnLocus *locus, GtArray *refrmrnas,
+                                 GtArray *predmrnas, GtStr *desc);
+
+/**
+ * @function Compute a 64-bit FNV-1a hash of the given data.
+ */
+static GtUword locus_cache_hash(const void *data, GtUword length);
+
+/**
+ * @function Map each mRNA to its position in ``mrnas``, plus one.
+ */
+static GtHashmap *locus_cache_index_mrnas(GtArray *mrnas);
+
+/**
+ * @function Validate the records in the cache file, drop any incomplete or
+ * corrupt records at the end of the file, map the remaining records into
+ * memory, and index them. Must be called with the file locked. Returns false
+ * if the file is not a cache file.
+ */
+static bool locus_cache_load(AgnLocusCache *cache);
+
+/**
+ * @function Read a clique written by ``locus_cache_write_clique``, taking its
+ * transcripts from ``mrnas``. Returns NULL if the clique could not be read.
+ */
+static AgnTranscriptClique *locus_cache_read_clique(FILE *instream,
+                                                    GtArray *mrnas,
+                                                    AgnSequenceRegion *region);
+
+/**
+ * @function Read a list of cliques written by ``locus_cache_write_cliques``
+ * into ``cliques``. Returns false if the cliques could not be read.
+ */
+static bool locus_cache_read_cliques(FILE *instream, GtArray *mrnas,
+                                     AgnSequenceRegion *region,
+                                     GtArray *cliques);
+
+/**
+ * @function Read the pairs and unique cliques of the given record and store
+ * them with ``locus``. Returns false if the record does not describe ``locus``
+ * or could not be read.
+ */
+static bool locus_cache_read_record(AgnLocusCache *cache, GtUword offset,
+                                    AgnLocus *locus, GtArray *refrmrnas,
+                                    GtArray *predmrnas, const char *desc);
+
+/**
+ * @function Load the loci from the given data files for testing, without
+ * running the comparative analysis.
+ */
+static GtArray *locus_cache_test_data(const char **filenames);
+
+/**
+ * @function Write the members of ``clique`` as indices into the locus' mRNAs.
+ */
+static bool locus_cache_write_clique(FILE *outstream,
+                                     AgnTranscriptClique *clique,
+                                     GtHashmap *mrnaindex);
+
+/**
+ * @function Write the number of cliques in ``cliques`` (which may be NULL),
+ * followed by each clique.
+ */
+static bool locus_cache_write_cliques(FILE *outstream, GtArray *cliques,
+                                      GtHashmap *mrnaindex);
+
+
+//------------------------------------------------------------------------------
+// Method implementations
+//------------------------------------------------------------------------------
+
+void agn_locus_cache_delete(AgnLocusCache *cache)
+{
+  if(cache == NULL)
+    return;
+  if(cache->map != NULL)
+    munmap(cache->map, cache->mapsize);
+  close(cache->fd);
+  gt_hashmap_delete(cache->index);
+  gt_hashmap_delete(cache->appended);
+  gt_free(cache);
+}
+
+bool agn_locus_cache_get(AgnLocusCache *cache, AgnLocus *locus)
+{
+  agn_assert(cache && locus);
+  GtArray *refrmrnas = agn_locus_refr_mrnas(locus);
+  GtArray *predmrnas = agn_locus_pred_mrnas(locus);
+  if(gt_array_size(refrmrnas) == 0 || gt_array_size(predmrnas) == 0)
+  {
+    // Nothing to analyze, so nothing to look up
+    gt_array_delete(refrmrnas);
+    gt_array_delete(predmrnas);
+    return false;
+  }
+
+  GtStr *desc = gt_str_new();
+  locus_cache_describe(locus, refrmrnas, predmrnas, desc);
+  GtUword key = locus_cache_hash(gt_str_get(desc), gt_str_length(desc));
+  GtUword offset = (GtUword)gt_hashmap_get(cache->index, (void *)key);
+  bool found = offset > 0 &&
+               locus_cache_read_record(cache, offset, locus, refrmrnas,
+                                       predmrnas, gt_str_get(desc));
+  if(found)
+    cache->hits++;
+  else
+    cache->misses++;
+
+  gt_str_delete(desc);
+  gt_array_delete(refrmrnas);
+  gt_array_delete(predmrnas);
+  return found;
+}
+
+AgnLocusCache *agn_locus_cache_new(const char *filename, GtError *error)
+{
+  agn_assert(filename);
+  int fd = open(filename, O_RDWR | O_CREAT, 0644);
+  if(fd == -1)
+  {
+    gt_error_set(error, "cannot open cache file '%s'", filename);
+    return NULL;
+  }
+
+  AgnLocusCache *cache = gt_malloc( sizeof(AgnLocusCache) );
+  cache->fd = fd;
+  cache->map = NULL;
+  cache->mapsize = 0;
+  cache->index = gt_hashmap_new(GT_HASH_DIRECT, NULL, NULL);
+  cache->appended = gt_hashmap_new(GT_HASH_DIRECT, NULL, NULL);
+  cache->hits = 0;
+  cache->misses = 0;
+
+  flock(fd, LOCK_EX);
+  bool success = locus_cache_load(cache);
+  flock(fd, LOCK_UN);
+  if(!success)
+  {
+    gt_error_set(error, "cannot read cache file '%s'", filename);
+    agn_locus_cache_delete(cache);
+    return NULL;
+  }
+
+  return cache;
+}
+
+GtUword agn_locus_cache_num_hits(AgnLocusCache *cache)
+{
+  return cache->hits;
+}
+
+GtUword agn_locus_cache_num_misses(AgnLocusCache *cache)
+{
+  return cache->misses;
+}
+
+bool agn_locus_cache_put(AgnLocusCache *cache, AgnLocus *locus)
+{
+  agn_assert(cache && locus);
+  GtArray *pairs = agn_locus_pairs_to_report(locus);
+  if(pairs == NULL)
+    return true;
+
+  GtArray *refrmrnas = agn_locus_refr_mrnas(locus);
+  GtArray *predmrnas = agn_locus_pred_mrnas(locus);
+  GtStr *desc = gt_str_new();
+  locus_cache_describe(locus, refrmrnas, predmrnas, desc);
+  GtUword key = locus_cache_hash(gt_str_get(desc), gt_str_length(desc));
+  GtUword offset = (GtUword)gt_hashmap_get(cache->index, (void *)key);
+  bool stored = gt_hashmap_get(cache->appended, (void *)key) != NULL;
+  if(!stored && offset > 0)
+  {
+    GtStr *cached = gt_str_new();
+    FILE *instream = fmemopen(cache->map + offset,
+                              cache->mapsize - offset, "rb");
+    stored = instream != NULL && agn_str_read(instream, cached) &&
+             strcmp(gt_str_get(cached), gt_str_get(desc)) == 0;
+    if(instream != NULL)
+      fclose(instream);
+    gt_str_delete(cached);
+  }
+  if(stored)
+  {
+    gt_str_delete(desc);
+    gt_array_delete(refrmrnas);
+    gt_array_delete(predmrnas);
+    return true;
+  }
+
+  GtHashmap *refrindex = locus_cache_index_mrnas(refrmrnas);
+  GtHashmap *predindex = locus_cache_index_mrnas(predmrnas);
+  char *body = NULL, *record = NULL;
+  size_t bodysize = 0, recordsize = 0;
+  FILE *outstream = open_memstream(&body, &bodysize);
+  bool success = outstream != NULL;
+  success = success && agn_str_write(outstream, gt_str_get(desc));
+  success = success && agn_uword_write(outstream, gt_array_size(pairs));
+  GtUword i;
+  for(i = 0; success && i < gt_array_size(pairs); i++)
+  {
+    AgnCliquePair *pair = *(AgnCliquePair **)gt_array_get(pairs, i);
+    success = locus_cache_write_clique(outstream,
+                                       agn_clique_pair_get_refr_clique(pair),
+                                       refrindex) &&
+              locus_cache_write_clique(outstream,
+                                       agn_clique_pair_get_pred_clique(pair),
+                                       predindex) &&
+              agn_comparison_write(agn_clique_pair_get_stats(pair), outstream);
+  }
+  success = success &&
+            locus_cache_write_cliques(outstream,
+                                      agn_locus_get_unique_refr_cliques(locus),
+                                      refrindex) &&
+            locus_cache_write_cliques(outstream,
+                                      agn_locus_get_unique_pred_cliques(locus),
+                                      predindex);
+  if(outstream != NULL)
+    success = fclose(outstream) == 0 && success;
+
+  if(success)
+  {
+    outstream = open_memstream(&record, &recordsize);
+    success = outstream != NULL &&
+              agn_uword_write(outstream, bodysize) &&
+              agn_uword_write(outstream, key) &&
+              agn_uword_write(outstream, locus_cache_hash(body, bodysize)) &&
+              fwrite(body, 1, bodysize, outstream) == bodysize;
+    if(outstream != NULL)
+      success = fclose(outstream) == 0 && success;
+  }
+
+  if(success)
+  {
+    // Other processes may be appending to the same file
+    flock(cache->fd, LOCK_EX);
+    off_t end = lseek(cache->fd, 0, SEEK_END);
+    size_t written = 0;
+    while(end != -1 && written < recordsize)
+    {
+      ssize_t result = write(cache->fd, record + written,
+                             recordsize - written);
+      if(result <= 0)
+        break;
+      written += result;
+    }
+    success = end != -1 && written == recordsize;
+    if(!success && end != -1 && ftruncate(cache->fd, end) != 0)
+      success = false;
+    flock(cache->fd, LOCK_UN);
+  }
+  if(success)
+    gt_hashmap_add(cache->appended, (void *)key, (void *)key);
+
+  free(body);
+  free(record);
+  gt_hashmap_delete(refrindex);
+  gt_hashmap_delete(predindex);
+  gt_str_delete(desc);
+  gt_array_delete(refrmrnas);
+  gt_array_delete(predmrnas);
+  return success;
+}
+
+bool agn_locus_cache_unit_test(AgnUnitTest *test)
+{
+  char filename[] = "/tmp/agn-locus-cache-XXXXXX";
+  int fd = mkstemp(filename);
+  if(fd == -1)
+  {
+    fprintf(stderr, "error creating unit test cache file\n");
+    exit(1);
+  }
+  close(fd);
+
+  const char *filenames[] = { "data/gff3/pd0159-refr.gff3",
+                              "data/gff3/pd0159-pred.gff3" };
+  GtError *error = gt_error_new();
+  GtArray *loci1 = locus_cache_test_data(filenames);
+  GtArray *loci2 = locus_cache_test_data(filenames);
+
+  // First run: nothing is cached, so analyze and store every locus
+  AgnLocusCache *cache = agn_locus_cache_new(filename, error);
+  bool misstest = cache != NULL;
+  bool puttest = cache != NULL;
+  GtUword i, numanalyzed = 0;
+  for(i = 0; cache != NULL && i < gt_array_size(loci1); i++)
+  {
+    AgnLocus *locus = *(AgnLocus **)gt_array_get(loci1, i);
+    misstest = misstest && !agn_locus_cache_get(cache, locus);
+    agn_locus_comparative_analysis(locus, NULL);
+    if(agn_locus_pairs_to_report(locus) != NULL)
+      numanalyzed++;
+    puttest = puttest && agn_locus_cache_put(cache, locus);
+  }
+  misstest = misstest && numanalyzed > 0 &&
+             agn_locus_cache_num_hits(cache) == 0 &&
+             agn_locus_cache_num_misses(cache) == numanalyzed;
+  agn_locus_cache_delete(cache);
+  agn_unit_test_result(test, "empty cache", misstest);
+
+  struct stat filestat;
+  bool statok = stat(filename, &filestat) == 0;
+  off_t filesize = filestat.st_size;
+  puttest = puttest && statok &&
+            filesize > LOCUS_CACHE_HEADER_SIZE;
+  agn_unit_test_result(test, "store results", puttest);
+
+  // Second run: every locus is found in the cache, with identical results
+  cache = agn_locus_cache_new(filename, error);
+  bool hittest = cache != NULL &&
+                 gt_array_size(loci1) == gt_array_size(loci2);
+  bool statstest = hittest;
+  for(i = 0; hittest && i < gt_array_size(loci2); i++)
+  {
+    AgnLocus *l1 = *(AgnLocus **)gt_array_get(loci1, i);
+    AgnLocus *l2 = *(AgnLocus **)gt_array_get(loci2, i);
+    GtArray *pairs1 = agn_locus_pairs_to_report(l1);
+    bool found = agn_locus_cache_get(cache, l2);
+    hittest = found == (pairs1 != NULL);
+    if(!found)
+      continue;
+
+    GtArray *pairs2 = agn_locus_pairs_to_report(l2);
+    GtArray *uniq1 = agn_locus_get_unique_refr_cliques(l1);
+    GtArray *uniq2 = agn_locus_get_unique_refr_cliques(l2);
+    GtArray *uniq3 = agn_locus_get_unique_pred_cliques(l1);
+    GtArray *uniq4 = agn_locus_get_unique_pred_cliques(l2);
+    AgnComparison c1, c2;
+    agn_comparison_init(&c1);
+    agn_comparison_init(&c2);
+    agn_locus_comparison_aggregate(l1, &c1);
+    agn_locus_comparison_aggregate(l2, &c2);
+    agn_comparison_resolve(&c1);
+    agn_comparison_resolve(&c2);
+    statstest = statstest && pairs2 != NULL &&
+                gt_array_size(pairs1) == gt_array_size(pairs2) &&
+                (uniq1 == NULL) == (uniq2 == NULL) &&
+                (uniq1 == NULL || gt_array_size(uniq1)==gt_array_size(uniq2)) &&
+                (uniq3 == NULL) == (uniq4 == NULL) &&
+                (uniq3 == NULL || gt_array_size(uniq3)==gt_array_size(uniq4)) &&
+                agn_comparison_test(&c1, &c2) &&
+                c1.overall_matches == c2.overall_matches &&
+                c1.overall_length == c2.overall_length;
+  }
+  hittest = hittest && agn_locus_cache_num_hits(cache) == numanalyzed &&
+            agn_locus_cache_num_misses(cache) == 0;
+  agn_unit_test_result(test, "cache hits", hittest);
+  agn_unit_test_result(test, "cached results", statstest);
+
+  // Results that are already cached are not stored again
+  bool duptest = cache != NULL;
+  for(i = 0; cache != NULL && i < gt_array_size(loci2); i++)
+  {
+    AgnLocus *locus = *(AgnLocus **)gt_array_get(loci2, i);
+    duptest = duptest && agn_locus_cache_put(cache, locus);
+  }
+  duptest = duptest && stat(filename, &filestat) == 0 &&
+            filestat.st_size == filesize;
+  agn_locus_cache_delete(cache);
+  agn_unit_test_result(test, "no duplicates", duptest);
+
+  // A record cut short by an interrupted run is dropped
+  bool truncatetest = truncate(filename, filesize - 1) == 0;
+  cache = agn_locus_cache_new(filename, error);
+  truncatetest = truncatetest && cache != NULL;
+  for(i = 0; cache != NULL && i < gt_array_size(loci1); i++)
+  {
+    AgnLocus *locus = *(AgnLocus **)gt_array_get(loci1, i);
+    truncatetest = truncatetest && agn_locus_cache_put(cache, locus);
+  }
+  truncatetest = truncatetest && stat(filename, &filestat) == 0 &&
+                 filestat.st_size == filesize;
+  agn_locus_cache_delete(cache);
+  agn_unit_test_result(test, "incomplete records", truncatetest);
+
+  while(gt_array_size(loci1) > 0)
+  {
+    AgnLocus **locus = gt_array_pop(loci1);
+    agn_locus_delete(*locus);
+  }
+  while(gt_array_size(loci2) > 0)
+  {
+    AgnLocus **locus = gt_array_pop(loci2);
+    agn_locus_delete(*locus);
+  }
+  gt_array_delete(loci1);
+  gt_array_delete(loci2);
+  gt_error_delete(error);
+  unlink(filename);
+  return agn_unit_test_success(test);
+}
+
+static GtUword locus_cache_decode(const unsigned char *bytes)
+{
+  GtUword value = 0;
+  int i;
+  for(i = 7; i >= 0; i--)
+    value = (value << 8) | bytes[i];
+  return value;
+}
+
+static void locus_cache_describe(AgnLocus *locus, GtArray *refrmrnas,
+                                 GtArray *predmrnas, GtStr *desc)
+{
+  GtArray *sources[] = { refrmrnas, predmrnas };
+  GtUword i, j;
+  gt_str_reset(desc);
+  gt_str_append_uword(desc, gt_genome_node_get_start(locus));
+  gt_str_append_char(desc, '-');
+  gt_str_append_uword(desc, gt_genome_node_get_end(locus));
+  gt_str_append_char(desc, '\n');
+  for(i = 0; i < 2; i++)
+  {
+    gt_str_append_cstr(desc, i == 0 ? "[refr]\n" : "[pred]\n");
+    for(j = 0; j < gt_array_size(sources[i]); j++)
+    {
+      GtFeatureNode *mrna = *(GtFeatureNode **)gt_array_get(sources[i], j);
+      GtFeatureNodeIterator *iter = gt_feature_node_iterator_new(mrna);
+      GtFeatureNode *fn;
+      for(fn = gt_feature_node_iterator_next(iter);
+          fn != NULL;
+          fn = gt_feature_node_iterator_next(iter))
+      {
+        GtGenomeNode *gn = (GtGenomeNode *)fn;
+        const char *id = gt_feature_node_get_attribute(fn, "ID");
+        gt_str_append_cstr(desc, gt_feature_node_get_type(fn));
+        gt_str_append_char(desc, '\t');
+        gt_str_append_uword(desc, gt_genome_node_get_start(gn));
+        gt_str_append_char(desc, '\t');
+        gt_str_append_uword(desc, gt_genome_node_get_end(gn));
+        gt_str_append_char(desc, '\t');
+        gt_str_append_char(desc,
+                           GT_STRAND_CHARS[gt_feature_node_get_strand(fn)]);
+        gt_str_append_char(desc, '\t');
+        gt_str_append_cstr(desc, id != NULL ? id : "");
+        gt_str_append_char(desc, '\n');
+      }
+      gt_feature_node_iterator_delete(iter);
+    }
+  }
+}
+
+static GtUword locus_cache_hash(const void *data, GtUword length)
+{
+  const unsigned char *bytes = data;
+  uint64_t hash = 14695981039346656037ULL;
+  GtUword i;
+  for(i = 0; i < length; i++)
+  {
+    hash ^= bytes[i];
+    hash *= 1099511628211ULL;
+  }
+
+  // Zero is reserved for empty hashmap slots
+  return hash == 0 ? 1 : (GtUword)hash;
+}
+
+static GtHashmap *locus_cache_index_mrnas(GtArray *mrnas)
+{
+  GtHashmap *index = gt_hashmap_new(GT_HASH_DIRECT, NULL, NULL);
+  GtUword i;
+  for(i = 0; i < gt_array_size(mrnas); i++)
+  {
+    GtFeatureNode *mrna = *(GtFeatureNode **)gt_array_get(mrnas, i);
+    gt_hashmap_add(index, mrna, (void *)(i + 1));
+  }
+  return index;
+}
+
+static bool locus_cache_load(AgnLocusCache *cache)
+{
+  struct stat filestat;
+  if(fstat(cache->fd, &filestat) != 0)
+    return false;
+
+  GtUword filesize = filestat.st_size;
+  if(filesize == 0)
+  {
+    FILE *outstream = fdopen(dup(cache->fd), "wb");
+    bool success = outstream != NULL &&
+                   fwrite(LOCUS_CACHE_MAGIC, 1, 8, outstream) == 8 &&
+                   agn_uword_write(outstream, LOCUS_CACHE_VERSION);
+    if(outstream != NULL)
+      success = fclose(outstream) == 0 && success;
+    return success;
+  }
+  if(filesize < LOCUS_CACHE_HEADER_SIZE)
+    return false;
+
+  unsigned char *map = mmap(NULL, filesize, PROT_READ, MAP_SHARED, cache->fd,
+                            0);
+  if(map == MAP_FAILED)
+    return false;
+  if(memcmp(map, LOCUS_CACHE_MAGIC, 8) != 0 ||
+     locus_cache_decode(map + 8) != LOCUS_CACHE_VERSION)
+  {
+    munmap(map, filesize);
+    return false;
+  }
+
+  GtUword offset = LOCUS_CACHE_HEADER_SIZE;
+  while(filesize - offset >= LOCUS_CACHE_RECORD_HEADER_SIZE)
+  {
+    GtUword bodysize = locus_cache_decode(map + offset);
+    GtUword key = locus_cache_decode(map + offset + 8);
+    GtUword checksum = locus_cache_decode(map + offset + 16);
+    GtUword bodyoffset = offset + LOCUS_CACHE_RECORD_HEADER_SIZE;
+    if(bodysize > filesize - bodyoffset ||
+       locus_cache_hash(map + bodyoffset, bodysize) != checksum)
+      break;
+
+    // Later records replace earlier records with the same key
+    if(gt_hashmap_get(cache->index, (void *)key) != NULL)
+      gt_hashmap_remove(cache->index, (void *)key);
+    gt_hashmap_add(cache->index, (void *)key, (void *)bodyoffset);
+    offset = bodyoffset + bodysize;
+  }
+
+  if(offset < filesize)
+  {
+    // Only the tail can be incomplete, since records are appended under lock
+    munmap(map, filesize);
+    if(ftruncate(cache->fd, offset) != 0)
+      return false;
+    filesize = offset;
+    map = mmap(NULL, filesize, PROT_READ, MAP_SHARED, cache->fd, 0);
+    if(map == MAP_FAILED)
+      return false;
+  }
+  cache->map = map;
+  cache->mapsize = filesize;
+  return true;
+}
+
+static AgnTranscriptClique *locus_cache_read_clique(FILE *instream,
+                                                    GtArray *mrnas,
+                                                    AgnSequenceRegion *region)
+{
+  GtUword i, size, index;
+  if(!agn_uword_read(instream, &size) || size == 0 ||
+     size > gt_array_size(mrnas))
+    return NULL;
+
+  AgnTranscriptClique *clique = agn_transcript_clique_new(region);
+  for(i = 0; i < size; i++)
+  {
+    if(!agn_uword_read(instream, &index) || index >= gt_array_size(mrnas))
+    {
+      agn_transcript_clique_delete(clique);
+      return NULL;
+    }
+    GtFeatureNode *mrna = *(GtFeatureNode **)gt_array_get(mrnas, index);
+    agn_transcript_clique_add(clique, mrna);
+  }
+  return clique;
+}
+
+static bool locus_cache_read_cliques(FILE *instream, GtArray *mrnas,
+                                     AgnSequenceRegion *region,
+                                     GtArray *cliques)
+{
+  GtUword i, numcliques;
+  if(!agn_uword_read(instream, &numcliques) ||
+     numcliques > gt_array_size(mrnas))
+    return false;
+
+  for(i = 0; i < numcliques; i++)
+  {
+    AgnTranscriptClique *clique = locus_cache_read_clique(instream, mrnas,
+                                                          region);
+    if(clique == NULL)
+      return false;
+    gt_array_add(cliques, clique);
+  }
+  return true;
+}
+
+static bool locus_cache_read_record(AgnLocusCache *cache, GtUword offset,
+                                    AgnLocus *locus, GtArray *refrmrnas,
+                                    GtArray *predmrnas, const char *desc)
+{
+  FILE *instream = fmemopen(cache->map + offset, cache->mapsize - offset, "rb");
+  if(instream == NULL)
+    return false;
+
+  GtStr *cached = gt_str_new();
+  bool success = agn_str_read(instream, cached) &&
+                 strcmp(gt_str_get(cached), desc) == 0;
+  gt_str_delete(cached);
+
+  AgnSequenceRegion region = { gt_genome_node_get_seqid(locus),
+                               gt_genome_node_get_range(locus) };
+  GtArray *pairs = gt_array_new( sizeof(AgnCliquePair *) );
+  GtUword i, numpairs;
+  success = success && agn_uword_read(instream, &numpairs) &&
+            numpairs <= gt_array_size(refrmrnas);
+  for(i = 0; success && i < numpairs; i++)
+  {
+    AgnTranscriptClique *refr, *pred;
+    AgnComparison stats;
+    refr = locus_cache_read_clique(instream, refrmrnas, &region);
+    pred = refr == NULL ? NULL
+                        : locus_cache_read_clique(instream, predmrnas, &region);
+    success = pred != NULL && agn_comparison_read(&stats, instream);
+    if(success)
+    {
+      AgnCliquePair *pair = agn_clique_pair_new_with_stats(refr, pred, &stats);
+      gt_array_add(pairs, pair);
+    }
+    if(refr != NULL)
+      agn_transcript_clique_delete(refr);
+    if(pred != NULL)
+      agn_transcript_clique_delete(pred);
+  }
+
+  GtArray *uniqrefr = gt_array_new( sizeof(AgnTranscriptClique *) );
+  GtArray *uniqpred = gt_array_new( sizeof(AgnTranscriptClique *) );
+  success = success &&
+            locus_cache_read_cliques(instream, refrmrnas, &region, uniqrefr) &&
+            locus_cache_read_cliques(instream, predmrnas, &region, uniqpred);
+  fclose(instream);
+
+  if(success)
+    agn_locus_set_comparative_analysis(locus, pairs, uniqrefr, uniqpred);
+  else
+  {
+    while(gt_array_size(pairs) > 0)
+    {
+      AgnCliquePair **pair = gt_array_pop(pairs);
+      agn_clique_pair_delete(*pair);
+    }
+    while(gt_array_size(uniqrefr) > 0)
+    {
+      AgnTranscriptClique **clique = gt_array_pop(uniqrefr);
+      agn_transcript_clique_delete(*clique);
+    }
+    while(gt_array_size(uniqpred) > 0)
+    {
+      AgnTranscriptClique **clique = gt_array_pop(uniqpred);
+      agn_transcript_clique_delete(*clique);
+    }
+  }
+  gt_array_delete(pairs);
+  gt_array_delete(uniqrefr);
+  gt_array_delete(uniqpred);
+  return success;
+}
+
+static GtArray *locus_cache_test_data(const char **filenames)
+{
+  GtNodeStream *current_stream, *last_stream;
+  GtQueue *streams = gt_queue_new();
+  GtLogger *logger = gt_logger_new(true, "", stderr);
+  GtError *error = gt_error_new();
+
+  current_stream = gt_gff3_in_stream_new_unsorted(2, filenames);
+  gt_gff3_in_stream_check_id_attributes((GtGFF3InStream *)current_stream);
+  gt_gff3_in_stream_enable_tidy_mode((GtGFF3InStream *)current_stream);
+  gt_queue_add(streams, current_stream);
+  last_stream = current_stream;
+
+  current_stream = gt_sort_stream_new(last_stream);
+  gt_queue_add(streams, current_stream);
+  last_stream = current_stream;
+
+  current_stream = agn_gene_stream_new(last_stream, logger);
+  gt_queue_add(streams, current_stream);
+  last_stream = current_stream;
+
+  current_stream = agn_locus_stream_new(last_stream, 0);
+  agn_locus_stream_skip_iiLoci((AgnLocusStream *)current_stream);
+  agn_locus_stream_label_pairwise((AgnLocusStream *)current_stream,
+                                  filenames[0], filenames[1]);
+  gt_queue_add(streams, current_stream);
+  last_stream = current_stream;
+
+  GtArray *loci = gt_array_new( sizeof(AgnLocus *) );
+  current_stream = gt_array_out_stream_new(last_stream, loci, error);
+  gt_queue_add(streams, current_stream);
+  last_stream = current_stream;
+
+  int result = gt_node_stream_pull(last_stream, error);
+  if(result == -1)
+  {
+    fprintf(stderr, "error loading unit test data: %s\n", gt_error_get(error));
+    exit(1);
+  }
+
+  while(gt_queue_size(streams) > 0)
+  {
+    GtNodeStream *ns = gt_queue_get(streams);
+    gt_node_stream_delete(ns);
+  }
+  gt_queue_delete(streams);
+  gt_logger_delete(logger);
+  gt_error_delete(error);
+  return loci;
+}
+
+static bool locus_cache_write_clique(FILE *outstream,
+                                     AgnTranscriptClique *clique,
+                                     GtHashmap *mrnaindex)
+{
+  GtArray *mrnas = agn_transcript_clique_to_array(clique);
+  bool success = agn_uword_write(outstream, gt_array_size(mrnas));
+  GtUword i;
+  for(i = 0; success && i < gt_array_size(mrnas); i++)
+  {
+    GtFeatureNode *mrna = *(GtFeatureNode **)gt_array_get(mrnas, i);
+    GtUword index = (GtUword)gt_hashmap_get(mrnaindex, mrna);
+    success = index > 0 && agn_uword_write(outstream, index - 1);
+  }
+  gt_array_delete(mrnas);
+  return success;
+}
+
+static bool locus_cache_write_cliques(FILE *outstream, GtArray *cliques,
+                                      GtHashmap *mrnaindex)
+{
+  GtUword i, numcliques = cliques == NULL ? 0 : gt_array_size(cliques);
+  bool success = agn_uword_write(outstream, numcliques);
+  for(i = 0; success && i < numcliques; i++)
+  {
+    AgnTranscriptClique *clique;
+    clique = *(AgnTranscriptClique **)gt_array_get(cliques, i);
+    success = locus_cache_write_clique(outstream, clique, mrnaindex);
+  }
+  return success;
+}
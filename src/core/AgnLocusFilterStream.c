@@ -46,6 +46,13 @@ static void locus_filter_stream_free(GtNodeStream *ns);
 static int locus_filter_stream_next(GtNodeStream *ns, GtGenomeNode **gn,
                               GtError *error);
 
+/**
+ * @function Returns true if ``locus`` passes all of the stream's filtering
+ * criteria.
+ */
+static bool locus_filter_stream_test(AgnLocusFilterStream *stream,
+                                     AgnLocus *locus);
+
 
 //------------------------------------------------------------------------------
 // Method implementations
@@ -93,13 +100,13 @@ static int locus_filter_stream_next(GtNodeStream *ns, GtGenomeNode **gn,
 {
   AgnLocusFilterStream *stream;
   GtFeatureNode *fn;
-  GtUword i;
+  GtUword i, numsets;
   gt_error_check(error);
   stream = locus_filter_stream_cast(ns);
 
   while(1)
   {
-    bool keeplocus = true;
+    bool keeplocus;
     int had_err = gt_node_stream_next(stream->in_stream, gn, error);
     if(had_err)
       return had_err;
@@ -111,13 +118,23 @@ static int locus_filter_stream_next(GtNodeStream *ns, GtGenomeNode **gn,
       return 0;
 
     agn_assert(gt_feature_node_has_type(fn, "locus"));
-    for(i = 0; i < gt_array_size(stream->filters); i++)
+    numsets = agn_locus_num_pred_sets(*gn);
+    if(numsets == 0)
+      keeplocus = locus_filter_stream_test(stream, *gn);
+    else
     {
-      AgnLocusFilter *filter = gt_array_get(stream->filters, i);
-      if(agn_locus_filter_test(*gn, filter) == false)
+      // Filter the locus for each prediction set separately, as if the
+      // reference had been compared with each set on its own
+      keeplocus = false;
+      for(i = 0; i < numsets; i++)
       {
-        keeplocus = false;
-        break;
+        AgnLocus *setlocus = agn_locus_get_pred_set(*gn, i);
+        if(setlocus == NULL)
+          continue;
+        if(locus_filter_stream_test(stream, setlocus))
+          keeplocus = true;
+        else
+          agn_locus_remove_pred_set(*gn, i);
       }
     }
 
@@ -133,6 +150,19 @@ static int locus_filter_stream_next(GtNodeStream *ns, GtGenomeNode **gn,
   return 0;
 }
 
+static bool locus_filter_stream_test(AgnLocusFilterStream *stream,
+                                     AgnLocus *locus)
+{
+  GtUword i;
+  for(i = 0; i < gt_array_size(stream->filters); i++)
+  {
+    AgnLocusFilter *filter = gt_array_get(stream->filters, i);
+    if(agn_locus_filter_test(locus, filter) == false)
+      return false;
+  }
+  return true;
+}
+
 bool agn_locus_filter_stream_unit_test(GT_UNUSED AgnUnitTest *test)
 {
   return false;
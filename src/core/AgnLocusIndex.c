@@ -0,0 +1,867 @@
+/**
+
+Copyright (c) 2010-2016, Daniel S. Standage and CONTRIBUTORS
+
+The AEGeAn Toolkit is distributed under the ISC License. See
+the 'LICENSE' file in the AEGeAn source code distribution or
+online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
+
+**/
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "core/hashmap_api.h"
+#include "extended/array_in_stream_api.h"
+#include "extended/array_out_stream_api.h"
+#include "extended/feature_node_iterator_api.h"
+#include "AgnLocusIndex.h"
+#include "AgnLocusStream.h"
+#include "AgnTypecheck.h"
+#include "AgnUtils.h"
+
+#define LOCUS_INDEX_MAGIC "AGNLINDX"
+#define LOCUS_INDEX_VERSION 1
+#define LOCUS_INDEX_HEADER_SIZE 48
+#define LOCUS_INDEX_SEQ_SIZE 24
+#define LOCUS_INDEX_TYPE_SIZE 8
+#define LOCUS_INDEX_LOCUS_SIZE 64
+#define LOCUS_INDEX_ID_SIZE 24
+
+#define locus_index_stream_cast(GS)\
+        gt_node_stream_cast(locus_index_stream_class(), GS)
+
+//------------------------------------------------------------------------------
+// Data structure definitions
+//------------------------------------------------------------------------------
+
+/**
+ * The index file begins with an 8-byte magic string, a format version, and
+ * the number of sequences, types, iLoci, and IDs in the index. These are
+ * followed by four tables of fixed-size records and a pool of NUL-terminated
+ * strings, which are referenced by their offset into the pool.
+ *
+ *   - sequences, sorted by ID: ID, number of the first iLocus, number of iLoci
+ *   - types: name
+ *   - iLoci, grouped by sequence and sorted by coordinates: sequence number,
+ *     start, end, largest end of this and all preceding iLoci of the sequence,
+ *     type number, label, number of genes, number of mRNAs
+ *   - IDs, sorted: ID, iLocus number, kind (0 for genes, 1 for mRNAs)
+ *
+ * All integers are written with :c:func:`agn_uword_write`.
+ */
+struct AgnLocusIndex
+{
+  unsigned char *map;
+  GtUword mapsize;
+  GtUword numseqs;
+  GtUword numtypes;
+  GtUword numloci;
+  GtUword numids;
+  const unsigned char *seqs;
+  const unsigned char *types;
+  const unsigned char *loci;
+  const unsigned char *ids;
+  const char *pool;
+  GtUword poolsize;
+};
+
+/**
+ * An iLocus recorded by the index stream.
+ */
+typedef struct
+{
+  GtUword start;
+  GtUword end;
+  GtUword maxend;
+  GtUword type;
+  char *label;
+  GtUword numgenes;
+  GtUword nummrnas;
+  GtUword index;
+} IndexLocus;
+
+/**
+ * A gene or mRNA recorded by the index stream.
+ */
+typedef struct
+{
+  char *id;
+  IndexLocus *locus;
+  GtUword kind;
+} IndexId;
+
+/**
+ * A sequence and its iLoci recorded by the index stream.
+ */
+typedef struct
+{
+  char *seqid;
+  GtArray *loci;
+} IndexSequence;
+
+typedef struct
+{
+  const GtNodeStream parent_instance;
+  GtNodeStream *in_stream;
+  FILE *outstream;
+  GtArray *seqs;
+  GtHashmap *seqindex;
+  GtArray *types;
+  GtArray *ids;
+  bool written;
+} AgnLocusIndexStream;
+
+
+//------------------------------------------------------------------------------
+// Prototypes for private functions
+//------------------------------------------------------------------------------
+
+/**
+ * @function Decode the unsigned integer at ``bytes``.
+ */
+static GtUword locus_index_decode(const unsigned char *bytes);
+
+/**
+ * @function Compare two iLocus IDs (for sorting).
+ */
+static int locus_index_id_compare(const void *p1, const void *p2);
+
+/**
+ * @function Compare two iLoci by coordinates (for sorting).
+ */
+static int locus_index_locus_compare(const void *p1, const void *p2);
+
+/**
+ * @function Compare two sequences by ID (for sorting).
+ */
+static int locus_index_seq_compare(const void *p1, const void *p2);
+
+/**
+ * @function Record ``locus`` and all of its genes and mRNAs.
+ */
+static void locus_index_stream_add(AgnLocusIndexStream *stream,
+                                   GtFeatureNode *locus);
+
+/**
+ * @function Implement the node stream interface.
+ */
+static const GtNodeStreamClass *locus_index_stream_class(void);
+
+/**
+ * @function Class destructor.
+ */
+static void locus_index_stream_free(GtNodeStream *ns);
+
+/**
+ * @function Pass each node through unchanged, recording each locus. Write the
+ * index after the last node.
+ */
+static int locus_index_stream_next(GtNodeStream *ns, GtGenomeNode **gn,
+                                   GtError *error);
+
+/**
+ * @function Add ``str`` to the string pool and return its offset.
+ */
+static GtUword locus_index_stream_pool(GtStr *pool, const char *str);
+
+/**
+ * @function Sort the recorded iLoci and IDs and write the index. Returns false
+ * on a write error.
+ */
+static bool locus_index_stream_write(AgnLocusIndexStream *stream);
+
+/**
+ * @function The string at the given offset of the string pool.
+ */
+static const char *locus_index_string(AgnLocusIndex *index, GtUword offset);
+
+/**
+ * @function Create an index of a few synthetic loci for unit testing. Returns
+ * the name of the index file, to be freed and unlinked by the caller.
+ */
+static char *locus_index_test_data();
+
+
+//------------------------------------------------------------------------------
+// Method implementations
+//------------------------------------------------------------------------------
+
+void agn_locus_index_delete(AgnLocusIndex *index)
+{
+  if(index == NULL)
+    return;
+  munmap(index->map, index->mapsize);
+  gt_free(index);
+}
+
+void agn_locus_index_get(AgnLocusIndex *index, GtUword i,
+                         AgnLocusIndexEntry *entry)
+{
+  agn_assert(index && entry && i < index->numloci);
+  const unsigned char *record = index->loci + (i * LOCUS_INDEX_LOCUS_SIZE);
+  GtUword seq = locus_index_decode(record);
+  GtUword type = locus_index_decode(record + 32);
+  entry->seqid = "";
+  if(seq < index->numseqs)
+  {
+    const unsigned char *seqrecord = index->seqs + (seq*LOCUS_INDEX_SEQ_SIZE);
+    entry->seqid = locus_index_string(index, locus_index_decode(seqrecord));
+  }
+  entry->range.start = locus_index_decode(record + 8);
+  entry->range.end = locus_index_decode(record + 16);
+  entry->type = "";
+  if(type < index->numtypes)
+  {
+    const unsigned char *typerecord = index->types +
+                                      (type * LOCUS_INDEX_TYPE_SIZE);
+    entry->type = locus_index_string(index, locus_index_decode(typerecord));
+  }
+  entry->label = locus_index_string(index, locus_index_decode(record + 40));
+  entry->numgenes = locus_index_decode(record + 48);
+  entry->nummrnas = locus_index_decode(record + 56);
+}
+
+void agn_locus_index_lookup_id(AgnLocusIndex *index, const char *id,
+                               GtArray *loci)
+{
+  agn_assert(index && id && loci);
+  GtUword low = 0, high = index->numids;
+  while(low < high)
+  {
+    GtUword mid = low + (high - low) / 2;
+    const unsigned char *record = index->ids + (mid * LOCUS_INDEX_ID_SIZE);
+    const char *midid = locus_index_string(index, locus_index_decode(record));
+    if(strcmp(midid, id) < 0)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+
+  GtUword prevlocus = 0;
+  bool first = true;
+  for(; low < index->numids; low++)
+  {
+    const unsigned char *record = index->ids + (low * LOCUS_INDEX_ID_SIZE);
+    const char *lowid = locus_index_string(index, locus_index_decode(record));
+    if(strcmp(lowid, id) != 0)
+      break;
+
+    // IDs are sorted by iLocus, so a gene and its mRNAs are reported once
+    GtUword locus = locus_index_decode(record + 8);
+    if(locus < index->numloci && (first || locus != prevlocus))
+      gt_array_add(loci, locus);
+    prevlocus = locus;
+    first = false;
+  }
+}
+
+bool agn_locus_index_lookup_range(AgnLocusIndex *index, const char *seqid,
+                                  GtRange *range, GtArray *loci)
+{
+  agn_assert(index && seqid && range && loci);
+  GtUword low = 0, high = index->numseqs;
+  while(low < high)
+  {
+    GtUword mid = low + (high - low) / 2;
+    const unsigned char *record = index->seqs + (mid * LOCUS_INDEX_SEQ_SIZE);
+    const char *midseq = locus_index_string(index, locus_index_decode(record));
+    if(strcmp(midseq, seqid) < 0)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  if(low == index->numseqs)
+    return false;
+  const unsigned char *seqrecord = index->seqs + (low * LOCUS_INDEX_SEQ_SIZE);
+  if(strcmp(locus_index_string(index, locus_index_decode(seqrecord)),
+            seqid) != 0)
+    return false;
+
+  GtUword first = locus_index_decode(seqrecord + 8);
+  GtUword numloci = locus_index_decode(seqrecord + 16);
+  if(first > index->numloci || numloci > index->numloci - first)
+    return false;
+
+  // Find the first iLocus starting after the range...
+  low = first;
+  high = first + numloci;
+  while(low < high)
+  {
+    GtUword mid = low + (high - low) / 2;
+    const unsigned char *record = index->loci + (mid*LOCUS_INDEX_LOCUS_SIZE);
+    if(locus_index_decode(record + 8) <= range->end)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+
+  // ...then walk back until no preceding iLocus can reach the range
+  GtUword i, numfound = 0;
+  for(i = low; i > first; i--)
+  {
+    const unsigned char *record = index->loci + ((i-1)*LOCUS_INDEX_LOCUS_SIZE);
+    if(locus_index_decode(record + 24) < range->start)
+      break;
+    if(locus_index_decode(record + 16) >= range->start)
+    {
+      GtUword locus = i - 1;
+      gt_array_add(loci, locus);
+      numfound++;
+    }
+  }
+
+  GtUword *found = (GtUword *)gt_array_get_space(loci) +
+                   (gt_array_size(loci) - numfound);
+  for(i = 0; i < numfound / 2; i++)
+  {
+    GtUword temp = found[i];
+    found[i] = found[numfound - i - 1];
+    found[numfound - i - 1] = temp;
+  }
+  return true;
+}
+
+AgnLocusIndex *agn_locus_index_new(const char *filename, GtError *error)
+{
+  agn_assert(filename);
+  int fd = open(filename, O_RDONLY);
+  if(fd == -1)
+  {
+    gt_error_set(error, "could not open iLocus index '%s'", filename);
+    return NULL;
+  }
+  struct stat filestat;
+  if(fstat(fd, &filestat) != 0 || filestat.st_size < LOCUS_INDEX_HEADER_SIZE)
+  {
+    close(fd);
+    gt_error_set(error, "'%s' is not an iLocus index", filename);
+    return NULL;
+  }
+
+  GtUword filesize = filestat.st_size;
+  unsigned char *map = mmap(NULL, filesize, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if(map == MAP_FAILED)
+  {
+    gt_error_set(error, "could not map iLocus index '%s'", filename);
+    return NULL;
+  }
+
+  AgnLocusIndex *index = gt_malloc( sizeof(AgnLocusIndex) );
+  index->map = map;
+  index->mapsize = filesize;
+  index->numseqs = locus_index_decode(map + 16);
+  index->numtypes = locus_index_decode(map + 24);
+  index->numloci = locus_index_decode(map + 32);
+  index->numids = locus_index_decode(map + 40);
+
+  // Check each count before computing table sizes so nothing can overflow
+  GtUword remaining = filesize - LOCUS_INDEX_HEADER_SIZE;
+  bool valid = memcmp(map, LOCUS_INDEX_MAGIC, 8) == 0 &&
+               locus_index_decode(map + 8) == LOCUS_INDEX_VERSION;
+  GtUword counts[] = { index->numseqs, index->numtypes, index->numloci,
+                       index->numids };
+  GtUword sizes[] = { LOCUS_INDEX_SEQ_SIZE, LOCUS_INDEX_TYPE_SIZE,
+                      LOCUS_INDEX_LOCUS_SIZE, LOCUS_INDEX_ID_SIZE };
+  const unsigned char *tables[4];
+  const unsigned char *offset = map + LOCUS_INDEX_HEADER_SIZE;
+  int i;
+  for(i = 0; valid && i < 4; i++)
+  {
+    valid = counts[i] <= remaining / sizes[i];
+    if(valid)
+    {
+      tables[i] = offset;
+      offset += counts[i] * sizes[i];
+      remaining -= counts[i] * sizes[i];
+    }
+  }
+  valid = valid && (remaining == 0 || map[filesize - 1] == '\0');
+  if(!valid)
+  {
+    agn_locus_index_delete(index);
+    gt_error_set(error, "'%s' is not an iLocus index", filename);
+    return NULL;
+  }
+
+  index->seqs = tables[0];
+  index->types = tables[1];
+  index->loci = tables[2];
+  index->ids = tables[3];
+  index->pool = (const char *)offset;
+  index->poolsize = remaining;
+  return index;
+}
+
+GtUword agn_locus_index_num_loci(AgnLocusIndex *index)
+{
+  agn_assert(index);
+  return index->numloci;
+}
+
+GtNodeStream *agn_locus_index_stream_new(GtNodeStream *in, FILE *outstream)
+{
+  agn_assert(in && outstream);
+  GtNodeStream *ns = gt_node_stream_create(locus_index_stream_class(), false);
+  AgnLocusIndexStream *stream = locus_index_stream_cast(ns);
+  stream->in_stream = gt_node_stream_ref(in);
+  stream->outstream = outstream;
+  stream->seqs = gt_array_new( sizeof(IndexSequence) );
+  stream->seqindex = gt_hashmap_new(GT_HASH_STRING, NULL, NULL);
+  stream->types = gt_array_new( sizeof(char *) );
+  stream->ids = gt_array_new( sizeof(IndexId) );
+  stream->written = false;
+  return ns;
+}
+
+bool agn_locus_index_unit_test(AgnUnitTest *test)
+{
+  char *filename = locus_index_test_data();
+  GtError *error = gt_error_new();
+  AgnLocusIndex *index = agn_locus_index_new(filename, error);
+  bool opentest = index != NULL;
+  agn_unit_test_result(test, "open index", opentest);
+  if(!opentest)
+  {
+    fprintf(stderr, "error: %s\n", gt_error_get(error));
+    gt_error_delete(error);
+    unlink(filename);
+    gt_free(filename);
+    return false;
+  }
+
+  // seqA: locus (g1, g2), iiLocus, locus (g3), fiLocus; seqB: locus (g4)
+  GtArray *loci = gt_array_new( sizeof(GtUword) );
+  AgnLocusIndexEntry entry;
+  agn_locus_index_lookup_id(index, "m1", loci);
+  bool idtest = gt_array_size(loci) == 1;
+  if(idtest)
+  {
+    agn_locus_index_get(index, *(GtUword *)gt_array_get(loci, 0), &entry);
+    idtest = strcmp(entry.seqid, "seqA") == 0 && entry.numgenes == 2 &&
+             entry.nummrnas == 2 && entry.range.start == 901 &&
+             entry.range.end == 2600;
+  }
+  gt_array_reset(loci);
+  agn_locus_index_lookup_id(index, "g4", loci);
+  if(idtest && gt_array_size(loci) == 1)
+  {
+    agn_locus_index_get(index, *(GtUword *)gt_array_get(loci, 0), &entry);
+    idtest = strcmp(entry.seqid, "seqB") == 0 && entry.numgenes == 1;
+  }
+  else
+    idtest = false;
+  gt_array_reset(loci);
+  agn_locus_index_lookup_id(index, "g5", loci);
+  idtest = idtest && gt_array_size(loci) == 0;
+  agn_unit_test_result(test, "ID lookup", idtest);
+
+  gt_array_reset(loci);
+  GtRange range = { 3000, 3000 };
+  bool postest = agn_locus_index_lookup_range(index, "seqA", &range, loci) &&
+                 gt_array_size(loci) == 1;
+  if(postest)
+  {
+    agn_locus_index_get(index, *(GtUword *)gt_array_get(loci, 0), &entry);
+    postest = entry.numgenes == 0 && entry.range.start == 2601 &&
+              entry.range.end == 3899;
+  }
+  gt_array_reset(loci);
+  range.start = 2000;
+  range.end = 4000;
+  postest = postest &&
+            agn_locus_index_lookup_range(index, "seqA", &range, loci) &&
+            gt_array_size(loci) == 3;
+  if(postest)
+  {
+    GtUword *found = gt_array_get_space(loci);
+    postest = found[0] < found[1] && found[1] < found[2];
+    agn_locus_index_get(index, found[2], &entry);
+    postest = postest && entry.numgenes == 1 && entry.range.start == 3900;
+  }
+  gt_array_reset(loci);
+  range.start = range.end = 9000;
+  postest = postest &&
+            agn_locus_index_lookup_range(index, "seqA", &range, loci) &&
+            gt_array_size(loci) == 1;
+  if(postest)
+  {
+    agn_locus_index_get(index, *(GtUword *)gt_array_get(loci, 0), &entry);
+    postest = strcmp(entry.type, "fiLocus") == 0;
+  }
+  gt_array_reset(loci);
+  postest = postest &&
+            !agn_locus_index_lookup_range(index, "seqC", &range, loci) &&
+            gt_array_size(loci) == 0;
+  agn_unit_test_result(test, "position lookup", postest);
+
+  gt_array_delete(loci);
+  agn_locus_index_delete(index);
+  gt_error_delete(error);
+  unlink(filename);
+  gt_free(filename);
+  return agn_unit_test_success(test);
+}
+
+static GtUword locus_index_decode(const unsigned char *bytes)
+{
+  GtUword value = 0;
+  int i;
+  for(i = 7; i >= 0; i--)
+    value = (value << 8) | bytes[i];
+  return value;
+}
+
+static int locus_index_id_compare(const void *p1, const void *p2)
+{
+  const IndexId *id1 = p1;
+  const IndexId *id2 = p2;
+  int result = strcmp(id1->id, id2->id);
+  if(result != 0)
+    return result;
+  if(id1->locus->index != id2->locus->index)
+    return id1->locus->index < id2->locus->index ? -1 : 1;
+  if(id1->kind != id2->kind)
+    return id1->kind < id2->kind ? -1 : 1;
+  return 0;
+}
+
+static int locus_index_locus_compare(const void *p1, const void *p2)
+{
+  const IndexLocus *locus1 = *(IndexLocus *const *)p1;
+  const IndexLocus *locus2 = *(IndexLocus *const *)p2;
+  if(locus1->start != locus2->start)
+    return locus1->start < locus2->start ? -1 : 1;
+  if(locus1->end != locus2->end)
+    return locus1->end < locus2->end ? -1 : 1;
+  return 0;
+}
+
+static int locus_index_seq_compare(const void *p1, const void *p2)
+{
+  const IndexSequence *seq1 = p1;
+  const IndexSequence *seq2 = p2;
+  return strcmp(seq1->seqid, seq2->seqid);
+}
+
+static void locus_index_stream_add(AgnLocusIndexStream *stream,
+                                   GtFeatureNode *locusfn)
+{
+  GtGenomeNode *gn = (GtGenomeNode *)locusfn;
+  const char *seqid = gt_str_get(gt_genome_node_get_seqid(gn));
+  GtUword seqnum = (GtUword)gt_hashmap_get(stream->seqindex, seqid);
+  if(seqnum == 0)
+  {
+    IndexSequence seq;
+    seq.seqid = gt_cstr_dup(seqid);
+    seq.loci = gt_array_new( sizeof(IndexLocus *) );
+    gt_array_add(stream->seqs, seq);
+    seqnum = gt_array_size(stream->seqs);
+    gt_hashmap_add(stream->seqindex, seq.seqid, (void *)seqnum);
+  }
+  IndexSequence *seq = gt_array_get(stream->seqs, seqnum - 1);
+
+  IndexLocus *locus = gt_malloc( sizeof(IndexLocus) );
+  locus->start = gt_genome_node_get_start(gn);
+  locus->end = gt_genome_node_get_end(gn);
+  locus->maxend = locus->end;
+  locus->label = gt_cstr_dup(agn_feature_node_get_label(locusfn));
+  locus->numgenes = 0;
+  locus->nummrnas = 0;
+  locus->index = 0;
+  gt_array_add(seq->loci, locus);
+
+  GtFeatureNodeIterator *iter = gt_feature_node_iterator_new(locusfn);
+  GtFeatureNode *current;
+  for(current  = gt_feature_node_iterator_next(iter);
+      current != NULL;
+      current  = gt_feature_node_iterator_next(iter))
+  {
+    IndexId id;
+    if(agn_typecheck_gene(current))
+    {
+      locus->numgenes++;
+      id.kind = 0;
+    }
+    else if(agn_typecheck_mrna(current))
+    {
+      locus->nummrnas++;
+      id.kind = 1;
+    }
+    else
+      continue;
+
+    id.id = gt_cstr_dup(agn_feature_node_get_label(current));
+    id.locus = locus;
+    gt_array_add(stream->ids, id);
+  }
+  gt_feature_node_iterator_delete(iter);
+
+  // iLocus types are assigned by the refine stream; fiLoci are marked by the
+  // locus stream; otherwise iLoci with no children are intergenic
+  const char *type = gt_feature_node_get_attribute(locusfn, "iLocus_type");
+  if(type == NULL)
+    type = gt_genome_node_get_user_data(gn, "iLocus_type");
+  if(type == NULL)
+  {
+    bool haschildren = gt_feature_node_number_of_children(locusfn) > 0;
+    type = haschildren ? "locus" : "iiLocus";
+  }
+  GtUword i;
+  for(i = 0; i < gt_array_size(stream->types); i++)
+  {
+    const char **knowntype = gt_array_get(stream->types, i);
+    if(strcmp(*knowntype, type) == 0)
+      break;
+  }
+  if(i == gt_array_size(stream->types))
+  {
+    char *newtype = gt_cstr_dup(type);
+    gt_array_add(stream->types, newtype);
+  }
+  locus->type = i;
+}
+
+static const GtNodeStreamClass *locus_index_stream_class(void)
+{
+  static const GtNodeStreamClass *nsc = NULL;
+  if(!nsc)
+  {
+    nsc = gt_node_stream_class_new(sizeof (AgnLocusIndexStream),
+                                   locus_index_stream_free,
+                                   locus_index_stream_next);
+  }
+  return nsc;
+}
+
+static void locus_index_stream_free(GtNodeStream *ns)
+{
+  AgnLocusIndexStream *stream = locus_index_stream_cast(ns);
+  gt_node_stream_delete(stream->in_stream);
+  GtUword i, j;
+  for(i = 0; i < gt_array_size(stream->seqs); i++)
+  {
+    IndexSequence *seq = gt_array_get(stream->seqs, i);
+    for(j = 0; j < gt_array_size(seq->loci); j++)
+    {
+      IndexLocus **locus = gt_array_get(seq->loci, j);
+      gt_free((*locus)->label);
+      gt_free(*locus);
+    }
+    gt_array_delete(seq->loci);
+    gt_free(seq->seqid);
+  }
+  gt_array_delete(stream->seqs);
+  gt_hashmap_delete(stream->seqindex);
+  for(i = 0; i < gt_array_size(stream->types); i++)
+  {
+    char **type = gt_array_get(stream->types, i);
+    gt_free(*type);
+  }
+  gt_array_delete(stream->types);
+  for(i = 0; i < gt_array_size(stream->ids); i++)
+  {
+    IndexId *id = gt_array_get(stream->ids, i);
+    gt_free(id->id);
+  }
+  gt_array_delete(stream->ids);
+}
+
+static int locus_index_stream_next(GtNodeStream *ns, GtGenomeNode **gn,
+                                   GtError *error)
+{
+  gt_error_check(error);
+  AgnLocusIndexStream *stream = locus_index_stream_cast(ns);
+  int had_err = gt_node_stream_next(stream->in_stream, gn, error);
+  if(had_err)
+    return had_err;
+
+  if(*gn == NULL)
+  {
+    if(!stream->written)
+    {
+      stream->written = true;
+      if(!locus_index_stream_write(stream))
+      {
+        gt_error_set(error, "could not write iLocus index");
+        return -1;
+      }
+    }
+    return 0;
+  }
+
+  GtFeatureNode *fn = gt_feature_node_try_cast(*gn);
+  if(fn != NULL && gt_feature_node_has_type(fn, "locus"))
+    locus_index_stream_add(stream, fn);
+  return 0;
+}
+
+static GtUword locus_index_stream_pool(GtStr *pool, const char *str)
+{
+  GtUword offset = gt_str_length(pool);
+  gt_str_append_cstr(pool, str);
+  gt_str_append_char(pool, '\0');
+  return offset;
+}
+
+static bool locus_index_stream_write(AgnLocusIndexStream *stream)
+{
+  GtUword i, j, numloci = 0;
+  gt_array_sort(stream->seqs, locus_index_seq_compare);
+  for(i = 0; i < gt_array_size(stream->seqs); i++)
+  {
+    IndexSequence *seq = gt_array_get(stream->seqs, i);
+    gt_array_sort(seq->loci, locus_index_locus_compare);
+    GtUword maxend = 0;
+    for(j = 0; j < gt_array_size(seq->loci); j++)
+    {
+      IndexLocus *locus = *(IndexLocus **)gt_array_get(seq->loci, j);
+      if(locus->end > maxend)
+        maxend = locus->end;
+      locus->maxend = maxend;
+      locus->index = numloci++;
+    }
+  }
+  gt_array_sort(stream->ids, locus_index_id_compare);
+
+  FILE *out = stream->outstream;
+  GtStr *pool = gt_str_new();
+  bool success = fwrite(LOCUS_INDEX_MAGIC, 1, 8, out) == 8 &&
+                 agn_uword_write(out, LOCUS_INDEX_VERSION) &&
+                 agn_uword_write(out, gt_array_size(stream->seqs)) &&
+                 agn_uword_write(out, gt_array_size(stream->types)) &&
+                 agn_uword_write(out, numloci) &&
+                 agn_uword_write(out, gt_array_size(stream->ids));
+
+  GtUword first = 0;
+  for(i = 0; success && i < gt_array_size(stream->seqs); i++)
+  {
+    IndexSequence *seq = gt_array_get(stream->seqs, i);
+    success = agn_uword_write(out, locus_index_stream_pool(pool, seq->seqid)) &&
+              agn_uword_write(out, first) &&
+              agn_uword_write(out, gt_array_size(seq->loci));
+    first += gt_array_size(seq->loci);
+  }
+  for(i = 0; success && i < gt_array_size(stream->types); i++)
+  {
+    const char **type = gt_array_get(stream->types, i);
+    success = agn_uword_write(out, locus_index_stream_pool(pool, *type));
+  }
+  for(i = 0; success && i < gt_array_size(stream->seqs); i++)
+  {
+    IndexSequence *seq = gt_array_get(stream->seqs, i);
+    for(j = 0; success && j < gt_array_size(seq->loci); j++)
+    {
+      IndexLocus *locus = *(IndexLocus **)gt_array_get(seq->loci, j);
+      success = agn_uword_write(out, i) &&
+                agn_uword_write(out, locus->start) &&
+                agn_uword_write(out, locus->end) &&
+                agn_uword_write(out, locus->maxend) &&
+                agn_uword_write(out, locus->type) &&
+                agn_uword_write(out, locus_index_stream_pool(pool,
+                                                             locus->label)) &&
+                agn_uword_write(out, locus->numgenes) &&
+                agn_uword_write(out, locus->nummrnas);
+    }
+  }
+  for(i = 0; success && i < gt_array_size(stream->ids); i++)
+  {
+    IndexId *id = gt_array_get(stream->ids, i);
+    success = agn_uword_write(out, locus_index_stream_pool(pool, id->id)) &&
+              agn_uword_write(out, id->locus->index) &&
+              agn_uword_write(out, id->kind);
+  }
+
+  GtUword poolsize = gt_str_length(pool);
+  success = success &&
+            fwrite(gt_str_get(pool), 1, poolsize, out) == poolsize &&
+            fflush(out) == 0;
+  gt_str_delete(pool);
+  return success;
+}
+
+static const char *locus_index_string(AgnLocusIndex *index, GtUword offset)
+{
+  if(offset >= index->poolsize)
+    return "";
+  return index->pool + offset;
+}
+
+static char *locus_index_test_data()
+{
+  char filename[] = "/tmp/agn-locus-index-XXXXXX";
+  int fd = mkstemp(filename);
+  FILE *outstream = fd == -1 ? NULL : fdopen(fd, "wb");
+  if(outstream == NULL)
+  {
+    fprintf(stderr, "error creating unit test index file\n");
+    exit(1);
+  }
+
+  GtArray *source = gt_array_new( sizeof(GtGenomeNode *) );
+  GtArray *sink = gt_array_new( sizeof(GtGenomeNode *) );
+  GtStr *seqA = gt_str_new_cstr("seqA");
+  GtStr *seqB = gt_str_new_cstr("seqB");
+  GtGenomeNode *gn = gt_region_node_new(seqA, 1, 10000);
+  gt_array_add(source, gn);
+  gn = gt_region_node_new(seqB, 1, 5000);
+  gt_array_add(source, gn);
+
+  struct { GtStr *seqid; const char *id; GtUword start, end; } genes[] = {
+    { seqA, "g1", 1001, 2000 },
+    { seqA, "g2", 1800, 2500 },
+    { seqA, "g3", 4000, 4500 },
+    { seqB, "g4", 1, 5000 },
+  };
+  GtUword i;
+  for(i = 0; i < sizeof(genes) / sizeof(genes[0]); i++)
+  {
+    char mrnaid[8];
+    sprintf(mrnaid, "m%lu", i + 1);
+    GtGenomeNode *gene = gt_feature_node_new(genes[i].seqid, "gene",
+                                             genes[i].start, genes[i].end,
+                                             GT_STRAND_FORWARD);
+    GtGenomeNode *mrna = gt_feature_node_new(genes[i].seqid, "mRNA",
+                                             genes[i].start, genes[i].end,
+                                             GT_STRAND_FORWARD);
+    gt_feature_node_set_attribute((GtFeatureNode *)gene, "ID", genes[i].id);
+    gt_feature_node_set_attribute((GtFeatureNode *)mrna, "ID", mrnaid);
+    gt_feature_node_add_child((GtFeatureNode *)gene, (GtFeatureNode *)mrna);
+    gt_array_add(source, gene);
+  }
+  gt_str_delete(seqA);
+  gt_str_delete(seqB);
+
+  GtError *error = gt_error_new();
+  GtUword progress = 0;
+  GtNodeStream *ais = gt_array_in_stream_new(source, &progress, error);
+  GtNodeStream *ls = agn_locus_stream_new(ais, 100);
+  GtNodeStream *lis = agn_locus_index_stream_new(ls, outstream);
+  GtNodeStream *aos = gt_array_out_stream_new(lis, sink, error);
+  int result = gt_node_stream_pull(aos, error);
+  if(result == -1)
+  {
+    fprintf(stderr, "error creating unit test index: %s\n",
+            gt_error_get(error));
+    exit(1);
+  }
+  fclose(outstream);
+
+  gt_node_stream_delete(aos);
+  gt_node_stream_delete(lis);
+  gt_node_stream_delete(ls);
+  gt_node_stream_delete(ais);
+  while(gt_array_size(sink) > 0)
+  {
+    GtGenomeNode **locus = gt_array_pop(sink);
+    gt_genome_node_delete(*locus);
+  }
+  gt_array_delete(sink);
+  gt_array_delete(source);
+  gt_error_delete(error);
+  return gt_cstr_dup(filename);
+}
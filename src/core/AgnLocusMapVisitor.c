@@ -21,8 +21,8 @@ online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
 struct AgnLocusMapVisitor
 {
   const GtNodeVisitor parent_instance;
-  FILE *genefh;
-  FILE *mrnafh;
+  AgnOutputSink *genemap;
+  AgnOutputSink *mrnamap;
 };
 
 
@@ -47,18 +47,20 @@ visit_feature_node(GtNodeVisitor *nv, GtFeatureNode *fn, GtError *error);
 //------------------------------------------------------------------------------
 
 GtNodeStream*
-agn_locus_map_stream_new(GtNodeStream *in, FILE *genefh, FILE *mrnafh)
+agn_locus_map_stream_new(GtNodeStream *in, AgnOutputSink *genemap,
+                         AgnOutputSink *mrnamap)
 {
-  GtNodeVisitor *nv = agn_locus_map_visitor_new(genefh, mrnafh);
+  GtNodeVisitor *nv = agn_locus_map_visitor_new(genemap, mrnamap);
   return gt_visitor_stream_new(in, nv);
 }
 
-GtNodeVisitor *agn_locus_map_visitor_new(FILE *genefh, FILE *mrnafh)
+GtNodeVisitor *agn_locus_map_visitor_new(AgnOutputSink *genemap,
+                                         AgnOutputSink *mrnamap)
 {
   GtNodeVisitor *nv = gt_node_visitor_create(locus_map_visitor_class());
   AgnLocusMapVisitor *v = locus_map_visitor_cast(nv);
-  v->genefh = genefh;
-  v->mrnafh = mrnafh;
+  v->genemap = genemap;
+  v->mrnamap = mrnamap;
   return nv;
 }
 
@@ -87,16 +89,17 @@ visit_feature_node(GtNodeVisitor *nv, GtFeatureNode *fn, GtError *error)
       current != NULL;
       current  = gt_feature_node_iterator_next(iter))
   {
-    if(agn_typecheck_gene(current) && v->genefh != NULL)
+    AgnOutputSink *map = NULL;
+    if(agn_typecheck_gene(current))
+      map = v->genemap;
+    else if(agn_typecheck_mrna(current))
+      map = v->mrnamap;
+    if(map != NULL)
     {
-      const char *genelabel = agn_feature_node_get_label(current);
-      fprintf(v->genefh, "%s\t%s\n", genelabel, locuslabel);
-    }
-
-    if(agn_typecheck_mrna(current) && v->mrnafh != NULL)
-    {
-      const char *mrnalabel = agn_feature_node_get_label(current);
-      fprintf(v->mrnafh, "%s\t%s\n", mrnalabel, locuslabel);
+      agn_output_sink_cstr(map, agn_feature_node_get_label(current));
+      agn_output_sink_char(map, '\t');
+      agn_output_sink_cstr(map, locuslabel);
+      agn_output_sink_char(map, '\n');
     }
   }
   gt_feature_node_iterator_delete(iter);
@@ -0,0 +1,946 @@
+/**
+
+Copyright (c) 2010-2016, Daniel S. Standage and CONTRIBUTORS
+
+The AEGeAn Toolkit is distributed under the ISC License. See
+the 'LICENSE' file in the AEGeAn source code distribution or
+online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
+
+**/
+#include <pthread.h>
+#include <string.h>
+#include "core/hashmap_api.h"
+#include "core/queue_api.h"
+#include "extended/array_in_stream_api.h"
+#include "extended/array_out_stream_api.h"
+#include "extended/sort_stream_api.h"
+#include "AgnFilterStream.h"
+#include "AgnILocusCache.h"
+#include "AgnInferParentStream.h"
+#include "AgnLocusParallelStream.h"
+#include "AgnLocusRefineStream.h"
+#include "AgnLocusStream.h"
+#include "AgnUtils.h"
+#include "AgnVersion.h"
+
+#define LOCUS_PARALLEL_STREAM_BUFFER_PER_THREAD 4
+
+//------------------------------------------------------------------------------
+// Data structure definitions
+//------------------------------------------------------------------------------
+
+/**
+ * A group of nodes waiting in the stream's buffer. For a partition (all the
+ * features of one sequence), ``analyze`` is true and ``nodes`` holds the input
+ * nodes until the partition has been processed (``done``) and the resulting
+ * iLoci afterwards. Any other node is buffered on its own. ``next`` is the
+ * index of the next node to deliver. ``regions`` holds the partition's copies
+ * of sequence regions, in the order they precede the input nodes.
+ */
+typedef struct
+{
+  GtArray *nodes;
+  GtArray *regions;
+  AgnOutputSink *ilens;
+  GtError *error;
+  GtUword next;
+  bool analyze;
+  bool done;
+} LocusPartition;
+
+/**
+ * The range of a sequence as declared by its region node(s), and whether any
+ * of its features have been seen.
+ */
+typedef struct
+{
+  GtRange range;
+  bool annotated;
+} LocusSequence;
+
+struct AgnLocusParallelStream
+{
+  const GtNodeStream parent_instance;
+  GtNodeStream *in_stream;
+  GtUword delta;
+  int endmode;
+  bool skip_iiLoci;
+  bool refine;
+  GtUword minoverlap;
+  bool by_cds;
+  GtStr *source;
+  GtStr *nameformat;
+  AgnOutputSink *ilens;
+  AgnILocusCache *cache;
+  GtUword count;
+  GtHashmap *seqranges;
+  GtArray *seqorder;
+  GtUword seqnext;
+  GtArray *pending;
+  GtStr *pendingseqid;
+  GtUword numthreads;
+  GtUword numworkers;
+  pthread_t *workers;
+  pthread_mutex_t mutex;
+  pthread_cond_t job_added;
+  pthread_cond_t job_done;
+  LocusPartition *jobs;
+  GtUword capacity;
+  GtUword received;
+  GtUword claimed;
+  GtUword delivered;
+  bool input_done;
+  bool shutdown;
+};
+
+
+//------------------------------------------------------------------------------
+// Prototypes for private functions
+//------------------------------------------------------------------------------
+
+#define locus_parallel_stream_cast(GS)\
+        gt_node_stream_cast(locus_parallel_stream_class(), GS)
+
+/**
+ * @function Add a group of nodes to the buffer, making it available to the
+ * workers if it is a partition.
+ */
+static void locus_parallel_stream_add_job(AgnLocusParallelStream *stream,
+                                          GtArray *nodes, GtArray *regions,
+                                          bool analyze);
+
+/**
+ * @function Add to ``regions`` a copy of the region node of ``sequence``, with
+ * the given sequence ID.
+ */
+static void locus_parallel_stream_add_region(GtArray *regions, GtStr *seqid,
+                                             LocusSequence *sequence);
+
+/**
+ * @function Claim the oldest partition in the buffer that no thread has
+ * started processing yet, or return NULL if there is none. Must be called with
+ * the stream's mutex locked.
+ */
+static LocusPartition *
+locus_parallel_stream_claim(AgnLocusParallelStream *stream);
+
+/**
+ * @function Implements the GtNodeStream interface for this class.
+ */
+static const GtNodeStreamClass* locus_parallel_stream_class(void);
+
+/**
+ * @function Release a partition once all of its nodes have been delivered,
+ * copying its iLocus lengths to the stream's file.
+ */
+static void locus_parallel_stream_finish(AgnLocusParallelStream *stream,
+                                         LocusPartition *job);
+
+/**
+ * @function Class destructor.
+ */
+static void locus_parallel_stream_free(GtNodeStream *ns);
+
+/**
+ * @function Pulls nodes from the input stream, makes sure the partition of the
+ * oldest buffered sequence has been processed, and delivers its iLoci (named
+ * with the stream's running count) in order.
+ */
+static int locus_parallel_stream_next(GtNodeStream *ns, GtGenomeNode **gn,
+                                      GtError *error);
+
+/**
+ * @function Compute the iLoci of a single partition by pulling its nodes
+ * through a locus stream (and a refine stream if requested), or rebuild them
+ * from the cache if the partition is unchanged since they were stored.
+ */
+static void locus_parallel_stream_process(AgnLocusParallelStream *stream,
+                                          LocusPartition *job);
+
+/**
+ * @function Assign a node pulled from the input stream to the partition of the
+ * current sequence, or buffer it on its own if no partition is open.
+ */
+static void locus_parallel_stream_route(AgnLocusParallelStream *stream,
+                                        GtGenomeNode *gn);
+
+/**
+ * @function Describe every setting that affects the iLoci computed for a
+ * partition, for use in its cache key.
+ */
+static void locus_parallel_stream_settings(AgnLocusParallelStream *stream,
+                                           GtStr *settings);
+
+/**
+ * @function Close the partition of the current sequence (if any) and add it to
+ * the buffer. Sequences declared before it that have no features are added to
+ * the partition so that its locus stream reports them; if ``last`` is true,
+ * so are all remaining sequences with no features.
+ */
+static void locus_parallel_stream_submit(AgnLocusParallelStream *stream,
+                                         bool last);
+
+/**
+ * @function Pull the given data file through a locus stream (and refine stream)
+ * or, if ``numthreads`` is greater than 0, through a parallel locus stream
+ * with the given number of threads, and return the resulting iLoci in an
+ * array. iLocus lengths are written to ``ilens``.
+ */
+static GtArray *locus_parallel_stream_test_data(const char *filename,
+                                                GtUword numthreads,
+                                                bool refine,
+                                                AgnOutputSink *ilens);
+
+/**
+ * @function Worker thread main loop: process partitions from the buffer until
+ * the stream is shut down.
+ */
+static void *locus_parallel_stream_worker(void *data);
+
+
+//------------------------------------------------------------------------------
+// Method implementations
+//------------------------------------------------------------------------------
+
+GtNodeStream *agn_locus_parallel_stream_new(GtNodeStream *in_stream,
+                                            GtUword delta,
+                                            GtUword numthreads)
+{
+  GtNodeStream *ns;
+  AgnLocusParallelStream *stream;
+  agn_assert(in_stream && numthreads > 0);
+  ns = gt_node_stream_create(locus_parallel_stream_class(), false);
+  stream = locus_parallel_stream_cast(ns);
+  stream->in_stream = gt_node_stream_ref(in_stream);
+  stream->delta = delta;
+  stream->endmode = 0;
+  stream->skip_iiLoci = false;
+  stream->refine = false;
+  stream->minoverlap = 1;
+  stream->by_cds = false;
+  stream->source = gt_str_new_cstr("AEGeAn::AgnLocusStream");
+  stream->nameformat = NULL;
+  stream->ilens = NULL;
+  stream->cache = NULL;
+  stream->count = 0;
+  stream->seqranges = gt_hashmap_new(GT_HASH_STRING, gt_free_func,
+                                     gt_free_func);
+  stream->seqorder = gt_array_new( sizeof(const char *) );
+  stream->seqnext = 0;
+  stream->pending = NULL;
+  stream->pendingseqid = NULL;
+  stream->numthreads = numthreads;
+  stream->numworkers = 0;
+  stream->capacity = numthreads * LOCUS_PARALLEL_STREAM_BUFFER_PER_THREAD;
+  stream->jobs = gt_calloc(stream->capacity, sizeof(LocusPartition));
+  stream->received = 0;
+  stream->claimed = 0;
+  stream->delivered = 0;
+  stream->input_done = false;
+  stream->shutdown = false;
+  pthread_mutex_init(&stream->mutex, NULL);
+  pthread_cond_init(&stream->job_added, NULL);
+  pthread_cond_init(&stream->job_done, NULL);
+
+  // The calling thread processes partitions too while it waits for results, so
+  // if fewer workers can be started the stream is slower but still correct
+  stream->workers = NULL;
+  if(numthreads > 1)
+    stream->workers = gt_malloc( sizeof(pthread_t) * (numthreads - 1) );
+  GtUword i;
+  for(i = 0; i + 1 < numthreads; i++)
+  {
+    if(pthread_create(stream->workers + i, NULL, locus_parallel_stream_worker,
+                      stream) != 0)
+      break;
+    stream->numworkers++;
+  }
+
+  return ns;
+}
+
+void agn_locus_parallel_stream_refine(AgnLocusParallelStream *stream,
+                                      GtUword minoverlap, bool by_cds)
+{
+  agn_assert(stream);
+  stream->refine = true;
+  stream->minoverlap = minoverlap;
+  stream->by_cds = by_cds;
+}
+
+void agn_locus_parallel_stream_set_cache(AgnLocusParallelStream *stream,
+                                         AgnILocusCache *cache)
+{
+  agn_assert(stream);
+  stream->cache = cache;
+}
+
+void agn_locus_parallel_stream_set_endmode(AgnLocusParallelStream *stream,
+                                           int endmode)
+{
+  agn_assert(stream);
+  stream->endmode = endmode;
+}
+
+void agn_locus_parallel_stream_set_name_format(AgnLocusParallelStream *stream,
+                                               const char *format)
+{
+  agn_assert(stream && format);
+  if(stream->nameformat)
+    gt_str_delete(stream->nameformat);
+  stream->nameformat = gt_str_new_cstr(format);
+}
+
+void agn_locus_parallel_stream_set_source(AgnLocusParallelStream *stream,
+                                          const char *source)
+{
+  agn_assert(stream && source);
+  gt_str_delete(stream->source);
+  stream->source = gt_str_new_cstr(source);
+}
+
+void agn_locus_parallel_stream_skip_iiLoci(AgnLocusParallelStream *stream)
+{
+  agn_assert(stream);
+  stream->skip_iiLoci = true;
+}
+
+void agn_locus_parallel_stream_track_ilens(AgnLocusParallelStream *stream,
+                                           AgnOutputSink *ilens)
+{
+  agn_assert(stream);
+  stream->ilens = ilens;
+}
+
+bool agn_locus_parallel_stream_unit_test(AgnUnitTest *test)
+{
+  const char *filenames[] = { "data/gff3/ilocus.in.gff3",
+                              "data/gff3/amel-ogs-g716.gff3" };
+  const char *labels[] = { "iLoci", "refined iLoci" };
+  GtUword i, j;
+  for(i = 0; i < 2; i++)
+  {
+    AgnOutputSink *serialilens = agn_output_sink_new_memory();
+    AgnOutputSink *parallelilens = agn_output_sink_new_memory();
+    GtArray *serial = locus_parallel_stream_test_data(filenames[i], 0, i == 1,
+                                                      serialilens);
+    GtArray *parallel = locus_parallel_stream_test_data(filenames[i], 4, i == 1,
+                                                        parallelilens);
+
+    bool lociagree = gt_array_size(serial) > 0 &&
+                     gt_array_size(serial) == gt_array_size(parallel);
+    for(j = 0; lociagree && j < gt_array_size(serial); j++)
+    {
+      GtGenomeNode *l1 = *(GtGenomeNode **)gt_array_get(serial, j);
+      GtGenomeNode *l2 = *(GtGenomeNode **)gt_array_get(parallel, j);
+      GtRange r1 = gt_genome_node_get_range(l1);
+      GtRange r2 = gt_genome_node_get_range(l2);
+      const char *name1 = gt_feature_node_get_attribute((GtFeatureNode *)l1,
+                                                        "Name");
+      const char *name2 = gt_feature_node_get_attribute((GtFeatureNode *)l2,
+                                                        "Name");
+      lociagree = gt_range_compare(&r1, &r2) == 0 &&
+                  gt_str_cmp(gt_genome_node_get_seqid(l1),
+                             gt_genome_node_get_seqid(l2)) == 0 &&
+                  name1 != NULL && name2 != NULL && strcmp(name1, name2) == 0;
+    }
+    char label[64];
+    sprintf(label, "%s: coords and names", labels[i]);
+    agn_unit_test_result(test, label, lociagree);
+
+    GtUword length = agn_output_sink_length(serialilens);
+    bool ilensagree = length == agn_output_sink_length(parallelilens) &&
+                      memcmp(agn_output_sink_get(serialilens),
+                             agn_output_sink_get(parallelilens), length) == 0;
+    sprintf(label, "%s: iLocus lengths", labels[i]);
+    agn_unit_test_result(test, label, ilensagree);
+
+    GtArray *results[] = { serial, parallel };
+    for(j = 0; j < 2; j++)
+    {
+      while(gt_array_size(results[j]) > 0)
+      {
+        GtGenomeNode **locus = gt_array_pop(results[j]);
+        gt_genome_node_delete(*locus);
+      }
+      gt_array_delete(results[j]);
+    }
+    agn_output_sink_delete(serialilens);
+    agn_output_sink_delete(parallelilens);
+  }
+
+  return agn_unit_test_success(test);
+}
+
+static void locus_parallel_stream_add_job(AgnLocusParallelStream *stream,
+                                          GtArray *nodes, GtArray *regions,
+                                          bool analyze)
+{
+  pthread_mutex_lock(&stream->mutex);
+  LocusPartition *job = stream->jobs + stream->received % stream->capacity;
+  job->nodes = nodes;
+  job->regions = regions;
+  job->ilens = NULL;
+  job->error = NULL;
+  if(analyze)
+  {
+    job->error = gt_error_new();
+    if(stream->ilens != NULL || stream->cache != NULL)
+      job->ilens = agn_output_sink_new_memory();
+  }
+  job->next = 0;
+  job->analyze = analyze;
+  job->done = !analyze;
+  stream->received++;
+  if(analyze)
+    pthread_cond_signal(&stream->job_added);
+  pthread_mutex_unlock(&stream->mutex);
+}
+
+static void locus_parallel_stream_add_region(GtArray *regions, GtStr *seqid,
+                                             LocusSequence *sequence)
+{
+  GtGenomeNode *region = gt_region_node_new(seqid, sequence->range.start,
+                                            sequence->range.end);
+  gt_array_add(regions, region);
+}
+
+static LocusPartition *
+locus_parallel_stream_claim(AgnLocusParallelStream *stream)
+{
+  // Nodes that need no processing may be delivered before any thread looks at
+  // them; never revisit a buffer slot that has been recycled
+  if(stream->claimed < stream->delivered)
+    stream->claimed = stream->delivered;
+
+  while(stream->claimed < stream->received)
+  {
+    LocusPartition *job = stream->jobs + stream->claimed % stream->capacity;
+    stream->claimed++;
+    if(job->analyze)
+      return job;
+  }
+  return NULL;
+}
+
+static const GtNodeStreamClass *locus_parallel_stream_class(void)
+{
+  static const GtNodeStreamClass *nsc = NULL;
+  if(!nsc)
+  {
+    nsc = gt_node_stream_class_new(sizeof (AgnLocusParallelStream),
+                                   locus_parallel_stream_free,
+                                   locus_parallel_stream_next);
+  }
+  return nsc;
+}
+
+static void locus_parallel_stream_finish(AgnLocusParallelStream *stream,
+                                         LocusPartition *job)
+{
+  if(job->ilens != NULL)
+  {
+    if(stream->ilens != NULL)
+      agn_output_sink_append(stream->ilens, job->ilens);
+    agn_output_sink_delete(job->ilens);
+    job->ilens = NULL;
+  }
+  if(job->error != NULL)
+  {
+    gt_error_delete(job->error);
+    job->error = NULL;
+  }
+
+  // Any nodes left over if the caller stopped pulling early
+  for(; job->next < gt_array_size(job->nodes); job->next++)
+    gt_genome_node_delete(*(GtGenomeNode **)gt_array_get(job->nodes,
+                                                         job->next));
+  gt_array_delete(job->nodes);
+  job->nodes = NULL;
+  if(job->regions != NULL)
+  {
+    gt_array_delete(job->regions);
+    job->regions = NULL;
+  }
+}
+
+static void locus_parallel_stream_free(GtNodeStream *ns)
+{
+  AgnLocusParallelStream *stream = locus_parallel_stream_cast(ns);
+  gt_node_stream_delete(stream->in_stream);
+
+  pthread_mutex_lock(&stream->mutex);
+  stream->shutdown = true;
+  pthread_cond_broadcast(&stream->job_added);
+  pthread_mutex_unlock(&stream->mutex);
+  GtUword i;
+  for(i = 0; i < stream->numworkers; i++)
+    pthread_join(stream->workers[i], NULL);
+
+  for(i = stream->delivered; i < stream->received; i++)
+    locus_parallel_stream_finish(stream, stream->jobs + i % stream->capacity);
+  if(stream->pending != NULL)
+  {
+    while(gt_array_size(stream->pending) > 0)
+      gt_genome_node_delete(*(GtGenomeNode **)gt_array_pop(stream->pending));
+    gt_array_delete(stream->pending);
+    gt_str_delete(stream->pendingseqid);
+  }
+
+  pthread_cond_destroy(&stream->job_added);
+  pthread_cond_destroy(&stream->job_done);
+  pthread_mutex_destroy(&stream->mutex);
+  gt_free(stream->workers);
+  gt_free(stream->jobs);
+  gt_array_delete(stream->seqorder);
+  gt_hashmap_delete(stream->seqranges);
+  gt_str_delete(stream->source);
+  if(stream->nameformat)
+    gt_str_delete(stream->nameformat);
+}
+
+static int locus_parallel_stream_next(GtNodeStream *ns, GtGenomeNode **gn,
+                                      GtError *error)
+{
+  AgnLocusParallelStream *stream;
+  gt_error_check(error);
+  stream = locus_parallel_stream_cast(ns);
+
+  while(true)
+  {
+    // Keep the buffer full so that the workers always have sequences to
+    // process
+    while(!stream->input_done &&
+          stream->received - stream->delivered < stream->capacity)
+    {
+      GtGenomeNode *node;
+      int had_err = gt_node_stream_next(stream->in_stream, &node, error);
+      if(had_err)
+        return had_err;
+      if(node == NULL)
+      {
+        locus_parallel_stream_submit(stream, true);
+        stream->input_done = true;
+      }
+      else
+        locus_parallel_stream_route(stream, node);
+    }
+
+    if(stream->delivered == stream->received)
+    {
+      *gn = NULL;
+      return 0;
+    }
+
+    // Wait for the oldest partition; rather than sitting idle while a large
+    // sequence is processed, take on partitions no other thread has started
+    pthread_mutex_lock(&stream->mutex);
+    LocusPartition *job = stream->jobs + stream->delivered % stream->capacity;
+    while(!job->done)
+    {
+      LocusPartition *pending = locus_parallel_stream_claim(stream);
+      if(pending == NULL)
+      {
+        pthread_cond_wait(&stream->job_done, &stream->mutex);
+        continue;
+      }
+      pthread_mutex_unlock(&stream->mutex);
+      locus_parallel_stream_process(stream, pending);
+      pthread_mutex_lock(&stream->mutex);
+      pending->done = true;
+    }
+    pthread_mutex_unlock(&stream->mutex);
+
+    if(job->error != NULL && gt_error_is_set(job->error))
+    {
+      gt_error_set(error, "%s", gt_error_get(job->error));
+      return -1;
+    }
+
+    if(job->next < gt_array_size(job->nodes))
+    {
+      *gn = *(GtGenomeNode **)gt_array_get(job->nodes, job->next);
+      job->next++;
+      GtFeatureNode *fn = gt_feature_node_try_cast(*gn);
+      if(job->analyze && fn != NULL)
+      {
+        stream->count++;
+        if(stream->nameformat)
+        {
+          char locusname[256];
+          sprintf(locusname, gt_str_get(stream->nameformat), stream->count);
+          gt_feature_node_set_attribute(fn, "Name", locusname);
+        }
+      }
+      return 0;
+    }
+
+    locus_parallel_stream_finish(stream, job);
+    pthread_mutex_lock(&stream->mutex);
+    stream->delivered++;
+    pthread_mutex_unlock(&stream->mutex);
+  }
+}
+
+static void locus_parallel_stream_process(AgnLocusParallelStream *stream,
+                                          LocusPartition *job)
+{
+  GtNodeStream *current_stream, *last_stream;
+  GtQueue *streams = gt_queue_new();
+  GtUword progress, key = 0;
+  GtArray *nodes = job->nodes;
+  GtStr *desc = NULL;
+  if(stream->cache != NULL)
+  {
+    GtStr *settings = gt_str_new();
+    locus_parallel_stream_settings(stream, settings);
+    desc = gt_str_new();
+    key = agn_ilocus_cache_key(stream->cache, gt_str_get(settings), nodes,
+                               desc);
+    gt_str_delete(settings);
+
+    GtArray *loci = gt_array_new( sizeof(GtGenomeNode *) );
+    if(agn_ilocus_cache_get(stream->cache, key, desc, nodes, loci,
+                            job->ilens))
+    {
+      gt_str_delete(desc);
+      gt_queue_delete(streams);
+      gt_array_delete(nodes);
+      job->nodes = loci;
+      return;
+    }
+    gt_array_delete(loci);
+  }
+
+  current_stream = gt_array_in_stream_new(nodes, &progress, job->error);
+  gt_queue_add(streams, current_stream);
+  last_stream = current_stream;
+
+  // Loci are named with a count local to this partition so that the Name
+  // attribute is created in the same place as in the serial pipeline; the
+  // names are replaced as the loci are delivered
+  current_stream = agn_locus_stream_new(last_stream, stream->delta);
+  AgnLocusStream *ls = (AgnLocusStream *)current_stream;
+  agn_locus_stream_set_source(ls, gt_str_get(stream->source));
+  agn_locus_stream_set_endmode(ls, stream->endmode);
+  agn_locus_stream_track_ilens(ls, job->ilens);
+  if(stream->nameformat != NULL)
+    agn_locus_stream_set_name_format(ls, gt_str_get(stream->nameformat));
+  if(stream->skip_iiLoci)
+    agn_locus_stream_skip_iiLoci(ls);
+  gt_queue_add(streams, current_stream);
+  last_stream = current_stream;
+
+  if(stream->refine)
+  {
+    current_stream = agn_locus_refine_stream_new(last_stream, stream->delta,
+                                                 stream->minoverlap,
+                                                 stream->by_cds);
+    AgnLocusRefineStream *lrs = (AgnLocusRefineStream *)current_stream;
+    agn_locus_refine_stream_set_source(lrs, gt_str_get(stream->source));
+    agn_locus_refine_stream_track_ilens(lrs, job->ilens);
+    if(stream->nameformat != NULL)
+    {
+      agn_locus_refine_stream_set_name_format(lrs,
+                                              gt_str_get(stream->nameformat));
+    }
+    gt_queue_add(streams, current_stream);
+    last_stream = current_stream;
+  }
+
+  // The partition's copies of sequence regions are only needed to compute the
+  // coordinates of iLoci at the ends of sequences; they are delivered first,
+  // in order
+  GtGenomeNode *gn;
+  GtUword numregions = 0;
+  GtArray *loci = gt_array_new( sizeof(GtGenomeNode *) );
+  while(!gt_node_stream_next(last_stream, &gn, job->error) && gn)
+  {
+    GtGenomeNode **region = NULL;
+    if(numregions < gt_array_size(job->regions))
+      region = gt_array_get(job->regions, numregions);
+    if(region != NULL && gn == *region)
+    {
+      gt_genome_node_delete(gn);
+      numregions++;
+    }
+    else
+      gt_array_add(loci, gn);
+  }
+
+  while(gt_queue_size(streams) > 0)
+  {
+    current_stream = gt_queue_get(streams);
+    gt_node_stream_delete(current_stream);
+  }
+  gt_queue_delete(streams);
+  gt_array_delete(nodes);
+  job->nodes = loci;
+
+  if(stream->cache != NULL && !gt_error_is_set(job->error) &&
+     !agn_ilocus_cache_put(stream->cache, key, desc, loci, job->ilens))
+  {
+    gt_error_set(job->error, "could not write iLoci to cache directory");
+  }
+  if(desc != NULL)
+    gt_str_delete(desc);
+}
+
+static void locus_parallel_stream_route(AgnLocusParallelStream *stream,
+                                        GtGenomeNode *gn)
+{
+  GtRegionNode *rn = gt_region_node_try_cast(gn);
+  if(rn != NULL)
+  {
+    const char *seqid = gt_str_get(gt_genome_node_get_seqid(gn));
+    GtRange range = gt_genome_node_get_range(gn);
+    LocusSequence *sequence = gt_hashmap_get(stream->seqranges, seqid);
+    if(sequence == NULL)
+    {
+      char *key = gt_cstr_dup(seqid);
+      sequence = gt_malloc( sizeof(LocusSequence) );
+      sequence->range = range;
+      sequence->annotated = false;
+      gt_hashmap_add(stream->seqranges, key, sequence);
+      gt_array_add(stream->seqorder, key);
+    }
+    else
+      sequence->range = gt_range_join(&sequence->range, &range);
+  }
+
+  if(gt_feature_node_try_cast(gn) != NULL)
+  {
+    GtStr *seqid = gt_genome_node_get_seqid(gn);
+    if(stream->pending != NULL && gt_str_cmp(seqid, stream->pendingseqid) != 0)
+      locus_parallel_stream_submit(stream, false);
+    if(stream->pending == NULL)
+    {
+      stream->pending = gt_array_new( sizeof(GtGenomeNode *) );
+      stream->pendingseqid = gt_str_clone(seqid);
+    }
+
+    // Features of the same sequence share a sequence ID string with nodes
+    // delivered or deleted by this thread, and reference counts are not thread
+    // safe; give each partition its own copy
+    gt_genome_node_change_seqid(gn, stream->pendingseqid);
+    gt_array_add(stream->pending, gn);
+    return;
+  }
+
+  // Other nodes within a sequence's features are processed with them so that
+  // they are delivered in the same place as in the serial pipeline
+  if(stream->pending != NULL)
+  {
+    if(rn != NULL)
+    {
+      GtStr *seqid = gt_str_clone(gt_genome_node_get_seqid(gn));
+      gt_genome_node_change_seqid(gn, seqid);
+      gt_str_delete(seqid);
+    }
+    gt_array_add(stream->pending, gn);
+    return;
+  }
+
+  GtArray *nodes = gt_array_new( sizeof(GtGenomeNode *) );
+  gt_array_add(nodes, gn);
+  locus_parallel_stream_add_job(stream, nodes, NULL, false);
+}
+
+static void locus_parallel_stream_settings(AgnLocusParallelStream *stream,
+                                           GtStr *settings)
+{
+  char buffer[256];
+  sprintf(buffer, "version=%s\tdelta=%lu\tendmode=%d\tskipiiloci=%d\t",
+          AGN_SEMANTIC_VERSION, stream->delta, stream->endmode,
+          stream->skip_iiLoci);
+  gt_str_append_cstr(settings, buffer);
+  if(stream->refine)
+  {
+    sprintf(buffer, "refine=1\tminoverlap=%lu\tcds=%d\t", stream->minoverlap,
+            stream->by_cds);
+    gt_str_append_cstr(settings, buffer);
+  }
+  gt_str_append_cstr(settings, "source=");
+  gt_str_append_str(settings, stream->source);
+  gt_str_append_cstr(settings, "\tnameformat=");
+  if(stream->nameformat != NULL)
+    gt_str_append_str(settings, stream->nameformat);
+}
+
+static void locus_parallel_stream_submit(AgnLocusParallelStream *stream,
+                                         bool last)
+{
+  GtUword i, numseqs = gt_array_size(stream->seqorder);
+  GtUword current = numseqs;
+  LocusSequence *sequence = NULL;
+  if(stream->pending != NULL)
+  {
+    sequence = gt_hashmap_get(stream->seqranges,
+                              gt_str_get(stream->pendingseqid));
+    if(sequence != NULL)
+      sequence->annotated = true;
+    for(current = stream->seqnext; current < numseqs; current++)
+    {
+      const char **seqid = gt_array_get(stream->seqorder, current);
+      if(strcmp(*seqid, gt_str_get(stream->pendingseqid)) == 0)
+        break;
+    }
+  }
+
+  // Only the current sequence is needed unless the locus stream will report
+  // sequences with no features
+  bool report = stream->delta > 0 && stream->endmode >= 0 &&
+                !stream->skip_iiLoci;
+  GtUword stop = stream->seqnext;
+  if(last)
+    stop = numseqs;
+  else if(current < numseqs)
+    stop = current + 1;
+
+  GtArray *regions = gt_array_new( sizeof(GtGenomeNode *) );
+  if(current == numseqs && sequence != NULL)
+    locus_parallel_stream_add_region(regions, stream->pendingseqid, sequence);
+  for(i = stream->seqnext; i < stop; i++)
+  {
+    const char **seqid = gt_array_get(stream->seqorder, i);
+    LocusSequence *seq = gt_hashmap_get(stream->seqranges, *seqid);
+    if(i == current || (report && !seq->annotated))
+    {
+      GtStr *regionseqid = gt_str_new_cstr(*seqid);
+      locus_parallel_stream_add_region(regions, regionseqid, seq);
+      gt_str_delete(regionseqid);
+    }
+  }
+  stream->seqnext = stop;
+
+  if(stream->pending == NULL && gt_array_size(regions) == 0)
+  {
+    gt_array_delete(regions);
+    return;
+  }
+
+  GtArray *nodes = gt_array_new( sizeof(GtGenomeNode *) );
+  gt_array_add_array(nodes, regions);
+  if(stream->pending != NULL)
+  {
+    gt_array_add_array(nodes, stream->pending);
+    gt_array_delete(stream->pending);
+    gt_str_delete(stream->pendingseqid);
+    stream->pending = NULL;
+    stream->pendingseqid = NULL;
+  }
+  locus_parallel_stream_add_job(stream, nodes, regions, true);
+}
+
+static GtArray *locus_parallel_stream_test_data(const char *filename,
+                                                GtUword numthreads,
+                                                bool refine,
+                                                AgnOutputSink *ilens)
+{
+  GtNodeStream *current_stream, *last_stream;
+  GtQueue *streams = gt_queue_new();
+  GtError *error = gt_error_new();
+
+  current_stream = gt_gff3_in_stream_new_unsorted(1, &filename);
+  gt_gff3_in_stream_check_id_attributes((GtGFF3InStream *)current_stream);
+  gt_gff3_in_stream_enable_tidy_mode((GtGFF3InStream *)current_stream);
+  gt_queue_add(streams, current_stream);
+  last_stream = current_stream;
+
+  GtHashmap *type_parents = gt_hashmap_new(GT_HASH_STRING, gt_free_func,
+                                           gt_free_func);
+  gt_hashmap_add(type_parents, gt_cstr_dup("mRNA"), gt_cstr_dup("gene"));
+  current_stream = agn_infer_parent_stream_new(last_stream, type_parents);
+  gt_queue_add(streams, current_stream);
+  last_stream = current_stream;
+
+  GtHashmap *filter = gt_hashmap_new(GT_HASH_STRING, gt_free_func,
+                                     gt_free_func);
+  gt_hashmap_add(filter, gt_cstr_dup("gene"), gt_cstr_dup("gene"));
+  current_stream = agn_filter_stream_new(last_stream, filter);
+  gt_queue_add(streams, current_stream);
+  last_stream = current_stream;
+
+  current_stream = gt_sort_stream_new(last_stream);
+  gt_queue_add(streams, current_stream);
+  last_stream = current_stream;
+
+  if(numthreads > 0)
+  {
+    current_stream = agn_locus_parallel_stream_new(last_stream, 200,
+                                                   numthreads);
+    AgnLocusParallelStream *lps = (AgnLocusParallelStream *)current_stream;
+    agn_locus_parallel_stream_set_name_format(lps, "iLocus%lu");
+    agn_locus_parallel_stream_track_ilens(lps, ilens);
+    if(refine)
+      agn_locus_parallel_stream_refine(lps, 1, true);
+    gt_queue_add(streams, current_stream);
+    last_stream = current_stream;
+  }
+  else
+  {
+    current_stream = agn_locus_stream_new(last_stream, 200);
+    AgnLocusStream *ls = (AgnLocusStream *)current_stream;
+    agn_locus_stream_set_name_format(ls, "iLocus%lu");
+    agn_locus_stream_track_ilens(ls, ilens);
+    gt_queue_add(streams, current_stream);
+    last_stream = current_stream;
+
+    if(refine)
+    {
+      current_stream = agn_locus_refine_stream_new(last_stream, 200, 1, true);
+      AgnLocusRefineStream *lrs = (AgnLocusRefineStream *)current_stream;
+      agn_locus_refine_stream_set_name_format(lrs, "iLocus%lu");
+      agn_locus_refine_stream_track_ilens(lrs, ilens);
+      gt_queue_add(streams, current_stream);
+      last_stream = current_stream;
+    }
+  }
+
+  GtArray *loci = gt_array_new( sizeof(GtGenomeNode *) );
+  current_stream = gt_array_out_stream_new(last_stream, loci, error);
+  gt_queue_add(streams, current_stream);
+  last_stream = current_stream;
+
+  int result = gt_node_stream_pull(last_stream, error);
+  if(result == -1)
+  {
+    fprintf(stderr, "error loading unit test data: %s\n", gt_error_get(error));
+    exit(1);
+  }
+
+  while(gt_queue_size(streams) > 0)
+  {
+    GtNodeStream *ns = gt_queue_get(streams);
+    gt_node_stream_delete(ns);
+  }
+  gt_queue_delete(streams);
+  gt_hashmap_delete(type_parents);
+  gt_hashmap_delete(filter);
+  gt_error_delete(error);
+  return loci;
+}
+
+static void *locus_parallel_stream_worker(void *data)
+{
+  AgnLocusParallelStream *stream = data;
+  pthread_mutex_lock(&stream->mutex);
+  while(true)
+  {
+    LocusPartition *job = locus_parallel_stream_claim(stream);
+    if(job == NULL)
+    {
+      if(stream->shutdown)
+        break;
+      pthread_cond_wait(&stream->job_added, &stream->mutex);
+      continue;
+    }
+    pthread_mutex_unlock(&stream->mutex);
+    locus_parallel_stream_process(stream, job);
+    pthread_mutex_lock(&stream->mutex);
+    job->done = true;
+    pthread_cond_signal(&stream->job_done);
+  }
+  pthread_mutex_unlock(&stream->mutex);
+  return NULL;
+}
@@ -9,13 +9,16 @@ online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
 **/
 
 #include <string.h>
+#include <time.h>
 #include "core/queue_api.h"
+#include "extended/feature_node_iterator_api.h"
 #include "extended/sort_stream_api.h"
 #include "AgnGeneStream.h"
 #include "AgnLocus.h"
 #include "AgnLocusStream.h"
 #include "AgnLocusRefineStream.h"
 #include "AgnTypecheck.h"
+#include "AgnTypeCounter.h"
 #include "AgnUtils.h"
 
 #define locus_refine_stream_cast(GS)\
@@ -37,9 +40,20 @@ struct AgnLocusRefineStream
   GtUword count;
   GtQueue *locusqueue;
   AgnLocus *cache;
-  FILE *ilenfile;
+  AgnOutputSink *ilens;
+  AgnTypeCounter *typecounter;
 };
 
+typedef struct
+{
+  GtGenomeNode *gene;
+  GtRange range;
+  GtRange span;
+  bool coding;
+  GtUword index;
+  GtUword parent;
+} RefineGene;
+
 //------------------------------------------------------------------------------
 // Prototypes for private functions
 //------------------------------------------------------------------------------
@@ -47,11 +61,23 @@ struct AgnLocusRefineStream
 /**
  * @function Collect iLocus children (typically genes) into overlapping bins.
  * Overlap may be determined by UTR coordinates or CDS coordinates, and coding
- * genes are not considered to overlap with non-coding genes.
+ * genes are not considered to overlap with non-coding genes. The span of each
+ * gene is computed once; genes are then sorted by start and swept, with
+ * overlapping genes merged by union-find so that transitive overlaps end up in
+ * the same bin. Bins are ordered by their first gene.
+ */
+static GtArray *locus_refine_stream_bin_features(GtFeatureNode *locus,
+                                                 GtUword minoverlap,
+                                                 bool by_cds);
+
+/**
+ * @function Reference implementation of bin collection that compares each gene
+ * against the genes of the current bin only. Used only as a reference for
+ * benchmarking.
  */
-static
-GtArray *locus_refine_stream_bin_features(AgnLocusRefineStream *stream,
-                                          GtFeatureNode *locus);
+static GtArray *locus_refine_stream_bin_features_linear(GtFeatureNode *locus,
+                                                        GtUword minoverlap,
+                                                        bool by_cds);
 
 /**
  * @function Look for intron genes: a gene contained completely within the
@@ -72,17 +98,42 @@ static const GtNodeStreamClass *locus_refine_stream_class(void);
 static void locus_refine_stream_extend(AgnLocusRefineStream *stream,
                                        GtArray *iloci, AgnLocus *orig);
 
+/**
+ * @function Find the representative of the bin to which ``genes[i]`` belongs,
+ * compressing the path along the way.
+ */
+static GtUword locus_refine_stream_find(RefineGene *genes, GtUword i);
+
 /**
  * @function Destructor: release instance data.
  */
 static void locus_refine_stream_free(GtNodeStream *ns);
 
+/**
+ * @function Compare genes by coding status and then by complete coordinates.
+ */
+static int locus_refine_stream_gene_compare_range(const void *p1,
+                                                  const void *p2);
+
+/**
+ * @function Compare genes by coding status and then by the coordinates used
+ * for overlap (CDS coordinates for coding genes in CDS mode).
+ */
+static int locus_refine_stream_gene_compare_span(const void *p1,
+                                                 const void *p2);
+
 /**
  * @function Callback function to be executed for each node.
  */
 static int locus_refine_stream_handler(AgnLocusRefineStream *stream,
                                        GtGenomeNode *gn);
 
+/**
+ * @function Determine whether any of the genes in the given iLocus has a coding
+ * sequence, using the structural summary of each gene.
+ */
+static bool locus_refine_stream_is_coding(GtFeatureNode *locus);
+
 /**
  * @function While processing node i, it is often necessary to refer to the
  * nearest boundary of node i-1. However, in some cases the streaming
@@ -114,16 +165,92 @@ static int locus_refine_stream_next(GtNodeStream *ns, GtGenomeNode **gn,
 static GtArray *locus_refine_stream_resolve_bins(AgnLocusRefineStream *stream,
                                                  GtArray *bins);
 
+/**
+ * @function Create a synthetic iLocus with ``numgenes`` coding genes, each of
+ * whose CDS overlaps the CDS of only its immediate neighbors; if ``noncoding``
+ * is true, a non-coding gene is placed in the UTR of every fourth gene.
+ */
+static AgnLocus *locus_refine_stream_synthetic_locus(GtUword numgenes,
+                                                     bool noncoding);
+
 /**
  * @function Load data for unit tests.
  */
 static void locus_refine_stream_test_data(const char *filename, GtQueue *queue,
                                           GtUword delta);
 
+/**
+ * @function Merge the bins of ``genes[i]`` and ``genes[j]``. The gene with the
+ * smallest index always represents its bin.
+ */
+static void locus_refine_stream_union(RefineGene *genes, GtUword i,
+                                      GtUword j);
+
+/**
+ * @function Write one row of iLocus length output: the sequence ID, length, and
+ * orientation of the flanking genes.
+ */
+static void locus_refine_stream_write_ilen(AgnLocusRefineStream *stream,
+                                           GtStr *seqid, GtUword length,
+                                           const char *orientation);
+
 //------------------------------------------------------------------------------
 // Method definitions
 //------------------------------------------------------------------------------
 
+bool agn_locus_refine_stream_benchmark(AgnUnitTest *test)
+{
+  GtUword sizes[] = { 250, 500, 1000, 2000 };
+  GtUword i, j, k;
+  for(i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+  {
+    char label[64];
+    AgnLocus *locus = locus_refine_stream_synthetic_locus(sizes[i], false);
+    GtFeatureNode *locusfn = gt_feature_node_cast(locus);
+
+    clock_t start = clock();
+    GtArray *refbins = locus_refine_stream_bin_features_linear(locusfn, 1,
+                                                               true);
+    clock_t middle = clock();
+    GtArray *bins = locus_refine_stream_bin_features(locusfn, 1, true);
+    clock_t end = clock();
+    double reftime = (double)(middle - start) / CLOCKS_PER_SEC;
+    double newtime = (double)(end - middle) / CLOCKS_PER_SEC;
+
+    bool identical = gt_array_size(bins) == gt_array_size(refbins);
+    for(j = 0; identical && j < gt_array_size(bins); j++)
+    {
+      GtArray *bin = *(GtArray **)gt_array_get(bins, j);
+      GtArray *refbin = *(GtArray **)gt_array_get(refbins, j);
+      identical = gt_array_size(bin) == gt_array_size(refbin);
+      for(k = 0; identical && k < gt_array_size(bin); k++)
+      {
+        GtGenomeNode **gn = gt_array_get(bin, k);
+        GtGenomeNode **refgn = gt_array_get(refbin, k);
+        identical = *gn == *refgn;
+      }
+    }
+    printf("        [gene binning] %4lu genes: linear %.3fs, union-find "
+           "%.3fs (%.1fx)\n", sizes[i], reftime, newtime,
+           newtime > 0.0 ? reftime / newtime : 0.0);
+    sprintf(label, "identical bins, %lu genes", sizes[i]);
+    agn_unit_test_result(test, label, identical);
+
+    GtArray *binsets[] = { bins, refbins };
+    for(j = 0; j < 2; j++)
+    {
+      while(gt_array_size(binsets[j]) > 0)
+      {
+        GtArray **bin = gt_array_pop(binsets[j]);
+        gt_array_delete(*bin);
+      }
+      gt_array_delete(binsets[j]);
+    }
+    gt_genome_node_delete(locus);
+  }
+  return agn_unit_test_success(test);
+}
+
 GtNodeStream *agn_locus_refine_stream_new(GtNodeStream *in_stream,
                                           GtUword delta, GtUword minoverlap,
                                           bool by_cds)
@@ -139,7 +266,8 @@ GtNodeStream *agn_locus_refine_stream_new(GtNodeStream *in_stream,
   stream->count = 0;
   stream->locusqueue = gt_queue_new();
   stream->cache = NULL;
-  stream->ilenfile = NULL;
+  stream->ilens = NULL;
+  stream->typecounter = agn_type_counter_new();
   return ns;
 }
 
@@ -161,9 +289,9 @@ void agn_locus_refine_stream_set_source(AgnLocusRefineStream *stream,
 }
 
 void agn_locus_refine_stream_track_ilens(AgnLocusRefineStream *stream,
-                                         FILE *ilenfile)
+                                         AgnOutputSink *ilens)
 {
-  stream->ilenfile = ilenfile;
+  stream->ilens = ilens;
 }
 
 bool agn_locus_refine_stream_unit_test(AgnUnitTest *test)
@@ -221,12 +349,122 @@ bool agn_locus_refine_stream_unit_test(AgnUnitTest *test)
   agn_unit_test_result(test, "Megachile rotundata CST: elen", test2a);
   gt_queue_delete(queue);
 
+  AgnLocus *locus = locus_refine_stream_synthetic_locus(8, true);
+  GtArray *bins = locus_refine_stream_bin_features((GtFeatureNode *)locus, 1,
+                                                   true);
+  bool test3 = gt_array_size(bins) == 3;
+  if(test3)
+  {
+    GtArray **bin = gt_array_get(bins, 0);
+    test3 = gt_array_size(*bin) == 8;
+    bin = gt_array_get(bins, 1);
+    test3 = test3 && gt_array_size(*bin) == 1;
+  }
+  agn_unit_test_result(test, "transitive overlaps", test3);
+  while(gt_array_size(bins) > 0)
+  {
+    GtArray **bin = gt_array_pop(bins);
+    gt_array_delete(*bin);
+  }
+  gt_array_delete(bins);
+  gt_genome_node_delete(locus);
+
   return agn_unit_test_success(test);
 }
 
-static
-GtArray *locus_refine_stream_bin_features(AgnLocusRefineStream *stream,
-                                          GtFeatureNode *locus)
+static GtArray *locus_refine_stream_bin_features(GtFeatureNode *locus,
+                                                 GtUword minoverlap,
+                                                 bool by_cds)
+{
+  GtArray *features = agn_feature_node_get_children(locus);
+  GtUword numfeatures = gt_array_size(features);
+  agn_assert(numfeatures >= 2);
+
+  GtUword i;
+  RefineGene *genes = gt_calloc(numfeatures, sizeof(RefineGene));
+  GtArray *order = gt_array_new( sizeof(RefineGene *) );
+  for(i = 0; i < numfeatures; i++)
+  {
+    RefineGene *gene = genes + i;
+    gene->gene = *(GtGenomeNode **)gt_array_get(features, i);
+    gene->range = gt_genome_node_get_range(gene->gene);
+    gene->span = gene->range;
+    gene->coding = false;
+    if(by_cds)
+    {
+      AgnFeatureSummary summary;
+      agn_feature_node_get_summary((GtFeatureNode *)gene->gene, &summary);
+      if(summary.has_cds)
+      {
+        gene->span = summary.cds;
+        gene->coding = true;
+      }
+    }
+    gene->index = i;
+    gene->parent = i;
+    gt_array_add(order, gene);
+  }
+
+  // Sweep each class of genes in order of start position: a gene overlaps some
+  // preceding gene if and only if it overlaps the preceding gene extending
+  // furthest, and all the preceding genes it overlaps already share a bin.
+  gt_array_sort(order, (GtCompare)locus_refine_stream_gene_compare_span);
+  RefineGene *furthest = NULL;
+  for(i = 0; i < numfeatures; i++)
+  {
+    RefineGene *gene = *(RefineGene **)gt_array_get(order, i);
+    if(furthest == NULL || furthest->coding != gene->coding)
+    {
+      furthest = gene;
+      continue;
+    }
+    if(gt_range_overlap_delta(&furthest->span, &gene->span, minoverlap))
+      locus_refine_stream_union(genes, furthest->index, gene->index);
+    if(gene->span.end > furthest->span.end)
+      furthest = gene;
+  }
+
+  // Polycistrons belong together
+  if(by_cds)
+  {
+    gt_array_sort(order, (GtCompare)locus_refine_stream_gene_compare_range);
+    for(i = 1; i < numfeatures; i++)
+    {
+      RefineGene *prev = *(RefineGene **)gt_array_get(order, i - 1);
+      RefineGene *gene = *(RefineGene **)gt_array_get(order, i);
+      if(prev->coding && gene->coding &&
+         gt_range_compare(&prev->range, &gene->range) == 0)
+        locus_refine_stream_union(genes, prev->index, gene->index);
+    }
+  }
+
+  GtArray *bins = gt_array_new( sizeof(GtArray *) );
+  GtUword *binindex = gt_malloc( sizeof(GtUword) * numfeatures );
+  for(i = 0; i < numfeatures; i++)
+  {
+    GtArray *bin;
+    GtUword root = locus_refine_stream_find(genes, i);
+    if(root == i)
+    {
+      binindex[i] = gt_array_size(bins);
+      bin = gt_array_new( sizeof(GtGenomeNode *) );
+      gt_array_add(bins, bin);
+    }
+    else
+      bin = *(GtArray **)gt_array_get(bins, binindex[root]);
+    gt_array_add(bin, genes[i].gene);
+  }
+
+  gt_free(binindex);
+  gt_free(genes);
+  gt_array_delete(order);
+  gt_array_delete(features);
+  return bins;
+}
+
+static GtArray *locus_refine_stream_bin_features_linear(GtFeatureNode *locus,
+                                                        GtUword minoverlap,
+                                                        bool by_cds)
 {
   GtArray *features = agn_feature_node_get_children(locus);
   GtUword numfeatures = gt_array_size(features);
@@ -247,7 +485,7 @@ GtArray *locus_refine_stream_bin_features(AgnLocusRefineStream *stream,
     for(j = 0; j < gt_array_size(bin); j++)
     {
       GtGenomeNode **test_gn = gt_array_get(bin, j);
-      if(agn_overlap_ilocus(*gn, *test_gn, stream->minoverlap, stream->by_cds))
+      if(agn_overlap_ilocus(*gn, *test_gn, minoverlap, by_cds))
       {
         overlaps = true;
         gt_array_add(bin, *gn);
@@ -287,12 +525,12 @@ static bool refine_locus_check_intron_genes(AgnLocusRefineStream *stream,
 
   GtFeatureNode *fn1 = gt_feature_node_cast(*gn1);
   GtFeatureNode *fn2 = gt_feature_node_cast(*gn2);
-  GtArray *exons = agn_typecheck_select(fn1, agn_typecheck_exon);
-  if(gt_array_size(exons) <= 1)
-  {
-    gt_array_delete(exons);
+  AgnFeatureSummary summary;
+  agn_feature_node_get_summary(fn1, &summary);
+  if(summary.num_exons <= 1)
     return false;
-  }
+
+  GtArray *exons = agn_typecheck_select(fn1, agn_typecheck_exon);
 
   GtUword i;
   bool overlap = false;
@@ -320,8 +558,8 @@ static bool refine_locus_check_intron_genes(AgnLocusRefineStream *stream,
   agn_locus_add_feature(locus, fn2);
   gt_feature_node_add_attribute((GtFeatureNode *)locus, "iiLocus_exception",
                                 "intron-gene");
-  if(stream->ilenfile != NULL)
-    fprintf(stream->ilenfile, "%s\t0\tNA\n", gt_str_get(seqid));
+  if(stream->ilens != NULL)
+    locus_refine_stream_write_ilen(stream, seqid, 0, "NA");
   gt_genome_node_ref(*gn2);
   gt_array_add(iloci, locus);
 
@@ -413,11 +651,11 @@ static void locus_refine_stream_extend(AgnLocusRefineStream *stream,
     GtFeatureNode *fn = gt_feature_node_cast(*gn);
     if(i == 0)
     {
-      coding_status = agn_typecheck_count(fn, agn_typecheck_cds) > 0;
+      coding_status = locus_refine_stream_is_coding(fn);
     }
     else
     {
-      bool test_status = agn_typecheck_count(fn, agn_typecheck_cds) > 0;
+      bool test_status = locus_refine_stream_is_coding(fn);
       same_coding_status = coding_status == test_status;
       if(!same_coding_status)
         break;
@@ -448,11 +686,11 @@ static void locus_refine_stream_extend(AgnLocusRefineStream *stream,
           {
             gt_feature_node_add_attribute(fn, "iiLocus_exception",
                                           "gene-overlap-gene");
-            if(stream->ilenfile != NULL) {
+            if(stream->ilens != NULL) {
               const char *orientstrs[] = { "FF", "FR", "RF", "RR" };
               int orient = agn_locus_inner_orientation(*gn, *gn2);
-              fprintf(stream->ilenfile, "%s\t0\t%s\n", gt_str_get(seqid),
-                      orientstrs[orient]);
+              locus_refine_stream_write_ilen(stream, seqid, 0,
+                                             orientstrs[orient]);
             }
             gt_feature_node_add_attribute(fn, "riil", "0");
             gt_feature_node_add_attribute(fn2, "liil", "0");
@@ -496,7 +734,7 @@ static void locus_refine_stream_extend(AgnLocusRefineStream *stream,
     GtFeatureNode *fn1 = gt_feature_node_cast(*gn1);
     GtFeatureNode *fn2 = gt_feature_node_cast(*gn2);
 
-    bool cds1 = agn_typecheck_count(fn1, agn_typecheck_cds) > 0;;
+    bool cds1 = locus_refine_stream_is_coding(fn1);
     if(cds1 == true)
     {
       gt_feature_node_add_attribute(fn1, "iLocus_type", "siLocus");
@@ -521,8 +759,8 @@ static void locus_refine_stream_extend(AgnLocusRefineStream *stream,
       {
         gt_feature_node_add_attribute(fn1, "iiLocus_exception",
                                       "gene-contain-gene");
-        if(stream->ilenfile != NULL)
-          fprintf(stream->ilenfile, "%s\t0\tNA\n", gt_str_get(seqid));
+        if(stream->ilens != NULL)
+          locus_refine_stream_write_ilen(stream, seqid, 0, "NA");
         gt_feature_node_add_attribute(fn2, "liil", "0");
         gt_feature_node_add_attribute(fn2, "riil", "0");
         if(orig_liil)
@@ -549,11 +787,11 @@ static void locus_refine_stream_extend(AgnLocusRefineStream *stream,
       {
         gt_feature_node_add_attribute(fn1, "iiLocus_exception",
                                       "gene-overlap-gene");
-        if(stream->ilenfile != NULL) {
+        if(stream->ilens != NULL) {
           const char *orientstrs[] = { "FF", "FR", "RF", "RR" };
           int orient = agn_locus_inner_orientation(*gn1, *gn2);
-          fprintf(stream->ilenfile, "%s\t0\t%s\n", gt_str_get(seqid),
-                  orientstrs[orient]);
+          locus_refine_stream_write_ilen(stream, seqid, 0,
+                                         orientstrs[orient]);
         }
 
         if(orig_liil)
@@ -598,11 +836,11 @@ static void locus_refine_stream_extend(AgnLocusRefineStream *stream,
         GtUword genenum = agn_typecheck_count(origfn, agn_typecheck_gene);
         sprintf(exceptstr, "complex-overlap-%lu", genenum);
         gt_feature_node_add_attribute(fn, "iiLocus_exception", exceptstr);
-        if(stream->ilenfile != NULL)
+        if(stream->ilens != NULL)
         {
           GtUword k;
           for(k = 1; k < genenum; k++)
-            fprintf(stream->ilenfile, "%s\t0\tNA\n", gt_str_get(seqid));
+            locus_refine_stream_write_ilen(stream, seqid, 0, "NA");
         }
         if(orig_liil)
           gt_feature_node_set_attribute(fn, "liil", orig_liil);
@@ -645,6 +883,16 @@ static void locus_refine_stream_extend(AgnLocusRefineStream *stream,
   return;
 }
 
+static GtUword locus_refine_stream_find(RefineGene *genes, GtUword i)
+{
+  while(genes[i].parent != i)
+  {
+    genes[i].parent = genes[genes[i].parent].parent;
+    i = genes[i].parent;
+  }
+  return i;
+}
+
 static void locus_refine_stream_free(GtNodeStream *ns)
 {
   agn_assert(ns);
@@ -656,6 +904,33 @@ static void locus_refine_stream_free(GtNodeStream *ns)
   gt_queue_delete(stream->locusqueue);
   if(stream->cache != NULL)
     gt_genome_node_delete(stream->cache);
+  agn_type_counter_delete(stream->typecounter);
+}
+
+static int locus_refine_stream_gene_compare_range(const void *p1,
+                                                  const void *p2)
+{
+  const RefineGene *g1 = *(const RefineGene **)p1;
+  const RefineGene *g2 = *(const RefineGene **)p2;
+  if(g1->coding != g2->coding)
+    return g1->coding ? 1 : -1;
+  int result = gt_range_compare(&g1->range, &g2->range);
+  if(result == 0)
+    return g1->index < g2->index ? -1 : 1;
+  return result;
+}
+
+static int locus_refine_stream_gene_compare_span(const void *p1,
+                                                 const void *p2)
+{
+  const RefineGene *g1 = *(const RefineGene **)p1;
+  const RefineGene *g2 = *(const RefineGene **)p2;
+  if(g1->coding != g2->coding)
+    return g1->coding ? 1 : -1;
+  int result = gt_range_compare(&g1->span, &g2->span);
+  if(result == 0)
+    return g1->index < g2->index ? -1 : 1;
+  return result;
 }
 
 static int locus_refine_stream_handler(AgnLocusRefineStream *stream,
@@ -691,7 +966,8 @@ static int locus_refine_stream_handler(AgnLocusRefineStream *stream,
     return 0;
   }
 
-  GtArray *bins = locus_refine_stream_bin_features(stream, locus);
+  GtArray *bins = locus_refine_stream_bin_features(locus, stream->minoverlap,
+                                                   stream->by_cds);
   GtArray *iloci = locus_refine_stream_resolve_bins(stream, bins);
   locus_refine_stream_extend(stream, iloci, gn);
 
@@ -706,6 +982,23 @@ static int locus_refine_stream_handler(AgnLocusRefineStream *stream,
   return 0;
 }
 
+static bool locus_refine_stream_is_coding(GtFeatureNode *locus)
+{
+  bool coding = false;
+  GtFeatureNodeIterator *iter = gt_feature_node_iterator_new_direct(locus);
+  GtFeatureNode *gene;
+  for(gene = gt_feature_node_iterator_next(iter);
+      gene != NULL && !coding;
+      gene = gt_feature_node_iterator_next(iter))
+  {
+    AgnFeatureSummary summary;
+    agn_feature_node_get_summary(gene, &summary);
+    coding = summary.has_cds;
+  }
+  gt_feature_node_iterator_delete(iter);
+  return coding;
+}
+
 static void
 locus_refine_stream_mark_for_deletion(AgnLocusRefineStream *stream,
                                       GtGenomeNode *gn)
@@ -728,65 +1021,7 @@ static void locus_refine_stream_mint(AgnLocusRefineStream *stream,
     gt_feature_node_set_attribute((GtFeatureNode *)locus, "Name", locusname);
   }
 
-  GtArray *types = gt_array_new( sizeof(const char *) );
-  GtHashmap *countsbytype = gt_hashmap_new(GT_HASH_STRING, gt_free_func,
-                                           gt_free_func);
-  GtFeatureNode *feature;
-  GtFeatureNode *locusfn = (GtFeatureNode *)locus;
-  GtFeatureNodeIterator *iter = gt_feature_node_iterator_new_direct(locusfn);
-  for(feature  = gt_feature_node_iterator_next(iter);
-      feature != NULL;
-      feature  = gt_feature_node_iterator_next(iter))
-  {
-    const char *childtype = gt_feature_node_get_type(feature);
-    GtUword *num_of_type = gt_hashmap_get(countsbytype, childtype);
-    if(num_of_type == NULL)
-    {
-      char *type = gt_cstr_dup(childtype);
-      gt_array_add(types, type);
-      num_of_type = gt_malloc( sizeof(GtUword) );
-      (*num_of_type) = 0;
-      gt_hashmap_add(countsbytype, type, num_of_type);
-    }
-    (*num_of_type)++;
-
-    GtFeatureNodeIterator*
-      subiter = gt_feature_node_iterator_new_direct(feature);
-    GtFeatureNode *subfeature;
-    for(subfeature = gt_feature_node_iterator_next(subiter);
-        subfeature != NULL;
-        subfeature = gt_feature_node_iterator_next(subiter))
-    {
-      childtype = gt_feature_node_get_type(subfeature);
-      num_of_type = gt_hashmap_get(countsbytype, childtype);
-      if(num_of_type == NULL)
-      {
-        char *type = gt_cstr_dup(childtype);
-        gt_array_add(types, type);
-        num_of_type = gt_malloc( sizeof(GtUword) );
-        (*num_of_type) = 0;
-        gt_hashmap_add(countsbytype, type, num_of_type);
-      }
-      (*num_of_type)++;
-    }
-    gt_feature_node_iterator_delete(subiter);
-  }
-  gt_feature_node_iterator_delete(iter);
-
-  GtUword i;
-  for(i = 0; i < gt_array_size(types); i++)
-  {
-    const char **attrkey = gt_array_get(types, i);
-    GtUword *attrvalue = gt_hashmap_get(countsbytype, *attrkey);
-    char key[128];
-    char value[32];
-    sprintf(key, "child_%s", *attrkey);
-    sprintf(value, "%lu", *attrvalue);
-    gt_feature_node_set_attribute(locusfn, key, value);
-  }
-
-  gt_hashmap_delete(countsbytype);
-  gt_array_delete(types);
+  agn_type_counter_count_children(stream->typecounter, (GtFeatureNode *)locus);
 }
 
 static int locus_refine_stream_next(GtNodeStream *ns, GtGenomeNode **gn,
@@ -868,6 +1103,40 @@ static GtArray *locus_refine_stream_resolve_bins(AgnLocusRefineStream *stream,
   return iloci;
 }
 
+static AgnLocus *locus_refine_stream_synthetic_locus(GtUword numgenes,
+                                                     bool noncoding)
+{
+  GtStr *seqid = gt_str_new_cstr("chr");
+  AgnLocus *locus = agn_locus_new(seqid);
+  GtUword i;
+  for(i = 0; i < numgenes; i++)
+  {
+    GtUword start = 1001 + (i * 100);
+    GtUword end = start + 299;
+    GtGenomeNode *gene = gt_feature_node_new(seqid, "gene", start, end,
+                                             GT_STRAND_FORWARD);
+    GtGenomeNode *mrna = gt_feature_node_new(seqid, "mRNA", start, end,
+                                             GT_STRAND_FORWARD);
+    GtGenomeNode *cds = gt_feature_node_new(seqid, "CDS", start + 50, end - 50,
+                                            GT_STRAND_FORWARD);
+    gt_feature_node_add_child((GtFeatureNode *)mrna, (GtFeatureNode *)cds);
+    gt_feature_node_add_child((GtFeatureNode *)gene, (GtFeatureNode *)mrna);
+    agn_locus_add_feature(locus, (GtFeatureNode *)gene);
+
+    if(noncoding && i % 4 == 0)
+    {
+      gene = gt_feature_node_new(seqid, "gene", start + 10, start + 40,
+                                 GT_STRAND_REVERSE);
+      GtGenomeNode *ncrna = gt_feature_node_new(seqid, "ncRNA", start + 10,
+                                                start + 40, GT_STRAND_REVERSE);
+      gt_feature_node_add_child((GtFeatureNode *)gene, (GtFeatureNode *)ncrna);
+      agn_locus_add_feature(locus, (GtFeatureNode *)gene);
+    }
+  }
+  gt_str_delete(seqid);
+  return locus;
+}
+
 static void locus_refine_stream_test_data(const char *filename, GtQueue *queue,
                                           GtUword delta)
 {
@@ -928,3 +1197,26 @@ static void locus_refine_stream_test_data(const char *filename, GtQueue *queue,
   gt_error_delete(error);
   gt_array_delete(loci);
 }
+
+static void locus_refine_stream_union(RefineGene *genes, GtUword i,
+                                      GtUword j)
+{
+  GtUword rooti = locus_refine_stream_find(genes, i);
+  GtUword rootj = locus_refine_stream_find(genes, j);
+  if(rooti < rootj)
+    genes[rootj].parent = rooti;
+  else if(rootj < rooti)
+    genes[rooti].parent = rootj;
+}
+
+static void locus_refine_stream_write_ilen(AgnLocusRefineStream *stream,
+                                           GtStr *seqid, GtUword length,
+                                           const char *orientation)
+{
+  agn_output_sink_str(stream->ilens, seqid);
+  agn_output_sink_char(stream->ilens, '\t');
+  agn_output_sink_uword(stream->ilens, length);
+  agn_output_sink_char(stream->ilens, '\t');
+  agn_output_sink_cstr(stream->ilens, orientation);
+  agn_output_sink_char(stream->ilens, '\n');
+}
@@ -9,7 +9,10 @@ online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
 **/
 
 #include <string.h>
+#include <time.h>
 #include "core/queue_api.h"
+#include "extended/array_in_stream_api.h"
+#include "extended/array_out_stream_api.h"
 #include "extended/feature_index_memory_api.h"
 #include "extended/sort_stream_api.h"
 #include "AgnGeneStream.h"
@@ -17,6 +20,7 @@ online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
 #include "AgnLocusStream.h"
 #include "AgnLocus.h"
 #include "AgnTypecheck.h"
+#include "AgnTypeCounter.h"
 
 #define locus_stream_cast(GS)\
         gt_node_stream_cast(locus_stream_class(), GS)
@@ -25,6 +29,16 @@ online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
 // Data structure definition
 //------------------------------------------------------------------------------
 
+/**
+ * The range of a sequence as declared by its region node(s), and whether any
+ * locus has been reported for the sequence.
+ */
+typedef struct
+{
+  GtRange range;
+  bool annotated;
+} LocusSequence;
+
 struct AgnLocusStream
 {
   const GtNodeStream parent_instance;
@@ -33,15 +47,20 @@ struct AgnLocusStream
   GtUword count;
   bool skip_iiLoci;
   int endmode;
-  GtFeatureIndex *seqranges;
+  GtHashmap *seqranges;
+  GtArray *seqorder;
+  GtUword seqnext;
   AgnLocus *prev_locus;
   GtQueue *locusqueue;
   GtGenomeNode *buffer;
   GtStr *source;
   GtStr *nameformat;
   char *refrfile;
-  char *predfile;
-  FILE *ilenfile;
+  GtStrArray *predfiles;
+  bool predsets;
+  AgnOutputSink *ilens;
+  bool allpairs;
+  AgnTypeCounter *typecounter;
 };
 
 //------------------------------------------------------------------------------
@@ -66,7 +85,8 @@ static void locus_stream_extend(AgnLocusStream *stream, AgnLocus *locus);
 
 /**
  * @function Callback function: collect overlapping top-level features into
- * distinct interval loci.
+ * distinct interval loci. On sorted input each feature is tested against the
+ * running span of the current locus rather than against each of its features.
  */
 static int locus_stream_fn_handler(AgnLocusStream *stream, GtGenomeNode **gn,
                                    GtError *error);
@@ -89,12 +109,50 @@ static int locus_stream_next(GtNodeStream *ns, GtGenomeNode **gn,
                              GtError *error);
 
 /**
- * @function Callback function: store region nodes in a feature index to enable
- * computing end locus coordinates correctly.
+ * @function Determine whether ``feature`` overlaps any of the features
+ * collected so far in ``current_locus``. ``sweep`` holds the largest start and
+ * end coordinates of those features: if ``feature`` starts no earlier than
+ * every one of them (as is the case for sorted input), it overlaps one of them
+ * if and only if it starts at or before the largest end coordinate. Otherwise
+ * (or if the stream is configured to do so for benchmarking) every feature in
+ * the locus is checked.
+ */
+static bool locus_stream_overlap(AgnLocusStream *stream, GtArray *current_locus,
+                                 GtRange *sweep, GtGenomeNode *feature);
+
+/**
+ * @function Build a synthetic pathological cluster: a region node followed by
+ * a chain of ``numgenes`` genes in which each gene overlaps only its neighbors,
+ * and then a single isolated gene. Run it through a locus stream (with the
+ * same delta LocusPocus uses by default) and store the range of each output
+ * node in ``ranges``. Returns the elapsed time in seconds.
+ */
+static double locus_stream_pathological_run(GtUword numgenes, bool allpairs,
+                                             GtArray *ranges);
+
+/**
+ * @function Callback function: record the range of each sequence, in the order
+ * the region nodes are encountered, to enable computing end locus coordinates
+ * correctly and reporting sequences with no features.
  */
 static int locus_stream_rn_handler(AgnLocusStream *stream, GtGenomeNode **gn,
                                    GtError *error);
 
+/**
+ * @function Add the coordinates of ``feature`` to the running ``sweep`` span
+ * of the current locus, which contains ``size`` features before the addition.
+ */
+static void locus_stream_sweep(GtRange *sweep, GtGenomeNode *feature,
+                               GtUword size);
+
+/**
+ * @function Mark the sequence ``seqid`` as annotated and enqueue a fiLocus
+ * spanning each sequence declared before it that has not received any
+ * features. With ``seqid == NULL`` (end of input), do so for all remaining
+ * sequences.
+ */
+static void locus_stream_unannotated(AgnLocusStream *stream, GtStr *seqid);
+
 /**
  * @function Load data from the following file(s) for unit testing.
  */
@@ -118,10 +176,76 @@ static void locus_stream_unit_test_iloci(AgnUnitTest *test);
  */
 static void locus_stream_unit_test_loci(AgnUnitTest *test);
 
+/**
+ * @function Run unit tests for sequences with no features.
+ */
+static void locus_stream_unit_test_unannotated(AgnUnitTest *test);
+
+/**
+ * @function Write one row of iLocus length output: the sequence ID, length, and
+ * orientation of the flanking genes.
+ */
+static void locus_stream_write_ilen(AgnLocusStream *stream, GtStr *seqid,
+                                    GtUword length, const char *orientation);
+
 //------------------------------------------------------------------------------
 // Method definitions
 //------------------------------------------------------------------------------
 
+bool agn_locus_stream_benchmark(AgnUnitTest *test)
+{
+  GtUword sizes[] = { 12500, 25000, 50000, 100000 };
+  GtUword i, j;
+  for(i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+  {
+    char label[64];
+    GtArray *ranges = gt_array_new( sizeof(GtRange) );
+    double sweeptime = locus_stream_pathological_run(sizes[i], false, ranges);
+    bool grouped = gt_array_size(ranges) == 5;
+    sprintf(label, "pathological cluster, %lu genes", sizes[i]);
+    agn_unit_test_result(test, label, grouped);
+
+    // The all-pairs reference is quadratic; time it only on smaller clusters.
+    if(sizes[i] > 50000)
+    {
+      printf("        [locus grouping] %6lu genes: all-pairs skipped, sweep "
+             "%.3fs\n", sizes[i], sweeptime);
+      gt_array_delete(ranges);
+      continue;
+    }
+
+    GtArray *refranges = gt_array_new( sizeof(GtRange) );
+    double reftime = locus_stream_pathological_run(sizes[i], true, refranges);
+    bool identical = gt_array_size(ranges) == gt_array_size(refranges);
+    for(j = 0; identical && j < gt_array_size(ranges); j++)
+    {
+      GtRange *r1 = gt_array_get(ranges, j);
+      GtRange *r2 = gt_array_get(refranges, j);
+      identical = gt_range_compare(r1, r2) == 0;
+    }
+    printf("        [locus grouping] %6lu genes: all-pairs %.3fs, sweep %.3fs "
+           "(%.1fx)\n", sizes[i], reftime, sweeptime,
+           sweeptime > 0.0 ? reftime / sweeptime : 0.0);
+    sprintf(label, "identical loci, %lu genes", sizes[i]);
+    agn_unit_test_result(test, label, identical);
+    gt_array_delete(ranges);
+    gt_array_delete(refranges);
+  }
+  return agn_unit_test_success(test);
+}
+
+void agn_locus_stream_label_multi(AgnLocusStream *stream,
+                                  const char *refrfile, GtUword numpredfiles,
+                                  const char **predfiles)
+{
+  GtUword i;
+  agn_assert(stream && numpredfiles > 0);
+  agn_locus_stream_label_pairwise(stream, refrfile, predfiles[0]);
+  for(i = 1; i < numpredfiles; i++)
+    gt_str_array_add_cstr(stream->predfiles, predfiles[i]);
+  stream->predsets = true;
+}
+
 void agn_locus_stream_label_pairwise(AgnLocusStream *stream,
                                      const char *refrfile, const char *predfile)
 {
@@ -129,9 +253,9 @@ void agn_locus_stream_label_pairwise(AgnLocusStream *stream,
   if(stream->refrfile != NULL)
     gt_free(stream->refrfile);
   stream->refrfile = gt_cstr_dup(refrfile);
-  if(stream->predfile != NULL)
-    gt_free(stream->predfile);
-  stream->predfile = gt_cstr_dup(predfile);
+  gt_str_array_reset(stream->predfiles);
+  gt_str_array_add_cstr(stream->predfiles, predfile);
+  stream->predsets = false;
 }
 
 GtNodeStream *agn_locus_stream_new(GtNodeStream *in_stream, GtUword delta)
@@ -143,15 +267,21 @@ GtNodeStream *agn_locus_stream_new(GtNodeStream *in_stream, GtUword delta)
   stream->count = 0;
   stream->skip_iiLoci = false;
   stream->endmode = 0;
-  stream->seqranges = gt_feature_index_memory_new();
+  stream->seqranges = gt_hashmap_new(GT_HASH_STRING, gt_free_func,
+                                     gt_free_func);
+  stream->seqorder = gt_array_new( sizeof(const char *) );
+  stream->seqnext = 0;
   stream->prev_locus = NULL;
   stream->locusqueue = gt_queue_new();
   stream->buffer = NULL;
   stream->source = gt_str_new_cstr("AEGeAn::AgnLocusStream");
   stream->nameformat = NULL;
   stream->refrfile = NULL;
-  stream->predfile = NULL;
-  stream->ilenfile = NULL;
+  stream->predfiles = gt_str_array_new();
+  stream->predsets = false;
+  stream->ilens = NULL;
+  stream->allpairs = false;
+  stream->typecounter = agn_type_counter_new();
   return ns;
 }
 
@@ -186,12 +316,14 @@ bool agn_locus_stream_unit_test(AgnUnitTest *test)
 {
   locus_stream_unit_test_loci(test);
   locus_stream_unit_test_iloci(test);
+  locus_stream_unit_test_unannotated(test);
   return agn_unit_test_success(test);
 }
 
-void agn_locus_stream_track_ilens(AgnLocusStream *stream, FILE *ilenfile)
+void agn_locus_stream_track_ilens(AgnLocusStream *stream,
+                                  AgnOutputSink *ilens)
 {
-  stream->ilenfile = ilenfile;
+  stream->ilens = ilens;
 }
 
 static int locus_stream_add_feature(AgnLocusStream *stream, AgnLocus *locus,
@@ -205,9 +337,17 @@ static int locus_stream_add_feature(AgnLocusStream *stream, AgnLocus *locus,
   else
   {
     const char * filename = gt_genome_node_get_filename((GtGenomeNode*)feature);
+    GtUword i, numpredfiles = gt_str_array_size(stream->predfiles);
+    for(i = 0; i < numpredfiles; i++)
+    {
+      if(strcmp(filename, gt_str_array_get(stream->predfiles, i)) == 0)
+        break;
+    }
     if(strcmp(filename, stream->refrfile) == 0)
       agn_locus_add_refr_feature(locus, feature);
-    else if(strcmp(filename, stream->predfile) == 0)
+    else if(i < numpredfiles && stream->predsets)
+      agn_locus_add_pred_set_feature(locus, feature, i);
+    else if(i < numpredfiles)
       agn_locus_add_pred_feature(locus, feature);
     else
     {
@@ -247,9 +387,10 @@ static void locus_stream_extend(AgnLocusStream *stream, AgnLocus *locus)
   agn_assert(stream && locus);
   GtStr *seqid = gt_genome_node_get_seqid(locus);
   GtRange locusrange = gt_genome_node_get_range(locus);
-  GtRange seqrange;
-  gt_feature_index_get_range_for_seqid(stream->seqranges, &seqrange,
-                                       gt_str_get(seqid), NULL);
+  LocusSequence *sequence = gt_hashmap_get(stream->seqranges,
+                                           gt_str_get(seqid));
+  agn_assert(sequence != NULL);
+  GtRange seqrange = sequence->range;
   GtStr *prev_seqid = NULL;
   if(stream->prev_locus)
     prev_seqid = gt_genome_node_get_seqid(stream->prev_locus);
@@ -257,6 +398,7 @@ static void locus_stream_extend(AgnLocusStream *stream, AgnLocus *locus)
   // Handle initial loci
   if(stream->prev_locus == NULL || gt_str_cmp(seqid, prev_seqid) != 0)
   {
+    locus_stream_unannotated(stream, seqid);
     if(locusrange.start >= seqrange.start + (2*stream->delta))
     {
       agn_locus_set_range(locus, locusrange.start - stream->delta,
@@ -307,9 +449,8 @@ static void locus_stream_extend(AgnLocusStream *stream, AgnLocus *locus)
       gt_feature_node_add_attribute(prevfn, "iiLocus_exception",
                                     "delta-overlap-gene");
 
-      if(stream->ilenfile != NULL) {
-        fprintf(stream->ilenfile, "%s\t0\t%s\n", gt_str_get(seqid),
-                orientstrs[orient]);
+      if(stream->ilens != NULL) {
+        locus_stream_write_ilen(stream, seqid, 0, orientstrs[orient]);
       }
       gt_feature_node_add_attribute(prevfn, "riil", "0");
       gt_feature_node_add_attribute(locusfn, "liil", "0");
@@ -331,9 +472,8 @@ static void locus_stream_extend(AgnLocusStream *stream, AgnLocus *locus)
       gt_feature_node_add_attribute(prevfn, "iiLocus_exception",
                                     "delta-overlap-delta");
 
-      if(stream->ilenfile != NULL) {
-        fprintf(stream->ilenfile, "%s\t0\t%s\n", gt_str_get(seqid),
-                orientstrs[orient]);
+      if(stream->ilens != NULL) {
+        locus_stream_write_ilen(stream, seqid, 0, orientstrs[orient]);
       }
       gt_feature_node_add_attribute(prevfn, "riil", "0");
       gt_feature_node_add_attribute(locusfn, "liil", "0");
@@ -346,9 +486,8 @@ static void locus_stream_extend(AgnLocusStream *stream, AgnLocus *locus)
       gt_feature_node_add_attribute(prevfn, "iiLocus_exception",
                                     "delta-re-extend");
 
-      if(stream->ilenfile != NULL) {
-        fprintf(stream->ilenfile, "%s\t0\t%s\n", gt_str_get(seqid),
-                orientstrs[orient]);
+      if(stream->ilens != NULL) {
+        locus_stream_write_ilen(stream, seqid, 0, orientstrs[orient]);
       }
       gt_feature_node_add_attribute(prevfn, "riil", "0");
       gt_feature_node_add_attribute(locusfn, "liil", "0");
@@ -369,9 +508,9 @@ static void locus_stream_extend(AgnLocusStream *stream, AgnLocus *locus)
                            locusrange.start - stream->delta - 1 };
         agn_locus_set_range(iilocus, irange.start, irange.end);
 
-        if(stream->ilenfile != NULL) {
-          fprintf(stream->ilenfile, "%s\t%lu\t%s\n", gt_str_get(seqid),
-                  gt_range_length(&irange), orientstrs[orient]);
+        if(stream->ilens != NULL) {
+          locus_stream_write_ilen(stream, seqid, gt_range_length(&irange),
+                                  orientstrs[orient]);
         }
         char iilocuslen[32];
         sprintf(iilocuslen, "%lu", gt_range_length(&irange));
@@ -386,12 +525,12 @@ static void locus_stream_extend(AgnLocusStream *stream, AgnLocus *locus)
       }
     }
 
-    if (stream->ilenfile != NULL) {
+    if (stream->ilens != NULL) {
       GtUword genenum = agn_typecheck_count(locusfn, agn_typecheck_gene);
       if (genenum > 1) {
         GtUword k;
         for (k = 1; k < genenum; k++) {
-          fprintf(stream->ilenfile, "%s\t0\tNA\n", gt_str_get(seqid));
+          locus_stream_write_ilen(stream, seqid, 0, "NA");
         }
       }
     }
@@ -435,8 +574,10 @@ static int locus_stream_fn_handler(AgnLocusStream *stream, GtGenomeNode **gn,
   agn_assert(stream && gn && error);
 
   GtArray *current_locus = gt_array_new( sizeof(GtFeatureNode *) );
+  GtRange sweep = { 0, 0 };
   if(stream->buffer != NULL)
   {
+    locus_stream_sweep(&sweep, stream->buffer, 0);
     gt_array_add(current_locus, stream->buffer);
     stream->buffer = NULL;
   }
@@ -459,19 +600,13 @@ static int locus_stream_fn_handler(AgnLocusStream *stream, GtGenomeNode **gn,
       break;
     }
 
-    GtUword i;
-    bool overlap = false;
-    for(i = 0; i < gt_array_size(current_locus); i++)
-    {
-      GtGenomeNode **oldfeature = gt_array_get(current_locus, i);
-      if(agn_overlap_ilocus(*gn, *oldfeature, 1, false))
-      {
-        overlap = true;
-        break;
-      }
-    }
-    if(overlap || gt_array_size(current_locus) == 0)
+    // Each gene is summarized as it enters the stream, so that overlap tests
+    // here and in refinement do not traverse its subfeatures again
+    agn_feature_node_summarize((GtFeatureNode *)*gn);
+    GtUword size = gt_array_size(current_locus);
+    if(size == 0 || locus_stream_overlap(stream, current_locus, &sweep, *gn))
     {
+      locus_stream_sweep(&sweep, *gn, size);
       gt_array_add(current_locus, *gn);
       again = true;
     }
@@ -490,6 +625,8 @@ static int locus_stream_fn_handler(AgnLocusStream *stream, GtGenomeNode **gn,
     GtGenomeNode **rep = gt_array_get(current_locus, 0);
     GtStr *seqid = gt_genome_node_get_seqid(*rep);
     AgnLocus *locus = agn_locus_new(seqid);
+    if(stream->predsets)
+      agn_locus_set_num_pred_sets(locus, gt_str_array_size(stream->predfiles));
     while(gt_array_size(current_locus) > 0)
     {
       GtFeatureNode **fn = gt_array_pop(current_locus);
@@ -521,13 +658,15 @@ static void locus_stream_free(GtNodeStream *ns)
   agn_assert(ns);
   AgnLocusStream *stream = locus_stream_cast(ns);
   gt_node_stream_delete(stream->in_stream);
-  gt_feature_index_delete(stream->seqranges);
+  gt_array_delete(stream->seqorder);
+  gt_hashmap_delete(stream->seqranges);
   gt_queue_delete(stream->locusqueue);
   gt_str_delete(stream->source);
   if(stream->nameformat)
     gt_str_delete(stream->nameformat);
   gt_free(stream->refrfile);
-  gt_free(stream->predfile);
+  gt_str_array_delete(stream->predfiles);
+  agn_type_counter_delete(stream->typecounter);
 }
 
 static void locus_stream_mint(AgnLocusStream *stream, AgnLocus *locus)
@@ -543,65 +682,7 @@ static void locus_stream_mint(AgnLocusStream *stream, AgnLocus *locus)
     gt_feature_node_set_attribute((GtFeatureNode *)locus, "Name", locusname);
   }
 
-  GtArray *types = gt_array_new( sizeof(const char *) );
-  GtHashmap *countsbytype = gt_hashmap_new(GT_HASH_STRING, gt_free_func,
-                                           gt_free_func);
-  GtFeatureNode *feature;
-  GtFeatureNode *locusfn = (GtFeatureNode *)locus;
-  GtFeatureNodeIterator *iter = gt_feature_node_iterator_new_direct(locusfn);
-  for(feature  = gt_feature_node_iterator_next(iter);
-      feature != NULL;
-      feature  = gt_feature_node_iterator_next(iter))
-  {
-    const char *childtype = gt_feature_node_get_type(feature);
-    GtUword *num_of_type = gt_hashmap_get(countsbytype, childtype);
-    if(num_of_type == NULL)
-    {
-      char *type = gt_cstr_dup(childtype);
-      gt_array_add(types, type);
-      num_of_type = gt_malloc( sizeof(GtUword) );
-      (*num_of_type) = 0;
-      gt_hashmap_add(countsbytype, type, num_of_type);
-    }
-    (*num_of_type)++;
-
-    GtFeatureNodeIterator*
-      subiter = gt_feature_node_iterator_new_direct(feature);
-    GtFeatureNode *subfeature;
-    for(subfeature = gt_feature_node_iterator_next(subiter);
-        subfeature != NULL;
-        subfeature = gt_feature_node_iterator_next(subiter))
-    {
-      childtype = gt_feature_node_get_type(subfeature);
-      num_of_type = gt_hashmap_get(countsbytype, childtype);
-      if(num_of_type == NULL)
-      {
-        char *type = gt_cstr_dup(childtype);
-        gt_array_add(types, type);
-        num_of_type = gt_malloc( sizeof(GtUword) );
-        (*num_of_type) = 0;
-        gt_hashmap_add(countsbytype, type, num_of_type);
-      }
-      (*num_of_type)++;
-    }
-    gt_feature_node_iterator_delete(subiter);
-  }
-  gt_feature_node_iterator_delete(iter);
-
-  GtUword i;
-  for(i = 0; i < gt_array_size(types); i++)
-  {
-    const char **attrkey = gt_array_get(types, i);
-    GtUword *attrvalue = gt_hashmap_get(countsbytype, *attrkey);
-    char key[128];
-    char value[32];
-    sprintf(key, "child_%s", *attrkey);
-    sprintf(value, "%lu", *attrvalue);
-    gt_feature_node_set_attribute(locusfn, key, value);
-  }
-
-  gt_hashmap_delete(countsbytype);
-  gt_array_delete(types);
+  agn_type_counter_count_children(stream->typecounter, (GtFeatureNode *)locus);
 }
 
 static int locus_stream_next(GtNodeStream *ns, GtGenomeNode **gn,
@@ -637,8 +718,18 @@ static int locus_stream_next(GtNodeStream *ns, GtGenomeNode **gn,
   }
 
   int result = gt_node_stream_next(stream->in_stream, gn, error);
-  if(result || !*gn)
+  if(result)
     return result;
+  if(!*gn)
+  {
+    locus_stream_unannotated(stream, NULL);
+    if(gt_queue_size(stream->locusqueue) > 0)
+    {
+      *gn = gt_queue_get(stream->locusqueue);
+      locus_stream_mint(stream, *gn);
+    }
+    return 0;
+  }
 
   if(gt_feature_node_try_cast(*gn))
     return locus_stream_fn_handler(stream, gn, error);
@@ -649,12 +740,127 @@ static int locus_stream_next(GtNodeStream *ns, GtGenomeNode **gn,
   return 0;
 }
 
+static bool locus_stream_overlap(AgnLocusStream *stream, GtArray *current_locus,
+                                 GtRange *sweep, GtGenomeNode *feature)
+{
+  agn_assert(stream && current_locus && sweep && feature);
+  agn_assert(gt_array_size(current_locus) > 0);
+
+  GtRange range = gt_genome_node_get_range(feature);
+  if(!stream->allpairs && range.start >= sweep->start)
+  {
+    GtGenomeNode **rep = gt_array_get(current_locus, 0);
+    GtStr *seqid = gt_genome_node_get_seqid(*rep);
+    GtStr *featseqid = gt_genome_node_get_seqid(feature);
+    if(seqid != featseqid && gt_str_cmp(seqid, featseqid) != 0)
+      return false;
+    return range.start <= sweep->end;
+  }
+
+  GtUword i;
+  for(i = 0; i < gt_array_size(current_locus); i++)
+  {
+    GtGenomeNode **oldfeature = gt_array_get(current_locus, i);
+    if(agn_overlap_ilocus(feature, *oldfeature, 1, false))
+      return true;
+  }
+  return false;
+}
+
+static double locus_stream_pathological_run(GtUword numgenes, bool allpairs,
+                                            GtArray *ranges)
+{
+  GtUword i, progress;
+  GtError *error = gt_error_new();
+  GtStr *seqid = gt_str_new_cstr("chr");
+  GtArray *source = gt_array_new( sizeof(GtGenomeNode *) );
+  GtArray *sink = gt_array_new( sizeof(GtGenomeNode *) );
+
+  GtUword seqlength = (numgenes * 100) + 5000;
+  GtGenomeNode *gn = gt_region_node_new(seqid, 1, seqlength);
+  gt_array_add(source, gn);
+  for(i = 0; i < numgenes; i++)
+  {
+    GtUword start = 1001 + (i * 100);
+    gn = gt_feature_node_new(seqid, "gene", start, start + 149,
+                             GT_STRAND_FORWARD);
+    gt_array_add(source, gn);
+  }
+  gn = gt_feature_node_new(seqid, "gene", seqlength - 2000, seqlength - 1500,
+                           GT_STRAND_REVERSE);
+  gt_array_add(source, gn);
+
+  GtNodeStream *ais = gt_array_in_stream_new(source, &progress, error);
+  GtNodeStream *ls = agn_locus_stream_new(ais, 500);
+  AgnLocusStream *stream = locus_stream_cast(ls);
+  stream->allpairs = allpairs;
+  GtNodeStream *aos = gt_array_out_stream_new(ls, sink, error);
+
+  clock_t start = clock();
+  int result = gt_node_stream_pull(aos, error);
+  clock_t end = clock();
+  if(result)
+  {
+    fprintf(stderr, "[AgnLocusStream::locus_stream_pathological_run] error "
+            "processing synthetic cluster: %s\n", gt_error_get(error));
+  }
+
+  for(i = 0; i < gt_array_size(sink); i++)
+  {
+    GtGenomeNode **node = gt_array_get(sink, i);
+    if(gt_feature_node_try_cast(*node))
+    {
+      GtRange range = gt_genome_node_get_range(*node);
+      gt_array_add(ranges, range);
+    }
+    gt_genome_node_delete(*node);
+  }
+
+  gt_node_stream_delete(aos);
+  gt_node_stream_delete(ls);
+  gt_node_stream_delete(ais);
+  gt_array_delete(source);
+  gt_array_delete(sink);
+  gt_str_delete(seqid);
+  gt_error_delete(error);
+  return (double)(end - start) / CLOCKS_PER_SEC;
+}
+
 static int locus_stream_rn_handler(AgnLocusStream *stream, GtGenomeNode **gn,
                                    GtError *error)
 {
   agn_assert(stream && gn && error);
-  GtRegionNode *rn = gt_region_node_cast(*gn);
-  return gt_feature_index_add_region_node(stream->seqranges, rn, error);
+  const char *seqid = gt_str_get(gt_genome_node_get_seqid(*gn));
+  GtRange range = gt_genome_node_get_range(*gn);
+  LocusSequence *sequence = gt_hashmap_get(stream->seqranges, seqid);
+  if(sequence == NULL)
+  {
+    char *key = gt_cstr_dup(seqid);
+    sequence = gt_malloc( sizeof(LocusSequence) );
+    sequence->range = range;
+    sequence->annotated = false;
+    gt_hashmap_add(stream->seqranges, key, sequence);
+    gt_array_add(stream->seqorder, key);
+  }
+  else
+    sequence->range = gt_range_join(&sequence->range, &range);
+  return 0;
+}
+
+static void locus_stream_sweep(GtRange *sweep, GtGenomeNode *feature,
+                               GtUword size)
+{
+  agn_assert(sweep && feature);
+  GtRange range = gt_genome_node_get_range(feature);
+  if(size == 0)
+  {
+    *sweep = range;
+    return;
+  }
+  if(range.start > sweep->start)
+    sweep->start = range.start;
+  if(range.end > sweep->end)
+    sweep->end = range.end;
 }
 
 static void locus_stream_test_data(GtQueue *queue, int numfiles,
@@ -752,6 +958,48 @@ static GtNodeStream *locus_stream_test_data2(GtFeatureIndex *iloci,
   return fstream;
 }
 
+static void locus_stream_unannotated(AgnLocusStream *stream, GtStr *seqid)
+{
+  agn_assert(stream);
+  GtUword i, last = gt_array_size(stream->seqorder);
+  if(seqid != NULL)
+  {
+    LocusSequence *sequence = gt_hashmap_get(stream->seqranges,
+                                             gt_str_get(seqid));
+    if(sequence != NULL)
+      sequence->annotated = true;
+    for(i = stream->seqnext; i < gt_array_size(stream->seqorder); i++)
+    {
+      const char **regionseqid = gt_array_get(stream->seqorder, i);
+      if(strcmp(*regionseqid, gt_str_get(seqid)) == 0)
+        break;
+    }
+    if(i == gt_array_size(stream->seqorder))
+      return;
+    last = i;
+  }
+
+  bool report = stream->delta > 0 && stream->endmode >= 0 &&
+                !stream->skip_iiLoci;
+  for(i = stream->seqnext; i < last; i++)
+  {
+    const char **regionseqid = gt_array_get(stream->seqorder, i);
+    LocusSequence *sequence = gt_hashmap_get(stream->seqranges, *regionseqid);
+    if(sequence->annotated || !report)
+      continue;
+
+    GtStr *filocusseqid = gt_str_new_cstr(*regionseqid);
+    AgnLocus *filocus = agn_locus_new(filocusseqid);
+    agn_locus_set_range(filocus, sequence->range.start, sequence->range.end);
+    gt_feature_node_add_attribute((GtFeatureNode *)filocus, "unannot", "true");
+    gt_genome_node_add_user_data(filocus, "iLocus_type",
+                                 gt_cstr_dup("fiLocus"), gt_free_func);
+    gt_queue_add(stream->locusqueue, filocus);
+    gt_str_delete(filocusseqid);
+  }
+  stream->seqnext = seqid == NULL ? last : last + 1;
+}
+
 static void locus_stream_unit_test_iloci(AgnUnitTest *test)
 {
   GtFeatureIndex *iloci = gt_feature_index_memory_new();
@@ -880,3 +1128,82 @@ static void locus_stream_unit_test_loci(AgnUnitTest *test)
 
   gt_queue_delete(queue);
 }
+
+static void locus_stream_unit_test_unannotated(AgnUnitTest *test)
+{
+  const char *seqids[] = { "chrA", "chrB", "chrC", "chrD" };
+  GtUword seqlens[] = { 5000, 8000, 3000, 2000 };
+  const char *expseqids[] = { "chrA", "chrB", "chrB", "chrB", "chrC", "chrD" };
+  GtUword expstarts[] = {    1,    1, 2801, 4201,    1,    1 };
+  GtUword expends[]   = { 5000, 2800, 4200, 8000, 3000, 2000 };
+  bool expunannot[] = { true, false, false, false, true, true };
+
+  int endmode;
+  for(endmode = 0; endmode >= -1; endmode--)
+  {
+    GtUword i, j, progress;
+    GtError *error = gt_error_new();
+    GtArray *source = gt_array_new( sizeof(GtGenomeNode *) );
+    GtArray *sink = gt_array_new( sizeof(GtGenomeNode *) );
+    for(i = 0; i < 4; i++)
+    {
+      GtStr *seqid = gt_str_new_cstr(seqids[i]);
+      GtGenomeNode *gn = gt_region_node_new(seqid, 1, seqlens[i]);
+      gt_array_add(source, gn);
+      gt_str_delete(seqid);
+    }
+    GtStr *seqid = gt_str_new_cstr("chrB");
+    GtGenomeNode *gn = gt_feature_node_new(seqid, "gene", 3001, 4000,
+                                           GT_STRAND_FORWARD);
+    gt_array_add(source, gn);
+    gt_str_delete(seqid);
+
+    GtNodeStream *ais = gt_array_in_stream_new(source, &progress, error);
+    GtNodeStream *ls = agn_locus_stream_new(ais, 200);
+    agn_locus_stream_set_endmode((AgnLocusStream *)ls, endmode);
+    GtNodeStream *aos = gt_array_out_stream_new(ls, sink, error);
+    bool success = gt_node_stream_pull(aos, error) == 0;
+
+    // Without terminal iLoci, only the gene's iLocus is reported
+    GtUword numexpected = endmode == 0 ? 6 : 1;
+    for(i = 0, j = 0; i < gt_array_size(sink); i++)
+    {
+      GtGenomeNode **node = gt_array_get(sink, i);
+      GtFeatureNode *fn = gt_feature_node_try_cast(*node);
+      if(fn != NULL)
+      {
+        GtUword k = endmode == 0 ? j : 2;
+        GtRange range = gt_genome_node_get_range(*node);
+        const char *unannot = gt_feature_node_get_attribute(fn, "unannot");
+        success = success && j < numexpected &&
+                  strcmp(gt_str_get(gt_genome_node_get_seqid(*node)),
+                         expseqids[k]) == 0 &&
+                  range.start == expstarts[k] && range.end == expends[k] &&
+                  (unannot != NULL) == expunannot[k];
+        j++;
+      }
+      gt_genome_node_delete(*node);
+    }
+    success = success && j == numexpected;
+    agn_unit_test_result(test, endmode == 0 ? "unannotated sequences" :
+                         "unannotated sequences (skip ends)", success);
+
+    gt_node_stream_delete(aos);
+    gt_node_stream_delete(ls);
+    gt_node_stream_delete(ais);
+    gt_array_delete(source);
+    gt_array_delete(sink);
+    gt_error_delete(error);
+  }
+}
+
+static void locus_stream_write_ilen(AgnLocusStream *stream, GtStr *seqid,
+                                    GtUword length, const char *orientation)
+{
+  agn_output_sink_str(stream->ilens, seqid);
+  agn_output_sink_char(stream->ilens, '\t');
+  agn_output_sink_uword(stream->ilens, length);
+  agn_output_sink_char(stream->ilens, '\t');
+  agn_output_sink_cstr(stream->ilens, orientation);
+  agn_output_sink_char(stream->ilens, '\n');
+}
@@ -0,0 +1,416 @@
+/**
+
+Copyright (c) 2010-2014, Daniel S. Standage and CONTRIBUTORS
+
+The AEGeAn Toolkit is distributed under the ISC License. See
+the 'LICENSE' file in the AEGeAn source code distribution or
+online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
+
+**/
+#include <string.h>
+#include "extended/array_in_stream_api.h"
+#include "extended/sort_stream_api.h"
+#include "AgnMergeStream.h"
+#include "AgnUtils.h"
+
+#define merge_stream_cast(GS)\
+        gt_node_stream_cast(merge_stream_class(), GS)
+
+//------------------------------------------------------------------------------
+// Data structure definitions
+//------------------------------------------------------------------------------
+
+/**
+ * One of the streams being merged, along with the next node it has provided
+ * (if any) and the position of the last feature it provided.
+ */
+typedef struct
+{
+  GtNodeStream *stream;
+  GtGenomeNode *head;
+  GtStr *seqid;
+  GtUword start;
+  bool done;
+} MergeInput;
+
+struct AgnMergeStream
+{
+  const GtNodeStream parent_instance;
+  GtArray *inputs;
+};
+
+
+//------------------------------------------------------------------------------
+// Prototypes for private functions
+//------------------------------------------------------------------------------
+
+/**
+ * @function Implements the GtNodeStream interface for this class.
+ */
+static const GtNodeStreamClass* merge_stream_class(void);
+
+/**
+ * @function Each input file declares its own sequence regions; when two inputs
+ * have a region for the same sequence waiting, join them into one. Returns
+ * true if any regions were joined.
+ */
+static bool merge_stream_consolidate(AgnMergeStream *stream);
+
+/**
+ * @function Pull the next node from the given input, checking that it does not
+ * precede the last feature pulled from the same input.
+ */
+static int merge_stream_fill(MergeInput *input, GtError *error);
+
+/**
+ * @function Class destructor.
+ */
+static void merge_stream_free(GtNodeStream *ns);
+
+/**
+ * @function Delivers the next node in sorted order from among the inputs.
+ */
+static int merge_stream_next(GtNodeStream *ns, GtGenomeNode **gn,
+                             GtError *error);
+
+/**
+ * @function Pull nodes from the given stream into an array, and return the
+ * stream's status.
+ */
+static int merge_stream_test_pull(GtNodeStream *ns, GtArray *nodes,
+                                  GtError *error);
+
+
+//------------------------------------------------------------------------------
+// Method implementations
+//------------------------------------------------------------------------------
+
+GtNodeStream* agn_merge_stream_new(GtArray *in_streams)
+{
+  GtNodeStream *ns;
+  AgnMergeStream *stream;
+  agn_assert(in_streams && gt_array_size(in_streams) > 0);
+  ns = gt_node_stream_create(merge_stream_class(), true);
+  stream = merge_stream_cast(ns);
+  stream->inputs = gt_array_new( sizeof(MergeInput) );
+  GtUword i;
+  for(i = 0; i < gt_array_size(in_streams); i++)
+  {
+    GtNodeStream *in_stream = *(GtNodeStream **)gt_array_get(in_streams, i);
+    MergeInput input = { gt_node_stream_ref(in_stream), NULL, NULL, 0, false };
+    gt_array_add(stream->inputs, input);
+  }
+  return ns;
+}
+
+GtNodeStream* agn_merge_stream_new_gff3(int numfiles, const char **filenames)
+{
+  GtArray *in_streams = gt_array_new( sizeof(GtNodeStream *) );
+  int i, numstreams = numfiles > 0 ? numfiles : 1;
+  for(i = 0; i < numstreams; i++)
+  {
+    const char *filename = numfiles > 0 ? filenames[i] : NULL;
+    GtNodeStream *gff3 = gt_gff3_in_stream_new_sorted(filename);
+    gt_gff3_in_stream_check_id_attributes((GtGFF3InStream *)gff3);
+    gt_gff3_in_stream_enable_tidy_mode((GtGFF3InStream *)gff3);
+    gt_array_add(in_streams, gff3);
+  }
+
+  GtNodeStream *ns = agn_merge_stream_new(in_streams);
+  while(gt_array_size(in_streams) > 0)
+  {
+    GtNodeStream **gff3 = gt_array_pop(in_streams);
+    gt_node_stream_delete(*gff3);
+  }
+  gt_array_delete(in_streams);
+  return ns;
+}
+
+bool agn_merge_stream_unit_test(AgnUnitTest *test)
+{
+  GtError *error = gt_error_new();
+  GtStr *chr1 = gt_str_new_cstr("chr1");
+  GtStr *chr2 = gt_str_new_cstr("chr2");
+  GtUword progress1, progress2;
+
+  GtArray *source1 = gt_array_new( sizeof(GtGenomeNode *) );
+  GtArray *source2 = gt_array_new( sizeof(GtGenomeNode *) );
+  GtGenomeNode *gn;
+  gn = gt_feature_node_new(chr1, "gene", 100, 200, GT_STRAND_FORWARD);
+  gt_array_add(source1, gn);
+  gn = gt_feature_node_new(chr1, "gene", 700, 800, GT_STRAND_REVERSE);
+  gt_array_add(source1, gn);
+  gn = gt_feature_node_new(chr2, "gene", 50, 90, GT_STRAND_FORWARD);
+  gt_array_add(source1, gn);
+  gn = gt_feature_node_new(chr1, "gene", 300, 400, GT_STRAND_FORWARD);
+  gt_array_add(source2, gn);
+  gn = gt_feature_node_new(chr2, "gene", 10, 40, GT_STRAND_REVERSE);
+  gt_array_add(source2, gn);
+  GtArray *in_streams = gt_array_new( sizeof(GtNodeStream *) );
+  GtNodeStream *ais1 = gt_array_in_stream_new(source1, &progress1, error);
+  GtNodeStream *ais2 = gt_array_in_stream_new(source2, &progress2, error);
+  gt_array_add(in_streams, ais1);
+  gt_array_add(in_streams, ais2);
+  GtNodeStream *ms = agn_merge_stream_new(in_streams);
+  GtArray *sink = gt_array_new( sizeof(GtGenomeNode *) );
+  int result = merge_stream_test_pull(ms, sink, error);
+  GtUword starts[] = { 100, 300, 700, 10, 50 };
+  bool mergetest = result == 0 && gt_array_size(sink) == 5;
+  GtUword i;
+  for(i = 0; mergetest && i < gt_array_size(sink); i++)
+  {
+    gn = *(GtGenomeNode **)gt_array_get(sink, i);
+    mergetest = gt_genome_node_get_start(gn) == starts[i];
+  }
+  agn_unit_test_result(test, "merge", mergetest);
+  gt_node_stream_delete(ms);
+  gt_node_stream_delete(ais1);
+  gt_node_stream_delete(ais2);
+  gt_array_reset(in_streams);
+  while(gt_array_size(sink) > 0)
+  {
+    GtGenomeNode **node = gt_array_pop(sink);
+    gt_genome_node_delete(*node);
+  }
+  gt_array_reset(source1);
+  gt_array_reset(source2);
+
+  gn = gt_feature_node_new(chr1, "gene", 500, 800, GT_STRAND_FORWARD);
+  gt_array_add(source1, gn);
+  gn = gt_feature_node_new(chr1, "gene", 100, 300, GT_STRAND_FORWARD);
+  gt_array_add(source1, gn);
+  gn = gt_feature_node_new(chr2, "gene", 100, 300, GT_STRAND_FORWARD);
+  gt_array_add(source2, gn);
+  gn = gt_feature_node_new(chr1, "gene", 900, 1000, GT_STRAND_FORWARD);
+  gt_array_add(source2, gn);
+  bool ordertest = true;
+  GtArray *sources[] = { source1, source2 };
+  GtUword *progress[] = { &progress1, &progress2 };
+  for(i = 0; i < 2; i++)
+  {
+    GtNodeStream *ais = gt_array_in_stream_new(sources[i], progress[i], error);
+    gt_array_add(in_streams, ais);
+    ms = agn_merge_stream_new(in_streams);
+    result = merge_stream_test_pull(ms, sink, error);
+    ordertest = ordertest && result == -1 &&
+                strstr(gt_error_get(error), "not sorted") != NULL;
+    gt_error_unset(error);
+    gt_node_stream_delete(ms);
+    gt_node_stream_delete(ais);
+    gt_array_reset(in_streams);
+    while(gt_array_size(sink) > 0)
+    {
+      GtGenomeNode **node = gt_array_pop(sink);
+      gt_genome_node_delete(*node);
+    }
+    GtUword j;
+    for(j = *progress[i]; j < gt_array_size(sources[i]); j++)
+      gt_genome_node_delete(*(GtGenomeNode **)gt_array_get(sources[i], j));
+  }
+  agn_unit_test_result(test, "out of order", ordertest);
+
+  const char *filenames[] = { "data/gff3/grape-refr.gff3",
+                              "data/gff3/grape-pred.gff3" };
+  GtNodeStream *gff3 = gt_gff3_in_stream_new_unsorted(2, filenames);
+  gt_gff3_in_stream_check_id_attributes((GtGFF3InStream *)gff3);
+  gt_gff3_in_stream_enable_tidy_mode((GtGFF3InStream *)gff3);
+  GtNodeStream *sort = gt_sort_stream_new(gff3);
+  GtArray *sorted = gt_array_new( sizeof(GtGenomeNode *) );
+  result = merge_stream_test_pull(sort, sorted, error);
+  gt_node_stream_delete(gff3);
+  gt_node_stream_delete(sort);
+  ms = agn_merge_stream_new_gff3(2, filenames);
+  result = result || merge_stream_test_pull(ms, sink, error);
+  gt_node_stream_delete(ms);
+  bool grapetest = result == 0 && gt_array_size(sink) > 0 &&
+                   gt_array_size(sink) == gt_array_size(sorted);
+  for(i = 0; grapetest && i < gt_array_size(sink); i++)
+  {
+    GtGenomeNode *gn1 = *(GtGenomeNode **)gt_array_get(sink, i);
+    GtGenomeNode *gn2 = *(GtGenomeNode **)gt_array_get(sorted, i);
+    GtRange r1 = gt_genome_node_get_range(gn1);
+    GtRange r2 = gt_genome_node_get_range(gn2);
+    grapetest = gt_range_compare(&r1, &r2) == 0 &&
+                strcmp(gt_genome_node_get_filename(gn1),
+                       gt_genome_node_get_filename(gn2)) == 0;
+  }
+  agn_unit_test_result(test, "grape", grapetest);
+  while(gt_array_size(sink) > 0)
+  {
+    GtGenomeNode **node = gt_array_pop(sink);
+    gt_genome_node_delete(*node);
+  }
+  while(gt_array_size(sorted) > 0)
+  {
+    GtGenomeNode **node = gt_array_pop(sorted);
+    gt_genome_node_delete(*node);
+  }
+
+  gt_array_delete(sorted);
+  gt_array_delete(sink);
+  gt_array_delete(in_streams);
+  gt_array_delete(source1);
+  gt_array_delete(source2);
+  gt_str_delete(chr1);
+  gt_str_delete(chr2);
+  gt_error_delete(error);
+  return agn_unit_test_success(test);
+}
+
+static const GtNodeStreamClass *merge_stream_class(void)
+{
+  static const GtNodeStreamClass *nsc = NULL;
+  if(!nsc)
+  {
+    nsc = gt_node_stream_class_new(sizeof (AgnMergeStream),
+                                   merge_stream_free,
+                                   merge_stream_next);
+  }
+  return nsc;
+}
+
+static bool merge_stream_consolidate(AgnMergeStream *stream)
+{
+  bool consolidated = false;
+  GtUword i, j;
+  for(i = 0; i < gt_array_size(stream->inputs); i++)
+  {
+    MergeInput *input = gt_array_get(stream->inputs, i);
+    if(input->head == NULL || !gt_region_node_try_cast(input->head))
+      continue;
+
+    GtStr *seqid = gt_genome_node_get_seqid(input->head);
+    for(j = i + 1; j < gt_array_size(stream->inputs); j++)
+    {
+      MergeInput *other = gt_array_get(stream->inputs, j);
+      if(other->head == NULL || !gt_region_node_try_cast(other->head) ||
+         gt_str_cmp(seqid, gt_genome_node_get_seqid(other->head)) != 0)
+        continue;
+
+      GtRange range = gt_genome_node_get_range(input->head);
+      GtRange otherrange = gt_genome_node_get_range(other->head);
+      range = gt_range_join(&range, &otherrange);
+      gt_genome_node_set_range(input->head, &range);
+      gt_genome_node_delete(other->head);
+      other->head = NULL;
+      consolidated = true;
+    }
+  }
+  return consolidated;
+}
+
+static int merge_stream_fill(MergeInput *input, GtError *error)
+{
+  int had_err = gt_node_stream_next(input->stream, &input->head, error);
+  if(had_err)
+    return had_err;
+  if(input->head == NULL)
+  {
+    input->done = true;
+    return 0;
+  }
+  if(gt_feature_node_try_cast(input->head) == NULL)
+    return 0;
+
+  GtStr *seqid = gt_genome_node_get_seqid(input->head);
+  GtUword start = gt_genome_node_get_start(input->head);
+  if(input->seqid != NULL)
+  {
+    int seqcmp = gt_str_cmp(seqid, input->seqid);
+    if(seqcmp < 0 || (seqcmp == 0 && start < input->start))
+    {
+      const char *filename = gt_genome_node_get_filename(input->head);
+      gt_error_set(error, "input is not sorted: feature at %s:%lu (file '%s', "
+                   "line %u) follows a feature at %s:%lu; sort the input "
+                   "with 'gt gff3 -sort' or omit the '--sorted' option",
+                   gt_str_get(seqid), start, filename,
+                   gt_genome_node_get_line_number(input->head),
+                   gt_str_get(input->seqid), input->start);
+      return -1;
+    }
+    gt_str_delete(input->seqid);
+  }
+  input->seqid = gt_str_ref(seqid);
+  input->start = start;
+  return 0;
+}
+
+static void merge_stream_free(GtNodeStream *ns)
+{
+  AgnMergeStream *stream = merge_stream_cast(ns);
+  GtUword i;
+  for(i = 0; i < gt_array_size(stream->inputs); i++)
+  {
+    MergeInput *input = gt_array_get(stream->inputs, i);
+    if(input->head != NULL)
+      gt_genome_node_delete(input->head);
+    if(input->seqid != NULL)
+      gt_str_delete(input->seqid);
+    gt_node_stream_delete(input->stream);
+  }
+  gt_array_delete(stream->inputs);
+}
+
+static int merge_stream_next(GtNodeStream *ns, GtGenomeNode **gn,
+                             GtError *error)
+{
+  AgnMergeStream *stream;
+  MergeInput *next = NULL;
+  GtUword i;
+  gt_error_check(error);
+  stream = merge_stream_cast(ns);
+
+  do
+  {
+    for(i = 0; i < gt_array_size(stream->inputs); i++)
+    {
+      MergeInput *input = gt_array_get(stream->inputs, i);
+      if(input->head == NULL && !input->done)
+      {
+        int had_err = merge_stream_fill(input, error);
+        if(had_err)
+          return had_err;
+      }
+    }
+  } while(merge_stream_consolidate(stream));
+
+  for(i = 0; i < gt_array_size(stream->inputs); i++)
+  {
+    MergeInput *input = gt_array_get(stream->inputs, i);
+    if(input->head == NULL)
+      continue;
+
+    // Regions, comments, and other non-feature nodes are passed through first
+    if(gt_feature_node_try_cast(input->head) == NULL)
+    {
+      next = input;
+      break;
+    }
+    if(next == NULL || gt_genome_node_cmp(input->head, next->head) < 0)
+      next = input;
+  }
+
+  if(next == NULL)
+  {
+    *gn = NULL;
+    return 0;
+  }
+  *gn = next->head;
+  next->head = NULL;
+  return 0;
+}
+
+static int merge_stream_test_pull(GtNodeStream *ns, GtArray *nodes,
+                                  GtError *error)
+{
+  GtGenomeNode *gn;
+  int result;
+  while((result = gt_node_stream_next(ns, &gn, error)) == 0 && gn != NULL)
+  {
+    if(gt_feature_node_try_cast(gn))
+      gt_array_add(nodes, gn);
+    else
+      gt_genome_node_delete(gn);
+  }
+  return result;
+}
@@ -0,0 +1,488 @@
+/**
+
+Copyright (c) 2010-2016, Daniel S. Standage and CONTRIBUTORS
+
+The AEGeAn Toolkit is distributed under the ISC License. See
+the 'LICENSE' file in the AEGeAn source code distribution or
+online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
+
+**/
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include "core/queue_api.h"
+#include "extended/array_in_stream_api.h"
+#include "extended/array_out_stream_api.h"
+#include "extended/feature_node_iterator_api.h"
+#include "AgnLocus.h"
+#include "AgnMiLocusStream.h"
+#include "AgnUtils.h"
+
+#define milocus_stream_cast(GS)\
+        gt_node_stream_cast(milocus_stream_class(), GS)
+
+//------------------------------------------------------------------------------
+// Data structure definitions
+//------------------------------------------------------------------------------
+
+struct AgnMiLocusStream
+{
+  const GtNodeStream parent_instance;
+  GtNodeStream *in_stream;
+  GtArray *buffer;
+  GtQueue *queue;
+  GtStr *nameformat;
+  GtUword count;
+  bool eof;
+};
+
+/**
+ * The sum of a numeric attribute over all of the iLoci in a miLocus.
+ */
+typedef struct
+{
+  char *key;
+  GtUword sum;
+} AttributeSum;
+
+
+//------------------------------------------------------------------------------
+// Prototypes for private functions
+//------------------------------------------------------------------------------
+
+/**
+ * @function Compare two attribute sums by key (for sorting).
+ */
+static int milocus_stream_attribute_compare(const void *p1, const void *p2);
+
+/**
+ * @function Implement the node stream interface.
+ */
+static const GtNodeStreamClass *milocus_stream_class(void);
+
+/**
+ * @function Move the buffered iLoci to the output queue, merging them into a
+ * single miLocus if there is more than one.
+ */
+static void milocus_stream_flush(AgnMiLocusStream *stream);
+
+/**
+ * @function Class destructor.
+ */
+static void milocus_stream_free(GtNodeStream *ns);
+
+/**
+ * @function Returns true if the given attribute value is a non-negative
+ * integer.
+ */
+static bool milocus_stream_is_count(const char *value);
+
+/**
+ * @function Returns true if ``locus`` is a gene-containing iLocus that can be
+ * merged with its neighbors.
+ */
+static bool milocus_stream_mergeable(GtFeatureNode *locus);
+
+/**
+ * @function Create a miLocus from the given iLoci, which are deleted.
+ */
+static AgnLocus *milocus_stream_merge(GtArray *loci);
+
+/**
+ * @function Assign a name to the next iLocus, if a name format is set.
+ */
+static void milocus_stream_mint(AgnMiLocusStream *stream,
+                                GtFeatureNode *locus);
+
+/**
+ * @function Pull iLoci from the input stream until the next miLocus or other
+ * iLocus is complete, and deliver it.
+ */
+static int milocus_stream_next(GtNodeStream *ns, GtGenomeNode **gn,
+                               GtError *error);
+
+/**
+ * @function Create an iLocus of the given type with a single gene for unit
+ * testing.
+ */
+static AgnLocus *milocus_stream_test_locus(const char *seqid, GtUword start,
+                                           GtUword end, const char *type);
+
+
+//------------------------------------------------------------------------------
+// Method implementations
+//------------------------------------------------------------------------------
+
+GtNodeStream *agn_milocus_stream_new(GtNodeStream *in_stream)
+{
+  agn_assert(in_stream);
+  GtNodeStream *ns = gt_node_stream_create(milocus_stream_class(), false);
+  AgnMiLocusStream *stream = milocus_stream_cast(ns);
+  stream->in_stream = gt_node_stream_ref(in_stream);
+  stream->buffer = gt_array_new( sizeof(GtGenomeNode *) );
+  stream->queue = gt_queue_new();
+  stream->nameformat = NULL;
+  stream->count = 0;
+  stream->eof = false;
+  return ns;
+}
+
+void agn_milocus_stream_set_name_format(AgnMiLocusStream *stream,
+                                        const char *format)
+{
+  agn_assert(stream && format);
+  if(stream->nameformat != NULL)
+    gt_str_delete(stream->nameformat);
+  stream->nameformat = gt_str_new_cstr(format);
+}
+
+bool agn_milocus_stream_unit_test(AgnUnitTest *test)
+{
+  GtArray *source = gt_array_new( sizeof(GtGenomeNode *) );
+  AgnLocus *locus = milocus_stream_test_locus("chr", 1, 1000, "siLocus");
+  gt_feature_node_set_attribute((GtFeatureNode *)locus, "riil", "0");
+  gt_feature_node_set_attribute((GtFeatureNode *)locus, "right_overlap", "100");
+  gt_array_add(source, locus);
+  locus = milocus_stream_test_locus("chr", 901, 2000, "niLocus");
+  gt_feature_node_set_attribute((GtFeatureNode *)locus, "left_overlap", "100");
+  gt_feature_node_set_attribute((GtFeatureNode *)locus, "liil", "0");
+  gt_feature_node_set_attribute((GtFeatureNode *)locus, "child_ncRNA", "1");
+  gt_array_add(source, locus);
+  locus = milocus_stream_test_locus("chr", 2001, 3000, "iiLocus");
+  gt_array_add(source, locus);
+  locus = milocus_stream_test_locus("chr", 3001, 4000, "siLocus");
+  gt_array_add(source, locus);
+  locus = milocus_stream_test_locus("chr", 3401, 3600, "siLocus");
+  gt_feature_node_set_attribute((GtFeatureNode *)locus, "iiLocus_exception",
+                                "intron-gene");
+  gt_array_add(source, locus);
+  locus = milocus_stream_test_locus("chr2", 1, 500, "siLocus");
+  gt_array_add(source, locus);
+  locus = milocus_stream_test_locus("chr2", 501, 900, "siLocus");
+  gt_array_add(source, locus);
+
+  GtError *error = gt_error_new();
+  GtArray *sink = gt_array_new( sizeof(GtGenomeNode *) );
+  GtUword progress = 0;
+  GtNodeStream *ais = gt_array_in_stream_new(source, &progress, error);
+  GtNodeStream *mls = agn_milocus_stream_new(ais);
+  agn_milocus_stream_set_name_format((AgnMiLocusStream *)mls, "miLocus%lu");
+  GtNodeStream *aos = gt_array_out_stream_new(mls, sink, error);
+  int result = gt_node_stream_pull(aos, error);
+  if(result == -1)
+  {
+    fprintf(stderr, "[AgnMiLocusStream::agn_milocus_stream_unit_test] error "
+            "processing nodes: %s\n", gt_error_get(error));
+    return false;
+  }
+
+  bool test1 = gt_array_size(sink) == 5;
+  if(test1)
+  {
+    GtFeatureNode *fn = *(GtFeatureNode **)gt_array_get(sink, 0);
+    GtRange range = gt_genome_node_get_range((GtGenomeNode *)fn);
+    const char *type = gt_feature_node_get_attribute(fn, "iLocus_type");
+    const char *genes = gt_feature_node_get_attribute(fn, "child_gene");
+    const char *ncrnas = gt_feature_node_get_attribute(fn, "child_ncRNA");
+    test1 = range.start == 1 && range.end == 2000 &&
+            type && strcmp(type, "miLocus") == 0 &&
+            genes && strcmp(genes, "2") == 0 &&
+            ncrnas && strcmp(ncrnas, "1") == 0 &&
+            gt_feature_node_get_attribute(fn, "left_overlap") == NULL &&
+            gt_feature_node_number_of_children(fn) == 2 &&
+            gt_feature_node_get_score(fn) == 2.0;
+  }
+  agn_unit_test_result(test, "merge overlapping iLoci", test1);
+
+  bool test2 = gt_array_size(sink) == 5;
+  if(test2)
+  {
+    const char *types[] = { "miLocus", "iiLocus", "siLocus", "siLocus",
+                            "miLocus" };
+    GtUword i;
+    for(i = 0; i < 5; i++)
+    {
+      GtFeatureNode *fn = *(GtFeatureNode **)gt_array_get(sink, i);
+      const char *type = gt_feature_node_get_attribute(fn, "iLocus_type");
+      test2 = test2 && type && strcmp(type, types[i]) == 0;
+    }
+    GtFeatureNode *fn = *(GtFeatureNode **)gt_array_get(sink, 4);
+    GtRange range = gt_genome_node_get_range((GtGenomeNode *)fn);
+    test2 = test2 && range.start == 1 && range.end == 900;
+  }
+  agn_unit_test_result(test, "iiLoci and intron genes not merged", test2);
+
+  bool test3 = gt_array_size(sink) == 5;
+  if(test3)
+  {
+    GtFeatureNode *fn = *(GtFeatureNode **)gt_array_get(sink, 2);
+    const char *name = gt_feature_node_get_attribute(fn, "Name");
+    test3 = name && strcmp(name, "miLocus3") == 0;
+    fn = *(GtFeatureNode **)gt_array_get(sink, 4);
+    name = gt_feature_node_get_attribute(fn, "Name");
+    test3 = test3 && name && strcmp(name, "miLocus5") == 0;
+  }
+  agn_unit_test_result(test, "names", test3);
+
+  gt_node_stream_delete(aos);
+  gt_node_stream_delete(mls);
+  gt_node_stream_delete(ais);
+  while(gt_array_size(sink) > 0)
+  {
+    GtGenomeNode **gn = gt_array_pop(sink);
+    gt_genome_node_delete(*gn);
+  }
+  gt_array_delete(sink);
+  gt_array_delete(source);
+  gt_error_delete(error);
+  return agn_unit_test_success(test);
+}
+
+static int milocus_stream_attribute_compare(const void *p1, const void *p2)
+{
+  const AttributeSum *sum1 = p1;
+  const AttributeSum *sum2 = p2;
+  return strcmp(sum1->key, sum2->key);
+}
+
+static const GtNodeStreamClass *milocus_stream_class(void)
+{
+  static const GtNodeStreamClass *nsc = NULL;
+  if(!nsc)
+  {
+    nsc = gt_node_stream_class_new(sizeof (AgnMiLocusStream),
+                                   milocus_stream_free,
+                                   milocus_stream_next);
+  }
+  return nsc;
+}
+
+static void milocus_stream_flush(AgnMiLocusStream *stream)
+{
+  GtUword numloci = gt_array_size(stream->buffer);
+  if(numloci == 0)
+    return;
+
+  if(numloci == 1)
+  {
+    GtGenomeNode **gn = gt_array_get(stream->buffer, 0);
+    gt_queue_add(stream->queue, *gn);
+  }
+  else
+    gt_queue_add(stream->queue, milocus_stream_merge(stream->buffer));
+  gt_array_reset(stream->buffer);
+}
+
+static void milocus_stream_free(GtNodeStream *ns)
+{
+  AgnMiLocusStream *stream = milocus_stream_cast(ns);
+  gt_node_stream_delete(stream->in_stream);
+  while(gt_array_size(stream->buffer) > 0)
+  {
+    GtGenomeNode **gn = gt_array_pop(stream->buffer);
+    gt_genome_node_delete(*gn);
+  }
+  gt_array_delete(stream->buffer);
+  while(gt_queue_size(stream->queue) > 0)
+  {
+    GtGenomeNode *gn = gt_queue_get(stream->queue);
+    gt_genome_node_delete(gn);
+  }
+  gt_queue_delete(stream->queue);
+  if(stream->nameformat != NULL)
+    gt_str_delete(stream->nameformat);
+}
+
+static bool milocus_stream_is_count(const char *value)
+{
+  if(*value == '\0')
+    return false;
+  for(; *value != '\0'; value++)
+  {
+    if(!isdigit((unsigned char)*value))
+      return false;
+  }
+  return true;
+}
+
+static bool milocus_stream_mergeable(GtFeatureNode *locus)
+{
+  const char *type = gt_feature_node_get_attribute(locus, "iLocus_type");
+  if(type == NULL ||
+     (strcmp(type, "siLocus") != 0 && strcmp(type, "niLocus") != 0))
+    return false;
+
+  const char *exception = gt_feature_node_get_attribute(locus,
+                                                        "iiLocus_exception");
+  return exception == NULL || strcmp(exception, "intron-gene") != 0;
+}
+
+static AgnLocus *milocus_stream_merge(GtArray *loci)
+{
+  GtFeatureNode *first = *(GtFeatureNode **)gt_array_get(loci, 0);
+  GtRange range = gt_genome_node_get_range((GtGenomeNode *)first);
+  AgnLocus *milocus = agn_locus_new(gt_genome_node_get_seqid((GtGenomeNode *)
+                                                             first));
+  GtStr *source = gt_str_new_cstr(gt_feature_node_get_source(first));
+  gt_feature_node_set_source((GtFeatureNode *)milocus, source);
+  gt_str_delete(source);
+
+  GtArray *sums = gt_array_new( sizeof(AttributeSum) );
+  GtArray *children = gt_array_new( sizeof(GtFeatureNode *) );
+  GtUword i, j, k, numloci = gt_array_size(loci);
+  for(i = 0; i < numloci; i++)
+  {
+    GtFeatureNode *locus = *(GtFeatureNode **)gt_array_get(loci, i);
+    GtRange locusrange = gt_genome_node_get_range((GtGenomeNode *)locus);
+    range = gt_range_join(&range, &locusrange);
+
+    GtStrArray *attrs = gt_feature_node_get_attribute_list(locus);
+    for(j = 0; j < gt_str_array_size(attrs); j++)
+    {
+      const char *key = gt_str_array_get(attrs, j);
+      const char *value = gt_feature_node_get_attribute(locus, key);
+      if(strcmp(key, "left_overlap") == 0 ||
+         strcmp(key, "right_overlap") == 0 || !milocus_stream_is_count(value))
+        continue;
+
+      for(k = 0; k < gt_array_size(sums); k++)
+      {
+        AttributeSum *sum = gt_array_get(sums, k);
+        if(strcmp(sum->key, key) == 0)
+          break;
+      }
+      if(k == gt_array_size(sums))
+      {
+        AttributeSum newsum = { gt_cstr_dup(key), 0 };
+        gt_array_add(sums, newsum);
+      }
+      AttributeSum *sum = gt_array_get(sums, k);
+      sum->sum += strtoul(value, NULL, 10);
+    }
+    gt_str_array_delete(attrs);
+
+    GtFeatureNode *child;
+    GtFeatureNodeIterator *iter = gt_feature_node_iterator_new_direct(locus);
+    for(child  = gt_feature_node_iterator_next(iter);
+        child != NULL;
+        child  = gt_feature_node_iterator_next(iter))
+    {
+      gt_array_add(children, child);
+    }
+    gt_feature_node_iterator_delete(iter);
+    for(j = 0; j < gt_array_size(children); j++)
+    {
+      GtFeatureNode **fn = gt_array_get(children, j);
+      agn_locus_add_feature(milocus, *fn);
+      gt_genome_node_ref((GtGenomeNode *)*fn);  // Compensate for deletion of
+                                                // its former locus
+    }
+    gt_array_reset(children);
+    gt_genome_node_delete((GtGenomeNode *)locus);
+  }
+  gt_array_delete(children);
+
+  agn_locus_set_range(milocus, range.start, range.end);
+  gt_feature_node_set_score((GtFeatureNode *)milocus, (float)numloci);
+  gt_feature_node_set_attribute((GtFeatureNode *)milocus, "iLocus_type",
+                                "miLocus");
+  gt_array_sort(sums, milocus_stream_attribute_compare);
+  for(i = 0; i < gt_array_size(sums); i++)
+  {
+    AttributeSum *sum = gt_array_get(sums, i);
+    char value[32];
+    sprintf(value, "%lu", sum->sum);
+    gt_feature_node_set_attribute((GtFeatureNode *)milocus, sum->key, value);
+    gt_free(sum->key);
+  }
+  gt_array_delete(sums);
+  return milocus;
+}
+
+static void milocus_stream_mint(AgnMiLocusStream *stream,
+                                GtFeatureNode *locus)
+{
+  stream->count++;
+  if(stream->nameformat)
+  {
+    char locusname[256];
+    sprintf(locusname, gt_str_get(stream->nameformat), stream->count);
+    gt_feature_node_set_attribute(locus, "Name", locusname);
+  }
+}
+
+static int milocus_stream_next(GtNodeStream *ns, GtGenomeNode **gn,
+                               GtError *error)
+{
+  gt_error_check(error);
+  AgnMiLocusStream *stream = milocus_stream_cast(ns);
+
+  while(gt_queue_size(stream->queue) == 0 && !stream->eof)
+  {
+    GtGenomeNode *node;
+    int result = gt_node_stream_next(stream->in_stream, &node, error);
+    if(result)
+      return result;
+    if(node == NULL)
+    {
+      stream->eof = true;
+      milocus_stream_flush(stream);
+      break;
+    }
+
+    GtFeatureNode *fn = gt_feature_node_try_cast(node);
+    if(fn == NULL || !gt_feature_node_has_type(fn, "locus"))
+    {
+      milocus_stream_flush(stream);
+      gt_queue_add(stream->queue, node);
+      continue;
+    }
+
+    if(gt_array_size(stream->buffer) > 0)
+    {
+      GtGenomeNode **prev = gt_array_get_last(stream->buffer);
+      if(gt_str_cmp(gt_genome_node_get_seqid(*prev),
+                    gt_genome_node_get_seqid(node)) != 0)
+        milocus_stream_flush(stream);
+    }
+
+    if(milocus_stream_mergeable(fn))
+      gt_array_add(stream->buffer, node);
+    else
+    {
+      milocus_stream_flush(stream);
+      gt_queue_add(stream->queue, node);
+    }
+  }
+
+  if(gt_queue_size(stream->queue) == 0)
+  {
+    *gn = NULL;
+    return 0;
+  }
+
+  *gn = gt_queue_get(stream->queue);
+  GtFeatureNode *fn = gt_feature_node_try_cast(*gn);
+  if(fn != NULL && gt_feature_node_has_type(fn, "locus"))
+    milocus_stream_mint(stream, fn);
+  return 0;
+}
+
+static AgnLocus *milocus_stream_test_locus(const char *seqid, GtUword start,
+                                           GtUword end, const char *type)
+{
+  GtStr *seqidstr = gt_str_new_cstr(seqid);
+  AgnLocus *locus = agn_locus_new(seqidstr);
+  if(strcmp(type, "iiLocus") != 0)
+  {
+    GtGenomeNode *gene = gt_feature_node_new(seqidstr, "gene", start + 100,
+                                             end - 100, GT_STRAND_FORWARD);
+    agn_locus_add_feature(locus, (GtFeatureNode *)gene);
+    gt_feature_node_set_attribute((GtFeatureNode *)locus, "child_gene", "1");
+  }
+  agn_locus_set_range(locus, start, end);
+  gt_feature_node_set_attribute((GtFeatureNode *)locus, "iLocus_type", type);
+  gt_str_delete(seqidstr);
+  return locus;
+}
@@ -0,0 +1,439 @@
+/**
+
+Copyright (c) 2010-2016, Daniel S. Standage and CONTRIBUTORS
+
+The AEGeAn Toolkit is distributed under the ISC License. See
+the 'LICENSE' file in the AEGeAn source code distribution or
+online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
+
+**/
+
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "core/queue_api.h"
+#include "AgnOutputSink.h"
+#include "AgnUtils.h"
+
+#define OUTPUT_SINK_BUFFER_SIZE (1 << 20)
+#define OUTPUT_SINK_MAX_PENDING 4
+
+//------------------------------------------------------------------------------
+// Data structure definitions
+//------------------------------------------------------------------------------
+
+/**
+ * A file sink with a background writer (``threaded``) queues full buffers as
+ * ``pending`` chunks; the writer waits for ``chunk_added`` and signals
+ * ``chunk_written`` after each write. A memory sink has no ``outfile`` and
+ * grows its buffer as needed.
+ */
+struct AgnOutputSink
+{
+  char *buffer;
+  GtUword length;
+  GtUword capacity;
+  GtFile *outfile;
+  bool threaded;
+  bool closing;
+  GtQueue *pending;
+  pthread_t writer;
+  pthread_mutex_t mutex;
+  pthread_cond_t chunk_added;
+  pthread_cond_t chunk_written;
+};
+
+/**
+ * A buffer waiting to be written by the background writer.
+ */
+typedef struct
+{
+  char *data;
+  GtUword length;
+} OutputSinkChunk;
+
+
+//------------------------------------------------------------------------------
+// Prototypes for private functions
+//------------------------------------------------------------------------------
+
+/**
+ * @function Write ``numrows`` rows of gene-to-locus map output to the given
+ * file, either with ``fprintf`` or with a file sink, for benchmarking.
+ */
+static void output_sink_benchmark_write(const char *filename, GtUword numrows,
+                                        bool use_sink);
+
+/**
+ * @function Pass the contents of a file sink's buffer to the background writer
+ * (or write them directly if there is none) and start a new buffer.
+ */
+static void output_sink_flush(AgnOutputSink *sink);
+
+/**
+ * @function Make room for at least ``length`` more bytes in the buffer.
+ * Returns false if the bytes do not fit in the (empty) buffer of a file sink
+ * and must be written directly.
+ */
+static bool output_sink_reserve(AgnOutputSink *sink, GtUword length);
+
+/**
+ * @function Read the contents of the given file into ``str`` for unit testing.
+ */
+static void output_sink_test_read(const char *filename, GtStr *str);
+
+/**
+ * @function Background writer main loop: write pending chunks to the output
+ * file until the sink is closed and no chunks remain.
+ */
+static void *output_sink_writer(void *data);
+
+
+//------------------------------------------------------------------------------
+// Method implementations
+//------------------------------------------------------------------------------
+
+bool agn_output_sink_benchmark(AgnUnitTest *test)
+{
+  GtUword sizes[] = { 1000000, 5000000 };
+  char reffilename[] = "/tmp/agn-output-sink-ref-XXXXXX";
+  char filename[] = "/tmp/agn-output-sink-XXXXXX";
+  int reffd = mkstemp(reffilename);
+  int fd = mkstemp(filename);
+  agn_assert(reffd != -1 && fd != -1);
+  close(reffd);
+  close(fd);
+
+  GtUword i;
+  for(i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+  {
+    char label[64];
+    clock_t start = clock();
+    output_sink_benchmark_write(reffilename, sizes[i], false);
+    clock_t middle = clock();
+    output_sink_benchmark_write(filename, sizes[i], true);
+    clock_t end = clock();
+    double reftime = (double)(middle - start) / CLOCKS_PER_SEC;
+    double newtime = (double)(end - middle) / CLOCKS_PER_SEC;
+
+    GtStr *refcontents = gt_str_new();
+    GtStr *contents = gt_str_new();
+    output_sink_test_read(reffilename, refcontents);
+    output_sink_test_read(filename, contents);
+    bool identical = gt_str_cmp(refcontents, contents) == 0;
+    gt_str_delete(refcontents);
+    gt_str_delete(contents);
+
+    printf("        [map output] %7lu rows: fprintf %.3fs (%.0f rows/s), "
+           "output sink %.3fs (%.0f rows/s)\n", sizes[i], reftime,
+           reftime > 0.0 ? sizes[i] / reftime : 0.0, newtime,
+           newtime > 0.0 ? sizes[i] / newtime : 0.0);
+    sprintf(label, "identical output, %lu rows", sizes[i]);
+    agn_unit_test_result(test, label, identical);
+  }
+  unlink(reffilename);
+  unlink(filename);
+  return agn_unit_test_success(test);
+}
+
+void agn_output_sink_append(AgnOutputSink *sink, AgnOutputSink *source)
+{
+  agn_assert(sink && source && source->outfile == NULL);
+  agn_output_sink_write(sink, source->buffer, source->length);
+}
+
+void agn_output_sink_char(AgnOutputSink *sink, char c)
+{
+  agn_assert(sink);
+  if(sink->length == sink->capacity)
+    output_sink_reserve(sink, 1);
+  sink->buffer[sink->length++] = c;
+}
+
+void agn_output_sink_cstr(AgnOutputSink *sink, const char *cstr)
+{
+  agn_output_sink_write(sink, cstr, strlen(cstr));
+}
+
+void agn_output_sink_delete(AgnOutputSink *sink)
+{
+  if(sink == NULL)
+    return;
+
+  if(sink->outfile != NULL)
+  {
+    output_sink_flush(sink);
+    if(sink->threaded)
+    {
+      pthread_mutex_lock(&sink->mutex);
+      sink->closing = true;
+      pthread_cond_signal(&sink->chunk_added);
+      pthread_mutex_unlock(&sink->mutex);
+      pthread_join(sink->writer, NULL);
+    }
+    pthread_mutex_destroy(&sink->mutex);
+    pthread_cond_destroy(&sink->chunk_added);
+    pthread_cond_destroy(&sink->chunk_written);
+    gt_queue_delete(sink->pending);
+    gt_file_delete(sink->outfile);
+  }
+  gt_free(sink->buffer);
+  gt_free(sink);
+}
+
+const char *agn_output_sink_get(AgnOutputSink *sink)
+{
+  agn_assert(sink && sink->outfile == NULL);
+  return sink->buffer;
+}
+
+GtUword agn_output_sink_length(AgnOutputSink *sink)
+{
+  agn_assert(sink && sink->outfile == NULL);
+  return sink->length;
+}
+
+AgnOutputSink *agn_output_sink_new(const char *filename, GtError *error)
+{
+  agn_assert(filename);
+  GtFile *outfile = gt_file_new(filename, "w", error);
+  if(outfile == NULL)
+    return NULL;
+
+  AgnOutputSink *sink = gt_malloc( sizeof(AgnOutputSink) );
+  sink->capacity = OUTPUT_SINK_BUFFER_SIZE;
+  sink->buffer = gt_malloc( sizeof(char) * sink->capacity );
+  sink->length = 0;
+  sink->outfile = outfile;
+  sink->closing = false;
+  sink->pending = gt_queue_new();
+  pthread_mutex_init(&sink->mutex, NULL);
+  pthread_cond_init(&sink->chunk_added, NULL);
+  pthread_cond_init(&sink->chunk_written, NULL);
+
+  // Without a writer thread, buffers are simply written as they fill up
+  sink->threaded = pthread_create(&sink->writer, NULL, output_sink_writer,
+                                  sink) == 0;
+  return sink;
+}
+
+AgnOutputSink *agn_output_sink_new_memory()
+{
+  AgnOutputSink *sink = gt_malloc( sizeof(AgnOutputSink) );
+  sink->capacity = 256;
+  sink->buffer = gt_malloc( sizeof(char) * sink->capacity );
+  sink->length = 0;
+  sink->outfile = NULL;
+  sink->threaded = false;
+  sink->closing = false;
+  sink->pending = NULL;
+  return sink;
+}
+
+void agn_output_sink_str(AgnOutputSink *sink, GtStr *str)
+{
+  agn_output_sink_write(sink, gt_str_get(str), gt_str_length(str));
+}
+
+bool agn_output_sink_unit_test(AgnUnitTest *test)
+{
+  AgnOutputSink *memsink = agn_output_sink_new_memory();
+  GtStr *seqid = gt_str_new_cstr("chr1");
+  agn_output_sink_str(memsink, seqid);
+  agn_output_sink_char(memsink, '\t');
+  agn_output_sink_uword(memsink, 0);
+  agn_output_sink_char(memsink, '\t');
+  agn_output_sink_uword(memsink, 18446744073709551615UL);
+  agn_output_sink_cstr(memsink, "\tFR\n");
+  const char *expected = "chr1\t0\t18446744073709551615\tFR\n";
+  bool memtest = agn_output_sink_length(memsink) == strlen(expected) &&
+                 memcmp(agn_output_sink_get(memsink), expected,
+                        strlen(expected)) == 0;
+  agn_unit_test_result(test, "memory sink", memtest);
+
+  // Enough rows to fill several buffers, so that the background writer is
+  // used and must preserve the order of the buffers
+  char filename[] = "/tmp/agn-output-sink-XXXXXX";
+  int fd = mkstemp(filename);
+  agn_assert(fd != -1);
+  close(fd);
+  GtError *error = gt_error_new();
+  AgnOutputSink *filesink = agn_output_sink_new(filename, error);
+  GtStr *reference = gt_str_new();
+  GtUword i;
+  for(i = 0; i < 500000; i++)
+  {
+    char row[64];
+    sprintf(row, "gene%lu\tiLocus%lu\n", i, i / 3);
+    gt_str_append_cstr(reference, row);
+    agn_output_sink_cstr(filesink, "gene");
+    agn_output_sink_uword(filesink, i);
+    agn_output_sink_cstr(filesink, "\tiLocus");
+    agn_output_sink_uword(filesink, i / 3);
+    agn_output_sink_char(filesink, '\n');
+  }
+  agn_output_sink_append(filesink, memsink);
+  gt_str_append_cstr(reference, expected);
+  agn_output_sink_delete(filesink);
+
+  GtStr *contents = gt_str_new();
+  output_sink_test_read(filename, contents);
+  bool filetest = gt_str_cmp(contents, reference) == 0;
+  agn_unit_test_result(test, "file sink", filetest);
+  unlink(filename);
+
+  gt_str_delete(contents);
+  gt_str_delete(reference);
+  gt_str_delete(seqid);
+  gt_error_delete(error);
+  agn_output_sink_delete(memsink);
+  return agn_unit_test_success(test);
+}
+
+void agn_output_sink_uword(AgnOutputSink *sink, GtUword value)
+{
+  char digits[24];
+  int i = sizeof(digits);
+  do
+  {
+    digits[--i] = '0' + (value % 10);
+    value /= 10;
+  } while(value > 0);
+  agn_output_sink_write(sink, digits + i, sizeof(digits) - i);
+}
+
+void agn_output_sink_write(AgnOutputSink *sink, const void *data,
+                           GtUword length)
+{
+  agn_assert(sink && (data || length == 0));
+  if(sink->length + length > sink->capacity &&
+     !output_sink_reserve(sink, length))
+  {
+    gt_file_xwrite(sink->outfile, (void *)data, length);
+    return;
+  }
+  memcpy(sink->buffer + sink->length, data, length);
+  sink->length += length;
+}
+
+static void output_sink_benchmark_write(const char *filename, GtUword numrows,
+                                        bool use_sink)
+{
+  GtUword i;
+  if(!use_sink)
+  {
+    FILE *outstream = fopen(filename, "w");
+    agn_assert(outstream != NULL);
+    for(i = 0; i < numrows; i++)
+      fprintf(outstream, "gene%lu\tiLocus%lu\n", i, i / 3);
+    fclose(outstream);
+    return;
+  }
+
+  GtError *error = gt_error_new();
+  AgnOutputSink *sink = agn_output_sink_new(filename, error);
+  agn_assert(sink != NULL);
+  for(i = 0; i < numrows; i++)
+  {
+    agn_output_sink_cstr(sink, "gene");
+    agn_output_sink_uword(sink, i);
+    agn_output_sink_cstr(sink, "\tiLocus");
+    agn_output_sink_uword(sink, i / 3);
+    agn_output_sink_char(sink, '\n');
+  }
+  agn_output_sink_delete(sink);
+  gt_error_delete(error);
+}
+
+static void output_sink_flush(AgnOutputSink *sink)
+{
+  if(sink->length == 0)
+    return;
+
+  if(!sink->threaded)
+  {
+    gt_file_xwrite(sink->outfile, sink->buffer, sink->length);
+    sink->length = 0;
+    return;
+  }
+
+  OutputSinkChunk *chunk = gt_malloc( sizeof(OutputSinkChunk) );
+  chunk->data = sink->buffer;
+  chunk->length = sink->length;
+  pthread_mutex_lock(&sink->mutex);
+  while(gt_queue_size(sink->pending) >= OUTPUT_SINK_MAX_PENDING)
+    pthread_cond_wait(&sink->chunk_written, &sink->mutex);
+  gt_queue_add(sink->pending, chunk);
+  pthread_cond_signal(&sink->chunk_added);
+  pthread_mutex_unlock(&sink->mutex);
+
+  sink->buffer = gt_malloc( sizeof(char) * sink->capacity );
+  sink->length = 0;
+}
+
+static bool output_sink_reserve(AgnOutputSink *sink, GtUword length)
+{
+  if(sink->outfile == NULL)
+  {
+    while(sink->length + length > sink->capacity)
+      sink->capacity *= 2;
+    sink->buffer = gt_realloc(sink->buffer, sizeof(char) * sink->capacity);
+    return true;
+  }
+
+  output_sink_flush(sink);
+  if(length <= sink->capacity)
+    return true;
+
+  // Anything larger than a buffer can only be written directly, which is
+  // safe once all earlier text has been written
+  if(sink->threaded)
+  {
+    pthread_mutex_lock(&sink->mutex);
+    while(gt_queue_size(sink->pending) > 0)
+      pthread_cond_wait(&sink->chunk_written, &sink->mutex);
+    pthread_mutex_unlock(&sink->mutex);
+  }
+  return false;
+}
+
+static void output_sink_test_read(const char *filename, GtStr *str)
+{
+  FILE *instream = fopen(filename, "r");
+  agn_assert(instream != NULL);
+  char buffer[4096];
+  size_t n;
+  while((n = fread(buffer, 1, sizeof(buffer), instream)) > 0)
+    gt_str_append_cstr_nt(str, buffer, n);
+  fclose(instream);
+}
+
+static void *output_sink_writer(void *data)
+{
+  AgnOutputSink *sink = data;
+  pthread_mutex_lock(&sink->mutex);
+  while(true)
+  {
+    if(gt_queue_size(sink->pending) == 0)
+    {
+      if(sink->closing)
+        break;
+      pthread_cond_wait(&sink->chunk_added, &sink->mutex);
+      continue;
+    }
+
+    // The chunk stays in the queue while it is written, so that a full queue
+    // also accounts for the chunk in progress
+    OutputSinkChunk *chunk = gt_queue_head(sink->pending);
+    pthread_mutex_unlock(&sink->mutex);
+    gt_file_xwrite(sink->outfile, chunk->data, chunk->length);
+    gt_free(chunk->data);
+    pthread_mutex_lock(&sink->mutex);
+    gt_queue_get(sink->pending);
+    gt_free(chunk);
+    pthread_cond_signal(&sink->chunk_written);
+  }
+  pthread_mutex_unlock(&sink->mutex);
+  return NULL;
+}
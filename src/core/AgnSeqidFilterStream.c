@@ -0,0 +1,293 @@
+/**
+
+Copyright (c) 2010-2014, Daniel S. Standage and CONTRIBUTORS
+
+The AEGeAn Toolkit is distributed under the ISC License. See
+the 'LICENSE' file in the AEGeAn source code distribution or
+online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
+
+**/
+
+#include <string.h>
+#include "core/hashmap_api.h"
+#include "AgnSeqidFilterStream.h"
+#include "AgnUtils.h"
+
+#define seqid_filter_stream_cast(GS)\
+        gt_node_stream_cast(seqid_filter_stream_class(), GS)
+
+//------------------------------------------------------------------------------
+// Data structure definition
+//------------------------------------------------------------------------------
+
+struct AgnSeqidFilterStream
+{
+  const GtNodeStream parent_instance;
+  GtNodeStream *in_stream;
+  GtHashmap *seqids;
+  GtUword shard;
+  GtUword numshards;
+};
+
+
+//------------------------------------------------------------------------------
+// Prototypes for private functions
+//------------------------------------------------------------------------------
+
+/**
+ * @function Implements the GtNodeStream interface for this class.
+ */
+static const GtNodeStreamClass* seqid_filter_stream_class(void);
+
+/**
+ * @function Class destructor.
+ */
+static void seqid_filter_stream_free(GtNodeStream *ns);
+
+/**
+ * @function Determine whether nodes on the given sequence should be kept.
+ */
+static bool seqid_filter_stream_keep_seqid(AgnSeqidFilterStream *stream,
+                                           const char *seqid);
+
+/**
+ * @function Pulls nodes from the input stream and feeds them to the output
+ * stream if they belong to one of the selected sequences.
+ */
+static int seqid_filter_stream_next(GtNodeStream *ns, GtGenomeNode **gn,
+                                    GtError *error);
+
+/**
+ * @function Assign a sequence to a shard. This is a simple string hash (djb2)
+ * rather than ``gt_hashmap``'s, so that the assignment never changes between
+ * runs, platforms, or library versions.
+ */
+static GtUword seqid_filter_stream_shard(const char *seqid, GtUword numshards);
+
+/**
+ * @function Read the features and sequence regions kept by a filter that
+ * selects ``seqids`` (if non-NULL) and the given shard (if ``numshards`` > 0).
+ */
+static GtArray *seqid_filter_stream_test_data(GtStrArray *seqids,
+                                              GtUword shard, GtUword numshards);
+
+
+//------------------------------------------------------------------------------
+// Method implementations
+//------------------------------------------------------------------------------
+
+void agn_seqid_filter_stream_keep(AgnSeqidFilterStream *stream,
+                                  const char *seqid)
+{
+  agn_assert(stream && seqid);
+  if(stream->seqids == NULL)
+    stream->seqids = gt_hashmap_new(GT_HASH_STRING, gt_free_func, NULL);
+  if(gt_hashmap_get(stream->seqids, seqid) == NULL)
+  {
+    char *key = gt_cstr_dup(seqid);
+    gt_hashmap_add(stream->seqids, key, key);
+  }
+}
+
+GtNodeStream* agn_seqid_filter_stream_new(GtNodeStream *in_stream)
+{
+  GtNodeStream *ns;
+  AgnSeqidFilterStream *stream;
+  agn_assert(in_stream);
+  ns = gt_node_stream_create(seqid_filter_stream_class(), false);
+  stream = seqid_filter_stream_cast(ns);
+  stream->in_stream = gt_node_stream_ref(in_stream);
+  stream->seqids = NULL;
+  stream->shard = 0;
+  stream->numshards = 0;
+  return ns;
+}
+
+void agn_seqid_filter_stream_set_shard(AgnSeqidFilterStream *stream,
+                                       GtUword shard, GtUword numshards)
+{
+  agn_assert(stream && shard >= 1 && shard <= numshards);
+  stream->shard = shard;
+  stream->numshards = numshards;
+}
+
+bool agn_seqid_filter_stream_unit_test(AgnUnitTest *test)
+{
+  GtArray *nodes;
+  GtUword i, j, total;
+
+  GtStrArray *seqids = gt_str_array_new();
+  gt_str_array_add_cstr(seqids, "seq07");
+  gt_str_array_add_cstr(seqids, "seq10");
+  nodes = seqid_filter_stream_test_data(seqids, 0, 0);
+  bool test1 = gt_array_size(nodes) == 6;
+  for(i = 0; i < gt_array_size(nodes); i++)
+  {
+    GtGenomeNode *gn = *(GtGenomeNode **)gt_array_get(nodes, i);
+    const char *seqid = gt_str_get(gt_genome_node_get_seqid(gn));
+    test1 = test1 && (strcmp(seqid, "seq07") == 0 ||
+                      strcmp(seqid, "seq10") == 0);
+    gt_genome_node_delete(gn);
+  }
+  gt_array_delete(nodes);
+  agn_unit_test_result(test, "select by name", test1);
+
+  nodes = seqid_filter_stream_test_data(NULL, 0, 0);
+  total = gt_array_size(nodes);
+  for(i = 0; i < gt_array_size(nodes); i++)
+    gt_genome_node_delete(*(GtGenomeNode **)gt_array_get(nodes, i));
+  gt_array_delete(nodes);
+  GtHashmap *seen = gt_hashmap_new(GT_HASH_STRING, gt_free_func, NULL);
+  GtUword shardtotal = 0;
+  bool test2 = true;
+  for(j = 1; j <= 3; j++)
+  {
+    nodes = seqid_filter_stream_test_data(NULL, j, 3);
+    shardtotal += gt_array_size(nodes);
+    for(i = 0; i < gt_array_size(nodes); i++)
+    {
+      GtGenomeNode *gn = *(GtGenomeNode **)gt_array_get(nodes, i);
+      const char *seqid = gt_str_get(gt_genome_node_get_seqid(gn));
+      GtUword prevshard = (GtUword)gt_hashmap_get(seen, seqid);
+      if(prevshard == 0)
+        gt_hashmap_add(seen, gt_cstr_dup(seqid), (void *)j);
+      else
+        test2 = test2 && prevshard == j;
+      gt_genome_node_delete(gn);
+    }
+    gt_array_delete(nodes);
+  }
+  test2 = test2 && total == 63 && shardtotal == total;
+  agn_unit_test_result(test, "shards", test2);
+  gt_hashmap_delete(seen);
+
+  nodes = seqid_filter_stream_test_data(seqids, 2, 3);
+  bool test3 = true;
+  for(i = 0; i < gt_array_size(nodes); i++)
+  {
+    GtGenomeNode *gn = *(GtGenomeNode **)gt_array_get(nodes, i);
+    const char *seqid = gt_str_get(gt_genome_node_get_seqid(gn));
+    test3 = test3 && (strcmp(seqid, "seq07") == 0 ||
+                      strcmp(seqid, "seq10") == 0) &&
+            seqid_filter_stream_shard(seqid, 3) == 2;
+    gt_genome_node_delete(gn);
+  }
+  GtUword expected = 0;
+  if(seqid_filter_stream_shard("seq07", 3) == 2)
+    expected += 3;
+  if(seqid_filter_stream_shard("seq10", 3) == 2)
+    expected += 3;
+  test3 = test3 && gt_array_size(nodes) == expected;
+  gt_array_delete(nodes);
+  agn_unit_test_result(test, "select by name and shard", test3);
+
+  gt_str_array_delete(seqids);
+  return agn_unit_test_success(test);
+}
+
+static const GtNodeStreamClass *seqid_filter_stream_class(void)
+{
+  static const GtNodeStreamClass *nsc = NULL;
+  if(!nsc)
+  {
+    nsc = gt_node_stream_class_new(sizeof (AgnSeqidFilterStream),
+                                   seqid_filter_stream_free,
+                                   seqid_filter_stream_next);
+  }
+  return nsc;
+}
+
+static void seqid_filter_stream_free(GtNodeStream *ns)
+{
+  AgnSeqidFilterStream *stream = seqid_filter_stream_cast(ns);
+  gt_node_stream_delete(stream->in_stream);
+  if(stream->seqids != NULL)
+    gt_hashmap_delete(stream->seqids);
+}
+
+static bool seqid_filter_stream_keep_seqid(AgnSeqidFilterStream *stream,
+                                           const char *seqid)
+{
+  if(stream->seqids != NULL && gt_hashmap_get(stream->seqids, seqid) == NULL)
+    return false;
+  if(stream->numshards > 0 &&
+     seqid_filter_stream_shard(seqid, stream->numshards) != stream->shard)
+    return false;
+  return true;
+}
+
+static int seqid_filter_stream_next(GtNodeStream *ns, GtGenomeNode **gn,
+                                    GtError *error)
+{
+  AgnSeqidFilterStream *stream;
+  int had_err;
+  gt_error_check(error);
+  stream = seqid_filter_stream_cast(ns);
+
+  while(1)
+  {
+    had_err = gt_node_stream_next(stream->in_stream, gn, error);
+    if(had_err)
+      return had_err;
+    if(!*gn)
+      return 0;
+
+    if(!gt_feature_node_try_cast(*gn) && !gt_region_node_try_cast(*gn))
+      return 0;
+
+    const char *seqid = gt_str_get(gt_genome_node_get_seqid(*gn));
+    if(seqid_filter_stream_keep_seqid(stream, seqid))
+      return 0;
+
+    gt_genome_node_delete(*gn);
+  }
+
+  return 0;
+}
+
+static GtUword seqid_filter_stream_shard(const char *seqid, GtUword numshards)
+{
+  const unsigned char *c;
+  GtUword hash = 5381;
+  for(c = (const unsigned char *)seqid; *c != '\0'; c++)
+    hash = ((hash << 5) + hash + *c) & 0xffffffff;
+  return (hash % numshards) + 1;
+}
+
+static GtArray *seqid_filter_stream_test_data(GtStrArray *seqids,
+                                              GtUword shard, GtUword numshards)
+{
+  GtError *error = gt_error_new();
+  const char *infile = "data/gff3/ilocus.in.gff3";
+  GtNodeStream *gff3in = gt_gff3_in_stream_new_unsorted(1, &infile);
+  gt_gff3_in_stream_check_id_attributes((GtGFF3InStream *)gff3in);
+  gt_gff3_in_stream_enable_tidy_mode((GtGFF3InStream *)gff3in);
+  GtNodeStream *filter = agn_seqid_filter_stream_new(gff3in);
+  AgnSeqidFilterStream *sfs = seqid_filter_stream_cast(filter);
+  GtUword i;
+  for(i = 0; seqids != NULL && i < gt_str_array_size(seqids); i++)
+    agn_seqid_filter_stream_keep(sfs, gt_str_array_get(seqids, i));
+  if(numshards > 0)
+    agn_seqid_filter_stream_set_shard(sfs, shard, numshards);
+
+  GtArray *nodes = gt_array_new( sizeof(GtGenomeNode *) );
+  GtGenomeNode *gn;
+  int result;
+  while((result = gt_node_stream_next(filter, &gn, error)) == 0 && gn != NULL)
+  {
+    if(gt_feature_node_try_cast(gn) || gt_region_node_try_cast(gn))
+      gt_array_add(nodes, gn);
+    else
+      gt_genome_node_delete(gn);
+  }
+  if(result == -1)
+  {
+    fprintf(stderr, "[AgnSeqidFilterStream::seqid_filter_stream_test_data] "
+            "error processing features: %s\n", gt_error_get(error));
+  }
+
+  gt_node_stream_delete(filter);
+  gt_node_stream_delete(gff3in);
+  gt_error_delete(error);
+  return nodes;
+}
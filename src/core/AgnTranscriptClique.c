@@ -46,6 +46,15 @@ static void clique_ids_put(GtFeatureNode *fn, GtHashmap *map);
  */
 static void clique_size(GtFeatureNode *fn, GtWord *count);
 
+/**
+ * @function Label nucleotides ``start`` through ``end`` (locus-relative
+ * offsets) as ``type`` in the given segment array, overwriting any existing
+ * labels in that range. ``buffer`` is used as scratch space. Adjacent segments
+ * with the same label are merged so that each segment is a maximal run.
+ */
+static void clique_segments_paint(GtArray *segments, GtArray *buffer,
+                                  GtUword start, GtUword end, char type);
+
 /**
  * @function Generate data for unit testing.
  */
@@ -87,7 +96,7 @@ static void clique_traverse_direct(AgnTranscriptClique *clique,
 static void clique_utr_count(GtFeatureNode *fn, GtWord *count);
 
 /**
- * @function Update the clique's model vector whenever a new transcript is
+ * @function Update the clique's model segments whenever a new transcript is
  * added.
  */
 static void clique_vector_update(AgnTranscriptClique *clique,
@@ -145,9 +154,63 @@ void agn_transcript_clique_delete(AgnTranscriptClique *clique)
   gt_genome_node_delete(clique);
 }
 
+GtArray *agn_transcript_clique_get_model_segments(AgnTranscriptClique *clique)
+{
+  return gt_genome_node_get_user_data(clique, "modelsegments");
+}
+
+void agn_transcript_clique_get_model_summary(AgnTranscriptClique *clique,
+                                             AgnModelSummary *summary)
+{
+  GtArray *segments = gt_genome_node_get_user_data(clique, "modelsegments");
+  AgnModelSegment *segs = gt_array_get_space(segments);
+  GtUword i, numsegs = gt_array_size(segments);
+  summary->cds_length = summary->utr_length = 0;
+  summary->num_cds = summary->num_exons = 0;
+
+  for(i = 0; i < numsegs; i++)
+  {
+    GtUword length = segs[i].end - segs[i].start + 1;
+    bool contiguous = i > 0 && segs[i-1].end + 1 == segs[i].start;
+    if(segs[i].type == 'C')
+    {
+      summary->cds_length += length;
+      if(!contiguous || segs[i-1].type != 'C')
+        summary->num_cds++;
+    }
+    else if(segs[i].type == 'F' || segs[i].type == 'T')
+      summary->utr_length += length;
+    else
+      continue;
+
+    if(!contiguous || segs[i-1].type == 'I')
+      summary->num_exons++;
+  }
+}
+
 const char *agn_transcript_clique_get_model_vector(AgnTranscriptClique *clique)
 {
-  return gt_genome_node_get_user_data(clique, "modelvector");
+  char *modelvector = gt_genome_node_get_user_data(clique, "modelvector");
+  if(modelvector != NULL)
+    return modelvector;
+
+  GtUword length = gt_genome_node_get_length(clique);
+  modelvector = gt_malloc( sizeof(char) * (length + 1) );
+  memset(modelvector, 'G', length);
+  modelvector[length] = '\0';
+
+  GtArray *segments = gt_genome_node_get_user_data(clique, "modelsegments");
+  GtUword i;
+  for(i = 0; i < gt_array_size(segments); i++)
+  {
+    AgnModelSegment *seg = gt_array_get(segments, i);
+    agn_assert(seg->end < length);
+    memset(modelvector + seg->start, seg->type, seg->end - seg->start + 1);
+  }
+  gt_genome_node_add_user_data(clique, "modelvector", modelvector,
+                               gt_free_func);
+
+  return modelvector;
 }
 
 bool agn_transcript_clique_has_id_in_hash(AgnTranscriptClique *clique,
@@ -225,14 +288,9 @@ AgnTranscriptClique *agn_transcript_clique_new(AgnSequenceRegion *region)
                                                            region->range.end,
                                                            GT_STRAND_BOTH);
 
-  GtUword length = gt_range_length(&region->range);
-  char *modelvector = gt_malloc( sizeof(char) * (length + 1) );
-  GtUword i;
-  for(i = 0; i < length; i++)
-    modelvector[i] = 'G';
-  modelvector[length] = '\0';
-  gt_genome_node_add_user_data(clique, "modelvector", modelvector,
-                               gt_free_func);
+  GtArray *segments = gt_array_new( sizeof(AgnModelSegment) );
+  gt_genome_node_add_user_data(clique, "modelsegments", segments,
+                               (GtFree)gt_array_delete);
 
   return clique;
 }
@@ -308,6 +366,12 @@ bool agn_transcript_clique_unit_test(AgnUnitTest *test)
                      strcmp(modelvector, testmodelvector) == 0 &&
                      agn_transcript_clique_size(clique) == 1;
   agn_unit_test_result(test, "simple check", simplecheck);
+
+  GtArray *segments = agn_transcript_clique_get_model_segments(clique);
+  AgnModelSegment *seg = gt_array_get_first(segments);
+  bool segmentcheck = gt_array_size(segments) == 1 && seg->type == 'C' &&
+                      seg->start == 9 && seg->end == 89;
+  agn_unit_test_result(test, "model segments", segmentcheck);
   agn_transcript_clique_delete(clique);
 
   clique = gt_queue_get(queue);
@@ -317,6 +381,13 @@ bool agn_transcript_clique_unit_test(AgnUnitTest *test)
                       agn_transcript_clique_num_utrs(clique) == 0;
   agn_unit_test_result(test, "two mRNAs", twomrnacheck);
 
+  AgnModelSummary summary;
+  agn_transcript_clique_get_model_summary(clique, &summary);
+  bool summarycheck = summary.num_cds == 10 && summary.num_exons == 10 &&
+                      summary.utr_length == 0 && summary.cds_length ==
+                      agn_transcript_clique_cds_length(clique);
+  agn_unit_test_result(test, "model summary", summarycheck);
+
   clique_copy = agn_transcript_clique_copy(clique);
   GtArray *clique_feats = agn_transcript_clique_to_array(clique);
   GtFeatureNode *fn1a = *(GtFeatureNode **)gt_array_get_first(clique_feats);
@@ -366,6 +437,72 @@ static void clique_ids_put(GtFeatureNode *fn, GtHashmap *map)
   gt_hashmap_add(map, (char *)tid, (char *)tid);
 }
 
+static void clique_segments_paint(GtArray *segments, GtArray *buffer,
+                                  GtUword start, GtUword end, char type)
+{
+  agn_assert(start <= end);
+  AgnModelSegment newseg = { start, end, type };
+  GtUword i, numsegs = gt_array_size(segments);
+
+  // Fast path: segments are usually painted left to right without overlap
+  AgnModelSegment *last = numsegs > 0 ? gt_array_get_last(segments) : NULL;
+  if(last == NULL || last->end < start)
+  {
+    if(last != NULL && last->type == type && last->end + 1 == start)
+      last->end = end;
+    else
+      gt_array_add(segments, newseg);
+    return;
+  }
+
+  gt_array_reset(buffer);
+  bool added = false;
+  for(i = 0; i < numsegs; i++)
+  {
+    AgnModelSegment seg = *(AgnModelSegment *)gt_array_get(segments, i);
+    if(seg.end < start)
+    {
+      gt_array_add(buffer, seg);
+      continue;
+    }
+    if(seg.start < start)
+    {
+      AgnModelSegment left = { seg.start, start - 1, seg.type };
+      gt_array_add(buffer, left);
+    }
+    if(!added && seg.start > end)
+    {
+      gt_array_add(buffer, newseg);
+      added = true;
+    }
+    if(seg.end > end)
+    {
+      if(!added)
+      {
+        gt_array_add(buffer, newseg);
+        added = true;
+      }
+      AgnModelSegment right = { seg.start > end ? seg.start : end + 1, seg.end,
+                                seg.type };
+      gt_array_add(buffer, right);
+    }
+  }
+  if(!added)
+    gt_array_add(buffer, newseg);
+
+  gt_array_reset(segments);
+  for(i = 0; i < gt_array_size(buffer); i++)
+  {
+    AgnModelSegment *seg = gt_array_get(buffer, i);
+    GtUword size = gt_array_size(segments);
+    last = size > 0 ? gt_array_get_last(segments) : NULL;
+    if(last != NULL && last->type == seg->type && last->end + 1 == seg->start)
+      last->end = seg->end;
+    else
+      gt_array_add(segments, *seg);
+  }
+}
+
 static void clique_size(GtFeatureNode *fn, GtWord *count)
 {
   agn_assert(agn_typecheck_transcript(fn));
@@ -534,10 +671,14 @@ static void clique_vector_update(AgnTranscriptClique *clique,
 {
   GtRange locusrange = gt_genome_node_get_range(clique);
   GtRange transrange = gt_genome_node_get_range((GtGenomeNode *)transcript);
-  char *modelvector = gt_genome_node_get_user_data(clique, "modelvector");
+  GtArray *segments = gt_genome_node_get_user_data(clique, "modelsegments");
   agn_assert(gt_range_contains(&locusrange, &transrange));
-  agn_assert(gt_range_length(&locusrange) == strlen(modelvector));
 
+  // Any cached model vector is now out of date
+  if(gt_genome_node_get_user_data(clique, "modelvector") != NULL)
+    gt_genome_node_release_user_data(clique, "modelvector");
+
+  GtArray *buffer = gt_array_new( sizeof(AgnModelSegment) );
   GtFeatureNode *fn;
   GtFeatureNodeIterator *iter = gt_feature_node_iterator_new(transcript);
   for(fn = gt_feature_node_iterator_next(iter);
@@ -562,14 +703,9 @@ static void clique_vector_update(AgnTranscriptClique *clique,
 
     GtUword fn_start = gt_genome_node_get_start((GtGenomeNode *)fn);
     GtUword fn_end = gt_genome_node_get_end((GtGenomeNode *)fn);
-    GtUword i;
-
-    for(i = fn_start - locusrange.start;
-        i < fn_end - locusrange.start + 1;
-        i++)
-    {
-      modelvector[i] = c;
-    }
+    clique_segments_paint(segments, buffer, fn_start - locusrange.start,
+                          fn_end - locusrange.start, c);
   }
   gt_feature_node_iterator_delete(iter);
+  gt_array_delete(buffer);
 }
@@ -0,0 +1,301 @@
+/**
+
+Copyright (c) 2010-2016, Daniel S. Standage and CONTRIBUTORS
+
+The AEGeAn Toolkit is distributed under the ISC License. See
+the 'LICENSE' file in the AEGeAn source code distribution or
+online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
+
+**/
+#include <string.h>
+#include <time.h>
+#include "core/symbol_api.h"
+#include "extended/feature_node_iterator_api.h"
+#include "AgnTypeCounter.h"
+#include "AgnUtils.h"
+
+//------------------------------------------------------------------------------
+// Data structure definitions
+//------------------------------------------------------------------------------
+
+/**
+ * The tally of one feature type: the interned type, the name of the attribute
+ * holding its count, and its count for the current feature.
+ */
+typedef struct
+{
+  const char *type;
+  char *key;
+  GtUword count;
+} TypeTally;
+
+/**
+ * ``allocations`` counts the calls made by the counter to functions that
+ * always allocate memory, for benchmarking.
+ */
+struct AgnTypeCounter
+{
+  GtArray *tallies;
+  GtArray *order;
+  GtUword allocations;
+};
+
+
+//------------------------------------------------------------------------------
+// Prototypes for private functions
+//------------------------------------------------------------------------------
+
+/**
+ * @function Count one feature of the given type.
+ */
+static void type_counter_add(AgnTypeCounter *counter, const char *type);
+
+/**
+ * @function Create ``numloci`` synthetic loci, each with a few genes and
+ * transcripts of different types, and store them in ``loci``.
+ */
+static void type_counter_synthetic_loci(GtUword numloci, GtArray *loci);
+
+
+//------------------------------------------------------------------------------
+// Method definitions
+//------------------------------------------------------------------------------
+
+bool agn_type_counter_benchmark(AgnUnitTest *test)
+{
+  GtUword sizes[] = { 10000, 50000, 100000 };
+  GtUword i, j;
+  AgnTypeCounter *counter = agn_type_counter_new();
+  for(i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+  {
+    char label[64];
+    GtArray *loci = gt_array_new( sizeof(GtFeatureNode *) );
+    type_counter_synthetic_loci(sizes[i], loci);
+
+    // Even-numbered loci have 3 genes (4 mRNAs and an ncRNA), odd-numbered
+    // loci have 2 (4 mRNAs). Once all three types have been seen, each locus
+    // takes one iterator for the locus and one for each gene.
+    GtUword numtypes = gt_array_size(counter->tallies);
+    GtUword expected = 3 - numtypes;
+    counter->allocations = 0;
+    clock_t start = clock();
+    for(j = 0; j < sizes[i]; j++)
+    {
+      GtFeatureNode **fn = gt_array_get(loci, j);
+      agn_type_counter_count_children(counter, *fn);
+      expected += 1 + (j % 2 == 0 ? 3 : 2);
+    }
+    clock_t end = clock();
+    double elapsed = (double)(end - start) / CLOCKS_PER_SEC;
+
+    bool correct = true;
+    for(j = 0; correct && j < sizes[i]; j++)
+    {
+      GtFeatureNode *fn = *(GtFeatureNode **)gt_array_get(loci, j);
+      const char *genes = gt_feature_node_get_attribute(fn, "child_gene");
+      const char *mrnas = gt_feature_node_get_attribute(fn, "child_mRNA");
+      const char *ncrnas = gt_feature_node_get_attribute(fn, "child_ncRNA");
+      correct = genes && strcmp(genes, j % 2 == 0 ? "3" : "2") == 0 &&
+                mrnas && strcmp(mrnas, "4") == 0 &&
+                (j % 2 == 0 ? ncrnas && strcmp(ncrnas, "1") == 0
+                            : ncrnas == NULL);
+    }
+    printf("        [child types] %6lu loci: %.3fs (%.0f loci/s), %.2f "
+           "allocations per locus\n", sizes[i], elapsed,
+           elapsed > 0.0 ? sizes[i] / elapsed : 0.0,
+           (double)counter->allocations / sizes[i]);
+    sprintf(label, "correct tallies, %lu loci", sizes[i]);
+    agn_unit_test_result(test, label, correct);
+    sprintf(label, "expected allocations, %lu loci", sizes[i]);
+    agn_unit_test_result(test, label, counter->allocations == expected);
+
+    while(gt_array_size(loci) > 0)
+    {
+      GtGenomeNode **gn = gt_array_pop(loci);
+      gt_genome_node_delete(*gn);
+    }
+    gt_array_delete(loci);
+  }
+  agn_type_counter_delete(counter);
+  return agn_unit_test_success(test);
+}
+
+void agn_type_counter_count_children(AgnTypeCounter *counter,
+                                     GtFeatureNode *fn)
+{
+  agn_assert(counter && fn);
+
+  GtFeatureNode *child;
+  GtFeatureNodeIterator *iter = gt_feature_node_iterator_new_direct(fn);
+  counter->allocations++;
+  for(child  = gt_feature_node_iterator_next(iter);
+      child != NULL;
+      child  = gt_feature_node_iterator_next(iter))
+  {
+    type_counter_add(counter, gt_feature_node_get_type(child));
+    if(gt_feature_node_number_of_children(child) == 0)
+      continue;
+
+    GtFeatureNodeIterator *subiter = gt_feature_node_iterator_new_direct(child);
+    counter->allocations++;
+    GtFeatureNode *grandchild;
+    for(grandchild  = gt_feature_node_iterator_next(subiter);
+        grandchild != NULL;
+        grandchild  = gt_feature_node_iterator_next(subiter))
+    {
+      type_counter_add(counter, gt_feature_node_get_type(grandchild));
+    }
+    gt_feature_node_iterator_delete(subiter);
+  }
+  gt_feature_node_iterator_delete(iter);
+
+  GtUword i;
+  TypeTally *tallies = gt_array_get_space(counter->tallies);
+  for(i = 0; i < gt_array_size(counter->order); i++)
+  {
+    GtUword *index = gt_array_get(counter->order, i);
+    TypeTally *tally = tallies + *index;
+    char value[32];
+    sprintf(value, "%lu", tally->count);
+    gt_feature_node_set_attribute(fn, tally->key, value);
+    tally->count = 0;
+  }
+  gt_array_reset(counter->order);
+}
+
+void agn_type_counter_delete(AgnTypeCounter *counter)
+{
+  GtUword i;
+  for(i = 0; i < gt_array_size(counter->tallies); i++)
+  {
+    TypeTally *tally = gt_array_get(counter->tallies, i);
+    gt_free(tally->key);
+  }
+  gt_array_delete(counter->tallies);
+  gt_array_delete(counter->order);
+  gt_free(counter);
+}
+
+AgnTypeCounter *agn_type_counter_new(void)
+{
+  AgnTypeCounter *counter = gt_malloc( sizeof(AgnTypeCounter) );
+  counter->tallies = gt_array_new( sizeof(TypeTally) );
+  counter->order = gt_array_new( sizeof(GtUword) );
+  counter->allocations = 0;
+  return counter;
+}
+
+bool agn_type_counter_unit_test(AgnUnitTest *test)
+{
+  GtArray *loci = gt_array_new( sizeof(GtFeatureNode *) );
+  type_counter_synthetic_loci(3, loci);
+  AgnTypeCounter *counter = agn_type_counter_new();
+  GtUword i;
+  for(i = 0; i < gt_array_size(loci); i++)
+  {
+    GtFeatureNode **fn = gt_array_get(loci, i);
+    agn_type_counter_count_children(counter, *fn);
+  }
+
+  GtFeatureNode *locus = *(GtFeatureNode **)gt_array_get(loci, 0);
+  const char *genes = gt_feature_node_get_attribute(locus, "child_gene");
+  const char *mrnas = gt_feature_node_get_attribute(locus, "child_mRNA");
+  const char *ncrnas = gt_feature_node_get_attribute(locus, "child_ncRNA");
+  bool test1 = genes && strcmp(genes, "3") == 0 && mrnas &&
+               strcmp(mrnas, "4") == 0 && ncrnas && strcmp(ncrnas, "1") == 0;
+  agn_unit_test_result(test, "counts", test1);
+
+  locus = *(GtFeatureNode **)gt_array_get(loci, 1);
+  genes = gt_feature_node_get_attribute(locus, "child_gene");
+  mrnas = gt_feature_node_get_attribute(locus, "child_mRNA");
+  ncrnas = gt_feature_node_get_attribute(locus, "child_ncRNA");
+  bool test2 = genes && strcmp(genes, "2") == 0 && mrnas &&
+               strcmp(mrnas, "4") == 0 && ncrnas == NULL;
+  agn_unit_test_result(test, "counts reset between loci", test2);
+
+  GtStrArray *attrs = gt_feature_node_get_attribute_list(locus);
+  bool test3 = gt_str_array_size(attrs) == 2 &&
+               strcmp(gt_str_array_get(attrs, 0), "child_gene") == 0 &&
+               strcmp(gt_str_array_get(attrs, 1), "child_mRNA") == 0;
+  agn_unit_test_result(test, "attribute order", test3);
+  gt_str_array_delete(attrs);
+
+  agn_type_counter_delete(counter);
+  while(gt_array_size(loci) > 0)
+  {
+    GtGenomeNode **gn = gt_array_pop(loci);
+    gt_genome_node_delete(*gn);
+  }
+  gt_array_delete(loci);
+  return agn_unit_test_success(test);
+}
+
+static void type_counter_add(AgnTypeCounter *counter, const char *type)
+{
+  GtUword i, numtypes = gt_array_size(counter->tallies);
+  TypeTally *tallies = gt_array_get_space(counter->tallies);
+  for(i = 0; i < numtypes; i++)
+  {
+    if(tallies[i].type == type)
+      break;
+  }
+  if(i == numtypes)
+  {
+    // Types are normally interned, but compare strings before adding a type
+    for(i = 0; i < numtypes; i++)
+    {
+      if(strcmp(tallies[i].type, type) == 0)
+        break;
+    }
+  }
+  if(i == numtypes)
+  {
+    TypeTally tally;
+    tally.type = gt_symbol(type);
+    tally.key = gt_malloc( sizeof(char) * (strlen(type) + 7) );
+    counter->allocations++;
+    sprintf(tally.key, "child_%s", type);
+    tally.count = 0;
+    gt_array_add(counter->tallies, tally);
+    tallies = gt_array_get_space(counter->tallies);
+  }
+
+  if(tallies[i].count == 0)
+    gt_array_add(counter->order, i);
+  tallies[i].count++;
+}
+
+static void type_counter_synthetic_loci(GtUword numloci, GtArray *loci)
+{
+  GtStr *seqid = gt_str_new_cstr("chr");
+  GtUword i, j;
+  for(i = 0; i < numloci; i++)
+  {
+    GtUword start = 1 + (i * 10000);
+    GtGenomeNode *locus = gt_feature_node_new(seqid, "locus", start,
+                                              start + 9000, GT_STRAND_BOTH);
+    GtUword numgenes = 2 + ((i + 1) % 2);
+    for(j = 0; j < numgenes; j++)
+    {
+      GtUword genestart = start + (j * 3000);
+      GtUword geneend = genestart + 2000;
+      GtGenomeNode *gene = gt_feature_node_new(seqid, "gene", genestart,
+                                               geneend, GT_STRAND_FORWARD);
+      const char *rnatype = j == 2 ? "ncRNA" : "mRNA";
+      GtUword numrnas = j == 2 ? 1 : 2;
+      GtUword k;
+      for(k = 0; k < numrnas; k++)
+      {
+        GtGenomeNode *rna = gt_feature_node_new(seqid, rnatype, genestart,
+                                                geneend, GT_STRAND_FORWARD);
+        GtGenomeNode *exon = gt_feature_node_new(seqid, "exon", genestart,
+                                                 geneend, GT_STRAND_FORWARD);
+        gt_feature_node_add_child((GtFeatureNode *)rna, (GtFeatureNode *)exon);
+        gt_feature_node_add_child((GtFeatureNode *)gene, (GtFeatureNode *)rna);
+      }
+      gt_feature_node_add_child((GtFeatureNode *)locus, (GtFeatureNode *)gene);
+    }
+    gt_array_add(loci, locus);
+  }
+  gt_str_delete(seqid);
+}
@@ -201,6 +201,44 @@ const char *agn_feature_node_get_label(GtFeatureNode *fn)
   return label;
 }
 
+void agn_feature_node_get_summary(GtFeatureNode *fn,
+                                  AgnFeatureSummary *summary)
+{
+  agn_assert(fn && summary);
+  AgnFeatureSummary *stored = gt_genome_node_get_user_data((GtGenomeNode *)fn,
+                                                           "agn_summary");
+  if(stored != NULL)
+  {
+    *summary = *stored;
+    return;
+  }
+
+  summary->range = gt_genome_node_get_range((GtGenomeNode *)fn);
+  summary->cds.start = 0;
+  summary->cds.end = 0;
+  summary->has_cds = false;
+  summary->num_exons = 0;
+  GtFeatureNodeIterator *iter = gt_feature_node_iterator_new(fn);
+  GtFeatureNode *child;
+  for(child = gt_feature_node_iterator_next(iter);
+      child != NULL;
+      child = gt_feature_node_iterator_next(iter))
+  {
+    if(agn_typecheck_exon(child))
+      summary->num_exons++;
+    else if(agn_typecheck_cds(child))
+    {
+      GtRange childrange = gt_genome_node_get_range((GtGenomeNode *)child);
+      if(summary->has_cds)
+        summary->cds = gt_range_join(&summary->cds, &childrange);
+      else
+        summary->cds = childrange;
+      summary->has_cds = true;
+    }
+  }
+  gt_feature_node_iterator_delete(iter);
+}
+
 void agn_feature_node_remove_tree(GtFeatureNode *root, GtFeatureNode *fn)
 {
   agn_assert(root && fn);
@@ -216,6 +254,17 @@ void agn_feature_node_remove_tree(GtFeatureNode *root, GtFeatureNode *fn)
   gt_feature_node_remove_leaf(root, fn);
 }
 
+void agn_feature_node_summarize(GtFeatureNode *fn)
+{
+  agn_assert(fn);
+  GtGenomeNode *gn = (GtGenomeNode *)fn;
+  if(gt_genome_node_get_user_data(gn, "agn_summary") != NULL)
+    gt_genome_node_release_user_data(gn, "agn_summary");
+  AgnFeatureSummary *summary = gt_malloc( sizeof(AgnFeatureSummary) );
+  agn_feature_node_get_summary(fn, summary);
+  gt_genome_node_add_user_data(gn, "agn_summary", summary, gt_free_func);
+}
+
 int agn_genome_node_compare(GtGenomeNode **gn_a, GtGenomeNode **gn_b)
 {
   return gt_genome_node_cmp(*gn_a, *gn_b);
@@ -274,10 +323,13 @@ bool agn_overlap_ilocus(GtGenomeNode *f1, GtGenomeNode *f2,
 
   if(by_cds)
   {
-    GtRange c1 = agn_feature_node_get_cds_range((GtFeatureNode *)f1);
-    GtRange c2 = agn_feature_node_get_cds_range((GtFeatureNode *)f2);
-    bool has_cds_1 = c1.end != 0;
-    bool has_cds_2 = c2.end != 0;
+    AgnFeatureSummary s1, s2;
+    agn_feature_node_get_summary((GtFeatureNode *)f1, &s1);
+    agn_feature_node_get_summary((GtFeatureNode *)f2, &s2);
+    GtRange c1 = s1.cds;
+    GtRange c2 = s2.cds;
+    bool has_cds_1 = s1.has_cds;
+    bool has_cds_2 = s2.has_cds;
     if(has_cds_1 != has_cds_2)
     {
       // One feature has a CDS, the other doesn't, so they should belong to
@@ -368,3 +420,53 @@ GtStrArray* agn_str_array_union(GtStrArray *a1, GtStrArray *a2)
   gt_array_delete(strings);
   return uniona;
 }
+
+bool agn_str_read(FILE *instream, GtStr *str)
+{
+  GtUword length;
+  char buffer[256];
+  gt_str_reset(str);
+  if(!agn_uword_read(instream, &length))
+    return false;
+  while(length > 0)
+  {
+    GtUword chunk = length < sizeof (buffer) ? length : sizeof (buffer);
+    if(fread(buffer, 1, chunk, instream) != chunk)
+      return false;
+    gt_str_append_cstr_nt(str, buffer, chunk);
+    length -= chunk;
+  }
+  return true;
+}
+
+bool agn_str_write(FILE *outstream, const char *str)
+{
+  GtUword length = strlen(str);
+  if(!agn_uword_write(outstream, length))
+    return false;
+  return fwrite(str, 1, length, outstream) == length;
+}
+
+bool agn_uword_read(FILE *instream, GtUword *value)
+{
+  unsigned char bytes[8];
+  int i;
+  if(fread(bytes, 1, 8, instream) != 8)
+    return false;
+  *value = 0;
+  for(i = 7; i >= 0; i--)
+    *value = (*value << 8) | bytes[i];
+  return true;
+}
+
+bool agn_uword_write(FILE *outstream, GtUword value)
+{
+  unsigned char bytes[8];
+  int i;
+  for(i = 0; i < 8; i++)
+  {
+    bytes[i] = (unsigned char)(value & 0xff);
+    value >>= 8;
+  }
+  return fwrite(bytes, 1, 8, outstream) == 8;
+}
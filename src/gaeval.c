@@ -11,9 +11,11 @@ online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
 #include <getopt.h>
 #include <math.h>
 #include "genometools.h"
+#include "AgnGaevalParallelStream.h"
 #include "AgnGaevalVisitor.h"
 #include "AgnInferCDSVisitor.h"
 #include "AgnInferExonsVisitor.h"
+#include "AgnMergeStream.h"
 #include "AgnUtils.h"
 
 typedef struct
@@ -22,6 +24,8 @@ typedef struct
   const char **genefiles;
   int numgenefiles;
   GtStr *tsvout;
+  bool sorted;
+  GtUword numthreads;
   AgnGaevalParams params;
 } GaevalOptions;
 
@@ -45,6 +49,14 @@ static void print_usage(FILE *outstream)
 "  Basic options:\n"
 "    -h|--help               print this help message and exit\n"
 "    -v|--version            print version number and exit\n"
+"    -j|--threads: INT       number of threads to use for scoring gene\n"
+"                            models; output is written in input order;\n"
+"                            default is 1\n"
+"    -S|--sorted             alignments and gene models are already sorted\n"
+"                            (as with 'gt gff3 -sort'); read alignments\n"
+"                            alongside the gene models rather than loading\n"
+"                            them all into memory, and fail on any feature\n"
+"                            out of order\n"
 "    -t|--tsv FILE           print coverage and integrity scores to the\n"
 "                            specified file in tab-separated text\n\n"
 "  Weights for calculating integrity score (must add up to 1.0):\n"
@@ -62,14 +74,18 @@ static void print_usage(FILE *outstream)
 static void parse_options(int argc, char **argv, GaevalOptions *options)
 {
   options->tsvout = NULL;
+  options->sorted = false;
+  options->numthreads = 1;
   default_params(&options->params);
   int opt = 0;
   int optindex = 0;
-  const char *optstr = "hvt:a:b:g:e:c:5:3:";
+  const char *optstr = "hvj:St:a:b:g:e:c:5:3:";
   const struct option gaeval_options[] =
   {
     { "help",      no_argument,       NULL, 'h' },
     { "version",   no_argument,       NULL, 'v' },
+    { "threads",   required_argument, NULL, 'j' },
+    { "sorted",    no_argument,       NULL, 'S' },
     { "tsv",       required_argument, NULL, 't' },
     { "alpha",     required_argument, NULL, 'a' },
     { "beta",      required_argument, NULL, 'b' },
@@ -88,6 +104,8 @@ static void parse_options(int argc, char **argv, GaevalOptions *options)
       options->params.exp_3putr_len = atoi(optarg);
     else if(opt == '5')
       options->params.exp_5putr_len = atoi(optarg);
+    else if(opt == 'S')
+      options->sorted = true;
     else if(opt == 'a')
       options->params.alpha = atof(optarg);
     else if(opt == 'b')
@@ -103,6 +121,16 @@ static void parse_options(int argc, char **argv, GaevalOptions *options)
     }
     else if(opt == 'g')
       options->params.gamma = atof(optarg);
+    else if(opt == 'j')
+    {
+      if(sscanf(optarg, "%lu", &options->numthreads) != 1 ||
+         options->numthreads == 0)
+      {
+        fprintf(stderr, "error: could not convert threads '%s' to a positive "
+                "integer\n", optarg);
+        exit(1);
+      }
+    }
     else if(opt == 't')
     {
       if(options->tsvout != NULL)
@@ -155,16 +183,29 @@ int main(int argc, char **argv)
   parse_options(argc, argv, &options);
   streams = gt_queue_new();
 
-  stream = gt_gff3_in_stream_new_unsorted(1, &options.alignfile);
-  gt_gff3_in_stream_check_id_attributes((GtGFF3InStream *)stream);
-  gt_gff3_in_stream_enable_tidy_mode((GtGFF3InStream *)stream);
+  if(options.sorted)
+    stream = agn_merge_stream_new_gff3(1, &options.alignfile);
+  else
+  {
+    stream = gt_gff3_in_stream_new_unsorted(1, &options.alignfile);
+    gt_gff3_in_stream_check_id_attributes((GtGFF3InStream *)stream);
+    gt_gff3_in_stream_enable_tidy_mode((GtGFF3InStream *)stream);
+  }
   gt_queue_add(streams, stream);
   align_stream = stream;
 
-  stream = gt_gff3_in_stream_new_unsorted(options.numgenefiles,
-                                          options.genefiles);
-  gt_gff3_in_stream_check_id_attributes((GtGFF3InStream *)stream);
-  gt_gff3_in_stream_enable_tidy_mode((GtGFF3InStream *)stream);
+  if(options.sorted)
+  {
+    stream = agn_merge_stream_new_gff3(options.numgenefiles,
+                                       options.genefiles);
+  }
+  else
+  {
+    stream = gt_gff3_in_stream_new_unsorted(options.numgenefiles,
+                                            options.genefiles);
+    gt_gff3_in_stream_check_id_attributes((GtGFF3InStream *)stream);
+    gt_gff3_in_stream_enable_tidy_mode((GtGFF3InStream *)stream);
+  }
   gt_queue_add(streams, stream);
   last_stream = stream;
 
@@ -179,12 +220,22 @@ int main(int argc, char **argv)
   last_stream = stream;
   gt_str_delete(source);
 
-  GtNodeVisitor *nv = agn_gaeval_visitor_new(align_stream, options.params);
+  GtNodeVisitor *nv;
+  if(options.sorted)
+    nv = agn_gaeval_visitor_new_sorted(align_stream, options.params);
+  else
+    nv = agn_gaeval_visitor_new(align_stream, options.params);
   if(options.tsvout)
   {
     agn_gaeval_visitor_tsv_out((AgnGaevalVisitor *)nv, options.tsvout);
   }
-  stream = gt_visitor_stream_new(last_stream, nv);
+  if(options.numthreads > 1)
+  {
+    stream = agn_gaeval_parallel_stream_new(last_stream, nv,
+                                            options.numthreads);
+  }
+  else
+    stream = gt_visitor_stream_new(last_stream, nv);
   gt_queue_add(streams, stream);
   last_stream = stream;
 
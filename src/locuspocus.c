@@ -18,22 +18,27 @@ typedef struct
 {
   bool debug;
   GtHashmap *filter;
-  FILE *genestream;
+  AgnOutputSink *genestream;
   char *nameformat;
   unsigned long delta;
   GtFile *outstream;
   void (*filefreefunc)(GtFile *);
   GtHashmap *type_parents;
   int endmode;
-  FILE *transstream;
+  AgnOutputSink *transstream;
   bool pseudofix;
   bool verbose;
   bool skipiiLoci;
   bool refine;
   bool by_cds;
+  bool miloci;
   GtUword minoverlap;
-  FILE *ilenfile;
+  AgnOutputSink *ilenfile;
+  FILE *indexfile;
   bool retain;
+  bool sorted;
+  GtUword numthreads;
+  AgnILocusCache *cache;
 } LocusPocusOptions;
 
 // Set default values for program
@@ -56,9 +61,14 @@ static void set_option_defaults(LocusPocusOptions *options)
   options->skipiiLoci = false;
   options->refine = false;
   options->by_cds = false;
+  options->miloci = false;
   options->minoverlap = 1;
   options->ilenfile = NULL;
+  options->indexfile = NULL;
   options->retain = false;
+  options->sorted = false;
+  options->numthreads = 1;
+  options->cache = NULL;
 }
 
 static void free_option_memory(LocusPocusOptions *options)
@@ -66,14 +76,14 @@ static void free_option_memory(LocusPocusOptions *options)
   options->filefreefunc(options->outstream);
   gt_hashmap_delete(options->type_parents);
   gt_hashmap_delete(options->filter);
-  if(options->genestream != NULL)
-    fclose(options->genestream);
-  if(options->transstream != NULL)
-    fclose(options->transstream);
+  agn_output_sink_delete(options->genestream);
+  agn_output_sink_delete(options->transstream);
   if(options->nameformat != NULL)
     gt_free(options->nameformat);
-  if(options->ilenfile != NULL)
-    fclose(options->ilenfile);
+  agn_output_sink_delete(options->ilenfile);
+  if(options->indexfile != NULL)
+    fclose(options->indexfile);
+  agn_ilocus_cache_delete(options->cache);
 }
 
 // Usage statement
@@ -86,6 +96,14 @@ static void print_usage(FILE *outstream)
 "    -d|--debug             print detailed debugging messages to terminal\n"
 "                           (standard error)\n"
 "    -h|--help              print this help message and exit\n"
+"    -I|--incremental: DIR  store the iLoci of each sequence in the given\n"
+"                           directory, and reuse them in later runs for any\n"
+"                           sequence whose features and iLocus parsing\n"
+"                           settings have not changed\n"
+"    -j|--threads: INT      number of threads to use for computing iLoci;\n"
+"                           sequences are processed in parallel, and output\n"
+"                           is identical to that of a single thread; default\n"
+"                           is 1\n"
 "    -v|--version           print version number and exit\n\n"
 "  iLocus parsing:\n"
 "    -l|--delta: INT        when parsing interval loci, use the following\n"
@@ -106,7 +124,10 @@ static void print_usage(FILE *outstream)
 "                           overlap; implies 'refine' mode\n"
 "    -m|--minoverlap: INT   the minimum number of nucleotides two genes must\n"
 "                           overlap to be grouped in the same iLocus; default\n"
-"                           is 1\n\n"
+"                           is 1\n"
+"    -M|--miloci            merge adjacent or overlapping gene-containing\n"
+"                           iLoci into merged iLoci (miLoci); implies 'refine'\n"
+"                           mode\n\n"
 "  Output options:\n"
 "    -n|--namefmt: STR     provide a printf-style format string to override\n"
 "                           the default ID format for newly created loci;\n"
@@ -119,6 +140,9 @@ static void print_usage(FILE *outstream)
 "                           iLocus\n"
 "    -g|--genemap: FILE     print a mapping from each gene annotation to its\n"
 "                           corresponding locus to the given file\n"
+"    -x|--index: FILE       write a binary index of all iLoci and their genes\n"
+"                           and mRNAs to the given file, for fast lookups\n"
+"                           with the 'lpquery' program\n"
 "    -o|--outfile: FILE     name of file to which results will be written;\n"
 "                           default is terminal (standard output)\n"
 "    -T|--retainids         retain original feature IDs from input files;\n"
@@ -126,6 +150,9 @@ static void print_usage(FILE *outstream)
 "                           ID values\n"
 "    -t|--transmap: FILE    print a mapping from each transcript annotation\n"
 "                           to its corresponding locus to the given file\n"
+"                           (ilens, genemap, and transmap files are\n"
+"                           compressed with gzip if the filename ends in\n"
+"                           '.gz')\n"
 "    -V|--verbose           include all locus subfeatures (genes, RNAs, etc)\n"
 "                           in the GFF3 output; default includes only locus\n"
 "                           features\n\n"
@@ -137,6 +164,9 @@ static void print_usage(FILE *outstream)
 "                           for example, mRNA:gene will create a gene feature\n"
 "                           as a parent for any top-level mRNA feature;\n"
 "                           this option can be specified multiple times\n"
+"    -S|--sorted            input files are already sorted (as with 'gt gff3\n"
+"                           -sort'); merge them as they are read and fail on\n"
+"                           any feature out of order\n"
 "    -u|--pseudo            correct erroneously labeled pseudogenes\n\n");
 }
 
@@ -146,7 +176,7 @@ parse_options(int argc, char **argv, LocusPocusOptions *options, GtError *error)
 {
   int opt = 0;
   int optindex = 0;
-  const char *optstr = "cdef:g:hi:l:m:n:o:p:rsTt:uVvy";
+  const char *optstr = "cdef:g:hI:i:j:l:m:Mn:o:p:rSsTt:uVvx:y";
   const char *key, *value, *oldvalue;
   const struct option locuspocus_options[] =
   {
@@ -156,19 +186,24 @@ parse_options(int argc, char **argv, LocusPocusOptions *options, GtError *error)
     { "filter",     required_argument, NULL, 'f' },
     { "genemap",    required_argument, NULL, 'g' },
     { "help",       no_argument,       NULL, 'h' },
+    { "incremental", required_argument, NULL, 'I' },
     { "ilens",      required_argument, NULL, 'i' },
+    { "threads",    required_argument, NULL, 'j' },
     { "delta",      required_argument, NULL, 'l' },
     { "minoverlap", required_argument, NULL, 'm' },
+    { "miloci",     no_argument,       NULL, 'M' },
     { "namefmt",    required_argument, NULL, 'n' },
     { "outfile",    required_argument, NULL, 'o' },
     { "parent",     required_argument, NULL, 'p' },
     { "refine",     no_argument,       NULL, 'r' },
+    { "sorted",     no_argument,       NULL, 'S' },
     { "skipends",   no_argument,       NULL, 's' },
     { "retainids",  no_argument,       NULL, 'T' },
     { "transmap",   required_argument, NULL, 't' },
     { "pseudo",     no_argument,       NULL, 'u' },
     { "version",    no_argument,       NULL, 'v' },
     { "verbose",    no_argument,       NULL, 'V' },
+    { "index",      required_argument, NULL, 'x' },
     { "skipiiloci", no_argument,       NULL, 'y' },
     { NULL,         no_argument,       NULL,  0  },
   };
@@ -212,7 +247,8 @@ parse_options(int argc, char **argv, LocusPocusOptions *options, GtError *error)
     }
     else if(opt == 'g')
     {
-      options->genestream = fopen(optarg, "w");
+      agn_output_sink_delete(options->genestream);
+      options->genestream = agn_output_sink_new(optarg, error);
       if(options->genestream == NULL)
         gt_error_set(error, "could not open genemap file '%s'", optarg);
     }
@@ -221,12 +257,27 @@ parse_options(int argc, char **argv, LocusPocusOptions *options, GtError *error)
       print_usage(stdout);
       exit(0);
     }
+    else if(opt == 'I')
+    {
+      agn_ilocus_cache_delete(options->cache);
+      options->cache = agn_ilocus_cache_new(optarg, error);
+    }
     else if(opt == 'i')
     {
-      options->ilenfile = fopen(optarg, "w");
+      agn_output_sink_delete(options->ilenfile);
+      options->ilenfile = agn_output_sink_new(optarg, error);
       if(options->ilenfile == NULL)
         gt_error_set(error, "could not open ilenfile file '%s'", optarg);
     }
+    else if(opt == 'j')
+    {
+      if(sscanf(optarg, "%lu", &options->numthreads) != 1 ||
+         options->numthreads == 0)
+      {
+        gt_error_set(error, "could not convert threads '%s' to a positive "
+                     "integer", optarg);
+      }
+    }
     else if(opt == 'l')
     {
       if(sscanf(optarg, "%lu", &options->delta) == EOF)
@@ -243,6 +294,11 @@ parse_options(int argc, char **argv, LocusPocusOptions *options, GtError *error)
                      optarg);
       }
     }
+    else if(opt == 'M')
+    {
+      options->miloci = true;
+      options->refine = 1;
+    }
     else if(opt == 'n')
     {
       if(options->nameformat != NULL)
@@ -273,6 +329,8 @@ parse_options(int argc, char **argv, LocusPocusOptions *options, GtError *error)
     }
     else if(opt == 'r')
       options->refine = 1;
+    else if(opt == 'S')
+      options->sorted = true;
     else if(opt == 's')
     {
       if(options->endmode > 0)
@@ -286,7 +344,8 @@ parse_options(int argc, char **argv, LocusPocusOptions *options, GtError *error)
       options->retain = true;
     else if(opt == 't')
     {
-      options->transstream = fopen(optarg, "w");
+      agn_output_sink_delete(options->transstream);
+      options->transstream = agn_output_sink_new(optarg, error);
       if(options->transstream == NULL)
         gt_error_set(error, "could not open transmap file '%s'", optarg);
     }
@@ -299,6 +358,12 @@ parse_options(int argc, char **argv, LocusPocusOptions *options, GtError *error)
     }
     else if(opt == 'V')
       options->verbose = 1;
+    else if(opt == 'x')
+    {
+      options->indexfile = fopen(optarg, "wb");
+      if(options->indexfile == NULL)
+        gt_error_set(error, "could not open index file '%s'", optarg);
+    }
     else if(opt == 'y')
       options->skipiiLoci = true;
   }
@@ -340,10 +405,18 @@ int main(int argc, char **argv)
   //----- Set up the node processing stream -----//
   //---------------------------------------------//
 
-  current_stream = gt_gff3_in_stream_new_unsorted(numfiles,
+  if(options.sorted)
+  {
+    current_stream = agn_merge_stream_new_gff3(numfiles,
+                                               (const char **)argv + optind);
+  }
+  else
+  {
+    current_stream = gt_gff3_in_stream_new_unsorted(numfiles,
                                                   (const char **)argv + optind);
-  gt_gff3_in_stream_check_id_attributes((GtGFF3InStream *)current_stream);
-  gt_gff3_in_stream_enable_tidy_mode((GtGFF3InStream *)current_stream);
+    gt_gff3_in_stream_check_id_attributes((GtGFF3InStream *)current_stream);
+    gt_gff3_in_stream_enable_tidy_mode((GtGFF3InStream *)current_stream);
+  }
   gt_queue_add(streams, current_stream);
   last_stream = current_stream;
 
@@ -363,32 +436,75 @@ int main(int argc, char **argv)
   gt_queue_add(streams, current_stream);
   last_stream = current_stream;
 
+  // Selecting subfeatures can put sorted input out of order (the kept
+  // subfeatures of one feature may start after the next feature), so the
+  // filtered features are sorted even when the input files are
   current_stream = gt_sort_stream_new(last_stream);
   gt_queue_add(streams, current_stream);
   last_stream = current_stream;
 
-  current_stream = agn_locus_stream_new(last_stream, options.delta);
-  AgnLocusStream *ls = (AgnLocusStream*)current_stream;
-  agn_locus_stream_set_source(ls, "AEGeAn::LocusPocus");
-  agn_locus_stream_set_endmode(ls, options.endmode);
-  agn_locus_stream_track_ilens(ls, options.ilenfile);
-  if(options.nameformat != NULL)
-    agn_locus_stream_set_name_format(ls, options.nameformat);
-  if(options.skipiiLoci)
-    agn_locus_stream_skip_iiLoci(ls);
-  gt_queue_add(streams, current_stream);
-  last_stream = current_stream;
+  // Each sequence can be parsed independently, so with multiple threads (or
+  // when iLoci are cached per sequence) the locus and refine streams are run
+  // separately for each sequence
+  if(options.numthreads > 1 || options.cache != NULL)
+  {
+    current_stream = agn_locus_parallel_stream_new(last_stream, options.delta,
+                                                   options.numthreads);
+    AgnLocusParallelStream *lps = (AgnLocusParallelStream *)current_stream;
+    agn_locus_parallel_stream_set_source(lps, "AEGeAn::LocusPocus");
+    agn_locus_parallel_stream_set_endmode(lps, options.endmode);
+    agn_locus_parallel_stream_track_ilens(lps, options.ilenfile);
+    agn_locus_parallel_stream_set_cache(lps, options.cache);
+    if(options.nameformat != NULL && !options.miloci)
+      agn_locus_parallel_stream_set_name_format(lps, options.nameformat);
+    if(options.skipiiLoci)
+      agn_locus_parallel_stream_skip_iiLoci(lps);
+    if(options.refine)
+    {
+      agn_locus_parallel_stream_refine(lps, options.minoverlap,
+                                       options.by_cds);
+    }
+    gt_queue_add(streams, current_stream);
+    last_stream = current_stream;
+  }
+  else
+  {
+    current_stream = agn_locus_stream_new(last_stream, options.delta);
+    AgnLocusStream *ls = (AgnLocusStream*)current_stream;
+    agn_locus_stream_set_source(ls, "AEGeAn::LocusPocus");
+    agn_locus_stream_set_endmode(ls, options.endmode);
+    agn_locus_stream_track_ilens(ls, options.ilenfile);
+    if(options.nameformat != NULL && !options.miloci)
+      agn_locus_stream_set_name_format(ls, options.nameformat);
+    if(options.skipiiLoci)
+      agn_locus_stream_skip_iiLoci(ls);
+    gt_queue_add(streams, current_stream);
+    last_stream = current_stream;
+
+    if(options.refine)
+    {
+      current_stream = agn_locus_refine_stream_new(last_stream, options.delta,
+                                                   options.minoverlap,
+                                                   options.by_cds);
+      AgnLocusRefineStream *lrs = (AgnLocusRefineStream *)current_stream;
+      agn_locus_refine_stream_set_source(lrs, "AEGeAn::LocusPocus");
+      agn_locus_refine_stream_track_ilens(lrs, options.ilenfile);
+      if(options.nameformat != NULL && !options.miloci)
+        agn_locus_refine_stream_set_name_format(lrs, options.nameformat);
+      gt_queue_add(streams, current_stream);
+      last_stream = current_stream;
+    }
+  }
 
-  if(options.refine)
+  // Merged iLoci are numbered in place of the iLoci they replace
+  if(options.miloci)
   {
-    current_stream = agn_locus_refine_stream_new(last_stream, options.delta,
-                                                 options.minoverlap,
-                                                 options.by_cds);
-    AgnLocusRefineStream *lrs = (AgnLocusRefineStream *)current_stream;
-    agn_locus_refine_stream_set_source(lrs, "AEGeAn::LocusPocus");
-    agn_locus_refine_stream_track_ilens(lrs, options.ilenfile);
+    current_stream = agn_milocus_stream_new(last_stream);
     if(options.nameformat != NULL)
-      agn_locus_refine_stream_set_name_format(lrs, options.nameformat);
+    {
+      agn_milocus_stream_set_name_format((AgnMiLocusStream *)current_stream,
+                                         options.nameformat);
+    }
     gt_queue_add(streams, current_stream);
     last_stream = current_stream;
   }
@@ -401,6 +517,13 @@ int main(int argc, char **argv)
     last_stream = current_stream;
   }
 
+  if(options.indexfile != NULL)
+  {
+    current_stream = agn_locus_index_stream_new(last_stream, options.indexfile);
+    gt_queue_add(streams, current_stream);
+    last_stream = current_stream;
+  }
+
   if(options.verbose == 0)
   {
     current_stream = agn_remove_children_stream_new(last_stream);
@@ -421,6 +544,14 @@ int main(int argc, char **argv)
   int result = gt_node_stream_pull(last_stream, error);
   if(result == -1)
     fprintf(stderr, "[LocusPocus] error: %s", gt_error_get(error));
+  if(options.cache != NULL)
+  {
+    GtUword hits = agn_ilocus_cache_num_hits(options.cache);
+    GtUword misses = agn_ilocus_cache_num_misses(options.cache);
+    gt_logger_log(logger, "[LocusPocus] iLocus cache: %lu hits, %lu misses "
+                  "(%.1f%% of sequences reused)", hits, misses,
+                  hits + misses == 0 ? 0.0 : 100.0 * hits / (hits + misses));
+  }
 
 
   // Free memory and terminate
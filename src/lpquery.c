@@ -0,0 +1,163 @@
+/**
+
+Copyright (c) 2010-2016, Daniel S. Standage and CONTRIBUTORS
+
+The AEGeAn Toolkit is distributed under the ISC License. See
+the 'LICENSE' file in the AEGeAn source code distribution or
+online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
+
+**/
+#include <getopt.h>
+#include <string.h>
+#include "genometools.h"
+#include "aegean.h"
+
+// Usage statement
+static void print_usage(FILE *outstream)
+{
+  fprintf(outstream,
+"\nlpquery: look up iLoci in an index created by LocusPocus\n"
+"Usage: lpquery [options] index.lpi [query1 query2 ...]\n"
+"  Options:\n"
+"    -h|--help          print this help message and exit\n"
+"    -v|--version       print version number and exit\n\n"
+"  Each query is a position (seqid:pos), a range (seqid:start-end), or the ID\n"
+"  of a gene or mRNA. If no queries are given, queries are read from standard\n"
+"  input, one per line. For each iLocus found, the query, the sequence ID,\n"
+"  start, end, type, and label of the iLocus, and its number of genes and\n"
+"  mRNAs are printed, tab-separated.\n\n");
+}
+
+// Adjust program settings from command-line arguments/options
+static void parse_options(int argc, char **argv)
+{
+  int opt = 0;
+  int optindex = 0;
+  const char *optstr = "hv";
+  const struct option lpquery_options[] =
+  {
+    { "help",    no_argument, NULL, 'h' },
+    { "version", no_argument, NULL, 'v' },
+    { NULL,      no_argument, NULL,  0  },
+  };
+  for(opt  = getopt_long(argc, argv + 0, optstr, lpquery_options, &optindex);
+      opt != -1;
+      opt  = getopt_long(argc, argv + 0, optstr, lpquery_options, &optindex))
+  {
+    if(opt == 'h')
+    {
+      print_usage(stdout);
+      exit(0);
+    }
+    else if(opt == 'v')
+    {
+      agn_print_version("lpquery", stdout);
+      exit(0);
+    }
+    else
+    {
+      print_usage(stderr);
+      exit(1);
+    }
+  }
+}
+
+// Look up a position, range, or ID and print each iLocus found; returns false
+// if no iLocus was found
+static bool run_query(AgnLocusIndex *index, const char *query, GtArray *loci)
+{
+  gt_array_reset(loci);
+  bool isrange = false;
+  const char *colon = strrchr(query, ':');
+  if(colon != NULL && colon != query)
+  {
+    GtRange range;
+    char extra;
+    int numvalues = sscanf(colon + 1, "%lu-%lu%c", &range.start, &range.end,
+                           &extra);
+    if(numvalues == 1)
+      range.end = range.start;
+    if((numvalues == 1 || numvalues == 2) && range.start <= range.end)
+    {
+      char *seqid = gt_cstr_dup_nt(query, colon - query);
+      isrange = agn_locus_index_lookup_range(index, seqid, &range, loci);
+      gt_free(seqid);
+    }
+  }
+
+  // Sequence IDs can contain colons, so anything else is taken as an ID
+  if(!isrange)
+    agn_locus_index_lookup_id(index, query, loci);
+
+  GtUword i;
+  for(i = 0; i < gt_array_size(loci); i++)
+  {
+    AgnLocusIndexEntry entry;
+    agn_locus_index_get(index, *(GtUword *)gt_array_get(loci, i), &entry);
+    printf("%s\t%s\t%lu\t%lu\t%s\t%s\t%lu\t%lu\n", query, entry.seqid,
+           entry.range.start, entry.range.end, entry.type, entry.label,
+           entry.numgenes, entry.nummrnas);
+  }
+  return gt_array_size(loci) > 0;
+}
+
+// Main program
+int main(int argc, char **argv)
+{
+  parse_options(argc, argv);
+  if(argc - optind < 1)
+  {
+    fprintf(stderr, "[lpquery] error: must provide an iLocus index\n");
+    print_usage(stderr);
+    return 1;
+  }
+
+  gt_lib_init();
+  GtError *error = gt_error_new();
+  AgnLocusIndex *index = agn_locus_index_new(argv[optind], error);
+  if(index == NULL)
+  {
+    fprintf(stderr, "[lpquery] error: %s\n", gt_error_get(error));
+    gt_error_delete(error);
+    gt_lib_clean();
+    return 1;
+  }
+
+  GtArray *loci = gt_array_new( sizeof(GtUword) );
+  GtUword notfound = 0;
+  printf("Query\tSeqID\tStart\tEnd\tType\tiLocus\tGenes\tmRNAs\n");
+  if(argc - optind > 1)
+  {
+    int i;
+    for(i = optind + 1; i < argc; i++)
+    {
+      if(!run_query(index, argv[i], loci))
+      {
+        fprintf(stderr, "[lpquery] warning: no iLocus found for '%s'\n",
+                argv[i]);
+        notfound++;
+      }
+    }
+  }
+  else
+  {
+    GtStr *line = gt_str_new();
+    while(gt_str_read_next_line(line, stdin) != EOF)
+    {
+      if(gt_str_length(line) > 0 && !run_query(index, gt_str_get(line), loci))
+      {
+        fprintf(stderr, "[lpquery] warning: no iLocus found for '%s'\n",
+                gt_str_get(line));
+        notfound++;
+      }
+      gt_str_reset(line);
+    }
+    gt_str_delete(line);
+  }
+
+  gt_array_delete(loci);
+  agn_locus_index_delete(index);
+  gt_error_delete(error);
+  gt_lib_clean();
+  return notfound > 0 ? 2 : 0;
+}
@@ -48,6 +48,140 @@ fi
 printf "        | %-36s | %s\n" "Amel Group7.16 (delta=500)" $result
 rm $tempfile ${tempfile}.orig
 
+$memcheckcmd \
+bin/parseval --refrlabel=OGS \
+             --predlabel=NCBI \
+             --threads=4 \
+             data/gff3/amel-ogs-g716.gff3 \
+             data/gff3/amel-ncbi-g716.gff3 \
+  | grep -v -e '^Started' -e '^Executing command' \
+  > $tempfile
+
+grep -v -e '^Started' -e '^Executing command' data/misc/amel-ogs-vs-ncbi-parseval.txt \
+  > ${tempfile}.orig
+
+diff $tempfile ${tempfile}.orig > /dev/null 2>&1
+status=$?
+result="FAIL"
+if [ $status == 0 ]; then
+  result="PASS"
+fi
+printf "        | %-36s | %s\n" "Amel Group7.16 (threads=4)" $result
+rm $tempfile ${tempfile}.orig
+
+$memcheckcmd \
+bin/parseval --refrlabel=OGS \
+             --predlabel=NCBI \
+             --sorted \
+             data/gff3/amel-ogs-g716.gff3 \
+             data/gff3/amel-ncbi-g716.gff3 \
+  | grep -v -e '^Started' -e '^Executing command' \
+  > $tempfile
+
+grep -v -e '^Started' -e '^Executing command' data/misc/amel-ogs-vs-ncbi-parseval.txt \
+  > ${tempfile}.orig
+
+diff $tempfile ${tempfile}.orig > /dev/null 2>&1
+status=$?
+result="FAIL"
+if [ $status == 0 ]; then
+  result="PASS"
+fi
+printf "        | %-36s | %s\n" "Amel Group7.16 (sorted)" $result
+rm $tempfile ${tempfile}.orig
+
+for shard in 1 2 3; do
+  $memcheckcmd \
+  bin/parseval --refrlabel=OGS \
+               --predlabel=NCBI \
+               --shard=${shard}/3 \
+               --partial=${tempfile}.${shard}.dat \
+               --summary \
+               data/gff3/amel-ogs-g7.gff3 \
+               data/gff3/amel-ncbi-g7.gff3 \
+    > /dev/null
+done
+$memcheckcmd \
+bin/parseval-merge ${tempfile}.1.dat ${tempfile}.2.dat ${tempfile}.3.dat \
+  | grep -v -e '^Started' -e '^Executing command' \
+  > $tempfile
+
+bin/parseval --refrlabel=OGS \
+             --predlabel=NCBI \
+             --summary \
+             data/gff3/amel-ogs-g7.gff3 \
+             data/gff3/amel-ncbi-g7.gff3 \
+  | grep -v -e '^Started' -e '^Executing command' \
+  > ${tempfile}.orig
+
+diff $tempfile ${tempfile}.orig > /dev/null 2>&1
+status=$?
+result="FAIL"
+if [ $status == 0 ]; then
+  result="PASS"
+fi
+printf "        | %-36s | %s\n" "Amel Group7 (3 shards, merged)" $result
+rm $tempfile ${tempfile}.orig ${tempfile}.*.dat
+
+for threads in 1 4; do
+  $memcheckcmd \
+  bin/parseval --refrlabel=OGS \
+               --predlabel=NCBI \
+               --cache=${tempfile}.cache \
+               --threads=${threads} \
+               data/gff3/amel-ogs-g716.gff3 \
+               data/gff3/amel-ncbi-g716.gff3 \
+    2> ${tempfile}.${threads}.log \
+    | grep -v -e '^Started' -e '^Executing command' \
+    > ${tempfile}.${threads}
+done
+
+grep -v -e '^Started' -e '^Executing command' data/misc/amel-ogs-vs-ncbi-parseval.txt \
+  > ${tempfile}.orig
+
+# The second run must have taken its results from the cache
+diff ${tempfile}.1 ${tempfile}.orig > /dev/null 2>&1 && \
+diff ${tempfile}.4 ${tempfile}.orig > /dev/null 2>&1 && \
+grep -q 'locus cache: [1-9][0-9]* hits' ${tempfile}.4.log
+status=$?
+result="FAIL"
+if [ $status == 0 ]; then
+  result="PASS"
+fi
+printf "        | %-36s | %s\n" "Amel Group7.16 (cached)" $result
+rm ${tempfile}.1 ${tempfile}.4 ${tempfile}.orig ${tempfile}.cache \
+   ${tempfile}.1.log ${tempfile}.4.log
+
+# The same predictions twice, under different file names: the loci are the
+# same as for a pairwise comparison, so each report must match it exactly
+cp data/gff3/amel-ncbi-g716.gff3 ${tempfile}.pred2.gff3
+$memcheckcmd \
+bin/parseval --refrlabel=OGS \
+             --predlabel=NCBI,NCBI \
+             --threads=4 \
+             --outfile=${tempfile}.multi \
+             data/gff3/amel-ogs-g716.gff3 \
+             data/gff3/amel-ncbi-g716.gff3 \
+             ${tempfile}.pred2.gff3
+for i in 1 2; do
+  grep -v -e '^Started' -e '^Executing command' ${tempfile}.multi.${i} \
+    > ${tempfile}.${i}
+done
+
+grep -v -e '^Started' -e '^Executing command' data/misc/amel-ogs-vs-ncbi-parseval.txt \
+  > ${tempfile}.orig
+
+diff ${tempfile}.1 ${tempfile}.orig > /dev/null 2>&1 && \
+diff ${tempfile}.2 ${tempfile}.orig > /dev/null 2>&1
+status=$?
+result="FAIL"
+if [ $status == 0 ]; then
+  result="PASS"
+fi
+printf "        | %-36s | %s\n" "Amel Group7.16 (2 predictions)" $result
+rm ${tempfile}.1 ${tempfile}.2 ${tempfile}.multi.* ${tempfile}.orig \
+   ${tempfile}.pred2.gff3
+
 
 if [ "$2" == "cairo=no" ]; then
   exit 0
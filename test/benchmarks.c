@@ -0,0 +1,66 @@
+/**
+
+Copyright (c) 2010-2014, Daniel S. Standage and CONTRIBUTORS
+
+The AEGeAn Toolkit is distributed under the ISC License. See
+the 'LICENSE' file in the AEGeAn source code distribution or
+online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
+
+**/
+#include <string.h>
+#include "AgnGaevalVisitor.h"
+#include "AgnLocus.h"
+#include "AgnLocusRefineStream.h"
+#include "AgnLocusStream.h"
+#include "AgnOutputSink.h"
+#include "AgnTypeCounter.h"
+
+int main(int argc, char **argv)
+{
+  puts("AEGeAn Benchmarks");
+  gt_lib_init();
+
+  GtQueue *benchmarks = gt_queue_new();
+  gt_queue_add(benchmarks, agn_unit_test_new("AEGeAn::AgnLocus",
+                                             agn_locus_benchmark));
+  gt_queue_add(benchmarks, agn_unit_test_new("AEGeAn::AgnLocusStream",
+                                             agn_locus_stream_benchmark));
+  gt_queue_add(benchmarks, agn_unit_test_new("AEGeAn::AgnLocusRefineStream",
+                                             agn_locus_refine_stream_benchmark));
+  gt_queue_add(benchmarks, agn_unit_test_new("AEGeAn::AgnTypeCounter",
+                                             agn_type_counter_benchmark));
+  gt_queue_add(benchmarks, agn_unit_test_new("AEGeAn::AgnOutputSink",
+                                             agn_output_sink_benchmark));
+  gt_queue_add(benchmarks, agn_unit_test_new("AEGeAn::AgnGaevalVisitor",
+                                             agn_gaeval_visitor_benchmark));
+
+  unsigned passes   = 0;
+  unsigned failures = 0;
+  while(gt_queue_size(benchmarks) > 0)
+  {
+    AgnUnitTest *test = gt_queue_get(benchmarks);
+    agn_unit_test_run(test);
+    agn_unit_test_print(test, stdout);
+    if(agn_unit_test_success(test))
+      passes++;
+    else
+      failures++;
+    agn_unit_test_delete(test);
+  }
+
+  bool returnval = 0;
+  if(failures == 0)
+  {
+    printf("\n===== Benchmarks passed for all %u classes! =====\n\n", passes);
+  }
+  else
+  {
+    printf("\n===== Benchmarks failed for %u/%u classes! ===== \n\n", failures,
+           passes+failures);
+    returnval = 1;
+  }
+
+  gt_queue_delete(benchmarks);
+  gt_lib_clean();
+  return returnval;
+}
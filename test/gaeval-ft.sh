@@ -36,3 +36,94 @@ if [[ $status == 0 ]]; then
 fi
 printf "        | %-36s | %s\n" "Pdom" $result
 rm $tempfile
+
+
+$memcheckcmd \
+bin/gaeval --sorted data/gff3/gaeval-stream-unit-test-1.gff3 \
+                    data/gff3/gaeval-stream-unit-test-1.gff3 \
+    > $tempfile
+
+diff $tempfile data/gff3/gaeval-stream-unit-test-1-out.gff3 > /dev/null
+status=$?
+result="FAIL"
+if [[ $status == 0 ]]; then
+  result="PASS"
+fi
+printf "        | %-36s | %s\n" "sans CDS (sorted)" $result
+rm $tempfile
+
+
+$memcheckcmd \
+bin/gaeval --sorted data/gff3/gaeval-stream-unit-test-2.gff3 \
+                    data/gff3/gaeval-stream-unit-test-2.gff3 \
+    > $tempfile
+
+diff $tempfile data/gff3/gaeval-stream-unit-test-2-out.gff3 > /dev/null
+status=$?
+result="FAIL"
+if [[ $status == 0 ]]; then
+  result="PASS"
+fi
+printf "        | %-36s | %s\n" "Pdom (sorted)" $result
+rm $tempfile
+
+
+$memcheckcmd \
+bin/gaeval --threads=4 data/gff3/gaeval-stream-unit-test-2.gff3 \
+                       data/gff3/gaeval-stream-unit-test-2.gff3 \
+    > $tempfile
+
+diff $tempfile data/gff3/gaeval-stream-unit-test-2-out.gff3 > /dev/null
+status=$?
+result="FAIL"
+if [[ $status == 0 ]]; then
+  result="PASS"
+fi
+printf "        | %-36s | %s\n" "Pdom (4 threads)" $result
+rm $tempfile
+
+
+$memcheckcmd \
+bin/gaeval --sorted --threads=4 data/gff3/gaeval-stream-unit-test-1.gff3 \
+                                data/gff3/gaeval-stream-unit-test-1.gff3 \
+    > $tempfile
+
+diff $tempfile data/gff3/gaeval-stream-unit-test-1-out.gff3 > /dev/null
+status=$?
+result="FAIL"
+if [[ $status == 0 ]]; then
+  result="PASS"
+fi
+printf "        | %-36s | %s\n" "sans CDS (sorted, 4 threads)" $result
+rm $tempfile
+
+
+$memcheckcmd \
+bin/gaeval --tsv=$tempfile.tsv data/gff3/gaeval-stream-unit-test-2.gff3 \
+                               data/gff3/gaeval-stream-unit-test-2.gff3 \
+    > $tempfile
+
+diff $tempfile.tsv data/misc/gaeval-stream-unit-test-2-out.tsv > /dev/null
+status=$?
+result="FAIL"
+if [[ $status == 0 ]]; then
+  result="PASS"
+fi
+printf "        | %-36s | %s\n" "Pdom (TSV)" $result
+rm $tempfile $tempfile.tsv
+
+
+$memcheckcmd \
+bin/gaeval --threads=4 --tsv=$tempfile.tsv \
+           data/gff3/gaeval-stream-unit-test-2.gff3 \
+           data/gff3/gaeval-stream-unit-test-2.gff3 \
+    > $tempfile
+
+diff $tempfile.tsv data/misc/gaeval-stream-unit-test-2-out.tsv > /dev/null
+status=$?
+result="FAIL"
+if [[ $status == 0 ]]; then
+  result="PASS"
+fi
+printf "        | %-36s | %s\n" "Pdom (TSV, 4 threads)" $result
+rm $tempfile $tempfile.tsv
@@ -24,6 +24,9 @@ run_func_test()
   set +e
   diff $tempfile $testoutfile > /dev/null 2>&1
   status=$?
+  if [ -n "$expectlog" ] && ! grep -q "$expectlog" ${filelabel}.err; then
+    status=1
+  fi
   set -e
 
   result="FAIL"
@@ -41,11 +44,42 @@ echo "    AEGeAn::LocusPocus"
 
 run_func_test "default" data/gff3/ilocus.out.noskipends.gff3 --delta=200 --outfile=${tempfile} --parent mRNA:gene data/gff3/ilocus.in.gff3
 run_func_test "end skip" data/gff3/ilocus.out.skipends.gff3 --delta=200 --outfile=${tempfile} --skipends --parent mRNA:gene data/gff3/ilocus.in.gff3
+run_func_test "default (4 threads)" data/gff3/ilocus.out.noskipends.gff3 --threads=4 --delta=200 --outfile=${tempfile} --parent mRNA:gene data/gff3/ilocus.in.gff3
+run_func_test "end skip (4 threads)" data/gff3/ilocus.out.skipends.gff3 --threads=4 --delta=200 --outfile=${tempfile} --skipends --parent mRNA:gene data/gff3/ilocus.in.gff3
+run_func_test "unannotated sequences" data/gff3/ilocus-unannot-out.gff3 --delta=200 --outfile=${tempfile} --parent mRNA:gene data/gff3/ilocus-unannot.gff3
+run_func_test "unannotated (4 threads)" data/gff3/ilocus-unannot-out.gff3 --threads=4 --delta=200 --outfile=${tempfile} --parent mRNA:gene data/gff3/ilocus-unannot.gff3
 run_func_test "Apis mellifera plap" data/gff3/amel-plap-out.gff3 --outfile=${tempfile} --skipends data/gff3/amel-plap.gff3
 run_func_test "Apis mellifera plap (CDS)" data/gff3/amel-plap-out-cds.gff3 --outfile=${tempfile} --skipends --cds data/gff3/amel-plap.gff3
 run_func_test "Apis mellifera LSM" data/gff3/amel-lsm-out-cds.gff3 --outfile=${tempfile} --skipends --cds data/gff3/amel-lsm.gff3
+run_func_test "Apis mellifera plap (miLoci)" data/gff3/amel-plap-out-miloci.gff3 --outfile=${tempfile} --skipends --cds --miloci data/gff3/amel-plap.gff3
+run_func_test "Apis mellifera LSM (miLoci)" data/gff3/amel-lsm-out-miloci.gff3 --outfile=${tempfile} --skipends --cds --miloci data/gff3/amel-lsm.gff3
 run_func_test "Megachile rotundata CST (intron)" data/gff3/mrot-cst-out-cds.gff3 --outfile=${tempfile} --skipends --cds data/gff3/mrot-cst.gff3
 run_func_test "iiLocus lengths (Amel OGS Group7.16)" data/misc/amel-ogs-ilens.txt --delta=300 --ilens=${tempfile} --cds data/gff3/amel-ogs-g716.gff3
+run_func_test "iiLocus lengths (sorted input)" data/misc/amel-ogs-ilens.txt --sorted --delta=300 --ilens=${tempfile} --cds data/gff3/amel-ogs-g716.gff3
+run_func_test "iiLocus lengths (4 threads)" data/misc/amel-ogs-ilens.txt --threads=4 --delta=300 --ilens=${tempfile} --cds data/gff3/amel-ogs-g716.gff3
+
+# Selecting mRNAs from sorted input emits them out of order (the second mRNA of
+# the first gene starts after the second gene), so sorted and unsorted runs
+# must agree
+sortedref="ilocus-filter-sorted-ref.gff3"
+bin/locuspocus --retainids --filter=mRNA --outfile=${sortedref} data/gff3/ilocus-filter-sorted.gff3 2> /dev/null
+run_func_test "mRNA filter (sorted input)" ${sortedref} --sorted --filter=mRNA --outfile=${tempfile} data/gff3/ilocus-filter-sorted.gff3
+rm -f ${sortedref}
+
+# Each incremental test runs twice: the first run fills the cache and the
+# second rebuilds every sequence's iLoci from it, which the log must report
+cachedir="ilocus-cache.tmp"
+cachedlog='iLocus cache: [1-9][0-9]* hits, 0 misses (100.0% of sequences reused)'
+rm -rf $cachedir
+run_func_test "incremental" data/gff3/ilocus.out.noskipends.gff3 --incremental=${cachedir} --delta=200 --outfile=${tempfile} --parent mRNA:gene data/gff3/ilocus.in.gff3
+expectlog=$cachedlog
+run_func_test "incremental (cached)" data/gff3/ilocus.out.noskipends.gff3 --incremental=${cachedir} --delta=200 --outfile=${tempfile} --parent mRNA:gene data/gff3/ilocus.in.gff3
+expectlog=
+run_func_test "iiLocus lengths (incremental)" data/misc/amel-ogs-ilens.txt --incremental=${cachedir} --delta=300 --ilens=${tempfile} --cds data/gff3/amel-ogs-g716.gff3
+expectlog=$cachedlog
+run_func_test "iiLocus lengths (cached)" data/misc/amel-ogs-ilens.txt --incremental=${cachedir} --delta=300 --ilens=${tempfile} --cds data/gff3/amel-ogs-g716.gff3
+expectlog=
+rm -rf $cachedir
 run_func_test "Nasonia vitripennis (intron gene)" data/gff3/nvit-exospindle-out.gff3 --outfile=${tempfile} --cds data/gff3/nvit-exospindle.gff3
 run_func_test "A. echinatior (intron gene + ncRNA)" data/gff3/aech-dachsous-out.gff3 --outfile=${tempfile} --cds data/gff3/aech-dachsous.gff3
 run_func_test "iiLocus Flank Orientations (test 1)" data/misc/zitest-01-ilens.tsv --ilens=${tempfile} --cds data/gff3/zitest-01.gff3
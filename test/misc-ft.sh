@@ -60,3 +60,23 @@ if [[ $status == 0 ]]; then
 fi
 printf "        | %-36s | %s\n" "A. dorsata exception" $result
 rm $tempfile
+
+
+
+echo "    AEGeAn::lpquery"
+indexfile="misc.temp.lpi"
+$memcheckcmd \
+bin/locuspocus --delta=200 --outfile=/dev/null --index=$indexfile \
+               --parent mRNA:gene data/gff3/ilocus.in.gff3
+$memcheckcmd \
+bin/lpquery $indexfile seq07:900 seq07:1700 test2.1b seq08:700-1100 \
+    > $tempfile
+
+diff $tempfile data/misc/ilocus-lpquery.tsv > /dev/null
+status=$?
+result="FAIL"
+if [[ $status == 0 ]]; then
+  result="PASS"
+fi
+printf "        | %-36s | %s\n" "iLocus index lookups" $result
+rm $tempfile $indexfile
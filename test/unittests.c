@@ -10,20 +10,31 @@ online at https://github.com/standage/AEGeAn/blob/master/LICENSE.
 #include <string.h>
 #include "AgnAttributeFilterStream.h"
 #include "AgnCliquePair.h"
+#include "AgnCompareStream.h"
 #include "AgnFilterStream.h"
+#include "AgnGaevalParallelStream.h"
 #include "AgnGaevalVisitor.h"
 #include "AgnGeneStream.h"
 #include "AgnIdFilterStream.h"
+#include "AgnILocusCache.h"
 #include "AgnInferCDSVisitor.h"
 #include "AgnInferExonsVisitor.h"
 #include "AgnInferParentStream.h"
 #include "AgnLocus.h"
+#include "AgnLocusCache.h"
+#include "AgnLocusIndex.h"
+#include "AgnLocusParallelStream.h"
 #include "AgnLocusRefineStream.h"
 #include "AgnLocusStream.h"
+#include "AgnMergeStream.h"
+#include "AgnMiLocusStream.h"
 #include "AgnMrnaRepVisitor.h"
+#include "AgnOutputSink.h"
 #include "AgnPseudogeneFixVisitor.h"
 #include "AgnRemoveChildrenVisitor.h"
+#include "AgnSeqidFilterStream.h"
 #include "AgnTranscriptClique.h"
+#include "AgnTypeCounter.h"
 
 int main(int argc, char **argv)
 {
@@ -53,16 +64,38 @@ int main(int argc, char **argv)
                                         agn_infer_cds_visitor_unit_test));
   gt_queue_add(tests, agn_unit_test_new("AEGeAn::AgnInferExonsVisitor",
                                         agn_infer_exons_visitor_unit_test));
+  gt_queue_add(tests, agn_unit_test_new("AEGeAn::AgnMergeStream",
+                                        agn_merge_stream_unit_test));
   gt_queue_add(tests, agn_unit_test_new("AEGeAn::AgnGeneStream",
                                         agn_gene_stream_unit_test));
+  gt_queue_add(tests, agn_unit_test_new("AEGeAn::AgnTypeCounter",
+                                        agn_type_counter_unit_test));
+  gt_queue_add(tests, agn_unit_test_new("AEGeAn::AgnOutputSink",
+                                        agn_output_sink_unit_test));
   gt_queue_add(tests, agn_unit_test_new("AEGeAn::AgnLocusStream",
                                         agn_locus_stream_unit_test));
   gt_queue_add(tests, agn_unit_test_new("AEGeAn::AgnLocusRefineStream",
                                         agn_locus_refine_stream_unit_test));
+  gt_queue_add(tests, agn_unit_test_new("AEGeAn::AgnMiLocusStream",
+                                        agn_milocus_stream_unit_test));
+  gt_queue_add(tests, agn_unit_test_new("AEGeAn::AgnLocusParallelStream",
+                                        agn_locus_parallel_stream_unit_test));
+  gt_queue_add(tests, agn_unit_test_new("AEGeAn::AgnILocusCache",
+                                        agn_ilocus_cache_unit_test));
+  gt_queue_add(tests, agn_unit_test_new("AEGeAn::AgnCompareStream",
+                                        agn_compare_stream_unit_test));
+  gt_queue_add(tests, agn_unit_test_new("AEGeAn::AgnLocusCache",
+                                        agn_locus_cache_unit_test));
+  gt_queue_add(tests, agn_unit_test_new("AEGeAn::AgnLocusIndex",
+                                        agn_locus_index_unit_test));
   gt_queue_add(tests, agn_unit_test_new("AEGeAn::AgnGaevalVisitor",
                                         agn_gaeval_visitor_unit_test));
+  gt_queue_add(tests, agn_unit_test_new("AEGeAn::AgnGaevalParallelStream",
+                                        agn_gaeval_parallel_stream_unit_test));
   gt_queue_add(tests, agn_unit_test_new("AEGeAn::AgnIdFilterStream",
                                         agn_id_filter_stream_unit_test));
+  gt_queue_add(tests, agn_unit_test_new("AEGeAn::AgnSeqidFilterStream",
+                                        agn_seqid_filter_stream_unit_test));
 
   unsigned passes   = 0;
   unsigned failures = 0;